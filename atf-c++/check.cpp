@@ -39,6 +39,24 @@ extern "C" {
 namespace impl = atf::check;
 #define IMPL_NAME "atf::check"
 
+// ------------------------------------------------------------------------
+// The "expected_output" class.
+// ------------------------------------------------------------------------
+
+impl::expected_output::expected_output(const void* data,
+                                       const std::size_t size)
+{
+    atf_check_expect_init(&m_expect, data, size);
+}
+
+impl::expected_output::expected_output(const void* data,
+                                       const std::size_t size,
+                                       const int signo)
+{
+    atf_check_expect_init(&m_expect, data, size);
+    m_expect.m_signo = signo;
+}
+
 // ------------------------------------------------------------------------
 // The "check_result" class.
 // ------------------------------------------------------------------------
@@ -83,16 +101,111 @@ impl::check_result::termsig(void)
     return atf_check_result_termsig(&m_result);
 }
 
+bool
+impl::check_result::timed_out(void)
+    const
+{
+    return atf_check_result_timed_out(&m_result);
+}
+
+int64_t
+impl::check_result::wall_usec(void)
+    const
+{
+    return atf_check_result_wall_usec(&m_result);
+}
+
+int64_t
+impl::check_result::user_usec(void)
+    const
+{
+    return atf_check_result_user_usec(&m_result);
+}
+
+int64_t
+impl::check_result::system_usec(void)
+    const
+{
+    return atf_check_result_system_usec(&m_result);
+}
+
+long
+impl::check_result::maxrss_kb(void)
+    const
+{
+    return atf_check_result_maxrss_kb(&m_result);
+}
+
+long
+impl::check_result::minflt(void)
+    const
+{
+    return atf_check_result_minflt(&m_result);
+}
+
+long
+impl::check_result::majflt(void)
+    const
+{
+    return atf_check_result_majflt(&m_result);
+}
+
+long
+impl::check_result::nvcsw(void)
+    const
+{
+    return atf_check_result_nvcsw(&m_result);
+}
+
+long
+impl::check_result::nivcsw(void)
+    const
+{
+    return atf_check_result_nivcsw(&m_result);
+}
+
 const std::string
 impl::check_result::stdout_path(void) const
 {
-    return atf_check_result_stdout(&m_result);
+    const char* path;
+    atf_error_t err = atf_check_result_stdout_path(&m_result, &path);
+    if (atf_is_error(err))
+        throw_atf_error(err);
+    return path;
 }
 
 const std::string
 impl::check_result::stderr_path(void) const
 {
-    return atf_check_result_stderr(&m_result);
+    const char* path;
+    atf_error_t err = atf_check_result_stderr_path(&m_result, &path);
+    if (atf_is_error(err))
+        throw_atf_error(err);
+    return path;
+}
+
+const char*
+impl::check_result::stdout_data(std::size_t* size) const
+{
+    return atf_check_result_stdout_data(&m_result, size);
+}
+
+const char*
+impl::check_result::stderr_data(std::size_t* size) const
+{
+    return atf_check_result_stderr_data(&m_result, size);
+}
+
+bool
+impl::check_result::stdout_diverged(std::size_t* offset) const
+{
+    return atf_check_result_stdout_diverged(&m_result, offset);
+}
+
+bool
+impl::check_result::stderr_diverged(std::size_t* offset) const
+{
+    return atf_check_result_stderr_diverged(&m_result, offset);
 }
 
 // ------------------------------------------------------------------------
@@ -152,3 +265,29 @@ impl::exec(const atf::process::argv_array& argva)
 
     return std::unique_ptr< impl::check_result >(new impl::check_result(&result));
 }
+
+std::unique_ptr< impl::check_result >
+impl::exec(const atf::process::argv_array& argva,
+           const expected_output* out_expect,
+           const expected_output* err_expect)
+{
+    return exec(argva, out_expect, err_expect, 0);
+}
+
+std::unique_ptr< impl::check_result >
+impl::exec(const atf::process::argv_array& argva,
+           const expected_output* out_expect,
+           const expected_output* err_expect,
+           const int timeout_ms)
+{
+    atf_check_result_t result;
+
+    atf_error_t err = atf_check_exec_array_timeout(
+        argva.exec_argv(), out_expect == NULL ? NULL : &out_expect->m_expect,
+        err_expect == NULL ? NULL : &err_expect->m_expect, timeout_ms,
+        &result);
+    if (atf_is_error(err))
+        throw_atf_error(err);
+
+    return std::unique_ptr< impl::check_result >(new impl::check_result(&result));
+}
@@ -43,6 +43,32 @@ class argv_array;
 
 namespace check {
 
+class check_result;
+
+// ------------------------------------------------------------------------
+// The "expected_output" class.
+// ------------------------------------------------------------------------
+
+//!
+//! \brief The expected contents of an output of a command.
+//!
+//! The output is compared with the contents while the command runs, and
+//! the command is sent a signal, SIGKILL by default, as soon as it
+//! diverges from them, and SIGKILL if it has not exited a second later.
+//! The contents are not copied, so they must outlive the call to exec.
+//!
+class expected_output {
+    atf_check_expect_t m_expect;
+
+    friend std::unique_ptr< check_result > exec(
+        const atf::process::argv_array&, const expected_output*,
+        const expected_output*, const int);
+
+public:
+    expected_output(const void*, std::size_t);
+    expected_output(const void*, std::size_t, int);
+};
+
 // ------------------------------------------------------------------------
 // The "check_result" class.
 // ------------------------------------------------------------------------
@@ -72,6 +98,9 @@ class check_result {
 
     friend check_result test_constructor(const char* const*);
     friend std::unique_ptr< check_result > exec(const atf::process::argv_array&);
+    friend std::unique_ptr< check_result > exec(
+        const atf::process::argv_array&, const expected_output*,
+        const expected_output*, const int);
 
 public:
     //!
@@ -99,15 +128,91 @@ public:
     //!
     int termsig(void) const;
 
+    //!
+    //! \brief Returns whether the command was killed because it did not
+    //! finish within its timeout.
+    //!
+    //! The captured outputs hold what the command wrote until then.
+    //!
+    bool timed_out(void) const;
+
+    //!
+    //! \brief Returns the wall time from the start of the command until
+    //! it was reaped, in microseconds.
+    //!
+    int64_t wall_usec(void) const;
+
+    //!
+    //! \brief Returns the user and system CPU time consumed by the
+    //! command, in microseconds.
+    //!
+    int64_t user_usec(void) const;
+    int64_t system_usec(void) const;
+
+    //!
+    //! \brief Returns the peak resident set size of the command, in
+    //! kilobytes.
+    //!
+    long maxrss_kb(void) const;
+
+    //!
+    //! \brief Returns the minor and major page faults of the command.
+    //!
+    long minflt(void) const;
+    long majflt(void) const;
+
+    //!
+    //! \brief Returns the voluntary and involuntary context switches of
+    //! the command.
+    //!
+    long nvcsw(void) const;
+    long nivcsw(void) const;
+
     //!
     //! \brief Returns the path to file contaning command's stdout.
     //!
+    //! The file always exists for commands run by the exec overload that
+    //! only takes the arguments.  For the others, it is created on demand if the output was
+    //! kept in memory, which throws if the file cannot be created.
+    //!
     const std::string stdout_path(void) const;
 
     //!
     //! \brief Returns the path to file contaning command's stderr.
     //!
+    //! The file always exists for commands run by the exec overload that
+    //! only takes the arguments.  For the others, it is created on demand if the output was
+    //! kept in memory, which throws if the file cannot be created.
+    //!
     const std::string stderr_path(void) const;
+
+    //!
+    //! \brief Returns the command's stdout if it was kept in memory.
+    //!
+    //! Returns NULL if the output was too large and was stored in the
+    //! file returned by stdout_path instead.
+    //!
+    const char* stdout_data(std::size_t*) const;
+
+    //!
+    //! \brief Returns the command's stderr if it was kept in memory.
+    //!
+    //! Returns NULL if the output was too large and was stored in the
+    //! file returned by stderr_path instead.
+    //!
+    const char* stderr_data(std::size_t*) const;
+
+    //!
+    //! \brief Returns whether the command's stdout diverged from its
+    //! expected contents, and the offset of the first differing byte.
+    //!
+    bool stdout_diverged(std::size_t*) const;
+
+    //!
+    //! \brief Returns whether the command's stderr diverged from its
+    //! expected contents, and the offset of the first differing byte.
+    //!
+    bool stderr_diverged(std::size_t*) const;
 };
 
 // ------------------------------------------------------------------------
@@ -121,6 +226,12 @@ bool build_cpp(const std::string&, const std::string&,
 bool build_cxx_o(const std::string&, const std::string&,
                  const atf::process::argv_array&);
 std::unique_ptr< check_result > exec(const atf::process::argv_array&);
+std::unique_ptr< check_result > exec(const atf::process::argv_array&,
+                                     const expected_output*,
+                                     const expected_output*);
+std::unique_ptr< check_result > exec(const atf::process::argv_array&,
+                                     const expected_output*,
+                                     const expected_output*, const int);
 
 // Useful for testing only.
 check_result test_constructor(void);
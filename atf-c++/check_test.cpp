@@ -360,6 +360,72 @@ ATF_TEST_CASE_BODY(exec_stdout_stderr)
     check_lines(err2, "stderr", "result2");
 }
 
+ATF_TEST_CASE(exec_stdout_stderr_data);
+ATF_TEST_CASE_HEAD(exec_stdout_stderr_data)
+{
+    set_md_var("descr", "Tests that exec keeps small outputs in memory "
+               "and large ones in files");
+}
+ATF_TEST_CASE_BODY(exec_stdout_stderr_data)
+{
+    std::size_t size;
+
+    std::unique_ptr< atf::check::check_result > r1 =
+        do_exec(this, "stdout-stderr", "result1");
+    const char* data = r1->stdout_data(&size);
+    ATF_REQUIRE(data != NULL);
+    ATF_REQUIRE_EQ(std::string("Line 1 to stdout for result1\n"
+                               "Line 2 to stdout for result1\n"),
+                   std::string(data, size));
+    data = r1->stderr_data(&size);
+    ATF_REQUIRE(data != NULL);
+    ATF_REQUIRE_EQ(std::string("Line 1 to stderr for result1\n"
+                               "Line 2 to stderr for result1\n"),
+                   std::string(data, size));
+
+    std::unique_ptr< atf::check::check_result > r2 =
+        do_exec(this, "stdout-stderr-large", "65536");
+    ATF_REQUIRE(r2->stdout_data(&size) == NULL);
+    ATF_REQUIRE(r2->stderr_data(&size) == NULL);
+    ATF_REQUIRE_EQ(65536 * 16,
+                   atf::fs::file_info(atf::fs::path(r2->stdout_path()))
+                   .get_size());
+}
+
+ATF_TEST_CASE(exec_timeout);
+ATF_TEST_CASE_HEAD(exec_timeout)
+{
+    set_md_var("descr", "Tests that exec kills a command that runs for too "
+               "long and keeps its partial output");
+    set_md_var("timeout", "30");
+}
+ATF_TEST_CASE_BODY(exec_timeout)
+{
+    std::vector< std::string > argv;
+    argv.push_back("/bin/sh");
+    argv.push_back("-c");
+    argv.push_back("echo partial; sleep 60");
+
+    atf::process::argv_array argva(argv);
+    std::unique_ptr< atf::check::check_result > r =
+        atf::check::exec(argva, NULL, NULL, 200);
+    ATF_REQUIRE(r->timed_out());
+    ATF_REQUIRE(r->signaled());
+    ATF_REQUIRE_EQ(SIGTERM, r->termsig());
+
+    std::size_t size;
+    const char* data = r->stdout_data(&size);
+    ATF_REQUIRE(data != NULL);
+    ATF_REQUIRE_EQ("partial\n", std::string(data, size));
+
+    argv[2] = "echo done";
+    atf::process::argv_array argva2(argv);
+    std::unique_ptr< atf::check::check_result > r2 =
+        atf::check::exec(argva2, NULL, NULL, 10000);
+    ATF_REQUIRE(!r2->timed_out());
+    ATF_REQUIRE(r2->exited());
+}
+
 ATF_TEST_CASE(exec_unknown);
 ATF_TEST_CASE_HEAD(exec_unknown)
 {
@@ -377,6 +443,30 @@ ATF_TEST_CASE_BODY(exec_unknown)
     ATF_REQUIRE_EQ(r->exitcode(), 127);
 }
 
+ATF_TEST_CASE(exec_usage);
+ATF_TEST_CASE_HEAD(exec_usage)
+{
+    set_md_var("descr", "Tests that exec records the resources consumed "
+               "by the command");
+}
+ATF_TEST_CASE_BODY(exec_usage)
+{
+    std::unique_ptr< atf::check::check_result > r =
+        do_exec(this, "stdout-stderr-large", "100000");
+    ATF_REQUIRE(r->exited());
+    ATF_REQUIRE_EQ(r->exitcode(), EXIT_SUCCESS);
+
+    std::cout << "wall " << r->wall_usec() << " us, user " << r->user_usec()
+              << " us, system " << r->system_usec() << " us, maxrss "
+              << r->maxrss_kb() << " KB, minflt " << r->minflt()
+              << ", majflt " << r->majflt() << ", nvcsw " << r->nvcsw()
+              << ", nivcsw " << r->nivcsw() << "\n";
+    ATF_REQUIRE(r->wall_usec() > 0);
+    ATF_REQUIRE(r->user_usec() + r->system_usec() > 0);
+    ATF_REQUIRE(r->maxrss_kb() > 0);
+    ATF_REQUIRE(r->minflt() > 0);
+}
+
 // ------------------------------------------------------------------------
 // Main.
 // ------------------------------------------------------------------------
@@ -390,5 +480,8 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, exec_cleanup);
     ATF_ADD_TEST_CASE(tcs, exec_exitstatus);
     ATF_ADD_TEST_CASE(tcs, exec_stdout_stderr);
+    ATF_ADD_TEST_CASE(tcs, exec_stdout_stderr_data);
+    ATF_ADD_TEST_CASE(tcs, exec_timeout);
     ATF_ADD_TEST_CASE(tcs, exec_unknown);
+    ATF_ADD_TEST_CASE(tcs, exec_usage);
 }
@@ -274,6 +274,62 @@ impl::status::coredump(void)
     return atf_process_status_coredump(&m_status);
 }
 
+int64_t
+impl::status::wall_usec(void)
+    const
+{
+    return atf_process_status_wall_usec(&m_status);
+}
+
+int64_t
+impl::status::user_usec(void)
+    const
+{
+    return atf_process_status_user_usec(&m_status);
+}
+
+int64_t
+impl::status::system_usec(void)
+    const
+{
+    return atf_process_status_system_usec(&m_status);
+}
+
+long
+impl::status::maxrss_kb(void)
+    const
+{
+    return atf_process_status_maxrss_kb(&m_status);
+}
+
+long
+impl::status::minflt(void)
+    const
+{
+    return atf_process_status_minflt(&m_status);
+}
+
+long
+impl::status::majflt(void)
+    const
+{
+    return atf_process_status_majflt(&m_status);
+}
+
+long
+impl::status::nvcsw(void)
+    const
+{
+    return atf_process_status_nvcsw(&m_status);
+}
+
+long
+impl::status::nivcsw(void)
+    const
+{
+    return atf_process_status_nivcsw(&m_status);
+}
+
 // ------------------------------------------------------------------------
 // The "child" type.
 // ------------------------------------------------------------------------
@@ -328,6 +384,110 @@ impl::child::stderr_fd(void)
     return atf_process_child_stderr(&m_child);
 }
 
+// ------------------------------------------------------------------------
+// The "group" type.
+// ------------------------------------------------------------------------
+
+impl::group::group(void)
+{
+    atf_error_t err = atf_process_group_init(&m_group);
+    if (atf_is_error(err))
+        throw_atf_error(err);
+}
+
+impl::group::~group(void)
+{
+    atf_process_group_fini(&m_group);
+}
+
+std::size_t
+impl::group::size(void)
+    const
+{
+    return atf_process_group_size(&m_group);
+}
+
+pid_t
+impl::group::pid(const std::size_t index)
+    const
+{
+    return atf_process_group_pid(&m_group, index);
+}
+
+bool
+impl::group::finished(const std::size_t index)
+    const
+{
+    return atf_process_group_status(&m_group, index) != NULL;
+}
+
+impl::status
+impl::group::get_status(const std::size_t index)
+    const
+{
+    const atf_process_status_t* s = atf_process_group_status(&m_group, index);
+    PRE(s != NULL);
+
+    atf_process_status_t copy = *s;
+    return status(copy);
+}
+
+std::string
+impl::group::stdout_data(const std::size_t index)
+    const
+{
+    std::size_t size;
+    const char* data = atf_process_group_stdout(&m_group, index, &size);
+    return data == NULL ? std::string() : std::string(data, size);
+}
+
+std::string
+impl::group::stderr_data(const std::size_t index)
+    const
+{
+    std::size_t size;
+    const char* data = atf_process_group_stderr(&m_group, index, &size);
+    return data == NULL ? std::string() : std::string(data, size);
+}
+
+void
+impl::group::kill(const int signo)
+{
+    atf_process_group_kill(&m_group, signo);
+}
+
+void
+impl::group::set_deadline(const int timeout, const int signo)
+{
+    atf_process_group_set_deadline(&m_group, timeout, signo);
+}
+
+bool
+impl::group::wait_any(const int timeout, std::size_t& index)
+{
+    bool found;
+
+    atf_error_t err = atf_process_group_wait_any(&m_group, timeout, &index,
+                                                 &found);
+    if (atf_is_error(err))
+        throw_atf_error(err);
+
+    return found;
+}
+
+bool
+impl::group::wait_all(const int timeout)
+{
+    bool finished;
+
+    atf_error_t err = atf_process_group_wait_all(&m_group, timeout,
+                                                 &finished);
+    if (atf_is_error(err))
+        throw_atf_error(err);
+
+    return finished;
+}
+
 // ------------------------------------------------------------------------
 // Free functions.
 // ------------------------------------------------------------------------
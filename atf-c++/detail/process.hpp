@@ -43,6 +43,7 @@ namespace atf {
 namespace process {
 
 class child;
+class group;
 class status;
 
 // ------------------------------------------------------------------------
@@ -112,6 +113,7 @@ class stream_capture : basic_stream {
     template< class OutStream, class ErrStream > friend
     status exec(const atf::fs::path&, const argv_array&,
                 const OutStream&, const ErrStream&, void (*)(void));
+    friend class group;
 
 public:
     stream_capture(void);
@@ -124,6 +126,7 @@ class stream_connect : basic_stream {
     template< class OutStream, class ErrStream > friend
     status exec(const atf::fs::path&, const argv_array&,
                 const OutStream&, const ErrStream&, void (*)(void));
+    friend class group;
 
 public:
     stream_connect(const int, const int);
@@ -136,6 +139,7 @@ class stream_inherit : basic_stream {
     template< class OutStream, class ErrStream > friend
     status exec(const atf::fs::path&, const argv_array&,
                 const OutStream&, const ErrStream&, void (*)(void));
+    friend class group;
 
 public:
     stream_inherit(void);
@@ -148,6 +152,7 @@ class stream_redirect_fd : basic_stream {
     template< class OutStream, class ErrStream > friend
     status exec(const atf::fs::path&, const argv_array&,
                 const OutStream&, const ErrStream&, void (*)(void));
+    friend class group;
 
 public:
     stream_redirect_fd(const int);
@@ -160,6 +165,7 @@ class stream_redirect_path : basic_stream {
     template< class OutStream, class ErrStream > friend
     status exec(const atf::fs::path&, const argv_array&,
                 const OutStream&, const ErrStream&, void (*)(void));
+    friend class group;
 
 public:
     stream_redirect_path(const fs::path&);
@@ -173,6 +179,7 @@ class status {
     atf_process_status_t m_status;
 
     friend class child;
+    friend class group;
     template< class OutStream, class ErrStream > friend
     status exec(const atf::fs::path&, const argv_array&,
                 const OutStream&, const ErrStream&, void (*)(void));
@@ -188,6 +195,15 @@ public:
     bool signaled(void) const;
     int termsig(void) const;
     bool coredump(void) const;
+
+    int64_t wall_usec(void) const;
+    int64_t user_usec(void) const;
+    int64_t system_usec(void) const;
+    long maxrss_kb(void) const;
+    long minflt(void) const;
+    long majflt(void) const;
+    long nvcsw(void) const;
+    long nivcsw(void) const;
 };
 
 // ------------------------------------------------------------------------
@@ -213,6 +229,47 @@ public:
     int stderr_fd(void);
 };
 
+// ------------------------------------------------------------------------
+// The "group" type.
+// ------------------------------------------------------------------------
+
+//!
+//! \brief A set of children that are waited for together.
+//!
+//! The outputs of the children that are captured are read while waiting,
+//! so that no child blocks on a full pipe.  Any children still running
+//! when the group is destroyed are killed.
+//!
+class group {
+    atf_process_group_t m_group;
+
+    group(const group&);
+    group& operator=(const group&);
+
+public:
+    group(void);
+    ~group(void);
+
+    template< class OutStream, class ErrStream >
+    std::size_t fork(void (*)(void*), const OutStream&, const ErrStream&,
+                     void*);
+    template< class OutStream, class ErrStream >
+    std::size_t spawn(const atf::fs::path&, const argv_array&,
+                      const OutStream&, const ErrStream&);
+
+    std::size_t size(void) const;
+    pid_t pid(const std::size_t) const;
+    bool finished(const std::size_t) const;
+    status get_status(const std::size_t) const;
+    std::string stdout_data(const std::size_t) const;
+    std::string stderr_data(const std::size_t) const;
+
+    void kill(const int);
+    void set_deadline(const int, const int);
+    bool wait_any(const int, std::size_t&);
+    bool wait_all(const int);
+};
+
 // ------------------------------------------------------------------------
 // Free functions.
 // ------------------------------------------------------------------------
@@ -221,6 +278,40 @@ namespace detail {
 void flush_streams(void);
 } // namespace detail
 
+template< class OutStream, class ErrStream >
+std::size_t
+group::fork(void (*start)(void*), const OutStream& outsb,
+            const ErrStream& errsb, void* v)
+{
+    std::size_t index;
+
+    detail::flush_streams();
+    atf_error_t err = atf_process_group_fork(&m_group, start, outsb.get_sb(),
+                                             errsb.get_sb(), v, &index);
+    if (atf_is_error(err))
+        throw_atf_error(err);
+
+    return index;
+}
+
+template< class OutStream, class ErrStream >
+std::size_t
+group::spawn(const atf::fs::path& prog, const argv_array& argv,
+             const OutStream& outsb, const ErrStream& errsb)
+{
+    std::size_t index;
+
+    detail::flush_streams();
+    atf_error_t err = atf_process_group_spawn(&m_group, prog.c_str(),
+                                              argv.exec_argv(),
+                                              outsb.get_sb(), errsb.get_sb(),
+                                              &index);
+    if (atf_is_error(err))
+        throw_atf_error(err);
+
+    return index;
+}
+
 // TODO: The void* cookie can probably be templatized, thus also allowing
 // const data structures.
 template< class OutStream, class ErrStream >
@@ -25,6 +25,7 @@
 
 #include "atf-c++/detail/process.hpp"
 
+#include <csignal>
 #include <cstdlib>
 #include <cstring>
 
@@ -304,6 +305,76 @@ ATF_TEST_CASE_BODY(argv_array_iter)
     }
 }
 
+// ------------------------------------------------------------------------
+// Tests for the "group" type.
+// ------------------------------------------------------------------------
+
+ATF_TEST_CASE(group_spawn);
+ATF_TEST_CASE_HEAD(group_spawn)
+{
+    set_md_var("descr", "Tests waiting for several spawned commands and "
+               "collecting their outputs");
+}
+ATF_TEST_CASE_BODY(group_spawn)
+{
+    const atf::fs::path helpers = get_process_helpers_path(*this, true);
+    atf::process::group g;
+
+    for (int i = 0; i < 3; i++) {
+        const std::string id = std::string("child") + char('0' + i);
+        const std::size_t index = g.spawn(
+            helpers,
+            atf::process::argv_array(helpers.c_str(), "stdout-stderr",
+                                     id.c_str(), NULL),
+            atf::process::stream_capture(), atf::process::stream_capture());
+        ATF_REQUIRE_EQ(std::size_t(i), index);
+    }
+    ATF_REQUIRE_EQ(3, g.size());
+
+    ATF_REQUIRE(g.wait_all(-1));
+    for (std::size_t i = 0; i < g.size(); i++) {
+        ATF_REQUIRE(g.finished(i));
+        const atf::process::status s = g.get_status(i);
+        ATF_REQUIRE(s.exited());
+        ATF_REQUIRE_EQ(EXIT_SUCCESS, s.exitstatus());
+
+        const std::string id = std::string("child") + char('0' + i);
+        ATF_REQUIRE_EQ("Line 1 to stdout for " + id + "\n"
+                       "Line 2 to stdout for " + id + "\n", g.stdout_data(i));
+        ATF_REQUIRE_EQ("Line 1 to stderr for " + id + "\n"
+                       "Line 2 to stderr for " + id + "\n", g.stderr_data(i));
+    }
+
+    std::size_t index;
+    for (std::size_t i = 0; i < g.size(); i++)
+        ATF_REQUIRE(g.wait_any(0, index));
+    ATF_REQUIRE(!g.wait_any(0, index));
+}
+
+ATF_TEST_CASE(group_deadline);
+ATF_TEST_CASE_HEAD(group_deadline)
+{
+    set_md_var("descr", "Tests that the children of a group are killed once "
+               "its deadline passes");
+    set_md_var("timeout", "30");
+}
+ATF_TEST_CASE_BODY(group_deadline)
+{
+    atf::process::group g;
+
+    g.spawn(atf::fs::path("/bin/sh"),
+            atf::process::argv_array("sh", "-c", "sleep 60", NULL),
+            atf::process::stream_inherit(), atf::process::stream_inherit());
+    ATF_REQUIRE(!g.finished(0));
+    ATF_REQUIRE(!g.wait_all(50));
+
+    g.set_deadline(100, SIGKILL);
+    ATF_REQUIRE(g.wait_all(-1));
+    const atf::process::status s = g.get_status(0);
+    ATF_REQUIRE(s.signaled());
+    ATF_REQUIRE_EQ(SIGKILL, s.termsig());
+}
+
 // ------------------------------------------------------------------------
 // Tests cases for the free functions.
 // ------------------------------------------------------------------------
@@ -348,6 +419,10 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, argv_array_init_varargs);
     ATF_ADD_TEST_CASE(tcs, argv_array_iter);
 
+    // Add the test cases for the "group" type.
+    ATF_ADD_TEST_CASE(tcs, group_spawn);
+    ATF_ADD_TEST_CASE(tcs, group_deadline);
+
     // Add the test cases for the free functions.
     ATF_ADD_TEST_CASE(tcs, exec_failure);
     ATF_ADD_TEST_CASE(tcs, exec_success);
@@ -31,8 +31,10 @@ extern "C" {
 
 #include <cctype>
 #include <cstring>
+#include <memory>
 
 extern "C" {
+#include "atf-c/detail/grep.h"
 #include "atf-c/detail/text.h"
 #include "atf-c/error.h"
 }
@@ -50,30 +52,108 @@ impl::duplicate(const char* str)
     return copy;
 }
 
-bool
-impl::match(const std::string& str, const std::string& regex)
+static
+void
+free_regex(::regex_t* preg)
 {
-    bool found;
+    ::regfree(preg);
+    delete preg;
+}
 
+impl::regex::regex(const std::string& source) :
+    m_source(source)
+{
     // Special case: regcomp does not like empty regular expressions.
-    if (regex.empty()) {
-        found = str.empty();
-    } else {
-        ::regex_t preg;
+    if (source.empty())
+        return;
+
+    std::unique_ptr< ::regex_t > preg(new ::regex_t);
+    if (::regcomp(preg.get(), source.c_str(), REG_EXTENDED | REG_NOSUB) != 0)
+        throw std::runtime_error("Invalid regular expression '" + source +
+                                 "'");
+    m_preg.reset(preg.release(), free_regex);
+}
 
-        if (::regcomp(&preg, regex.c_str(), REG_EXTENDED) != 0)
-            throw std::runtime_error("Invalid regular expression '" + regex +
-                                     "'");
+const std::string&
+impl::regex::str(void)
+    const
+{
+    return m_source;
+}
 
-        const int res = ::regexec(&preg, str.c_str(), 0, NULL, 0);
-        regfree(&preg);
-        if (res != 0 && res != REG_NOMATCH)
-            throw std::runtime_error("Invalid regular expression " + regex);
+bool
+impl::regex::matches(const std::string& str)
+    const
+{
+    return matches(str.c_str());
+}
+
+bool
+impl::regex::matches(const char* str)
+    const
+{
+    if (!m_preg)
+        return str[0] == '\0';
+
+    const int res = ::regexec(m_preg.get(), str, 0, NULL, 0);
+    if (res != 0 && res != REG_NOMATCH)
+        throw std::runtime_error("Invalid regular expression " + m_source);
+    return res == 0;
+}
+
+struct impl::regex_set::impl {
+    atf_grep_t m_grep;
+
+    impl(const std::vector< std::string >& regexes)
+    {
+        std::vector< const char* > cregexes;
+        for (std::vector< std::string >::const_iterator iter =
+             regexes.begin(); iter != regexes.end(); ++iter)
+            cregexes.push_back(iter->empty() ? "^$" : iter->c_str());
+
+        atf_error_t err = atf_grep_init(&m_grep, cregexes.data(),
+                                        cregexes.size());
+        if (atf_is_error(err))
+            throw_atf_error(err);
+    }
 
-        found = res == 0;
+    ~impl(void)
+    {
+        atf_grep_fini(&m_grep);
     }
+};
 
-    return found;
+impl::regex_set::regex_set(const std::vector< std::string >& regexes) :
+    m_pimpl(new impl(regexes))
+{
+}
+
+void
+impl::regex_set::scan(const char* data, const std::size_t size)
+{
+    atf_error_t err = atf_grep_scan(&m_pimpl->m_grep, data, size);
+    if (atf_is_error(err))
+        throw_atf_error(err);
+}
+
+bool
+impl::regex_set::matched(const std::size_t i)
+    const
+{
+    return atf_grep_matched(&m_pimpl->m_grep, i);
+}
+
+std::size_t
+impl::regex_set::line(const std::size_t i)
+    const
+{
+    return atf_grep_line(&m_pimpl->m_grep, i);
+}
+
+bool
+impl::match(const std::string& str, const std::string& regex)
+{
+    return impl::regex(regex).matches(str);
 }
 
 std::string
@@ -27,9 +27,12 @@
 #define ATF_CXX_DETAIL_TEXT_HPP
 
 extern "C" {
+#include <regex.h>
 #include <stdint.h>
 }
 
+#include <cstddef>
+#include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -72,6 +75,45 @@ join(const T& words, const std::string& separator)
     return str;
 }
 
+//!
+//! \brief A compiled extended regular expression.
+//!
+//! Compiling an expression is much more expensive than matching it, so
+//! code that checks many strings against the same expression should
+//! build one of these once instead of calling match() for every string.
+//! Copies share the compiled expression.
+//!
+class regex {
+    std::string m_source;
+    std::shared_ptr< ::regex_t > m_preg;
+
+public:
+    explicit regex(const std::string&);
+
+    const std::string& str(void) const;
+    bool matches(const std::string&) const;
+    bool matches(const char*) const;
+};
+
+//!
+//! \brief A set of regular expressions looked for in a text at once.
+//!
+//! Scanning a text records which expressions match any of its lines and
+//! the first line that matched each of them.  An empty expression only
+//! matches empty lines, as in match().
+//!
+class regex_set {
+    struct impl;
+    std::shared_ptr< impl > m_pimpl;
+
+public:
+    explicit regex_set(const std::vector< std::string >&);
+
+    void scan(const char*, const std::size_t);
+    bool matched(const std::size_t) const;
+    std::size_t line(const std::size_t) const;
+};
+
 //!
 //! \brief Checks if the string matches a regular expression.
 //!
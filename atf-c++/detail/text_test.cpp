@@ -155,6 +155,63 @@ ATF_TEST_CASE_BODY(match)
     ATF_REQUIRE(!match("hello", "^ [a-z]+$"));
 }
 
+ATF_TEST_CASE(regex);
+ATF_TEST_CASE_HEAD(regex)
+{
+    set_md_var("descr", "Tests the regex class");
+}
+ATF_TEST_CASE_BODY(regex)
+{
+    using atf::text::regex;
+
+    ATF_REQUIRE_THROW(std::runtime_error, regex("["));
+
+    const regex empty("");
+    ATF_REQUIRE(empty.matches(""));
+    ATF_REQUIRE(!empty.matches("foo"));
+
+    const regex re("^[a-z]+$");
+    ATF_REQUIRE_EQ("^[a-z]+$", re.str());
+    ATF_REQUIRE(re.matches("hello"));
+    ATF_REQUIRE(re.matches("world"));
+    ATF_REQUIRE(!re.matches("hello world"));
+    ATF_REQUIRE(!re.matches(""));
+
+    const regex copy = re;
+    ATF_REQUIRE(copy.matches("hello"));
+    ATF_REQUIRE(!copy.matches("hello5"));
+}
+
+ATF_TEST_CASE(regex_set);
+ATF_TEST_CASE_HEAD(regex_set)
+{
+    set_md_var("descr", "Tests the regex_set class");
+}
+ATF_TEST_CASE_BODY(regex_set)
+{
+    std::vector< std::string > regexes;
+    regexes.push_back("^b");
+    regexes.push_back("");
+    regexes.push_back("missing");
+    regexes.push_back("a+");
+
+    ATF_REQUIRE_THROW(std::runtime_error,
+                      atf::text::regex_set(std::vector< std::string >(
+                          1, "[")));
+
+    atf::text::regex_set set(regexes);
+    const std::string text = "a\nb\n\nc\n";
+    set.scan(text.data(), text.size());
+
+    ATF_REQUIRE(set.matched(0));
+    ATF_REQUIRE_EQ(2, set.line(0));
+    ATF_REQUIRE(set.matched(1));
+    ATF_REQUIRE_EQ(3, set.line(1));
+    ATF_REQUIRE(!set.matched(2));
+    ATF_REQUIRE(set.matched(3));
+    ATF_REQUIRE_EQ(1, set.line(3));
+}
+
 ATF_TEST_CASE(split);
 ATF_TEST_CASE_HEAD(split)
 {
@@ -376,6 +433,8 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, duplicate);
     ATF_ADD_TEST_CASE(tcs, join);
     ATF_ADD_TEST_CASE(tcs, match);
+    ATF_ADD_TEST_CASE(tcs, regex);
+    ATF_ADD_TEST_CASE(tcs, regex_set);
     ATF_ADD_TEST_CASE(tcs, split);
     ATF_ADD_TEST_CASE(tcs, split_delims);
     ATF_ADD_TEST_CASE(tcs, trim);
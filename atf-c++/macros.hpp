@@ -72,6 +72,92 @@
     atfu_tc_ ## name::atfu_tc_ ## name(void) : atf::tests::tc(#name, true) {} \
     }
 
+#if ATF_DEFS_HAVE_TC_SECTION
+#define ATF_TEST_CASE_DESC_REGISTER(name) \
+    const atf::tests::tc_desc* const atfu_tcdescptr_ ## name \
+        __attribute__((__used__, __section__("atf_cxx_tcs"))) = \
+        &atfu_tcdesc_ ## name
+#define ATF_TEST_CASE_DESCS_DECLARE \
+    extern "C" const atf::tests::tc_desc* const __start_atf_cxx_tcs[] \
+        __attribute__((__weak__)); \
+    extern "C" const atf::tests::tc_desc* const __stop_atf_cxx_tcs[] \
+        __attribute__((__weak__))
+#define ATF_TEST_CASE_DESCS_BEGIN __start_atf_cxx_tcs
+#define ATF_TEST_CASE_DESCS_END __stop_atf_cxx_tcs
+#else
+#define ATF_TEST_CASE_DESC_REGISTER(name) \
+    static_assert(false && sizeof(atfu_tcdesc_ ## name), \
+                  "Static test cases are not supported by this toolchain")
+#define ATF_TEST_CASE_DESCS_DECLARE \
+    extern int atfu_no_tc_descs
+#define ATF_TEST_CASE_DESCS_BEGIN nullptr
+#define ATF_TEST_CASE_DESCS_END nullptr
+#endif
+
+#define ATF_TEST_CASE_STATIC_DESC(name, has_cleanup, ...) \
+    namespace { \
+    atf::tests::tc* atfu_tcnew_ ## name(void) \
+    { \
+        return new atfu_tc_ ## name(); \
+    } \
+    const char* const atfu_tcmd_ ## name[] = { \
+        "ident", #name, ##__VA_ARGS__, NULL, NULL }; \
+    static_assert( \
+        (sizeof(atfu_tcmd_ ## name) / sizeof(const char*)) % 2 == 0, \
+        "The metadata of " #name " is not a list of pairs"); \
+    const atf::tests::tc_desc atfu_tcdesc_ ## name = { \
+        #name, atfu_tcmd_ ## name, has_cleanup, atfu_tcnew_ ## name }; \
+    ATF_TEST_CASE_DESC_REGISTER(name); \
+    }
+
+#define ATF_TEST_CASE_STATIC(name, ...) \
+    namespace { \
+    class atfu_tc_ ## name : public atf::tests::tc { \
+        void body(void) const; \
+    public: \
+        atfu_tc_ ## name(void); \
+    }; \
+    atfu_tc_ ## name::atfu_tc_ ## name(void) : atf::tests::tc(#name, false) {} \
+    } \
+    ATF_TEST_CASE_STATIC_DESC(name, false, ##__VA_ARGS__)
+
+#define ATF_TEST_CASE_STATIC_WITH_CLEANUP(name, ...) \
+    namespace { \
+    class atfu_tc_ ## name : public atf::tests::tc { \
+        void body(void) const; \
+        void cleanup(void) const; \
+    public: \
+        atfu_tc_ ## name(void); \
+    }; \
+    atfu_tc_ ## name::atfu_tc_ ## name(void) : atf::tests::tc(#name, true) {} \
+    } \
+    ATF_TEST_CASE_STATIC_DESC(name, true, ##__VA_ARGS__)
+
+#define ATF_BENCHMARK_CASE_WITHOUT_HEAD(name) \
+    namespace { \
+    class atfu_tc_ ## name : public atf::tests::bench { \
+        void bench_body(const std::size_t) const; \
+    public: \
+        atfu_tc_ ## name(void); \
+    }; \
+    static atfu_tc_ ## name* atfu_tcptr_ ## name; \
+    atfu_tc_ ## name::atfu_tc_ ## name(void) : \
+        atf::tests::bench(#name, false) {} \
+    }
+
+#define ATF_BENCHMARK_CASE(name) \
+    namespace { \
+    class atfu_tc_ ## name : public atf::tests::bench { \
+        void head(void); \
+        void bench_body(const std::size_t) const; \
+    public: \
+        atfu_tc_ ## name(void); \
+    }; \
+    static atfu_tc_ ## name* atfu_tcptr_ ## name; \
+    atfu_tc_ ## name::atfu_tc_ ## name(void) : \
+        atf::tests::bench(#name, false) {} \
+    }
+
 #define ATF_TEST_CASE_NAME(name) atfu_tc_ ## name
 #define ATF_TEST_CASE_USE(name) (atfu_tcptr_ ## name) = NULL
 
@@ -84,6 +170,14 @@
     atfu_tc_ ## name::body(void) \
         const
 
+#define ATF_BENCHMARK_CASE_HEAD(name) \
+    ATF_TEST_CASE_HEAD(name)
+
+#define ATF_BENCHMARK_CASE_BODY(name, iterations) \
+    void \
+    atfu_tc_ ## name::bench_body(const std::size_t iterations) \
+        const
+
 #define ATF_TEST_CASE_CLEANUP(name) \
     void \
     atfu_tc_ ## name::cleanup(void) \
@@ -196,20 +290,44 @@
     atf::tests::tc::require_errno(__FILE__, __LINE__, expected_errno, \
                                   #bool_expr, bool_expr)
 
+// The block following these macros runs 'repeat' times and must not be
+// left with break, goto or return.
+#define ATF_TIMED_BLOCK(fatal, msec, repeat) \
+    for (atf::tests::detail::timed_block atfu_timing(__FILE__, __LINE__, \
+             fatal, msec, repeat); \
+         atfu_timing.next(); )
+
+#define ATF_CHECK_WITHIN(msec) \
+    ATF_TIMED_BLOCK(false, msec, 1)
+
+#define ATF_REQUIRE_WITHIN(msec) \
+    ATF_TIMED_BLOCK(true, msec, 1)
+
+#define ATF_CHECK_FASTER_THAN(msec, repeat) \
+    ATF_TIMED_BLOCK(false, msec, repeat)
+
+#define ATF_REQUIRE_FASTER_THAN(msec, repeat) \
+    ATF_TIMED_BLOCK(true, msec, repeat)
+
 #define ATF_INIT_TEST_CASES(tcs) \
     namespace atf { \
         namespace tests { \
-            int run_tp(int, char**, \
-                       void (*)(std::vector< atf::tests::tc * >&)); \
+            int run_tp_descs(int, char**, \
+                             void (*)(std::vector< atf::tests::tc * >&), \
+                             const atf::tests::tc_desc* const*, \
+                             const atf::tests::tc_desc* const*); \
         } \
     } \
+    ATF_TEST_CASE_DESCS_DECLARE; \
     \
     static void atfu_init_tcs(std::vector< atf::tests::tc * >&); \
     \
     int \
     main(int argc, char** argv) \
     { \
-        return atf::tests::run_tp(argc, argv, atfu_init_tcs); \
+        return atf::tests::run_tp_descs(argc, argv, atfu_init_tcs, \
+                                        ATF_TEST_CASE_DESCS_BEGIN, \
+                                        ATF_TEST_CASE_DESCS_END); \
     } \
     \
     static \
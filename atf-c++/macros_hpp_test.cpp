@@ -93,6 +93,27 @@ atf_require_errno_semicolons(void)
     ATF_REQUIRE_ERRNO(2, 2 == 2);
 }
 
+void
+atf_timing_inside_if(void)
+{
+    // Make sure that the timing macros can be used inside an if statement
+    // that does not have braces and that they accept a single statement as
+    // well as a block.
+    if (true)
+        ATF_CHECK_WITHIN(10) {
+        }
+    else
+        ATF_REQUIRE_WITHIN(10)
+            ATF_REQUIRE(true);
+
+    if (true)
+        ATF_CHECK_FASTER_THAN(10, 3)
+            ATF_REQUIRE(true);
+    else
+        ATF_REQUIRE_FASTER_THAN(10, 3) {
+        }
+}
+
 // Test case names should not be expanded during instatiation so that they
 // can have the exact same name as macros.
 #define TEST_MACRO_1 invalid + name
@@ -277,6 +277,31 @@ ATF_TEST_CASE_BODY(h_require_errno)
     create_ctl_file("after");
 }
 
+ATF_TEST_CASE(h_timing);
+ATF_TEST_CASE_HEAD(h_timing)
+{
+    set_md_var("descr", "Helper test case");
+}
+ATF_TEST_CASE_BODY(h_timing)
+{
+    create_ctl_file("before");
+
+    if (get_config_var("what") == "check_within_pass")
+        ATF_CHECK_WITHIN(10000) { ::usleep(1000); }
+    else if (get_config_var("what") == "check_within_fail")
+        ATF_CHECK_WITHIN(10) { ::usleep(50000); }
+    else if (get_config_var("what") == "require_within_fail")
+        ATF_REQUIRE_WITHIN(10) { ::usleep(50000); }
+    else if (get_config_var("what") == "require_faster_than_pass")
+        ATF_REQUIRE_FASTER_THAN(10000, 3) { ::usleep(1000); }
+    else if (get_config_var("what") == "check_faster_than_fail")
+        ATF_CHECK_FASTER_THAN(10, 3) { ::usleep(50000); }
+    else
+        UNREACHABLE;
+
+    create_ctl_file("after");
+}
+
 // ------------------------------------------------------------------------
 // Test cases for the macros.
 // ------------------------------------------------------------------------
@@ -751,6 +776,65 @@ ATF_TEST_CASE_BODY(require_errno)
     }
 }
 
+ATF_TEST_CASE(timing);
+ATF_TEST_CASE_HEAD(timing)
+{
+    set_md_var("descr", "Tests the ATF_CHECK_WITHIN, ATF_REQUIRE_WITHIN, "
+               "ATF_CHECK_FASTER_THAN and ATF_REQUIRE_FASTER_THAN macros");
+}
+ATF_TEST_CASE_BODY(timing)
+{
+    struct test {
+        const char *what;
+        bool fatal;
+        bool ok;
+        const char *msg;
+    } *t, tests[] = {
+        { "check_within_pass", false, true, NULL },
+        { "check_within_fail", false, false,
+          "Timed block took [0-9.]+ms, exceeding its budget of 10ms" },
+        { "require_within_fail", true, false,
+          "Timed block took [0-9.]+ms, exceeding its budget of 10ms" },
+        { "require_faster_than_pass", true, true, NULL },
+        { "check_faster_than_fail", false, false,
+          "Timed block took [0-9.]+ms \\(median of 3 runs; min [0-9.]+ms, "
+          "max [0-9.]+ms\\), exceeding its budget of 10ms" },
+        { NULL, false, false, NULL }
+    };
+
+    const atf::fs::path before("before");
+    const atf::fs::path after("after");
+
+    for (t = &tests[0]; t->what != NULL; t++) {
+        atf::tests::vars_map config;
+        config["what"] = t->what;
+
+        ATF_TEST_CASE_USE(h_timing);
+        run_h_tc< ATF_TEST_CASE_NAME(h_timing) >(config);
+
+        ATF_REQUIRE(atf::fs::exists(before));
+        if (t->ok) {
+            ATF_REQUIRE(atf::utils::grep_file("^passed", "result"));
+            ATF_REQUIRE(atf::fs::exists(after));
+        } else if (t->fatal) {
+            std::string exp_result = "^failed: .*macros_test.cpp:[0-9]+: " +
+                std::string(t->msg) + "$";
+            ATF_REQUIRE(atf::utils::grep_file(exp_result.c_str(), "result"));
+            ATF_REQUIRE(!atf::fs::exists(after));
+        } else {
+            ATF_REQUIRE(atf::utils::grep_file("^failed", "result"));
+            std::string exp_error = "macros_test.cpp:[0-9]+: " +
+                std::string(t->msg) + "$";
+            ATF_REQUIRE(atf::utils::grep_file(exp_error.c_str(), "stderr"));
+            ATF_REQUIRE(atf::fs::exists(after));
+        }
+
+        atf::fs::remove(before);
+        if (atf::fs::exists(after))
+            atf::fs::remove(after);
+    }
+}
+
 // ------------------------------------------------------------------------
 // Tests cases for the header file.
 // ------------------------------------------------------------------------
@@ -804,6 +888,7 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, require_throw);
     ATF_ADD_TEST_CASE(tcs, require_throw_re);
     ATF_ADD_TEST_CASE(tcs, require_errno);
+    ATF_ADD_TEST_CASE(tcs, timing);
 
     // Add the test cases for the header file.
     ATF_ADD_TEST_CASE(tcs, use);
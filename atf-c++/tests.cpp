@@ -41,17 +41,25 @@ extern "C" {
 #include <algorithm>
 #include <cctype>
 #include <cerrno>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <map>
 #include <memory>
 #include <sstream>
 #include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 extern "C" {
+#include "atf-c/detail/batch.h"
+#include "atf-c/detail/server.h"
+#include "atf-c/detail/shared_config.h"
+#include "atf-c/detail/tp_list.h"
 #include "atf-c/error.h"
 #include "atf-c/tc.h"
 #include "atf-c/utils.h"
@@ -112,6 +120,29 @@ detail::atf_tp_writer::tc_meta_data(const std::string& name,
     m_os.flush();
 }
 
+// ------------------------------------------------------------------------
+// The "timed_block" class.
+// ------------------------------------------------------------------------
+
+detail::timed_block::timed_block(const char* file, const std::size_t line,
+                                 const bool fatal, const long budget_msec,
+                                 const std::size_t repeat) :
+    m_timing(new atf_tc_timing_t(atf_tc_timing_start(file, line, fatal,
+                                                     budget_msec, repeat)))
+{
+}
+
+detail::timed_block::~timed_block(void)
+{
+    std::free(m_timing->m_samples);
+}
+
+bool
+detail::timed_block::next(void)
+{
+    return atf_tc_timing_next(m_timing.get());
+}
+
 // ------------------------------------------------------------------------
 // Free helper functions.
 // ------------------------------------------------------------------------
@@ -144,6 +175,35 @@ detail::match(const std::string& regexp, const std::string& str)
 static std::map< atf_tc_t*, impl::tc* > wraps;
 static std::map< const atf_tc_t*, const impl::tc* > cwraps;
 
+// Flattens the configuration variables into the NULL-terminated array of
+// name/value pairs used by the C library.  The array points into 'config'.
+static std::vector< const char * >
+config_array(const impl::vars_map& config)
+{
+    std::vector< const char * > array;
+    array.reserve((config.size() * 2) + 1);
+
+    for (impl::vars_map::const_iterator iter = config.begin();
+         iter != config.end(); iter++) {
+         array.push_back((*iter).first.c_str());
+         array.push_back((*iter).second.c_str());
+    }
+    array.push_back(nullptr);
+    return array;
+}
+
+static atf_shared_config_t*
+new_shared_config(const impl::vars_map& config)
+{
+    const std::vector< const char * > array = config_array(config);
+
+    atf_shared_config_t* shared;
+    atf_error_t err = atf_shared_config_new(&shared, array.data());
+    if (atf_is_error(err))
+        atf::throw_atf_error(err);
+    return shared;
+}
+
 struct impl::tc_impl {
 private:
     // Non-copyable.
@@ -154,11 +214,48 @@ public:
     std::string m_ident;
     atf_tc_t m_tc;
     bool m_has_cleanup;
+    const char* const* m_static_md;
 
     tc_impl(const std::string& ident, const bool has_cleanup) :
         m_ident(ident),
-        m_has_cleanup(has_cleanup)
+        m_has_cleanup(has_cleanup),
+        m_static_md(NULL)
+    {
+    }
+
+    static const atf_tc_t*
+    c_tc(const impl::tc* tc)
+    {
+        return &tc->pimpl->m_tc;
+    }
+
+    static void
+    init(impl::tc* tc, atf_shared_config_t* config)
+    {
+        tc_impl* pimpl = tc->pimpl.get();
+
+        wraps[&pimpl->m_tc] = tc;
+        cwraps[&pimpl->m_tc] = tc;
+
+        atf_error_t err = atf_tc_init_config(&pimpl->m_tc,
+            pimpl->m_ident.c_str(), pimpl->wrap_head, pimpl->wrap_body,
+            pimpl->m_has_cleanup ? pimpl->wrap_cleanup : NULL, config);
+        if (atf_is_error(err))
+            throw_atf_error(err);
+
+        if (pimpl->m_static_md != NULL) {
+            for (const char* const* ptr = pimpl->m_static_md + 2;
+                 *ptr != NULL; ptr += 2)
+                tc->set_md_var(*ptr, *(ptr + 1));
+        }
+    }
+
+    static impl::tc*
+    new_static(const impl::tc_desc* desc)
     {
+        impl::tc* tc = desc->m_new();
+        tc->pimpl->m_static_md = desc->m_md;
+        return tc;
     }
 
     static void
@@ -167,6 +264,9 @@ public:
         std::map< atf_tc_t*, impl::tc* >::iterator iter = wraps.find(tc);
         INV(iter != wraps.end());
         (*iter).second->head();
+
+        if (dynamic_cast< const impl::bench* >((*iter).second) != NULL)
+            atf_tc_mark_as_bench(tc);
     }
 
     static void
@@ -178,6 +278,18 @@ public:
         (*iter).second->body();
     }
 
+    static void
+    wrap_bench(const atf_tc_t *tc, const size_t iterations)
+    {
+        std::map< const atf_tc_t*, const impl::tc* >::const_iterator iter =
+            cwraps.find(tc);
+        INV(iter != cwraps.end());
+        const impl::bench* b = dynamic_cast< const impl::bench* >(
+            (*iter).second);
+        INV(b != NULL);
+        b->bench_body(iterations);
+    }
+
     static void
     wrap_cleanup(const atf_tc_t *tc)
     {
@@ -204,26 +316,21 @@ impl::tc::~tc(void)
 void
 impl::tc::init(const vars_map& config)
 {
-    atf_error_t err;
-
-    std::vector< const char * > array;
-    array.reserve((config.size() * 2) + 1);
-
-    for (vars_map::const_iterator iter = config.begin();
-         iter != config.end(); iter++) {
-         array.push_back((*iter).first.c_str());
-         array.push_back((*iter).second.c_str());
+    atf_shared_config_t* shared = new_shared_config(config);
+    try {
+        tc_impl::init(this, shared);
+    } catch (...) {
+        atf_shared_config_unref(shared);
+        throw;
     }
-    array.push_back(nullptr);
-
-    wraps[&pimpl->m_tc] = this;
-    cwraps[&pimpl->m_tc] = this;
+    atf_shared_config_unref(shared);
+}
 
-    err = atf_tc_init(&pimpl->m_tc, pimpl->m_ident.c_str(), pimpl->wrap_head,
-        pimpl->wrap_body, pimpl->m_has_cleanup ? pimpl->wrap_cleanup : NULL,
-        array.data());
-    if (atf_is_error(err))
-        throw_atf_error(err);
+const std::string
+impl::tc::get_ident(void)
+    const
+{
+    return pimpl->m_ident;
 }
 
 bool
@@ -399,6 +506,26 @@ impl::tc::expect_timeout(const std::string& reason)
     atf_tc_expect_timeout("%s", reason.c_str());
 }
 
+// ------------------------------------------------------------------------
+// The "bench" class.
+// ------------------------------------------------------------------------
+
+impl::bench::bench(const std::string& ident, const bool has_cleanup) :
+    tc(ident, has_cleanup)
+{
+}
+
+impl::bench::~bench(void)
+{
+}
+
+void
+impl::bench::body(void)
+    const
+{
+    atf_tc_run_bench(tc_impl::c_tc(this), tc_impl::wrap_bench);
+}
+
 // ------------------------------------------------------------------------
 // Test program main code.
 // ------------------------------------------------------------------------
@@ -406,6 +533,9 @@ impl::tc::expect_timeout(const std::string& reason)
 namespace {
 
 typedef std::vector< impl::tc * > tc_vector;
+typedef std::unordered_map< std::string, impl::tc * > tc_index;
+typedef std::pair< const impl::tc_desc* const*, const impl::tc_desc* const* >
+    tc_descs;
 
 enum tc_part { BODY, CLEANUP };
 
@@ -449,58 +579,201 @@ handle_srcdir(const char* argv0, const std::string& srcdir_arg)
     return srcdir;
 }
 
+// Instantiates the test cases registered at compile time whose identifiers
+// are in 'names', or all of them if 'names' is empty.  Test cases that were
+// also registered at run time are skipped.
 static void
-init_tcs(void (*add_tcs)(tc_vector&), tc_vector& tcs,
-         const atf::tests::vars_map& vars)
+add_desc_tcs(tc_vector& tcs, const tc_descs& descs,
+             const std::vector< std::string >& names)
 {
-    add_tcs(tcs);
-    for (tc_vector::iterator iter = tcs.begin(); iter != tcs.end(); iter++) {
-        impl::tc* tc = *iter;
+    std::unordered_set< std::string > idents;
+    for (tc_vector::const_iterator iter = tcs.begin(); iter != tcs.end();
+         iter++)
+        idents.insert((*iter)->get_ident());
+
+    for (const impl::tc_desc* const* iter = descs.first;
+         iter != descs.second; iter++) {
+        const impl::tc_desc* desc = *iter;
+
+        if (!names.empty() && std::find(names.begin(), names.end(),
+                                        desc->m_ident) == names.end())
+            continue;
+        if (idents.find(desc->m_ident) != idents.end())
+            continue;
+
+        tcs.push_back(impl::tc_impl::new_static(desc));
+    }
+}
+
+static void
+init_tcs(tc_vector& tcs, const atf::tests::vars_map& vars)
+{
+    atf_shared_config_t* shared = new_shared_config(vars);
+    try {
+        for (tc_vector::iterator iter = tcs.begin(); iter != tcs.end();
+             iter++) {
+            impl::tc* tc = *iter;
 
-        tc->init(vars);
+            impl::tc_impl::init(tc, shared);
+        }
+    } catch (...) {
+        atf_shared_config_unref(shared);
+        throw;
     }
+    atf_shared_config_unref(shared);
 }
 
-static int
-list_tcs(const tc_vector& tcs)
+// The test cases registered at compile time are listed straight from their
+// descriptors, without instantiating them, unless a test case with the same
+// name was registered at run time, which takes precedence as it does when
+// running it.
+static void
+build_list(atf_tp_list_t* list, const tc_vector& tcs, const tc_descs& descs)
 {
-    detail::atf_tp_writer writer(std::cout);
+    atf_error_t err = atf_no_error();
+    std::unordered_set< std::string > idents;
 
     for (tc_vector::const_iterator iter = tcs.begin();
-         iter != tcs.end(); iter++) {
+         !atf_is_error(err) && iter != tcs.end(); iter++) {
         const impl::vars_map vars = (*iter)->get_md_vars();
 
-        {
-            impl::vars_map::const_iterator iter2 = vars.find("ident");
-            INV(iter2 != vars.end());
-            writer.start_tc((*iter2).second);
-        }
+        idents.insert((*iter)->get_ident());
 
+        err = atf_tp_list_start_tc(list, (*iter)->get_ident().c_str());
         for (impl::vars_map::const_iterator iter2 = vars.begin();
-             iter2 != vars.end(); iter2++) {
+             !atf_is_error(err) && iter2 != vars.end(); iter2++) {
             const std::string& key = (*iter2).first;
             if (key != "ident")
-                writer.tc_meta_data(key, (*iter2).second);
+                err = atf_tp_list_tc_md(list, key.c_str(),
+                                        (*iter2).second.c_str());
         }
+        if (!atf_is_error(err))
+            err = atf_tp_list_end_tc(list);
+    }
+
+    for (const impl::tc_desc* const* iter = descs.first;
+         !atf_is_error(err) && iter != descs.second; iter++) {
+        const impl::tc_desc* desc = *iter;
+
+        if (idents.find(desc->m_ident) != idents.end())
+            continue;
+
+        err = atf_tp_list_start_tc(list, desc->m_ident);
+        if (!atf_is_error(err) && desc->m_has_cleanup)
+            err = atf_tp_list_tc_md(list, "has.cleanup", "true");
+        for (const char* const* ptr = desc->m_md + 2;
+             !atf_is_error(err) && *ptr != NULL; ptr += 2)
+            err = atf_tp_list_tc_md(list, *ptr, *(ptr + 1));
+        if (!atf_is_error(err))
+            err = atf_tp_list_end_tc(list);
+    }
 
-        writer.end_tc();
+    if (!atf_is_error(err))
+        err = atf_tp_list_finish(list);
+    if (atf_is_error(err))
+        atf::throw_atf_error(err);
+}
+
+static int
+list_tcs(const tc_vector& tcs, const tc_descs& descs,
+         const atf_tp_list_format format, const char* cachefile,
+         const char* binary, const atf::tests::vars_map& vars)
+{
+    atf_tp_list_t list;
+    atf_error_t err = atf_tp_list_init(&list, format);
+    if (atf_is_error(err))
+        atf::throw_atf_error(err);
+
+    try {
+        build_list(&list, tcs, descs);
+    } catch (...) {
+        atf_tp_list_fini(&list);
+        throw;
     }
 
+    std::cout.flush();
+    err = atf_tp_list_write(&list, stdout);
+    if (!atf_is_error(err) && cachefile != NULL) {
+        atf_error_t err2 = atf_tp_list_cache_store(&list, cachefile, binary,
+                                                   config_array(vars).data());
+        if (atf_is_error(err2)) {
+            char buf[4096];
+            atf_error_format(err2, buf, sizeof(buf));
+            atf_error_free(err2);
+            std::cerr << Program_Name << ": WARNING: " << buf << "\n";
+        }
+    }
+    atf_tp_list_fini(&list);
+
+    if (atf_is_error(err))
+        atf::throw_atf_error(err);
     return EXIT_SUCCESS;
 }
 
-static impl::tc*
-find_tc(tc_vector tcs, const std::string& name)
+// Indexes the test cases by their identifier for repeated lookups.  If
+// several test cases share an identifier, the first one wins, as it does
+// with a single lookup.
+static tc_index
+index_tcs(const tc_vector& tcs)
 {
-    std::vector< std::string > ids;
-    for (tc_vector::iterator iter = tcs.begin();
+    tc_index index;
+    index.reserve(tcs.size());
+    for (tc_vector::const_iterator iter = tcs.begin();
          iter != tcs.end(); iter++) {
         impl::tc* tc = *iter;
 
-        if (tc->get_md_var("ident") == name)
-            return tc;
+        index.insert(tc_index::value_type(tc->get_ident(), tc));
+    }
+    return index;
+}
+
+static impl::tc*
+find_tc(const tc_index& index, const std::string& name)
+{
+    const tc_index::const_iterator iter = index.find(name);
+    if (iter == index.end())
+        throw usage_error("Unknown test case `%s'", name.c_str());
+    return (*iter).second;
+}
+
+struct ident_is {
+    const std::string& m_name;
+
+    ident_is(const std::string& name) : m_name(name) {}
+
+    bool
+    operator()(const impl::tc* tc)
+        const
+    {
+        return tc->get_ident() == m_name;
+    }
+};
+
+// Looks up a single test case, which is cheaper with a scan than by
+// building an index first.
+static impl::tc*
+find_tc(const tc_vector& tcs, const std::string& name)
+{
+    const tc_vector::const_iterator iter = std::find_if(tcs.begin(),
+                                                        tcs.end(),
+                                                        ident_is(name));
+    if (iter == tcs.end())
+        throw usage_error("Unknown test case `%s'", name.c_str());
+    return *iter;
+}
+
+static void
+warn_if_unsupervised(void)
+{
+    if (!atf::env::has("__RUNNING_INSIDE_ATF_RUN") || atf::env::get(
+        "__RUNNING_INSIDE_ATF_RUN") != "internal-yes-value")
+    {
+        std::cerr << Program_Name << ": WARNING: Running test cases outside "
+            "of kyua(1) is unsupported\n";
+        std::cerr << Program_Name << ": WARNING: No isolation nor timeout "
+            "control is being applied; you may get unexpected failures; see "
+            "atf-test-case(4)\n";
     }
-    throw usage_error("Unknown test case `%s'", name.c_str());
 }
 
 static std::pair< std::string, tc_part >
@@ -530,15 +803,7 @@ run_tc(tc_vector& tcs, const std::string& tcarg, const atf::fs::path& resfile)
 
     impl::tc* tc = find_tc(tcs, fields.first);
 
-    if (!atf::env::has("__RUNNING_INSIDE_ATF_RUN") || atf::env::get(
-        "__RUNNING_INSIDE_ATF_RUN") != "internal-yes-value")
-    {
-        std::cerr << Program_Name << ": WARNING: Running test cases outside "
-            "of kyua(1) is unsupported\n";
-        std::cerr << Program_Name << ": WARNING: No isolation nor timeout "
-            "control is being applied; you may get unexpected failures; see "
-            "atf-test-case(4)\n";
-    }
+    warn_if_unsupervised();
 
     switch (fields.second) {
     case BODY:
@@ -554,12 +819,83 @@ run_tc(tc_vector& tcs, const std::string& tcarg, const atf::fs::path& resfile)
 }
 
 static int
-safe_main(int argc, char** argv, void (*add_tcs)(tc_vector&))
+run_batch(tc_vector& tcs, const int argc, char* const* argv,
+          const atf::fs::path& resdir, const unsigned int jobs)
+{
+    std::vector< const atf_tc_t* > c_tcs;
+
+    if (argc == 1 && std::strcmp(argv[0], "all") == 0) {
+        for (tc_vector::const_iterator iter = tcs.begin();
+             iter != tcs.end(); iter++)
+            c_tcs.push_back(impl::tc_impl::c_tc(*iter));
+    } else {
+        const tc_index index = index_tcs(tcs);
+        for (int i = 0; i < argc; i++) {
+            const std::string tcname = argv[i];
+            if (tcname.find(':') != std::string::npos)
+                throw usage_error("Cannot select a test case part in batch "
+                                  "mode (`%s')", tcname.c_str());
+            c_tcs.push_back(impl::tc_impl::c_tc(find_tc(index, tcname)));
+        }
+    }
+    c_tcs.push_back(NULL);
+
+    warn_if_unsupervised();
+
+    bool success;
+    atf_error_t err = atf_batch_run(c_tcs.data(), resdir.c_path(), jobs,
+                                    &success);
+    if (atf_is_error(err))
+        atf::throw_atf_error(err);
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int
+run_server(tc_vector& tcs)
+{
+    std::vector< const atf_tc_t* > c_tcs;
+
+    for (tc_vector::const_iterator iter = tcs.begin(); iter != tcs.end();
+         iter++)
+        c_tcs.push_back(impl::tc_impl::c_tc(*iter));
+    c_tcs.push_back(NULL);
+
+    warn_if_unsupervised();
+
+    atf_error_t err = atf_server_run(c_tcs.data(), stdin, stdout);
+    if (atf_is_error(err))
+        atf::throw_atf_error(err);
+    return EXIT_SUCCESS;
+}
+
+static unsigned int
+parse_jflag(const std::string& str)
+{
+    try {
+        const long jobs = atf::text::to_type< long >(str);
+        if (jobs > 0 && jobs <= std::numeric_limits< unsigned int >::max() / 2)
+            return static_cast< unsigned int >(jobs);
+    } catch (const std::runtime_error&) {
+    }
+    throw usage_error("-j requires a positive integer; got `%s'", str.c_str());
+}
+
+static int
+safe_main(int argc, char** argv, void (*add_tcs)(tc_vector&),
+          const tc_descs& descs)
 {
     const char* argv0 = argv[0];
 
     bool lflag = false;
+    bool Fflag = false;
+    atf_tp_list_format list_format = atf_tp_list_atf;
+    const char* cachefile = NULL;
+    bool rflag = false;
+    bool sflag = false;
     atf::fs::path resfile("/dev/stdout");
+    std::string resdir_arg;
+    bool jflag = false;
+    unsigned int jobs = 1;
     std::string srcdir_arg;
     atf::tests::vars_map vars;
 
@@ -568,14 +904,40 @@ safe_main(int argc, char** argv, void (*add_tcs)(tc_vector&))
 
     old_opterr = opterr;
     ::opterr = 0;
-    while ((ch = ::getopt(argc, argv, GETOPT_POSIX ":lr:s:v:")) != -1) {
+    while ((ch = ::getopt(argc, argv, GETOPT_POSIX ":C:F:j:lR:r:Ss:v:")) != -1) {
         switch (ch) {
+        case 'C':
+            cachefile = ::optarg;
+            break;
+
+        case 'F':
+            if (!atf_tp_list_parse_format(::optarg, &list_format))
+                throw usage_error("Unknown listing format `%s'", ::optarg);
+            Fflag = true;
+            break;
+
+        case 'j':
+            jobs = parse_jflag(::optarg);
+            jflag = true;
+            break;
+
         case 'l':
             lflag = true;
             break;
 
+        case 'R':
+            if (*::optarg == '\0')
+                throw usage_error("-R requires a non-empty argument");
+            resdir_arg = ::optarg;
+            break;
+
         case 'r':
             resfile = atf::fs::path(::optarg);
+            rflag = true;
+            break;
+
+        case 'S':
+            sflag = true;
             break;
 
         case 's':
@@ -609,13 +971,61 @@ safe_main(int argc, char** argv, void (*add_tcs)(tc_vector&))
 
     int errcode;
 
+    if (jflag && resdir_arg.empty())
+        throw usage_error("Cannot provide -j without -R");
+    if (Fflag && !lflag)
+        throw usage_error("Cannot provide -F without -l");
+    if (cachefile != NULL && !lflag)
+        throw usage_error("Cannot provide -C without -l");
+
     tc_vector tcs;
     if (lflag) {
         if (argc > 0)
             throw usage_error("Cannot provide test case names with -l");
-
-        init_tcs(add_tcs, tcs, vars);
-        errcode = list_tcs(tcs);
+        if (!resdir_arg.empty())
+            throw usage_error("Cannot provide -R with -l");
+        if (sflag)
+            throw usage_error("Cannot provide -S with -l");
+
+        const char* binary = atf_tp_list_cache_binary(argv0);
+        if (cachefile != NULL &&
+            atf_tp_list_cache_load(cachefile, binary,
+                                   config_array(vars).data(), list_format,
+                                   stdout))
+            return EXIT_SUCCESS;
+
+        add_tcs(tcs);
+        init_tcs(tcs, vars);
+        errcode = list_tcs(tcs, descs, list_format, cachefile, binary, vars);
+    } else if (sflag) {
+        if (argc > 0)
+            throw usage_error("Cannot provide test case names with -S");
+        if (!resdir_arg.empty())
+            throw usage_error("Cannot provide -R with -S");
+        if (rflag)
+            throw usage_error("Cannot provide -r with -S; each request names "
+                              "its own results file");
+
+        add_tcs(tcs);
+        add_desc_tcs(tcs, descs, std::vector< std::string >());
+        init_tcs(tcs, vars);
+        errcode = run_server(tcs);
+    } else if (!resdir_arg.empty()) {
+        if (argc == 0)
+            throw usage_error("Must provide at least one test case name or "
+                              "`all'");
+        if (rflag)
+            throw usage_error("Cannot provide -r with -R; results are stored "
+                              "in the results directory");
+
+        std::vector< std::string > names;
+        if (argc != 1 || std::strcmp(argv[0], "all") != 0)
+            names.assign(argv, argv + argc);
+
+        add_tcs(tcs);
+        add_desc_tcs(tcs, descs, names);
+        init_tcs(tcs, vars);
+        errcode = run_batch(tcs, argc, argv, atf::fs::path(resdir_arg), jobs);
     } else {
         if (argc == 0)
             throw usage_error("Must provide a test case name");
@@ -623,7 +1033,10 @@ safe_main(int argc, char** argv, void (*add_tcs)(tc_vector&))
             throw usage_error("Cannot provide more than one test case name");
         INV(argc == 1);
 
-        init_tcs(add_tcs, tcs, vars);
+        add_tcs(tcs);
+        add_desc_tcs(tcs, descs, std::vector< std::string >(
+            1, process_tcarg(argv[0]).first));
+        init_tcs(tcs, vars);
         errcode = run_tc(tcs, argv[0], resfile);
     }
     for (tc_vector::iterator iter = tcs.begin(); iter != tcs.end(); iter++) {
@@ -640,15 +1053,26 @@ safe_main(int argc, char** argv, void (*add_tcs)(tc_vector&))
 namespace atf {
     namespace tests {
         int run_tp(int, char**, void (*)(tc_vector&));
+        int run_tp_descs(int, char**, void (*)(tc_vector&),
+                         const tc_desc* const*, const tc_desc* const*);
     }
 }
 
 int
 impl::run_tp(int argc, char** argv, void (*add_tcs)(tc_vector&))
+{
+    return run_tp_descs(argc, argv, add_tcs, NULL, NULL);
+}
+
+int
+impl::run_tp_descs(int argc, char** argv, void (*add_tcs)(tc_vector&),
+                   const tc_desc* const* descs_begin,
+                   const tc_desc* const* descs_end)
 {
     try {
         set_program_name(argv[0]);
-        return ::safe_main(argc, argv, add_tcs);
+        return ::safe_main(argc, argv, add_tcs,
+                           tc_descs(descs_begin, descs_end));
     } catch (const usage_error& e) {
         std::cerr
             << Program_Name << ": ERROR: " << e.what() << '\n'
@@ -26,6 +26,7 @@
 #if !defined(ATF_CXX_TESTS_HPP)
 #define ATF_CXX_TESTS_HPP
 
+#include <cstddef>
 #include <map>
 #include <memory>
 #include <string>
@@ -34,6 +35,8 @@ extern "C" {
 #include <atf-c/defs.h>
 }
 
+struct atf_tc_timing;
+
 namespace atf {
 namespace tests {
 
@@ -54,6 +57,18 @@ public:
 
 bool match(const std::string&, const std::string&);
 
+// Measures the block of a timing assertion; internal to macros.hpp.
+class timed_block {
+    std::unique_ptr< ::atf_tc_timing > m_timing;
+
+public:
+    timed_block(const char*, const std::size_t, const bool, const long,
+                const std::size_t);
+    ~timed_block(void);
+
+    bool next(void);
+};
+
 } // namespace
 
 // ------------------------------------------------------------------------
@@ -90,6 +105,7 @@ public:
 
     void init(const vars_map&);
 
+    const std::string get_ident(void) const;
     const std::string get_config_var(const std::string&) const;
     const std::string get_config_var(const std::string&, const std::string&)
         const;
@@ -119,6 +135,39 @@ public:
     static void expect_timeout(const std::string&);
 };
 
+// ------------------------------------------------------------------------
+// The "bench" class.
+// ------------------------------------------------------------------------
+
+// A test case that measures the performance of its bench_body, which must
+// run the code under test the given number of times.
+class bench : public tc {
+    void body(void) const;
+
+protected:
+    virtual void bench_body(const std::size_t) const = 0;
+
+    friend struct tc_impl;
+
+public:
+    bench(const std::string&, const bool);
+    virtual ~bench(void);
+};
+
+// ------------------------------------------------------------------------
+// The "tc_desc" type.
+// ------------------------------------------------------------------------
+
+// For static initialization only; see the ATF_TEST_CASE_STATIC macros.
+// The metadata is a list of name/value pairs starting with "ident" and
+// ending with two null pointers.
+struct tc_desc {
+    const char* m_ident;
+    const char* const* m_md;
+    bool m_has_cleanup;
+    tc* (*m_new)(void);
+};
+
 } // namespace tests
 } // namespace atf
 
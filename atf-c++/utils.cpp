@@ -25,12 +25,147 @@
 
 #include "atf-c++/utils.hpp"
 
+extern "C" {
+#include <regex.h>
+#include <time.h>
+}
+
 extern "C" {
 #include "atf-c/utils.h"
 }
 
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
+#include <iomanip>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+#include "atf-c++/detail/sanity.hpp"
+#include "atf-c++/tests.hpp"
+
+struct complexity_model {
+    const char* name;
+    double (*scale)(const double);
+};
+
+static double scale_1(const double) { return 1.0; }
+static double scale_log_n(const double n) { return std::log2(n); }
+static double scale_n(const double n) { return n; }
+static double scale_n_log_n(const double n) { return n * std::log2(n); }
+static double scale_n_squared(const double n) { return n * n; }
+
+// Indexed by atf::utils::complexity.
+static const complexity_model complexity_models[] = {
+    { "O(1)", scale_1 },
+    { "O(log n)", scale_log_n },
+    { "O(n)", scale_n },
+    { "O(n log n)", scale_n_log_n },
+    { "O(n^2)", scale_n_squared },
+};
+
+// Every size is timed this many times, in rounds that go over all the
+// sizes so that a burst of noise does not distort a single size, and the
+// fastest time is kept.
+static const int complexity_rounds = 10;
+
+// Sizes that are too small for the clock are repeated for this long.
+static const double complexity_min_run_ns = 1e6;
+
+// Sizes stop growing once a single call takes longer than this.
+static const double complexity_max_call_ns = 1e9;
+
+// A class is only considered a better fit than a lower one if its residual
+// error is this many times smaller.  Noisy measurements fit the higher
+// classes a bit better than the lower ones by chance.
+static const double complexity_fit_margin = 1.5;
+
+// If even the best fit has a larger residual error than this, the times
+// are too noisy to tell the classes apart.
+static const double complexity_max_rms = 0.25;
+
+//
+// Returns the CPU time consumed by the process so far, in nanoseconds.
+// CPU time, unlike wall time, does not grow when other processes compete
+// for the CPU.
+//
+static
+double
+cpu_time_ns(void)
+{
+    struct ::timespec ts;
+
+    if (::clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) == -1)
+        UNREACHABLE;
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static double (*complexity_clock)(void) = cpu_time_ns;
+
+//
+// Returns the time taken by a single call to the body, in nanoseconds.
+//
+static
+double
+time_call(const std::function< void (const std::size_t) >& body,
+          const std::size_t n)
+{
+    // Doubles the number of calls between clock reads until they take long
+    // enough, so that reading the clock does not add to the time of a call.
+    for (std::size_t calls = 1; ; calls *= 2) {
+        const double start = complexity_clock();
+        for (std::size_t i = 0; i < calls; i++)
+            body(n);
+        const double elapsed = complexity_clock() - start;
+        if (elapsed >= complexity_min_run_ns)
+            return elapsed / calls;
+    }
+}
+
+//
+// Fits time = a + b * scale(n) by least squares on the relative error of
+// each point, so that the small sizes weigh as much as the large ones.
+// Returns false if the fit needs a negative b, which means the model does
+// not describe growing times at all.
+//
+static
+bool
+fit(const complexity_model& model, const std::vector< double >& sizes,
+    const std::vector< double >& times, double& a, double& b, double& rms)
+{
+    double s = 0.0, sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+    for (std::size_t i = 0; i < sizes.size(); i++) {
+        const double w = 1.0 / (times[i] * times[i]);
+        const double x = model.scale(sizes[i]);
+        s += w;
+        sx += w * x;
+        sy += w * times[i];
+        sxx += w * x * x;
+        sxy += w * x * times[i];
+    }
+
+    if (model.scale == scale_1) {
+        a = sy / s;
+        b = 0.0;
+    } else {
+        b = (s * sxy - sx * sy) / (s * sxx - sx * sx);
+        a = (sy - b * sx) / s;
+        if (b < 0.0)
+            return false;
+    }
+
+    double sum = 0.0;
+    for (std::size_t i = 0; i < sizes.size(); i++) {
+        const double e = (times[i] - a - b * model.scale(sizes[i])) /
+            times[i];
+        sum += e * e;
+    }
+    rms = std::sqrt(sum / sizes.size());
+    return true;
+}
 
 void
 atf::utils::cat_file(const std::string& path, const std::string& prefix)
@@ -89,6 +224,34 @@ atf::utils::grep_string(const std::string& regex, const std::string& str)
     return atf_utils_grep_string("%s", str.c_str(), regex.c_str());
 }
 
+struct atf::utils::detail::grep_regex::impl {
+    ::regex_t m_preg;
+
+    ~impl(void)
+    {
+        ::regfree(&m_preg);
+    }
+};
+
+atf::utils::detail::grep_regex::grep_regex(const std::string& regex)
+{
+    std::unique_ptr< impl > pimpl(new impl);
+    if (::regcomp(&pimpl->m_preg, regex.c_str(),
+                  REG_EXTENDED | REG_NOSUB) != 0)
+        atf::tests::tc::fail("Invalid regular expression '" + regex + "'");
+    m_pimpl.reset(pimpl.release());
+}
+
+bool
+atf::utils::detail::grep_regex::matches(const std::string& str)
+    const
+{
+    const int res = ::regexec(&m_pimpl->m_preg, str.c_str(), 0, NULL, 0);
+    if (res != 0 && res != REG_NOMATCH)
+        atf::tests::tc::fail("Failed to match regular expression");
+    return res == 0;
+}
+
 void
 atf::utils::redirect(const int fd, const std::string& path)
 {
@@ -105,3 +268,108 @@ atf::utils::wait(const pid_t pid, const int exitstatus,
 {
     atf_utils_wait(pid, exitstatus, expout.c_str(), experr.c_str());
 }
+
+//
+// Replaces the clock used by require_complexity to time the body, or
+// restores the CPU time clock if given NULL.  For testing only.
+//
+void
+atf::utils::detail::set_complexity_clock(double (*clock)(void))
+{
+    complexity_clock = clock == NULL ? cpu_time_ns : clock;
+}
+
+//
+// Times the body over a geometric range of sizes and fails the test case
+// if the times grow faster than the expected complexity class, or if they
+// are too noisy to fit any class.
+//
+void
+atf::utils::require_complexity(
+    const complexity expected,
+    const std::function< void (const std::size_t) >& body,
+    const std::size_t min_size, const std::size_t max_size)
+{
+    const std::size_t nmodels =
+        sizeof(complexity_models) / sizeof(complexity_models[0]);
+
+    if (min_size < 2 || max_size / 8 < min_size) {
+        std::ostringstream ss;
+        ss << "Invalid size range " << min_size << " to " << max_size
+           << "; sizes must start at 2 or more and span a factor of 8";
+        atf::tests::tc::fail(ss.str());
+    }
+
+    const std::ios_base::fmtflags old_flags = std::cout.flags();
+    const std::streamsize old_precision = std::cout.precision();
+
+    std::vector< double > sizes, times;
+    for (std::size_t n = min_size; n <= max_size; n *= 2) {
+        sizes.push_back(n);
+        times.push_back(time_call(body, n));
+        if (times.back() > complexity_max_call_ns)
+            break;
+    }
+    for (int round = 1; round < complexity_rounds; round++) {
+        for (std::size_t i = 0; i < sizes.size(); i++)
+            times[i] = std::min(times[i], time_call(body, sizes[i]));
+    }
+    for (std::size_t i = 0; i < sizes.size(); i++)
+        std::cout << "complexity: n = "
+                  << static_cast< std::size_t >(sizes[i]) << ": "
+                  << std::fixed << std::setprecision(1) << times[i]
+                  << " ns\n";
+    if (sizes.size() < 4) {
+        std::cout.flags(old_flags);
+        std::cout.precision(old_precision);
+        std::ostringstream ss;
+        ss << "Only " << sizes.size() << " sizes could be timed within "
+           "the time limit; need at least 4 to estimate complexity";
+        atf::tests::tc::fail(ss.str());
+    }
+
+    std::vector< double > rms(nmodels, -1.0);
+    double best_rms = std::numeric_limits< double >::max();
+    for (std::size_t i = 0; i < nmodels; i++) {
+        double a, b;
+        if (fit(complexity_models[i], sizes, times, a, b, rms[i])) {
+            std::cout << "complexity: " << complexity_models[i].name << ": "
+                      << std::defaultfloat << std::setprecision(4) << a
+                      << " + " << b << " * f(n) ns, rms " << std::fixed
+                      << std::setprecision(2) << rms[i] * 100.0 << "%\n";
+            best_rms = std::min(best_rms, rms[i]);
+        } else {
+            rms[i] = -1.0;
+            std::cout << "complexity: " << complexity_models[i].name
+                      << ": no fit\n";
+        }
+    }
+
+    if (best_rms > complexity_max_rms) {
+        std::cout.flags(old_flags);
+        std::cout.precision(old_precision);
+        std::cout.flush();
+        std::ostringstream ss;
+        ss << "Inconclusive: the times fit no complexity class within "
+           << complexity_max_rms * 100.0 << "% (best "
+           << best_rms * 100.0 << "%); are they too noisy?";
+        atf::tests::tc::fail(ss.str());
+    }
+
+    std::size_t best = 0;
+    while (best < nmodels &&
+           (rms[best] < 0.0 || rms[best] > best_rms * complexity_fit_margin))
+        best++;
+    std::cout << "complexity: best fit " << complexity_models[best].name
+              << ", expected " << complexity_models[expected].name
+              << std::endl;
+    std::cout.flags(old_flags);
+    std::cout.precision(old_precision);
+
+    if (best > static_cast< std::size_t >(expected)) {
+        std::ostringstream ss;
+        ss << "Times grow as " << complexity_models[best].name
+           << ", worse than the expected " << complexity_models[expected].name;
+        atf::tests::tc::fail(ss.str());
+    }
+}
@@ -30,11 +30,23 @@ extern "C" {
 #include <unistd.h>
 }
 
+#include <cstddef>
+#include <functional>
+#include <memory>
 #include <string>
 
 namespace atf {
 namespace utils {
 
+// Complexity classes understood by require_complexity, from best to worst.
+enum complexity {
+    o_1,
+    o_log_n,
+    o_n,
+    o_n_log_n,
+    o_n_squared,
+};
+
 void cat_file(const std::string&, const std::string&);
 bool compare_file(const std::string&, const std::string&);
 void copy_file(const std::string&, const std::string&);
@@ -45,15 +57,35 @@ void reset_resultsfile(void);
 bool grep_file(const std::string&, const std::string&);
 bool grep_string(const std::string&, const std::string&);
 void redirect(const int, const std::string&);
+void require_complexity(const complexity,
+                        const std::function< void (const std::size_t) >&,
+                        const std::size_t = 64, const std::size_t = 16384);
 void wait(const pid_t, const int, const std::string&, const std::string&);
 
+namespace detail {
+
+void set_complexity_clock(double (*)(void));
+
+// A regexp compiled once for all the items of grep_collection.
+class grep_regex {
+    struct impl;
+    std::shared_ptr< const impl > m_pimpl;
+
+public:
+    explicit grep_regex(const std::string&);
+    bool matches(const std::string&) const;
+};
+
+} // namespace detail
+
 template< typename Collection >
 bool
 grep_collection(const std::string& regexp, const Collection& collection)
 {
+    const detail::grep_regex regex(regexp);
     for (typename Collection::const_iterator iter = collection.begin();
          iter != collection.end(); ++iter) {
-        if (grep_string(regexp, *iter))
+        if (regex.matches(*iter))
             return true;
     }
     return false;
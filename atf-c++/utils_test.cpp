@@ -326,6 +326,112 @@ ATF_TEST_CASE_BODY(redirect__other)
     ATF_REQUIRE_EQ(message, read_file("captured.txt"));
 }
 
+// The bodies below do no real work: they charge a fixed cost to a fake
+// clock, so that the timings seen by require_complexity do not depend on
+// the load of the machine.
+static double fake_clock_ns = 0.0;
+
+static double
+fake_clock(void)
+{
+    return fake_clock_ns;
+}
+
+static void
+fake_linear(const std::size_t n)
+{
+    fake_clock_ns += 1000.0 + 10.0 * n;
+}
+
+static void
+fake_quadratic(const std::size_t n)
+{
+    fake_clock_ns += 10.0 * n * n;
+}
+
+static void
+fake_erratic(const std::size_t n)
+{
+    fake_clock_ns += (n / 64) % 3 == 1 ? 1e6 : 1e3;
+}
+
+ATF_TEST_CASE_WITHOUT_HEAD(require_complexity__ok);
+ATF_TEST_CASE_BODY(require_complexity__ok)
+{
+    atf::utils::detail::set_complexity_clock(fake_clock);
+    atf::utils::redirect(STDOUT_FILENO, "captured.txt");
+    atf::utils::require_complexity(atf::utils::o_n, fake_linear);
+    atf::utils::require_complexity(atf::utils::o_n_log_n, fake_linear);
+    std::cout.flush();
+    close(STDOUT_FILENO);
+    atf::utils::detail::set_complexity_clock(NULL);
+
+    ATF_REQUIRE(atf::utils::grep_file("^complexity: n = 64: [0-9.]+ ns$",
+                                      "captured.txt"));
+    ATF_REQUIRE(atf::utils::grep_file("^complexity: n = 16384: [0-9.]+ ns$",
+                                      "captured.txt"));
+    ATF_REQUIRE(atf::utils::grep_file("^complexity: O\\(n\\): .* \\* f\\(n\\) "
+                                      "ns, rms [0-9.]+%$", "captured.txt"));
+    ATF_REQUIRE(atf::utils::grep_file("^complexity: best fit O\\(n\\), "
+                                      "expected O\\(n log n\\)$",
+                                      "captured.txt"));
+}
+
+ATF_TEST_CASE_WITHOUT_HEAD(require_complexity__too_slow);
+ATF_TEST_CASE_BODY(require_complexity__too_slow)
+{
+    const pid_t pid = atf::utils::fork();
+    if (pid == 0) {
+        atf::utils::reset_resultsfile();
+        atf::utils::detail::set_complexity_clock(fake_clock);
+        atf::utils::require_complexity(atf::utils::o_n, fake_quadratic,
+                                       64, 4096);
+        exit(EXIT_SUCCESS);
+    }
+    int status;
+    ATF_REQUIRE(waitpid(pid, &status, 0) != -1);
+    ATF_REQUIRE(WIFEXITED(status));
+    ATF_REQUIRE_EQ(EXIT_FAILURE, WEXITSTATUS(status));
+    ATF_REQUIRE(atf::utils::grep_file("^complexity: best fit O\\(n\\^2\\), "
+                                      "expected O\\(n\\)$",
+                                      "atf_utils_fork_" +
+                                      std::to_string(pid) + "_out.txt"));
+}
+
+ATF_TEST_CASE_WITHOUT_HEAD(require_complexity__inconclusive);
+ATF_TEST_CASE_BODY(require_complexity__inconclusive)
+{
+    const pid_t pid = atf::utils::fork();
+    if (pid == 0) {
+        atf::utils::reset_resultsfile();
+        atf::utils::detail::set_complexity_clock(fake_clock);
+        atf::utils::require_complexity(atf::utils::o_n_squared, fake_erratic);
+        exit(EXIT_SUCCESS);
+    }
+    int status;
+    ATF_REQUIRE(waitpid(pid, &status, 0) != -1);
+    ATF_REQUIRE(WIFEXITED(status));
+    ATF_REQUIRE_EQ(EXIT_FAILURE, WEXITSTATUS(status));
+    ATF_REQUIRE(!atf::utils::grep_file("^complexity: best fit",
+                                       "atf_utils_fork_" +
+                                       std::to_string(pid) + "_out.txt"));
+}
+
+ATF_TEST_CASE_WITHOUT_HEAD(require_complexity__invalid_range);
+ATF_TEST_CASE_BODY(require_complexity__invalid_range)
+{
+    const pid_t pid = atf::utils::fork();
+    if (pid == 0) {
+        atf::utils::reset_resultsfile();
+        atf::utils::require_complexity(atf::utils::o_n, fake_linear, 64, 256);
+        exit(EXIT_SUCCESS);
+    }
+    int status;
+    ATF_REQUIRE(waitpid(pid, &status, 0) != -1);
+    ATF_REQUIRE(WIFEXITED(status));
+    ATF_REQUIRE_EQ(EXIT_FAILURE, WEXITSTATUS(status));
+}
+
 static void
 fork_and_wait(const int exitstatus, const char* expout, const char* experr)
 {
@@ -500,6 +606,11 @@ ATF_INIT_TEST_CASES(tcs)
     ATF_ADD_TEST_CASE(tcs, redirect__stderr);
     ATF_ADD_TEST_CASE(tcs, redirect__other);
 
+    ATF_ADD_TEST_CASE(tcs, require_complexity__ok);
+    ATF_ADD_TEST_CASE(tcs, require_complexity__too_slow);
+    ATF_ADD_TEST_CASE(tcs, require_complexity__inconclusive);
+    ATF_ADD_TEST_CASE(tcs, require_complexity__invalid_range);
+
     ATF_ADD_TEST_CASE(tcs, wait__ok);
     ATF_ADD_TEST_CASE(tcs, wait__ok_nested);
     ATF_ADD_TEST_CASE(tcs, wait__invalid_exitstatus);
@@ -29,6 +29,7 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <signal.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -37,6 +38,7 @@
 
 #include "atf-c/build.h"
 #include "atf-c/defs.h"
+#include "atf-c/detail/compare.h"
 #include "atf-c/detail/dynstr.h"
 #include "atf-c/detail/env.h"
 #include "atf-c/detail/fs.h"
@@ -72,37 +74,6 @@ out:
     return err;
 }
 
-static
-void
-cleanup_tmpdir(const atf_fs_path_t *dir, const atf_fs_path_t *outfile,
-               const atf_fs_path_t *errfile)
-{
-    {
-        atf_error_t err = atf_fs_unlink(outfile);
-        if (atf_is_error(err)) {
-            INV(atf_error_is(err, "libc") &&
-                atf_libc_error_code(err) == ENOENT);
-            atf_error_free(err);
-        } else
-            INV(!atf_is_error(err));
-    }
-
-    {
-        atf_error_t err = atf_fs_unlink(errfile);
-        if (atf_is_error(err)) {
-            INV(atf_error_is(err, "libc") &&
-                atf_libc_error_code(err) == ENOENT);
-            atf_error_free(err);
-        } else
-            INV(!atf_is_error(err));
-    }
-
-    {
-        atf_error_t err = atf_fs_rmdir(dir);
-        INV(!atf_is_error(err));
-    }
-}
-
 static
 int
 const_execvp(const char *file, const char *const *argv)
@@ -112,43 +83,9 @@ const_execvp(const char *file, const char *const *argv)
 #undef UNCONST
 }
 
-static
-atf_error_t
-init_sb(const atf_fs_path_t *path, atf_process_stream_t *sb)
-{
-    atf_error_t err;
-
-    if (path == NULL)
-        err = atf_process_stream_init_inherit(sb);
-    else
-        err = atf_process_stream_init_redirect_path(sb, path);
-
-    return err;
-}
-
-static
-atf_error_t
-init_sbs(const atf_fs_path_t *outfile, atf_process_stream_t *outsb,
-         const atf_fs_path_t *errfile, atf_process_stream_t *errsb)
-{
-    atf_error_t err;
-
-    err = init_sb(outfile, outsb);
-    if (atf_is_error(err))
-        goto out;
-
-    err = init_sb(errfile, errsb);
-    if (atf_is_error(err)) {
-        atf_process_stream_fini(outsb);
-        goto out;
-    }
-
-out:
-    return err;
-}
-
 struct exec_data {
     const char *const *m_argv;
+    bool m_pgrp;
 };
 
 static void exec_child(void *) ATF_DEFS_ATTRIBUTE_NORETURN;
@@ -159,34 +96,58 @@ exec_child(void *v)
 {
     struct exec_data *ea = v;
 
+    if (ea->m_pgrp)
+        (void)setpgid(0, 0);
     const_execvp(ea->m_argv[0], ea->m_argv);
     fprintf(stderr, "execvp(%s) failed: %s\n", ea->m_argv[0], strerror(errno));
     exit(127);
 }
 
+/* Starts the command, spawning it if possible.  A command that cannot be
+ * spawned is forked instead so that the child reports the failure and
+ * exits with 127, as a shell would.  If pgrp is true, the command leads a
+ * new process group. */
+static
+atf_error_t
+start_child(atf_process_child_t *child, const char *const *argv,
+            const atf_process_stream_t *outsb,
+            const atf_process_stream_t *errsb, const bool pgrp)
+{
+    atf_error_t err;
+    struct exec_data ea = { argv, pgrp };
+
+    if (pgrp)
+        err = atf_process_spawn_pgrp(child, argv[0], argv, outsb, errsb);
+    else
+        err = atf_process_spawn(child, argv[0], argv, outsb, errsb);
+    if (atf_is_error(err)) {
+        atf_error_free(err);
+        err = atf_process_fork(child, exec_child, outsb, errsb, &ea);
+    }
+
+    return err;
+}
+
 static
 atf_error_t
-fork_and_wait(const char *const *argv, const atf_fs_path_t *outfile,
-              const atf_fs_path_t *errfile, atf_process_status_t *status)
+fork_and_wait(const char *const *argv, atf_process_status_t *status)
 {
     atf_error_t err;
     atf_process_child_t child;
-    atf_process_stream_t outsb, errsb;
-    struct exec_data ea = { argv };
+    atf_process_stream_t inheritsb;
 
-    err = init_sbs(outfile, &outsb, errfile, &errsb);
+    err = atf_process_stream_init_inherit(&inheritsb);
     if (atf_is_error(err))
         goto out;
 
-    err = atf_process_fork(&child, exec_child, &outsb, &errsb, &ea);
+    err = start_child(&child, argv, &inheritsb, &inheritsb, false);
     if (atf_is_error(err))
-        goto out_sbs;
+        goto out_sb;
 
     err = atf_process_child_wait(&child, status);
 
-out_sbs:
-    atf_process_stream_fini(&errsb);
-    atf_process_stream_fini(&outsb);
+out_sb:
+    atf_process_stream_fini(&inheritsb);
 out:
     return err;
 }
@@ -268,7 +229,7 @@ check_build_run(const char *const *argv, bool *success)
 
     print_array(argv, ">");
 
-    err = fork_and_wait(argv, NULL, NULL, &status);
+    err = fork_and_wait(argv, &status);
     if (atf_is_error(err))
         goto out;
 
@@ -280,86 +241,474 @@ out:
     return err;
 }
 
+/* ---------------------------------------------------------------------
+ * The "atf_check_expect" type.
+ * --------------------------------------------------------------------- */
+
+void
+atf_check_expect_init(atf_check_expect_t *e, const void *data,
+                      const size_t size)
+{
+    e->m_data = data;
+    e->m_size = size;
+    e->m_signo = SIGKILL;
+}
+
 /* ---------------------------------------------------------------------
  * The "atf_check_result" type.
  * --------------------------------------------------------------------- */
 
+/* Outputs up to this size are kept in memory; larger ones are spilled to
+ * a file so that commands that print a lot do not exhaust our memory. */
+static const size_t capture_memory_limit = 256 * 1024;
+
+/* The output of the command read from one of its pipes.  It is kept in
+ * memory until it grows past capture_memory_limit, at which point it is
+ * moved to a file in the temporary directory of the result.  The file is
+ * also created once the command finishes if the result is not lazy, or on
+ * demand if the caller asks for its path otherwise.
+ *
+ * If the output has expected contents, it is compared with them as it is
+ * read, and reading stops at the first chunk that diverges. */
+struct capture {
+    const char *m_name;
+
+    const atf_check_expect_t *m_expect;
+    size_t m_read;
+    bool m_diverged;
+    size_t m_divergence;
+
+    char *m_data;
+    size_t m_size;
+    size_t m_capacity;
+
+    bool m_spilled;
+    int m_spillfd;
+
+    bool m_has_path;
+    atf_fs_path_t m_path;
+};
+
 struct atf_check_result_impl {
     atf_list_t m_argv;
+    bool m_has_dir;
     atf_fs_path_t m_dir;
-    atf_fs_path_t m_stdout;
-    atf_fs_path_t m_stderr;
+    struct capture m_stdout;
+    struct capture m_stderr;
     atf_process_status_t m_status;
+    bool m_timed_out;
 };
 
+static
+void
+capture_init(struct capture *c, const char *name)
+{
+    c->m_name = name;
+    c->m_expect = NULL;
+    c->m_read = 0;
+    c->m_diverged = false;
+    c->m_divergence = 0;
+    c->m_data = NULL;
+    c->m_size = 0;
+    c->m_capacity = 0;
+    c->m_spilled = false;
+    c->m_spillfd = -1;
+    c->m_has_path = false;
+}
+
+static
+void
+capture_fini(struct capture *c)
+{
+    if (c->m_spillfd != -1)
+        close(c->m_spillfd);
+    free(c->m_data);
+
+    if (c->m_has_path) {
+        atf_error_t err = atf_fs_unlink(&c->m_path);
+        if (atf_is_error(err)) {
+            INV(atf_error_is(err, "libc") &&
+                atf_libc_error_code(err) == ENOENT);
+            atf_error_free(err);
+        }
+        atf_fs_path_fini(&c->m_path);
+    }
+}
+
+static
+atf_error_t
+write_all(const int fd, const char *buf, size_t len)
+{
+    while (len > 0) {
+        const ssize_t n = write(fd, buf, len);
+        if (n == -1) {
+            if (errno == EINTR)
+                continue;
+            return atf_libc_error(errno, "Failed to write captured output");
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+    return atf_no_error();
+}
+
+/* Creates the file backing the capture and leaves it open in m_spillfd
+ * with the output captured in memory so far. */
 static
 atf_error_t
-atf_check_result_init(atf_check_result_t *r, const char *const *argv,
-                      const atf_fs_path_t *dir)
+capture_open_file(struct atf_check_result_impl *impl, struct capture *c)
 {
     atf_error_t err;
 
-    r->pimpl = malloc(sizeof(struct atf_check_result_impl));
-    if (r->pimpl == NULL)
-        return atf_no_memory_error();
+    PRE(!c->m_has_path);
 
-    err = array_to_list(argv, &r->pimpl->m_argv);
+    if (!impl->m_has_dir) {
+        err = create_tmpdir(&impl->m_dir);
+        if (atf_is_error(err))
+            goto out;
+        impl->m_has_dir = true;
+    }
+
+    err = atf_fs_path_init_fmt(&c->m_path, "%s/%s",
+                               atf_fs_path_cstring(&impl->m_dir), c->m_name);
     if (atf_is_error(err))
         goto out;
 
-    err = atf_fs_path_copy(&r->pimpl->m_dir, dir);
+    c->m_spillfd = open(atf_fs_path_cstring(&c->m_path),
+                        O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (c->m_spillfd == -1) {
+        err = atf_libc_error(errno, "Cannot create %s",
+                             atf_fs_path_cstring(&c->m_path));
+        atf_fs_path_fini(&c->m_path);
+        goto out;
+    }
+    c->m_has_path = true;
+
+    err = write_all(c->m_spillfd, c->m_data, c->m_size);
+
+out:
+    return err;
+}
+
+static
+atf_error_t
+capture_append(struct atf_check_result_impl *impl, struct capture *c,
+               const char *buf, const size_t len)
+{
+    atf_error_t err;
+
+    if (!c->m_spilled && c->m_size + len > capture_memory_limit) {
+        err = capture_open_file(impl, c);
+        if (atf_is_error(err))
+            return err;
+        free(c->m_data);
+        c->m_data = NULL;
+        c->m_spilled = true;
+    }
+
+    if (c->m_spilled)
+        return write_all(c->m_spillfd, buf, len);
+
+    if (c->m_size + len > c->m_capacity) {
+        size_t capacity = c->m_capacity == 0 ? 4096 : c->m_capacity;
+        char *data;
+
+        while (capacity < c->m_size + len)
+            capacity *= 2;
+        data = realloc(c->m_data, capacity);
+        if (data == NULL)
+            return atf_no_memory_error();
+        c->m_data = data;
+        c->m_capacity = capacity;
+    }
+    memcpy(c->m_data + c->m_size, buf, len);
+    c->m_size += len;
+
+    return atf_no_error();
+}
+
+/* Compares a chunk of output with the expected contents at the same offset
+ * and returns whether they diverge, recording where. */
+static
+bool
+capture_verify(struct capture *c, const char *buf, const size_t len)
+{
+    const atf_check_expect_t *e = c->m_expect;
+
+    if (e != NULL && !c->m_diverged) {
+        const size_t left = c->m_read < e->m_size ? e->m_size - c->m_read : 0;
+        const size_t common = len < left ? len : left;
+        atf_compare_result_t result;
+
+        atf_compare_mem((const char *)e->m_data + c->m_read, common, buf,
+                        common, &result);
+        if (!result.m_equal) {
+            c->m_diverged = true;
+            c->m_divergence = c->m_read + result.m_offset;
+        } else if (len > left) {
+            c->m_diverged = true;
+            c->m_divergence = c->m_read + left;
+        }
+    }
+    c->m_read += len;
+
+    return c->m_diverged;
+}
+
+struct capture_sink_data {
+    struct atf_check_result_impl *m_impl;
+    const atf_process_child_t *m_child;
+};
+
+/* Stores a chunk of the output of the child.  An output that diverges
+ * from its expected contents gets the child signalled, together with the
+ * process group that it leads if any, and the rest of it is discarded.
+ * The drain sends SIGKILL if the signal does not terminate the child. */
+static
+atf_error_t
+capture_sink(void *v, const int fd, const char *buf, const size_t len,
+             bool *stop)
+{
+    struct capture_sink_data *data = v;
+    struct capture *c = fd == STDOUT_FILENO ? &data->m_impl->m_stdout :
+                                              &data->m_impl->m_stderr;
+    atf_error_t err;
+
+    err = capture_append(data->m_impl, c, buf, len);
+    if (!atf_is_error(err) && capture_verify(c, buf, len)) {
+        atf_process_child_signal(data->m_child, c->m_expect->m_signo);
+        *stop = true;
+    }
+
+    return err;
+}
+
+static
+atf_error_t
+capture_output(struct atf_check_result_impl *impl, atf_process_child_t *child,
+               const int timeout_ms)
+{
+    struct capture_sink_data data = { impl, child };
+    struct capture *captures[2] = { &impl->m_stdout, &impl->m_stderr };
+    atf_error_t err;
+    size_t i;
+
+    if (timeout_ms > 0)
+        err = atf_process_child_drain_timeout(child, capture_sink, &data,
+                                              timeout_ms, &impl->m_timed_out);
+    else
+        err = atf_process_child_drain(child, capture_sink, &data);
+
+    for (i = 0; i < 2; i++) {
+        if (captures[i]->m_spillfd != -1) {
+            close(captures[i]->m_spillfd);
+            captures[i]->m_spillfd = -1;
+        }
+    }
+
+    return err;
+}
+
+static
+atf_error_t
+fork_and_capture(const char *const *argv, struct atf_check_result_impl *impl,
+                 const int timeout_ms)
+{
+    atf_error_t err, err2;
+    atf_process_child_t child;
+    atf_process_stream_t outsb, errsb;
+
+    err = atf_process_stream_init_capture(&outsb);
     if (atf_is_error(err))
-        goto err_argv;
+        goto out;
 
-    err = atf_fs_path_init_fmt(&r->pimpl->m_stdout, "%s/stdout",
-                               atf_fs_path_cstring(dir));
+    err = atf_process_stream_init_capture(&errsb);
     if (atf_is_error(err))
-        goto err_dir;
+        goto out_outsb;
 
-    err = atf_fs_path_init_fmt(&r->pimpl->m_stderr, "%s/stderr",
-                               atf_fs_path_cstring(dir));
+    err = start_child(&child, argv, &outsb, &errsb, timeout_ms > 0);
     if (atf_is_error(err))
-        goto err_stdout;
+        goto out_errsb;
 
-    INV(!atf_is_error(err));
-    goto out;
+    err = capture_output(impl, &child, timeout_ms);
 
-err_stdout:
-    atf_fs_path_fini(&r->pimpl->m_stdout);
-err_dir:
-    atf_fs_path_fini(&r->pimpl->m_dir);
-err_argv:
-    atf_list_fini(&r->pimpl->m_argv);
+    err2 = atf_process_child_wait(&child, &impl->m_status);
+    if (!atf_is_error(err))
+        err = err2;
+    else if (atf_is_error(err2))
+        atf_error_free(err2);
+    else
+        atf_process_status_fini(&impl->m_status);
+
+out_errsb:
+    atf_process_stream_fini(&errsb);
+out_outsb:
+    atf_process_stream_fini(&outsb);
 out:
     return err;
 }
 
-void
-atf_check_result_fini(atf_check_result_t *r)
+/* Creates the file holding the output if it was small enough to be kept
+ * in memory. */
+static
+atf_error_t
+capture_materialize(struct atf_check_result_impl *impl, struct capture *c)
 {
-    atf_process_status_fini(&r->pimpl->m_status);
+    atf_error_t err;
+
+    if (c->m_has_path)
+        return atf_no_error();
+
+    err = capture_open_file(impl, c);
+    if (c->m_spillfd != -1) {
+        close(c->m_spillfd);
+        c->m_spillfd = -1;
+    }
+    return err;
+}
+
+static
+const char *
+capture_path(const struct capture *c)
+{
+    PRE(c->m_has_path);
+    return atf_fs_path_cstring(&c->m_path);
+}
+
+static
+atf_error_t
+capture_path_lazy(struct atf_check_result_impl *impl, struct capture *c,
+                  const char **path)
+{
+    atf_error_t err;
 
-    cleanup_tmpdir(&r->pimpl->m_dir, &r->pimpl->m_stdout,
-                   &r->pimpl->m_stderr);
-    atf_fs_path_fini(&r->pimpl->m_stdout);
-    atf_fs_path_fini(&r->pimpl->m_stderr);
-    atf_fs_path_fini(&r->pimpl->m_dir);
+    err = capture_materialize(impl, c);
+    if (!atf_is_error(err))
+        *path = capture_path(c);
+    return err;
+}
+
+static
+const char *
+capture_data(const struct capture *c, size_t *size)
+{
+    if (c->m_spilled)
+        return NULL;
+
+    *size = c->m_size;
+    return c->m_data != NULL ? c->m_data : "";
+}
+
+static
+atf_error_t
+atf_check_result_init(atf_check_result_t *r, const char *const *argv)
+{
+    atf_error_t err;
+
+    r->pimpl = malloc(sizeof(struct atf_check_result_impl));
+    if (r->pimpl == NULL)
+        return atf_no_memory_error();
+
+    err = array_to_list(argv, &r->pimpl->m_argv);
+    if (atf_is_error(err)) {
+        free(r->pimpl);
+        goto out;
+    }
+
+    r->pimpl->m_has_dir = false;
+    r->pimpl->m_timed_out = false;
+    capture_init(&r->pimpl->m_stdout, "stdout");
+    capture_init(&r->pimpl->m_stderr, "stderr");
+
+    INV(!atf_is_error(err));
+out:
+    return err;
+}
+
+/* Releases everything in the result but its status, which is only valid
+ * once the command has been waited for. */
+static
+void
+result_release(atf_check_result_t *r)
+{
+    capture_fini(&r->pimpl->m_stdout);
+    capture_fini(&r->pimpl->m_stderr);
+    if (r->pimpl->m_has_dir) {
+        atf_error_t err = atf_fs_rmdir(&r->pimpl->m_dir);
+        INV(!atf_is_error(err));
+        atf_fs_path_fini(&r->pimpl->m_dir);
+    }
 
     atf_list_fini(&r->pimpl->m_argv);
 
     free(r->pimpl);
 }
 
+void
+atf_check_result_fini(atf_check_result_t *r)
+{
+    atf_process_status_fini(&r->pimpl->m_status);
+
+    result_release(r);
+}
+
+/* The files of results that are not lazy always exist.  Those of lazy
+ * results must have been created with the _path variants below. */
 const char *
 atf_check_result_stdout(const atf_check_result_t *r)
 {
-    return atf_fs_path_cstring(&r->pimpl->m_stdout);
+    return capture_path(&r->pimpl->m_stdout);
 }
 
 const char *
 atf_check_result_stderr(const atf_check_result_t *r)
 {
-    return atf_fs_path_cstring(&r->pimpl->m_stderr);
+    return capture_path(&r->pimpl->m_stderr);
+}
+
+atf_error_t
+atf_check_result_stdout_path(const atf_check_result_t *r, const char **path)
+{
+    return capture_path_lazy(r->pimpl, &r->pimpl->m_stdout, path);
+}
+
+atf_error_t
+atf_check_result_stderr_path(const atf_check_result_t *r, const char **path)
+{
+    return capture_path_lazy(r->pimpl, &r->pimpl->m_stderr, path);
+}
+
+const char *
+atf_check_result_stdout_data(const atf_check_result_t *r, size_t *size)
+{
+    return capture_data(&r->pimpl->m_stdout, size);
+}
+
+const char *
+atf_check_result_stderr_data(const atf_check_result_t *r, size_t *size)
+{
+    return capture_data(&r->pimpl->m_stderr, size);
+}
+
+static
+bool
+capture_diverged(const struct capture *c, size_t *offset)
+{
+    if (c->m_diverged)
+        *offset = c->m_divergence;
+    return c->m_diverged;
+}
+
+bool
+atf_check_result_stdout_diverged(const atf_check_result_t *r, size_t *offset)
+{
+    return capture_diverged(&r->pimpl->m_stdout, offset);
+}
+
+bool
+atf_check_result_stderr_diverged(const atf_check_result_t *r, size_t *offset)
+{
+    return capture_diverged(&r->pimpl->m_stderr, offset);
 }
 
 bool
@@ -386,6 +735,65 @@ atf_check_result_termsig(const atf_check_result_t *r)
     return atf_process_status_termsig(&r->pimpl->m_status);
 }
 
+/* Whether the command was killed because it did not finish within the
+ * timeout given to atf_check_exec_array_timeout.  Its outputs hold what it
+ * wrote until then. */
+bool
+atf_check_result_timed_out(const atf_check_result_t *r)
+{
+    return r->pimpl->m_timed_out;
+}
+
+/* The resources consumed by the command, from the moment it was started
+ * until it was reaped.  Times are in microseconds. */
+int64_t
+atf_check_result_wall_usec(const atf_check_result_t *r)
+{
+    return atf_process_status_wall_usec(&r->pimpl->m_status);
+}
+
+int64_t
+atf_check_result_user_usec(const atf_check_result_t *r)
+{
+    return atf_process_status_user_usec(&r->pimpl->m_status);
+}
+
+int64_t
+atf_check_result_system_usec(const atf_check_result_t *r)
+{
+    return atf_process_status_system_usec(&r->pimpl->m_status);
+}
+
+long
+atf_check_result_maxrss_kb(const atf_check_result_t *r)
+{
+    return atf_process_status_maxrss_kb(&r->pimpl->m_status);
+}
+
+long
+atf_check_result_minflt(const atf_check_result_t *r)
+{
+    return atf_process_status_minflt(&r->pimpl->m_status);
+}
+
+long
+atf_check_result_majflt(const atf_check_result_t *r)
+{
+    return atf_process_status_majflt(&r->pimpl->m_status);
+}
+
+long
+atf_check_result_nvcsw(const atf_check_result_t *r)
+{
+    return atf_process_status_nvcsw(&r->pimpl->m_status);
+}
+
+long
+atf_check_result_nivcsw(const atf_check_result_t *r)
+{
+    return atf_process_status_nivcsw(&r->pimpl->m_status);
+}
+
 /* ---------------------------------------------------------------------
  * Free functions.
  * --------------------------------------------------------------------- */
@@ -453,33 +861,75 @@ out:
     return err;
 }
 
+/* Like atf_check_exec_array_timeout, but creates the files holding the
+ * outputs before returning if 'lazy' is false. */
+static
 atf_error_t
-atf_check_exec_array(const char *const *argv, atf_check_result_t *r)
+exec_array(const char *const *argv, const atf_check_expect_t *out_expect,
+           const atf_check_expect_t *err_expect, const int timeout_ms,
+           const bool lazy, atf_check_result_t *r)
 {
     atf_error_t err;
-    atf_fs_path_t dir;
 
-    err = create_tmpdir(&dir);
+    PRE(timeout_ms >= 0);
+
+    err = atf_check_result_init(r, argv);
     if (atf_is_error(err))
         goto out;
+    r->pimpl->m_stdout.m_expect = out_expect;
+    r->pimpl->m_stderr.m_expect = err_expect;
 
-    err = atf_check_result_init(r, argv, &dir);
+    err = fork_and_capture(argv, r->pimpl, timeout_ms);
     if (atf_is_error(err)) {
-        atf_error_t err2 = atf_fs_rmdir(&dir);
-        INV(!atf_is_error(err2));
+        result_release(r);
         goto out;
     }
 
-    err = fork_and_wait(argv, &r->pimpl->m_stdout, &r->pimpl->m_stderr,
-                        &r->pimpl->m_status);
-    if (atf_is_error(err)) {
-        atf_check_result_fini(r);
-        goto out;
+    if (!lazy) {
+        err = capture_materialize(r->pimpl, &r->pimpl->m_stdout);
+        if (!atf_is_error(err))
+            err = capture_materialize(r->pimpl, &r->pimpl->m_stderr);
+        if (atf_is_error(err)) {
+            atf_check_result_fini(r);
+            goto out;
+        }
     }
 
-    INV(!atf_is_error(err));
-
-    atf_fs_path_fini(&dir);
 out:
     return err;
 }
+
+/* Runs the command and stores its outputs in files, whose paths can be
+ * obtained with atf_check_result_stdout and atf_check_result_stderr. */
+atf_error_t
+atf_check_exec_array(const char *const *argv, atf_check_result_t *r)
+{
+    return exec_array(argv, NULL, NULL, 0, false, r);
+}
+
+/* Like atf_check_exec_array, but compares the outputs of the command with
+ * their expected contents, if any, while it runs.  The result is lazy:
+ * small outputs are only kept in memory, and their files are created by
+ * atf_check_result_stdout_path and atf_check_result_stderr_path. */
+atf_error_t
+atf_check_exec_array_expect(const char *const *argv,
+                            const atf_check_expect_t *out_expect,
+                            const atf_check_expect_t *err_expect,
+                            atf_check_result_t *r)
+{
+    return atf_check_exec_array_timeout(argv, out_expect, err_expect, 0, r);
+}
+
+/* Like atf_check_exec_array_expect, but kills the command if it has not
+ * finished after timeout_ms milliseconds, or never if it is 0.  The command
+ * runs in its own process group, which is sent SIGTERM on timeout and
+ * SIGKILL if it does not exit within a second. */
+atf_error_t
+atf_check_exec_array_timeout(const char *const *argv,
+                             const atf_check_expect_t *out_expect,
+                             const atf_check_expect_t *err_expect,
+                             const int timeout_ms,
+                             atf_check_result_t *r)
+{
+    return exec_array(argv, out_expect, err_expect, timeout_ms, true, r);
+}
@@ -27,9 +27,29 @@
 #define ATF_C_CHECK_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #include <atf-c/error_fwd.h>
 
+/* ---------------------------------------------------------------------
+ * The "atf_check_expect" type.
+ * --------------------------------------------------------------------- */
+
+/* The expected contents of an output of a command.  The output is compared
+ * with them while the command runs, and the command is sent m_signo,
+ * SIGKILL by default, as soon as the output differs from them or grows
+ * past their size.  The rest of the output is discarded, and the command
+ * is sent SIGKILL if it has not exited a second later. */
+struct atf_check_expect {
+    const void *m_data;
+    size_t m_size;
+    int m_signo;
+};
+typedef struct atf_check_expect atf_check_expect_t;
+
+void atf_check_expect_init(atf_check_expect_t *, const void *, const size_t);
+
 /* ---------------------------------------------------------------------
  * The "atf_check_result" type.
  * --------------------------------------------------------------------- */
@@ -44,12 +64,33 @@ typedef struct atf_check_result atf_check_result_t;
 void atf_check_result_fini(atf_check_result_t *);
 
 /* Getters */
+
+/* The files holding the outputs of a command run by atf_check_exec_array
+ * always exist.  Those of a command run by the other functions are only
+ * created, which can fail, by the _path variants. */
 const char *atf_check_result_stdout(const atf_check_result_t *);
 const char *atf_check_result_stderr(const atf_check_result_t *);
+atf_error_t atf_check_result_stdout_path(const atf_check_result_t *,
+                                         const char **);
+atf_error_t atf_check_result_stderr_path(const atf_check_result_t *,
+                                         const char **);
+const char *atf_check_result_stdout_data(const atf_check_result_t *, size_t *);
+const char *atf_check_result_stderr_data(const atf_check_result_t *, size_t *);
+bool atf_check_result_stdout_diverged(const atf_check_result_t *, size_t *);
+bool atf_check_result_stderr_diverged(const atf_check_result_t *, size_t *);
 bool atf_check_result_exited(const atf_check_result_t *);
 int atf_check_result_exitcode(const atf_check_result_t *);
 bool atf_check_result_signaled(const atf_check_result_t *);
 int atf_check_result_termsig(const atf_check_result_t *);
+bool atf_check_result_timed_out(const atf_check_result_t *);
+int64_t atf_check_result_wall_usec(const atf_check_result_t *);
+int64_t atf_check_result_user_usec(const atf_check_result_t *);
+int64_t atf_check_result_system_usec(const atf_check_result_t *);
+long atf_check_result_maxrss_kb(const atf_check_result_t *);
+long atf_check_result_minflt(const atf_check_result_t *);
+long atf_check_result_majflt(const atf_check_result_t *);
+long atf_check_result_nvcsw(const atf_check_result_t *);
+long atf_check_result_nivcsw(const atf_check_result_t *);
 
 /* ---------------------------------------------------------------------
  * Free functions.
@@ -65,5 +106,14 @@ atf_error_t atf_check_build_cxx_o(const char *, const char *,
                                   const char *const [],
                                   bool *);
 atf_error_t atf_check_exec_array(const char *const *, atf_check_result_t *);
+atf_error_t atf_check_exec_array_expect(const char *const *,
+                                        const atf_check_expect_t *,
+                                        const atf_check_expect_t *,
+                                        atf_check_result_t *);
+atf_error_t atf_check_exec_array_timeout(const char *const *,
+                                         const atf_check_expect_t *,
+                                         const atf_check_expect_t *,
+                                         const int,
+                                         atf_check_result_t *);
 
 #endif /* !defined(ATF_C_CHECK_H) */
@@ -25,6 +25,9 @@
 
 #include "atf-c/check.h"
 
+#include <sys/stat.h>
+
+#include <dirent.h>
 #include <fcntl.h>
 #include <signal.h>
 #include <stdio.h>
@@ -34,6 +37,7 @@
 
 #include <atf-c.h>
 
+#include "atf-c/detail/env.h"
 #include "atf-c/detail/fs.h"
 #include "atf-c/detail/map.h"
 #include "atf-c/detail/process.h"
@@ -81,6 +85,43 @@ do_exec_with_arg(const atf_tc_t *tc, const char *helper_name, const char *arg,
     atf_fs_path_fini(&process_helpers);
 }
 
+static
+void
+do_exec_expect(const atf_tc_t *tc, const char *helper_name, const char *arg,
+               const atf_check_expect_t *out_expect,
+               const atf_check_expect_t *err_expect, atf_check_result_t *r)
+{
+    atf_fs_path_t process_helpers;
+    const char *argv[4];
+
+    get_process_helpers_path(tc, false, &process_helpers);
+
+    argv[0] = atf_fs_path_cstring(&process_helpers);
+    argv[1] = helper_name;
+    argv[2] = arg;
+    argv[3] = NULL;
+    printf("Executing %s %s\n", argv[0], argv[1]);
+    RE(atf_check_exec_array_expect(argv, out_expect, err_expect, r));
+
+    atf_fs_path_fini(&process_helpers);
+}
+
+/* Builds the output of the stdout-stderr-large helper for the given
+ * stream and number of lines. */
+static
+char *
+large_output(const char *name, const size_t lines, size_t *size)
+{
+    char *text = malloc(lines * 16 + 1);
+    size_t i;
+
+    ATF_REQUIRE(text != NULL);
+    for (i = 0; i < lines; i++)
+        snprintf(text + i * 16, 17, "%08zu %s\n", i, name);
+    *size = lines * 16;
+    return text;
+}
+
 static
 void
 check_line(int fd, const char *exp)
@@ -91,6 +132,35 @@ check_line(int fd, const char *exp)
     free(line);
 }
 
+static
+bool
+dir_is_empty(const atf_fs_path_t *path)
+{
+    DIR *dir;
+    struct dirent *de;
+    bool empty = true;
+
+    dir = opendir(atf_fs_path_cstring(path));
+    ATF_REQUIRE(dir != NULL);
+    while ((de = readdir(dir)) != NULL) {
+        if (strcmp(de->d_name, ".") != 0 && strcmp(de->d_name, "..") != 0)
+            empty = false;
+    }
+    closedir(dir);
+
+    return empty;
+}
+
+static
+off_t
+file_size(const char *path)
+{
+    struct stat sb;
+
+    ATF_REQUIRE(stat(path, &sb) != -1);
+    return sb.st_size;
+}
+
 /* ---------------------------------------------------------------------
  * Helper test cases for the free functions.
  * --------------------------------------------------------------------- */
@@ -454,23 +524,211 @@ ATF_TC_BODY(exec_stdout_stderr, tc)
     atf_check_result_fini(&result1);
 }
 
+ATF_TC(exec_data);
+ATF_TC_HEAD(exec_data, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks that atf_check_exec_array_expect "
+                      "keeps small outputs in memory and only creates "
+                      "files for them on demand");
+}
+ATF_TC_BODY(exec_data, tc)
+{
+    atf_check_result_t result;
+    atf_fs_path_t tmpdir;
+    const char *data;
+    size_t size;
+
+    RE(atf_fs_path_init_fmt(&tmpdir, "tmp.XXXXXX"));
+    RE(atf_fs_mkdtemp(&tmpdir));
+    RE(atf_env_set("TMPDIR", atf_fs_path_cstring(&tmpdir)));
+
+    do_exec_expect(tc, "stdout-stderr", "data", NULL, NULL, &result);
+
+    data = atf_check_result_stdout_data(&result, &size);
+    ATF_REQUIRE(data != NULL);
+    ATF_CHECK_EQ(strlen("Line 1 to stdout for data\n") * 2, size);
+    ATF_CHECK(memcmp(data, "Line 1 to stdout for data\n"
+                     "Line 2 to stdout for data\n", size) == 0);
+
+    data = atf_check_result_stderr_data(&result, &size);
+    ATF_REQUIRE(data != NULL);
+    ATF_CHECK_EQ(strlen("Line 1 to stderr for data\n") * 2, size);
+    ATF_CHECK(memcmp(data, "Line 1 to stderr for data\n"
+                     "Line 2 to stderr for data\n", size) == 0);
+
+    ATF_CHECK(dir_is_empty(&tmpdir));
+
+    {
+        const char *path;
+        int fd;
+
+        RE(atf_check_result_stderr_path(&result, &path));
+        ATF_CHECK_STREQ(path, atf_check_result_stderr(&result));
+        fd = open(path, O_RDONLY);
+        ATF_CHECK(fd != -1);
+        check_line(fd, "Line 1 to stderr for data");
+        check_line(fd, "Line 2 to stderr for data");
+        close(fd);
+    }
+    ATF_CHECK(!dir_is_empty(&tmpdir));
+
+    atf_check_result_fini(&result);
+    ATF_CHECK(dir_is_empty(&tmpdir));
+    atf_fs_path_fini(&tmpdir);
+}
+
+ATF_TC(exec_data_files);
+ATF_TC_HEAD(exec_data_files, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks that atf_check_exec_array "
+                      "creates the files for small outputs before returning "
+                      "and still keeps them in memory");
+}
+ATF_TC_BODY(exec_data_files, tc)
+{
+    atf_check_result_t result;
+    atf_fs_path_t tmpdir;
+    const char *data;
+    size_t size;
+
+    RE(atf_fs_path_init_fmt(&tmpdir, "tmp.XXXXXX"));
+    RE(atf_fs_mkdtemp(&tmpdir));
+    RE(atf_env_set("TMPDIR", atf_fs_path_cstring(&tmpdir)));
+
+    do_exec_with_arg(tc, "stdout-stderr", "data", &result);
+    ATF_CHECK(!dir_is_empty(&tmpdir));
+
+    data = atf_check_result_stdout_data(&result, &size);
+    ATF_REQUIRE(data != NULL);
+    ATF_CHECK_EQ(strlen("Line 1 to stdout for data\n") * 2, size);
+
+    {
+        const char *path = atf_check_result_stdout(&result);
+        int fd = open(path, O_RDONLY);
+        ATF_CHECK(fd != -1);
+        check_line(fd, "Line 1 to stdout for data");
+        check_line(fd, "Line 2 to stdout for data");
+        close(fd);
+    }
+
+    atf_check_result_fini(&result);
+    ATF_CHECK(dir_is_empty(&tmpdir));
+    atf_fs_path_fini(&tmpdir);
+}
+
+ATF_TC(exec_expect);
+ATF_TC_HEAD(exec_expect, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks that atf_check_exec_array_expect "
+                      "kills the command as soon as its output diverges "
+                      "from the expected contents");
+    atf_tc_set_md_var(tc, "timeout", "60");
+}
+ATF_TC_BODY(exec_expect, tc)
+{
+    atf_check_expect_t out_expect, err_expect;
+    atf_check_result_t result;
+    size_t out_size, err_size, offset;
+    char *out_text = large_output("stdout", 1000, &out_size);
+    char *err_text = large_output("stderr", 1000, &err_size);
+
+    atf_check_expect_init(&out_expect, out_text, out_size);
+    atf_check_expect_init(&err_expect, err_text, err_size);
+
+    /* Matching outputs do not interfere with the command. */
+    do_exec_expect(tc, "stdout-stderr-large", "1000", &out_expect,
+                   &err_expect, &result);
+    ATF_CHECK(atf_check_result_exited(&result));
+    ATF_CHECK_EQ(EXIT_SUCCESS, atf_check_result_exitcode(&result));
+    ATF_CHECK(!atf_check_result_stdout_diverged(&result, &offset));
+    ATF_CHECK(!atf_check_result_stderr_diverged(&result, &offset));
+    atf_check_result_fini(&result);
+
+    /* An output longer than expected diverges where the expected contents
+     * end; the command would otherwise never finish. */
+    do_exec_expect(tc, "stdout-forever", NULL, &out_expect, NULL, &result);
+    ATF_CHECK(atf_check_result_signaled(&result));
+    ATF_CHECK_EQ(SIGKILL, atf_check_result_termsig(&result));
+    ATF_CHECK(atf_check_result_stdout_diverged(&result, &offset));
+    ATF_CHECK_EQ(out_size, offset);
+    ATF_CHECK(!atf_check_result_stderr_diverged(&result, &offset));
+    atf_check_result_fini(&result);
+
+    /* A different byte makes the output diverge at its offset. */
+    out_text[500 * 16 + 3] = 'x';
+    out_expect.m_signo = SIGTERM;
+    do_exec_expect(tc, "stdout-forever", NULL, &out_expect, NULL, &result);
+    ATF_CHECK(atf_check_result_signaled(&result));
+    ATF_CHECK_EQ(SIGTERM, atf_check_result_termsig(&result));
+    ATF_CHECK(atf_check_result_stdout_diverged(&result, &offset));
+    ATF_CHECK_EQ(500 * 16 + 3, offset);
+    atf_check_result_fini(&result);
+
+    free(err_text);
+    free(out_text);
+}
+
+ATF_TC(exec_large_output);
+ATF_TC_HEAD(exec_large_output, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks that atf_check_exec_array "
+                      "reads both outputs at once and stores them in files "
+                      "when they are too large to keep in memory");
+    atf_tc_set_md_var(tc, "timeout", "60");
+}
+ATF_TC_BODY(exec_large_output, tc)
+{
+    atf_check_result_t result;
+    const char *path;
+    size_t size;
+    int fd;
+
+    /* 1 MB on each stream, written in turns; the child would block
+     * forever if we drained the outputs one after the other. */
+    do_exec_with_arg(tc, "stdout-stderr-large", "65536", &result);
+    ATF_CHECK(atf_check_result_exited(&result));
+    ATF_CHECK_EQ(EXIT_SUCCESS, atf_check_result_exitcode(&result));
+
+    ATF_CHECK(atf_check_result_stdout_data(&result, &size) == NULL);
+    ATF_CHECK(atf_check_result_stderr_data(&result, &size) == NULL);
+
+    path = atf_check_result_stdout(&result);
+    ATF_CHECK_EQ(65536 * 16, file_size(path));
+    fd = open(path, O_RDONLY);
+    ATF_CHECK(fd != -1);
+    check_line(fd, "00000000 stdout");
+    check_line(fd, "00000001 stdout");
+    close(fd);
+
+    path = atf_check_result_stderr(&result);
+    ATF_CHECK_EQ(65536 * 16, file_size(path));
+    fd = open(path, O_RDONLY);
+    ATF_CHECK(fd != -1);
+    check_line(fd, "00000000 stderr");
+    close(fd);
+
+    atf_check_result_fini(&result);
+}
+
 ATF_TC(exec_umask);
 ATF_TC_HEAD(exec_umask, tc)
 {
     atf_tc_set_md_var(tc, "descr", "Checks that atf_check_exec_array "
                       "correctly reports an error if the umask is too "
-                      "restrictive to create temporary files");
+                      "restrictive to store large outputs in temporary "
+                      "files");
 }
 ATF_TC_BODY(exec_umask, tc)
 {
     atf_check_result_t result;
     atf_fs_path_t process_helpers;
-    const char *argv[3];
+    const char *argv[4];
 
     get_process_helpers_path(tc, false, &process_helpers);
     argv[0] = atf_fs_path_cstring(&process_helpers);
-    argv[1] = "exit-success";
-    argv[2] = NULL;
+    argv[1] = "stdout-stderr-large";
+    argv[2] = "65536";
+    argv[3] = NULL;
 
     umask(0222);
     atf_error_t err = atf_check_exec_array(argv, &result);
@@ -481,6 +739,37 @@ ATF_TC_BODY(exec_umask, tc)
     atf_fs_path_fini(&process_helpers);
 }
 
+ATF_TC(exec_umask_small);
+ATF_TC_HEAD(exec_umask_small, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks that atf_check_exec_array_expect "
+                      "does not need temporary files for small outputs");
+}
+ATF_TC_BODY(exec_umask_small, tc)
+{
+    atf_check_result_t result;
+    atf_error_t err;
+    const char *data, *path;
+    size_t size;
+
+    umask(0222);
+    do_exec_expect(tc, "echo", "test-message", NULL, NULL, &result);
+    ATF_CHECK(atf_check_result_exited(&result));
+    ATF_CHECK_EQ(EXIT_SUCCESS, atf_check_result_exitcode(&result));
+
+    data = atf_check_result_stdout_data(&result, &size);
+    ATF_REQUIRE(data != NULL);
+    ATF_CHECK_EQ(strlen("test-message\n"), size);
+    ATF_CHECK(memcmp(data, "test-message\n", size) == 0);
+
+    err = atf_check_result_stdout_path(&result, &path);
+    ATF_CHECK(atf_is_error(err));
+    ATF_CHECK(atf_error_is(err, "invalid_umask"));
+    atf_error_free(err);
+
+    atf_check_result_fini(&result);
+}
+
 ATF_TC(exec_unknown);
 ATF_TC_HEAD(exec_unknown, tc)
 {
@@ -500,6 +789,143 @@ ATF_TC_BODY(exec_unknown, tc)
     atf_check_result_fini(&result);
 }
 
+ATF_TC(exec_timeout);
+ATF_TC_HEAD(exec_timeout, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks that atf_check_exec_array_timeout "
+                      "kills a command that runs for too long and keeps its "
+                      "partial output");
+    atf_tc_set_md_var(tc, "timeout", "30");
+}
+ATF_TC_BODY(exec_timeout, tc)
+{
+    const char *argv[4];
+    const char *data;
+    size_t size;
+
+    argv[0] = "/bin/sh";
+    argv[1] = "-c";
+    argv[2] = "echo partial; echo error 1>&2; sleep 60";
+    argv[3] = NULL;
+
+    {
+        atf_check_result_t result;
+        RE(atf_check_exec_array_timeout(argv, NULL, NULL, 200, &result));
+        ATF_CHECK(atf_check_result_timed_out(&result));
+        ATF_CHECK(atf_check_result_signaled(&result));
+        ATF_CHECK_EQ(SIGTERM, atf_check_result_termsig(&result));
+        data = atf_check_result_stdout_data(&result, &size);
+        ATF_REQUIRE(data != NULL);
+        ATF_CHECK_EQ(8, size);
+        ATF_CHECK(strncmp("partial\n", data, size) == 0);
+        data = atf_check_result_stderr_data(&result, &size);
+        ATF_REQUIRE(data != NULL);
+        ATF_CHECK(strncmp("error\n", data, size) == 0);
+        atf_check_result_fini(&result);
+    }
+
+    argv[2] = "echo done";
+    {
+        atf_check_result_t result;
+        RE(atf_check_exec_array_timeout(argv, NULL, NULL, 10000, &result));
+        ATF_CHECK(!atf_check_result_timed_out(&result));
+        ATF_CHECK(atf_check_result_exited(&result));
+        ATF_CHECK_EQ(EXIT_SUCCESS, atf_check_result_exitcode(&result));
+        atf_check_result_fini(&result);
+    }
+
+    /* An output that diverges gets the whole process group killed, not
+     * only the shell, so that none of its children outlives it. */
+    argv[2] = "(sleep 2; touch late) & echo y; echo y; wait";
+    {
+        atf_check_expect_t expect;
+        atf_check_result_t result;
+        size_t offset;
+
+        atf_check_expect_init(&expect, "y\n", 2);
+        expect.m_signo = SIGTERM;
+        RE(atf_check_exec_array_timeout(argv, &expect, NULL, 20000,
+                                        &result));
+        ATF_CHECK(!atf_check_result_timed_out(&result));
+        ATF_CHECK(atf_check_result_stdout_diverged(&result, &offset));
+        ATF_CHECK(atf_check_result_signaled(&result));
+        ATF_CHECK_EQ(SIGTERM, atf_check_result_termsig(&result));
+        atf_check_result_fini(&result);
+
+        sleep(3);
+        ATF_CHECK(access("late", F_OK) == -1);
+    }
+}
+
+ATF_TC(exec_expect_ignored_signal);
+ATF_TC_HEAD(exec_expect_ignored_signal, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks that a command that ignores "
+                      "the signal sent when its output diverges and keeps "
+                      "writing is killed instead of blocking forever");
+    atf_tc_set_md_var(tc, "timeout", "30");
+}
+ATF_TC_BODY(exec_expect_ignored_signal, tc)
+{
+    const char *argv[4];
+    atf_check_expect_t expect;
+    atf_check_result_t result;
+    size_t offset;
+
+    argv[0] = "/bin/sh";
+    argv[1] = "-c";
+    argv[2] = "trap '' TERM; while :; do echo y; done";
+    argv[3] = NULL;
+
+    atf_check_expect_init(&expect, "x\n", 2);
+    expect.m_signo = SIGTERM;
+    RE(atf_check_exec_array_timeout(argv, &expect, NULL, 20000, &result));
+    ATF_CHECK(!atf_check_result_timed_out(&result));
+    ATF_CHECK(atf_check_result_stdout_diverged(&result, &offset));
+    ATF_CHECK_EQ(0, offset);
+    ATF_CHECK(atf_check_result_signaled(&result));
+    ATF_CHECK_EQ(SIGKILL, atf_check_result_termsig(&result));
+    atf_check_result_fini(&result);
+}
+
+ATF_TC(exec_usage);
+ATF_TC_HEAD(exec_usage, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks that atf_check_exec_array "
+                      "records the resources consumed by the command");
+}
+ATF_TC_BODY(exec_usage, tc)
+{
+    atf_check_result_t result;
+
+    do_exec_with_arg(tc, "stdout-stderr-large", "100000", &result);
+    ATF_CHECK(atf_check_result_exited(&result));
+    ATF_CHECK(atf_check_result_exitcode(&result) == EXIT_SUCCESS);
+
+    printf("wall %lld us, user %lld us, system %lld us, maxrss %ld KB, "
+           "minflt %ld, majflt %ld, nvcsw %ld, nivcsw %ld\n",
+           (long long)atf_check_result_wall_usec(&result),
+           (long long)atf_check_result_user_usec(&result),
+           (long long)atf_check_result_system_usec(&result),
+           atf_check_result_maxrss_kb(&result),
+           atf_check_result_minflt(&result),
+           atf_check_result_majflt(&result),
+           atf_check_result_nvcsw(&result),
+           atf_check_result_nivcsw(&result));
+    ATF_CHECK(atf_check_result_wall_usec(&result) > 0);
+    ATF_CHECK(atf_check_result_user_usec(&result) +
+              atf_check_result_system_usec(&result) > 0);
+    ATF_CHECK(atf_check_result_wall_usec(&result) >=
+              atf_check_result_user_usec(&result) / 2);
+    ATF_CHECK(atf_check_result_maxrss_kb(&result) > 0);
+    ATF_CHECK(atf_check_result_minflt(&result) > 0);
+    ATF_CHECK(atf_check_result_majflt(&result) >= 0);
+    ATF_CHECK(atf_check_result_nvcsw(&result) +
+              atf_check_result_nivcsw(&result) >= 0);
+
+    atf_check_result_fini(&result);
+}
+
 /* ---------------------------------------------------------------------
  * Main.
  * --------------------------------------------------------------------- */
@@ -512,10 +938,18 @@ ATF_TP_ADD_TCS(tp)
     ATF_TP_ADD_TC(tp, build_cxx_o);
     ATF_TP_ADD_TC(tp, exec_array);
     ATF_TP_ADD_TC(tp, exec_cleanup);
+    ATF_TP_ADD_TC(tp, exec_data);
+    ATF_TP_ADD_TC(tp, exec_data_files);
     ATF_TP_ADD_TC(tp, exec_exitstatus);
+    ATF_TP_ADD_TC(tp, exec_expect);
+    ATF_TP_ADD_TC(tp, exec_large_output);
     ATF_TP_ADD_TC(tp, exec_stdout_stderr);
+    ATF_TP_ADD_TC(tp, exec_timeout);
+    ATF_TP_ADD_TC(tp, exec_expect_ignored_signal);
     ATF_TP_ADD_TC(tp, exec_umask);
+    ATF_TP_ADD_TC(tp, exec_umask_small);
     ATF_TP_ADD_TC(tp, exec_unknown);
+    ATF_TP_ADD_TC(tp, exec_usage);
 
     return atf_no_error();
 }
@@ -0,0 +1,904 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/batch.h"
+
+#include <sys/types.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "atf-c/defs.h"
+#include "atf-c/detail/process.h"
+#include "atf-c/detail/sanity.h"
+#include "atf-c/detail/text.h"
+#include "atf-c/detail/usage.h"
+#include "atf-c/error.h"
+#include "atf-c/tc.h"
+
+/* Every test case run by the batch scheduler gets its own subdirectory in
+ * the results directory, named after the test case, with the following
+ * contents:
+ *
+ *     result: the results file of the test case body.
+ *     result.usage: the resources consumed by the test case body.
+ *     result.bench: the statistics of the body, for benchmarks only.
+ *     stdout: the standard output of the body and the cleanup routine.
+ *     stderr: the standard error of the body and the cleanup routine.
+ *     work: the directory in which the test case is executed.
+ *
+ * Each test case part runs in its own subprocess forked from the test
+ * program, in a new process group so that it can be killed as a whole if
+ * it exceeds its timeout.  Up to a given number of test cases run
+ * concurrently, except for those marked as exclusive, which are deferred
+ * until all others are done and then run one at a time. */
+
+/* Default value of the "timeout" property; see atf-test-case(4). */
+static const long default_timeout = 300;
+
+/* ---------------------------------------------------------------------
+ * Auxiliary functions.
+ * --------------------------------------------------------------------- */
+
+static
+int64_t
+now_ms(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == -1)
+        UNREACHABLE;
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static
+atf_error_t
+mkdir_if_missing(const atf_fs_path_t *path)
+{
+    atf_error_t err;
+
+    if (mkdir(atf_fs_path_cstring(path), 0755) == -1 && errno != EEXIST)
+        err = atf_libc_error(errno, "Cannot create directory %s",
+                             atf_fs_path_cstring(path));
+    else
+        err = atf_no_error();
+
+    return err;
+}
+
+static
+atf_error_t
+open_output(const atf_fs_path_t *dir, const char *name, int *fd)
+{
+    atf_error_t err;
+    atf_fs_path_t path;
+
+    err = atf_fs_path_copy(&path, dir);
+    if (atf_is_error(err))
+        goto out;
+
+    err = atf_fs_path_append_fmt(&path, "%s", name);
+    if (atf_is_error(err))
+        goto out_path;
+
+    *fd = open(atf_fs_path_cstring(&path),
+               O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (*fd == -1)
+        err = atf_libc_error(errno, "Cannot create %s",
+                             atf_fs_path_cstring(&path));
+
+out_path:
+    atf_fs_path_fini(&path);
+out:
+    return err;
+}
+
+static
+atf_error_t
+get_bool_md_var(const atf_tc_t *tc, const char *name, bool *value)
+{
+    if (!atf_tc_has_md_var(tc, name)) {
+        *value = false;
+        return atf_no_error();
+    }
+    return atf_text_to_bool(atf_tc_get_md_var(tc, name), value);
+}
+
+static
+atf_error_t
+get_timeout_md_var(const atf_tc_t *tc, long *value)
+{
+    if (!atf_tc_has_md_var(tc, "timeout")) {
+        *value = default_timeout;
+        return atf_no_error();
+    }
+    return atf_text_to_long(atf_tc_get_md_var(tc, "timeout"), value);
+}
+
+/* ---------------------------------------------------------------------
+ * The SIGCHLD self-pipe.
+ * --------------------------------------------------------------------- */
+
+static int sigchld_pipe[2] = { -1, -1 };
+static struct sigaction old_sigchld;
+
+static
+void
+sigchld_handler(const int signo ATF_DEFS_ATTRIBUTE_UNUSED)
+{
+    const int errnocopy = errno;
+
+    /* If the pipe is full, a wakeup is already pending. */
+    if (write(sigchld_pipe[1], "", 1) == -1) {}
+
+    errno = errnocopy;
+}
+
+static
+atf_error_t
+set_nonblock_cloexec(const int fd)
+{
+    const int flags = fcntl(fd, F_GETFL);
+
+    if (flags == -1 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1 ||
+        fcntl(fd, F_SETFD, FD_CLOEXEC) == -1)
+        return atf_libc_error(errno, "Cannot configure descriptor %d", fd);
+    return atf_no_error();
+}
+
+static
+atf_error_t
+sigchld_setup(void)
+{
+    atf_error_t err;
+    struct sigaction sa;
+
+    PRE(sigchld_pipe[0] == -1 && sigchld_pipe[1] == -1);
+
+    if (pipe(sigchld_pipe) == -1)
+        return atf_libc_error(errno, "Failed to create pipe");
+
+    err = set_nonblock_cloexec(sigchld_pipe[0]);
+    if (!atf_is_error(err))
+        err = set_nonblock_cloexec(sigchld_pipe[1]);
+    if (atf_is_error(err))
+        goto err_pipe;
+
+    sa.sa_handler = sigchld_handler;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_NOCLDSTOP | SA_RESTART;
+    if (sigaction(SIGCHLD, &sa, &old_sigchld) == -1) {
+        err = atf_libc_error(errno, "Cannot install SIGCHLD handler");
+        goto err_pipe;
+    }
+
+    return atf_no_error();
+
+err_pipe:
+    close(sigchld_pipe[0]);
+    close(sigchld_pipe[1]);
+    sigchld_pipe[0] = sigchld_pipe[1] = -1;
+    return err;
+}
+
+static
+void
+sigchld_teardown(void)
+{
+    (void)sigaction(SIGCHLD, &old_sigchld, NULL);
+    close(sigchld_pipe[0]);
+    close(sigchld_pipe[1]);
+    sigchld_pipe[0] = sigchld_pipe[1] = -1;
+}
+
+static
+void
+sigchld_drain(void)
+{
+    char buf[64];
+
+    while (read(sigchld_pipe[0], buf, sizeof(buf)) > 0)
+        continue;
+}
+
+/* ---------------------------------------------------------------------
+ * The "job" type.
+ * --------------------------------------------------------------------- */
+
+enum job_part {
+    BODY,
+    CLEANUP,
+};
+
+struct job {
+    const atf_tc_t *m_tc;
+    bool m_exclusive;
+    bool m_has_cleanup;
+    long m_timeout;
+
+    /* Valid while the job is running. */
+    enum job_part m_part;
+    pid_t m_pid;
+    int64_t m_deadline;
+    bool m_timed_out;
+    bool m_success;
+    atf_fs_path_t m_workdir;
+    atf_fs_path_t m_resfile;
+    int m_outfd;
+    int m_errfd;
+    atf_usage_mark_t m_usage;
+};
+
+static
+atf_error_t
+job_init(struct job *j, const atf_tc_t *tc)
+{
+    atf_error_t err;
+
+    j->m_tc = tc;
+    j->m_pid = -1;
+
+    err = get_bool_md_var(tc, "is.exclusive", &j->m_exclusive);
+    if (!atf_is_error(err))
+        err = get_bool_md_var(tc, "has.cleanup", &j->m_has_cleanup);
+    if (!atf_is_error(err))
+        err = get_timeout_md_var(tc, &j->m_timeout);
+
+    return err;
+}
+
+static
+atf_error_t
+job_prepare(struct job *j, const atf_fs_path_t *resdir)
+{
+    atf_error_t err;
+    atf_fs_path_t tcdir;
+
+    err = atf_fs_path_copy(&tcdir, resdir);
+    if (atf_is_error(err))
+        goto out;
+    err = atf_fs_path_append_fmt(&tcdir, "%s", atf_tc_get_ident(j->m_tc));
+    if (atf_is_error(err))
+        goto out_tcdir;
+    err = mkdir_if_missing(&tcdir);
+    if (atf_is_error(err))
+        goto out_tcdir;
+
+    err = atf_fs_path_copy(&j->m_workdir, &tcdir);
+    if (atf_is_error(err))
+        goto out_tcdir;
+    err = atf_fs_path_append_fmt(&j->m_workdir, "work");
+    if (atf_is_error(err))
+        goto err_workdir;
+    err = mkdir_if_missing(&j->m_workdir);
+    if (atf_is_error(err))
+        goto err_workdir;
+
+    err = atf_fs_path_copy(&j->m_resfile, &tcdir);
+    if (atf_is_error(err))
+        goto err_workdir;
+    err = atf_fs_path_append_fmt(&j->m_resfile, "result");
+    if (atf_is_error(err))
+        goto err_resfile;
+
+    err = open_output(&tcdir, "stdout", &j->m_outfd);
+    if (atf_is_error(err))
+        goto err_resfile;
+    err = open_output(&tcdir, "stderr", &j->m_errfd);
+    if (atf_is_error(err))
+        goto err_outfd;
+
+    j->m_success = true;
+    goto out_tcdir;
+
+err_outfd:
+    close(j->m_outfd);
+err_resfile:
+    atf_fs_path_fini(&j->m_resfile);
+err_workdir:
+    atf_fs_path_fini(&j->m_workdir);
+out_tcdir:
+    atf_fs_path_fini(&tcdir);
+out:
+    return err;
+}
+
+static
+void
+job_release(struct job *j)
+{
+    close(j->m_errfd);
+    close(j->m_outfd);
+    atf_fs_path_fini(&j->m_resfile);
+    atf_fs_path_fini(&j->m_workdir);
+}
+
+static
+void
+job_child_start(void *v)
+{
+    const struct job *j = v;
+    atf_error_t err;
+    int fd;
+
+    (void)setpgid(0, 0);
+    sigchld_teardown();
+
+    fd = open("/dev/zero", O_RDONLY);
+    if (fd != -1 && fd != STDIN_FILENO) {
+        dup2(fd, STDIN_FILENO);
+        close(fd);
+    }
+
+    if (chdir(atf_fs_path_cstring(&j->m_workdir)) == -1)
+        err = atf_libc_error(errno, "Cannot enter work directory %s",
+                             atf_fs_path_cstring(&j->m_workdir));
+    else if (j->m_part == BODY)
+        err = atf_tc_run(j->m_tc, atf_fs_path_cstring(&j->m_resfile));
+    else
+        err = atf_tc_cleanup(j->m_tc);
+
+    if (atf_is_error(err)) {
+        char buf[1024];
+
+        atf_error_format(err, buf, sizeof(buf));
+        fprintf(stderr, "ERROR: %s\n", buf);
+        atf_error_free(err);
+        exit(EXIT_FAILURE);
+    }
+    exit(EXIT_SUCCESS);
+}
+
+static
+atf_error_t
+job_start(struct job *j, const enum job_part part)
+{
+    atf_error_t err;
+    atf_process_stream_t outsb, errsb;
+    atf_process_child_t child;
+
+    err = atf_process_stream_init_redirect_fd(&outsb, j->m_outfd);
+    if (atf_is_error(err))
+        goto out;
+
+    err = atf_process_stream_init_redirect_fd(&errsb, j->m_errfd);
+    if (atf_is_error(err))
+        goto out_outsb;
+
+    j->m_part = part;
+    j->m_timed_out = false;
+
+    fflush(stdout);
+    fflush(stderr);
+    if (part == BODY)
+        atf_usage_mark_init(&j->m_usage, j->m_outfd, j->m_errfd);
+    err = atf_process_fork(&child, job_child_start, &outsb, &errsb, j);
+    if (atf_is_error(err))
+        goto out_errsb;
+
+    j->m_pid = atf_process_child_pid(&child);
+    (void)setpgid(j->m_pid, j->m_pid);
+    j->m_deadline = j->m_timeout > 0 ? now_ms() + j->m_timeout * 1000 : 0;
+
+out_errsb:
+    atf_process_stream_fini(&errsb);
+out_outsb:
+    atf_process_stream_fini(&outsb);
+out:
+    return err;
+}
+
+static
+void
+job_kill(struct job *j)
+{
+    PRE(j->m_pid != -1);
+
+    if (kill(-j->m_pid, SIGKILL) == -1)
+        (void)kill(j->m_pid, SIGKILL);
+}
+
+/* Records that the body of a job did not finish within its timeout, unless
+ * the test case had declared that it expected to hang. */
+static
+atf_error_t
+job_write_timeout_result(const struct job *j)
+{
+    static const char expected[] = "expected_timeout";
+    char buf[sizeof(expected) - 1];
+    atf_error_t err;
+    ssize_t ret;
+    int fd;
+
+    fd = open(atf_fs_path_cstring(&j->m_resfile), O_RDWR | O_CREAT, 0644);
+    if (fd == -1)
+        return atf_libc_error(errno, "Cannot open %s",
+                              atf_fs_path_cstring(&j->m_resfile));
+
+    ret = read(fd, buf, sizeof(buf));
+    if (ret == (ssize_t)sizeof(buf) && memcmp(buf, expected, ret) == 0) {
+        close(fd);
+        return atf_no_error();
+    }
+
+    if (ftruncate(fd, 0) == -1 || lseek(fd, 0, SEEK_SET) == -1 ||
+        dprintf(fd, "failed: Test case body timed out after %ld seconds\n",
+                j->m_timeout) < 0)
+        err = atf_libc_error(errno, "Cannot write %s",
+                             atf_fs_path_cstring(&j->m_resfile));
+    else
+        err = atf_no_error();
+
+    close(fd);
+    return err;
+}
+
+/* Records an error that prevented the batch from running or judging a job
+ * as the broken result of the job, which then counts as failed.  The error
+ * is consumed. */
+static
+void
+job_write_broken_result(struct job *j, atf_error_t err)
+{
+    char buf[1024];
+    int fd;
+
+    atf_error_format(err, buf, sizeof(buf));
+    atf_error_free(err);
+
+    j->m_success = false;
+
+    fd = open(atf_fs_path_cstring(&j->m_resfile),
+              O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd == -1 || dprintf(fd, "broken: %s\n", buf) < 0)
+        fprintf(stderr, "WARNING: Cannot record result of %s: %s\n",
+                atf_tc_get_ident(j->m_tc), buf);
+    if (fd != -1)
+        close(fd);
+}
+
+static
+bool
+result_is(const char *line, const size_t len, const char *name)
+{
+    return strlen(name) == len && strncmp(line, name, len) == 0;
+}
+
+/* Returns whether the result of a finished body is a success, given its
+ * results file and how its process terminated.  Failed results count as
+ * failures, and so do broken ones: a missing or malformed results file, or
+ * one that does not agree with the termination of the body.  Timed out
+ * bodies have their results file rewritten before this is called, so they
+ * are only successful if they expected to time out. */
+static
+bool
+job_body_succeeded(const struct job *j, const int status)
+{
+    char line[1024], *end;
+    const char *arg;
+    long value = 0;
+    ssize_t ret;
+    size_t len;
+    int fd;
+
+    fd = open(atf_fs_path_cstring(&j->m_resfile), O_RDONLY);
+    if (fd == -1)
+        return false;
+    ret = read(fd, line, sizeof(line) - 1);
+    close(fd);
+    if (ret <= 0)
+        return false;
+    line[ret] = '\0';
+    line[strcspn(line, "\n")] = '\0';
+
+    len = strcspn(line, "(:");
+    arg = NULL;
+    if (line[len] == '(') {
+        arg = line + len + 1;
+        value = strtol(arg, &end, 10);
+        if (end == arg || *end != ')')
+            return false;
+    }
+
+    if (result_is(line, len, "passed") || result_is(line, len, "skipped") ||
+        result_is(line, len, "expected_failure"))
+        return arg == NULL && WIFEXITED(status) &&
+            WEXITSTATUS(status) == EXIT_SUCCESS;
+    else if (result_is(line, len, "expected_timeout"))
+        return arg == NULL && j->m_timed_out;
+    else if (result_is(line, len, "expected_death"))
+        return arg == NULL && !j->m_timed_out;
+    else if (result_is(line, len, "expected_exit"))
+        return !j->m_timed_out && WIFEXITED(status) &&
+            (arg == NULL || WEXITSTATUS(status) == value);
+    else if (result_is(line, len, "expected_signal"))
+        return !j->m_timed_out && WIFSIGNALED(status) &&
+            (arg == NULL || WTERMSIG(status) == value);
+    else
+        return false;
+}
+
+/* Records the resources consumed by the body of a job.  This replaces the
+ * usage file written by the body itself, if any, because the usage returned
+ * by wait4(2) also covers bodies that crashed or timed out. */
+static
+atf_error_t
+job_write_usage(const struct job *j, const struct rusage *ru)
+{
+    atf_error_t err;
+    atf_usage_t usage;
+    int fd;
+
+    atf_usage_since_child(&j->m_usage, ru, &usage);
+
+    err = atf_usage_open(atf_fs_path_cstring(&j->m_resfile), &fd);
+    if (atf_is_error(err))
+        return err;
+    err = atf_usage_write(&usage, fd);
+    close(fd);
+    return err;
+}
+
+/* ---------------------------------------------------------------------
+ * The "batch" type.
+ * --------------------------------------------------------------------- */
+
+struct batch {
+    const atf_fs_path_t *m_resdir;
+
+    struct job *m_jobs;
+    size_t m_njobs;
+    size_t m_next;
+
+    struct job **m_running;
+    unsigned int m_slots;
+    unsigned int m_nrunning;
+    bool m_exclusive_running;
+
+    bool m_success;
+};
+
+static
+atf_error_t
+batch_init(struct batch *b, const atf_tc_t *const *tcs,
+           const atf_fs_path_t *resdir, const unsigned int slots)
+{
+    atf_error_t err;
+    const atf_tc_t *const *tcsptr;
+    size_t i, ntcs;
+    int pass;
+
+    b->m_resdir = resdir;
+    b->m_next = 0;
+    b->m_slots = slots;
+    b->m_nrunning = 0;
+    b->m_exclusive_running = false;
+    b->m_success = true;
+
+    ntcs = 0;
+    for (tcsptr = tcs; *tcsptr != NULL; tcsptr++)
+        ntcs++;
+
+    b->m_jobs = calloc(ntcs == 0 ? 1 : ntcs, sizeof(struct job));
+    if (b->m_jobs == NULL)
+        return atf_no_memory_error();
+
+    b->m_running = calloc(slots, sizeof(struct job *));
+    if (b->m_running == NULL) {
+        free(b->m_jobs);
+        return atf_no_memory_error();
+    }
+
+    /* Queue the exclusive test cases after all the others so that they
+     * do not prevent the rest from running concurrently. */
+    err = atf_no_error();
+    b->m_njobs = 0;
+    for (pass = 0; pass < 2 && !atf_is_error(err); pass++) {
+        for (i = 0; i < ntcs; i++) {
+            struct job j;
+
+            err = job_init(&j, tcs[i]);
+            if (atf_is_error(err))
+                break;
+            if (j.m_exclusive == (pass == 1))
+                b->m_jobs[b->m_njobs++] = j;
+        }
+    }
+    INV(atf_is_error(err) || b->m_njobs == ntcs);
+
+    if (atf_is_error(err)) {
+        free(b->m_running);
+        free(b->m_jobs);
+    }
+    return err;
+}
+
+static
+void
+batch_fini(struct batch *b)
+{
+    PRE(b->m_nrunning == 0);
+
+    free(b->m_running);
+    free(b->m_jobs);
+}
+
+static
+void
+batch_add_running(struct batch *b, struct job *j)
+{
+    unsigned int i;
+
+    for (i = 0; i < b->m_slots; i++) {
+        if (b->m_running[i] == NULL) {
+            b->m_running[i] = j;
+            b->m_nrunning++;
+            if (j->m_exclusive)
+                b->m_exclusive_running = true;
+            return;
+        }
+    }
+    UNREACHABLE;
+}
+
+static
+void
+batch_finish_job(struct batch *b, const unsigned int slot)
+{
+    struct job *j = b->m_running[slot];
+
+    j->m_pid = -1;
+    if (!j->m_success)
+        b->m_success = false;
+    if (j->m_exclusive)
+        b->m_exclusive_running = false;
+    job_release(j);
+
+    b->m_running[slot] = NULL;
+    b->m_nrunning--;
+}
+
+static
+atf_error_t
+batch_start_ready(struct batch *b)
+{
+    atf_error_t err = atf_no_error();
+
+    while (b->m_next < b->m_njobs && b->m_nrunning < b->m_slots &&
+           !b->m_exclusive_running) {
+        struct job *j = &b->m_jobs[b->m_next];
+
+        if (j->m_exclusive && b->m_nrunning > 0)
+            break;
+
+        err = job_prepare(j, b->m_resdir);
+        if (atf_is_error(err))
+            break;
+
+        err = job_start(j, BODY);
+        if (atf_is_error(err)) {
+            job_release(j);
+            break;
+        }
+
+        batch_add_running(b, j);
+        b->m_next++;
+    }
+
+    return err;
+}
+
+/* Handles the termination of the current part of the job in the given
+ * slot, which either moves the job on to its cleanup routine or finishes
+ * it.  Errors only affect this job, which gets a broken result, so that
+ * they do not stop the rest of the batch. */
+static
+void
+batch_part_done(struct batch *b, const unsigned int slot, const int status,
+                const struct rusage *ru)
+{
+    atf_error_t err;
+    struct job *j = b->m_running[slot];
+
+    if (j->m_part == BODY) {
+        err = job_write_usage(j, ru);
+        if (!atf_is_error(err) && j->m_timed_out)
+            err = job_write_timeout_result(j);
+        if (atf_is_error(err))
+            job_write_broken_result(j, err);
+        else if (!job_body_succeeded(j, status))
+            j->m_success = false;
+
+        if (j->m_has_cleanup) {
+            err = job_start(j, CLEANUP);
+            if (!atf_is_error(err))
+                return;
+            job_write_broken_result(j, err);
+        }
+    } else if (j->m_timed_out || !WIFEXITED(status) ||
+               WEXITSTATUS(status) != EXIT_SUCCESS)
+        j->m_success = false;
+
+    batch_finish_job(b, slot);
+}
+
+static
+atf_error_t
+batch_reap(struct batch *b)
+{
+    atf_error_t err = atf_no_error();
+
+    while (!atf_is_error(err) && b->m_nrunning > 0) {
+        struct rusage ru;
+        unsigned int i;
+        int status;
+        pid_t pid;
+
+        pid = wait4(-1, &status, WNOHANG, &ru);
+        if (pid == 0)
+            break;
+        else if (pid == -1) {
+            if (errno == EINTR)
+                continue;
+            err = atf_libc_error(errno, "Failed waiting for test cases");
+            break;
+        }
+
+        for (i = 0; i < b->m_slots; i++) {
+            if (b->m_running[i] != NULL && b->m_running[i]->m_pid == pid) {
+                batch_part_done(b, i, status, &ru);
+                break;
+            }
+        }
+    }
+
+    return err;
+}
+
+static
+atf_error_t
+batch_wait(struct batch *b)
+{
+    struct pollfd pfd;
+    int64_t now, next_deadline;
+    unsigned int i;
+    int timeout;
+
+    now = now_ms();
+    next_deadline = 0;
+    for (i = 0; i < b->m_slots; i++) {
+        struct job *j = b->m_running[i];
+
+        if (j == NULL || j->m_deadline == 0 || j->m_timed_out)
+            continue;
+
+        if (j->m_deadline <= now) {
+            j->m_timed_out = true;
+            job_kill(j);
+        } else if (next_deadline == 0 || j->m_deadline < next_deadline)
+            next_deadline = j->m_deadline;
+    }
+
+    if (next_deadline == 0)
+        timeout = -1;
+    else if (next_deadline - now > INT_MAX)
+        timeout = INT_MAX;
+    else
+        timeout = (int)(next_deadline - now);
+
+    pfd.fd = sigchld_pipe[0];
+    pfd.events = POLLIN;
+    if (poll(&pfd, 1, timeout) == -1 && errno != EINTR)
+        return atf_libc_error(errno, "Failed waiting for test cases");
+    sigchld_drain();
+
+    return batch_reap(b);
+}
+
+/* Kills and collects all running jobs after a scheduling error. */
+static
+void
+batch_abort(struct batch *b)
+{
+    unsigned int i;
+
+    for (i = 0; i < b->m_slots; i++) {
+        struct job *j = b->m_running[i];
+
+        if (j != NULL) {
+            job_kill(j);
+            while (waitpid(j->m_pid, NULL, 0) == -1 && errno == EINTR)
+                continue;
+            j->m_success = false;
+            batch_finish_job(b, i);
+        }
+    }
+}
+
+/* ---------------------------------------------------------------------
+ * Free functions.
+ * --------------------------------------------------------------------- */
+
+atf_error_t
+atf_batch_run(const atf_tc_t *const *tcs, const atf_fs_path_t *resdir,
+              const unsigned int jobs, bool *success)
+{
+    atf_error_t err;
+    atf_fs_path_t absresdir;
+    struct batch b;
+
+    PRE(jobs > 0);
+
+    err = mkdir_if_missing(resdir);
+    if (atf_is_error(err))
+        goto out;
+
+    /* The children change their working directory, so make sure that the
+     * paths we hand them do not depend on it. */
+    if (atf_fs_path_is_absolute(resdir))
+        err = atf_fs_path_copy(&absresdir, resdir);
+    else
+        err = atf_fs_path_to_absolute(resdir, &absresdir);
+    if (atf_is_error(err))
+        goto out;
+
+    err = batch_init(&b, tcs, &absresdir, jobs);
+    if (atf_is_error(err))
+        goto out_absresdir;
+
+    err = sigchld_setup();
+    if (atf_is_error(err))
+        goto out_b;
+
+    while (!atf_is_error(err) && (b.m_next < b.m_njobs || b.m_nrunning > 0)) {
+        err = batch_start_ready(&b);
+        if (!atf_is_error(err) && b.m_nrunning > 0)
+            err = batch_wait(&b);
+    }
+    if (atf_is_error(err))
+        batch_abort(&b);
+    else
+        *success = b.m_success;
+
+    sigchld_teardown();
+out_b:
+    batch_fini(&b);
+out_absresdir:
+    atf_fs_path_fini(&absresdir);
+out:
+    return err;
+}
@@ -0,0 +1,241 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/bench.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "atf-c/detail/dynstr.h"
+#include "atf-c/detail/sanity.h"
+#include "atf-c/error.h"
+
+/* A benchmark is run in three phases.  First, the number of iterations is
+ * calibrated by running the body with growing iteration counts until one
+ * run lasts for the target duration of a sample.  Then, one more run with
+ * the calibrated count warms up caches and branch predictors.  Finally,
+ * the body is run once per sample with that same count.
+ *
+ * The summary of the samples is stored next to the results file, in a
+ * file named after it with a ".bench" suffix, as a list of "name: value"
+ * lines followed by the samples themselves. */
+
+/* Upper bound to the growth of the iteration count between two calibration
+ * runs, which prevents a fast first run from overshooting the target. */
+static const size_t max_growth = 100;
+
+/* ---------------------------------------------------------------------
+ * Auxiliary functions.
+ * --------------------------------------------------------------------- */
+
+static
+int64_t
+now_nsec(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == -1)
+        UNREACHABLE;
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static
+int64_t
+time_run(const atf_tc_t *tc, atf_tc_bench_t body, const size_t iterations)
+{
+    const int64_t start = now_nsec();
+    body(tc, iterations);
+    return now_nsec() - start;
+}
+
+/* Returns the number of iterations that makes a run of the body last for
+ * at least 'target' nanoseconds. */
+static
+size_t
+calibrate(const atf_tc_t *tc, atf_tc_bench_t body, const int64_t target)
+{
+    size_t iterations = 1;
+
+    for (;;) {
+        const int64_t elapsed = time_run(tc, body, iterations);
+        double predicted;
+        size_t next;
+
+        if (elapsed >= target || iterations >= SIZE_MAX / max_growth)
+            break;
+
+        /* Aim slightly above the target so that we converge quickly. */
+        predicted = elapsed <= 0 ? (double)SIZE_MAX :
+            (double)iterations * target * 1.2 / elapsed;
+        if (predicted >= (double)(iterations * max_growth))
+            next = iterations * max_growth;
+        else if (predicted <= (double)iterations)
+            next = iterations + 1;
+        else
+            next = (size_t)predicted;
+        iterations = next;
+    }
+
+    return iterations;
+}
+
+static
+int
+compare_doubles(const void *a, const void *b)
+{
+    const double da = *(const double *)a;
+    const double db = *(const double *)b;
+
+    return da < db ? -1 : da > db ? 1 : 0;
+}
+
+/* ---------------------------------------------------------------------
+ * The "atf_bench" type.
+ * --------------------------------------------------------------------- */
+
+atf_error_t
+atf_bench_run(const atf_tc_t *tc, atf_tc_bench_t body,
+              const atf_bench_params_t *params, atf_bench_result_t *result)
+{
+    double *samples;
+    size_t iterations, i;
+
+    PRE(params->m_samples > 0);
+    PRE(params->m_sample_nsec > 0);
+
+    samples = malloc(params->m_samples * sizeof(double));
+    if (samples == NULL)
+        return atf_no_memory_error();
+
+    iterations = calibrate(tc, body, params->m_sample_nsec);
+    (void)time_run(tc, body, iterations);
+
+    for (i = 0; i < params->m_samples; i++)
+        samples[i] = (double)time_run(tc, body, iterations) / iterations;
+
+    atf_bench_summarize(samples, params->m_samples, iterations, result);
+    result->m_data = samples;
+    return atf_no_error();
+}
+
+/* Computes the statistics of the given samples, which are sorted in the
+ * process. */
+void
+atf_bench_summarize(double *samples, const size_t nsamples,
+                    const size_t iterations, atf_bench_result_t *result)
+{
+    double sum, sqsum;
+    size_t i;
+
+    PRE(nsamples > 0);
+
+    qsort(samples, nsamples, sizeof(double), compare_doubles);
+
+    sum = 0.0;
+    for (i = 0; i < nsamples; i++)
+        sum += samples[i];
+
+    result->m_iterations = iterations;
+    result->m_samples = nsamples;
+    result->m_min = samples[0];
+    if (nsamples % 2 == 1)
+        result->m_median = samples[nsamples / 2];
+    else
+        result->m_median = (samples[nsamples / 2 - 1] +
+                            samples[nsamples / 2]) / 2;
+    /* Nearest-rank percentile. */
+    result->m_p99 = samples[(nsamples * 99 + 99) / 100 - 1];
+    result->m_mean = sum / nsamples;
+
+    sqsum = 0.0;
+    for (i = 0; i < nsamples; i++)
+        sqsum += (samples[i] - result->m_mean) * (samples[i] - result->m_mean);
+    result->m_stddev = nsamples > 1 ? sqrt(sqsum / (nsamples - 1)) : 0.0;
+    result->m_data = NULL;
+}
+
+void
+atf_bench_result_fini(atf_bench_result_t *result)
+{
+    free(result->m_data);
+}
+
+/* Opens the benchmark file that goes along the given results file. */
+atf_error_t
+atf_bench_open(const char *resfile, int *fd)
+{
+    atf_error_t err;
+    atf_dynstr_t path;
+
+    err = atf_dynstr_init_fmt(&path, "%s.bench", resfile);
+    if (atf_is_error(err))
+        return err;
+
+    *fd = open(atf_dynstr_cstring(&path),
+               O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (*fd == -1)
+        err = atf_libc_error(errno, "Cannot create benchmark file '%s'",
+                             atf_dynstr_cstring(&path));
+
+    atf_dynstr_fini(&path);
+    return err;
+}
+
+atf_error_t
+atf_bench_write(const atf_bench_result_t *result, const int fd)
+{
+    if (dprintf(fd, "iterations: %zu\n"
+                "samples: %zu\n"
+                "ns_per_op.min: %.3f\n"
+                "ns_per_op.median: %.3f\n"
+                "ns_per_op.p99: %.3f\n"
+                "ns_per_op.mean: %.3f\n"
+                "ns_per_op.stddev: %.3f\n",
+                result->m_iterations, result->m_samples, result->m_min,
+                result->m_median, result->m_p99, result->m_mean,
+                result->m_stddev) < 0)
+        return atf_libc_error(errno, "Cannot write benchmark results");
+
+    /* The raw samples allow later runs to be compared to this one with a
+     * statistical test; see atf-bench(1). */
+    if (result->m_data != NULL) {
+        size_t i;
+
+        if (dprintf(fd, "ns_per_op.samples:") < 0)
+            return atf_libc_error(errno, "Cannot write benchmark results");
+        for (i = 0; i < result->m_samples; i++)
+            if (dprintf(fd, " %.3f", result->m_data[i]) < 0)
+                return atf_libc_error(errno,
+                                      "Cannot write benchmark results");
+        if (dprintf(fd, "\n") < 0)
+            return atf_libc_error(errno, "Cannot write benchmark results");
+    }
+    return atf_no_error();
+}
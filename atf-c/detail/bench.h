@@ -0,0 +1,73 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#if !defined(ATF_C_DETAIL_BENCH_H)
+#define ATF_C_DETAIL_BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atf-c/error_fwd.h>
+#include <atf-c/tc.h>
+
+/* ---------------------------------------------------------------------
+ * The "atf_bench" type.
+ * --------------------------------------------------------------------- */
+
+/* How to run a benchmark: the number of samples to take and the duration
+ * that each sample should last, which determines the number of iterations
+ * per sample. */
+struct atf_bench_params {
+    size_t m_samples;
+    int64_t m_sample_nsec;
+};
+typedef struct atf_bench_params atf_bench_params_t;
+
+/* Summary of a benchmark run.  All times are in nanoseconds per iteration
+ * of the benchmark body.  m_data holds the sorted samples when they are
+ * kept, in which case the result must be released with
+ * atf_bench_result_fini; it is NULL otherwise. */
+struct atf_bench_result {
+    size_t m_iterations;
+    size_t m_samples;
+    double m_min;
+    double m_median;
+    double m_p99;
+    double m_mean;
+    double m_stddev;
+    double *m_data;
+};
+typedef struct atf_bench_result atf_bench_result_t;
+
+atf_error_t atf_bench_run(const atf_tc_t *, atf_tc_bench_t,
+                          const atf_bench_params_t *, atf_bench_result_t *);
+void atf_bench_summarize(double *, const size_t, const size_t,
+                         atf_bench_result_t *);
+void atf_bench_result_fini(atf_bench_result_t *);
+
+atf_error_t atf_bench_open(const char *, int *);
+atf_error_t atf_bench_write(const atf_bench_result_t *, const int);
+
+#endif /* !defined(ATF_C_DETAIL_BENCH_H) */
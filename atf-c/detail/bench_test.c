@@ -0,0 +1,200 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <atf-c.h>
+
+#include "atf-c/detail/test_helpers.h"
+#include "atf-c/utils.h"
+
+/* ---------------------------------------------------------------------
+ * Auxiliary functions.
+ * --------------------------------------------------------------------- */
+
+static size_t calls;
+static size_t last_iterations;
+
+static
+void
+count_body(const atf_tc_t *tc ATF_DEFS_ATTRIBUTE_UNUSED,
+           const size_t iterations)
+{
+    volatile size_t i;
+
+    calls++;
+    last_iterations = iterations;
+    for (i = 0; i < iterations; i++)
+        continue;
+}
+
+/* ---------------------------------------------------------------------
+ * Tests for the "atf_bench" type.
+ * --------------------------------------------------------------------- */
+
+ATF_TC(run);
+ATF_TC_HEAD(run, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks that atf_bench_run calibrates "
+                      "the iterations and takes the requested samples");
+}
+ATF_TC_BODY(run, tc)
+{
+    atf_bench_params_t params;
+    atf_bench_result_t result;
+
+    params.m_samples = 5;
+    params.m_sample_nsec = 1000000;
+
+    calls = 0;
+    RE(atf_bench_run(NULL, count_body, &params, &result));
+
+    ATF_REQUIRE(result.m_iterations > 1);
+    ATF_REQUIRE_EQ(5, result.m_samples);
+    ATF_REQUIRE_EQ(result.m_iterations, last_iterations);
+    /* At least one calibration run, the warmup run and the samples. */
+    ATF_REQUIRE(calls >= 1 + 1 + 5);
+
+    ATF_REQUIRE(result.m_min > 0.0);
+    ATF_REQUIRE(result.m_min <= result.m_median);
+    ATF_REQUIRE(result.m_median <= result.m_p99);
+    ATF_REQUIRE(result.m_stddev >= 0.0);
+
+    ATF_REQUIRE(result.m_data != NULL);
+    ATF_REQUIRE_EQ(result.m_min, result.m_data[0]);
+    ATF_REQUIRE_EQ(result.m_p99, result.m_data[4]);
+    atf_bench_result_fini(&result);
+}
+
+ATF_TC(summarize);
+ATF_TC_HEAD(summarize, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks the statistics computed by "
+                      "atf_bench_summarize");
+}
+ATF_TC_BODY(summarize, tc)
+{
+    double odd[] = { 9.0, 2.0, 4.0, 4.0, 5.0, 5.0, 7.0, 4.0, 1.0 };
+    double even[] = { 4.0, 1.0, 3.0, 2.0 };
+    double one[] = { 3.5 };
+    atf_bench_result_t result;
+
+    atf_bench_summarize(odd, 9, 100, &result);
+    ATF_CHECK_EQ(100, result.m_iterations);
+    ATF_CHECK_EQ(9, result.m_samples);
+    ATF_CHECK_EQ(1.0, result.m_min);
+    ATF_CHECK_EQ(4.0, result.m_median);
+    ATF_CHECK_EQ(9.0, result.m_p99);
+    ATF_CHECK_EQ(41.0 / 9, result.m_mean);
+    ATF_CHECK(result.m_stddev > 2.40 && result.m_stddev < 2.41);
+
+    atf_bench_summarize(even, 4, 1, &result);
+    ATF_CHECK_EQ(2.5, result.m_median);
+    ATF_CHECK_EQ(4.0, result.m_p99);
+
+    atf_bench_summarize(one, 1, 1, &result);
+    ATF_CHECK_EQ(3.5, result.m_min);
+    ATF_CHECK_EQ(3.5, result.m_median);
+    ATF_CHECK_EQ(3.5, result.m_p99);
+    ATF_CHECK_EQ(0.0, result.m_stddev);
+}
+
+ATF_TC(write);
+ATF_TC_HEAD(write, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks the format of the benchmark "
+                      "file");
+}
+ATF_TC_BODY(write, tc)
+{
+    atf_bench_result_t result;
+    int fd;
+
+    result.m_iterations = 1000;
+    result.m_samples = 10;
+    result.m_min = 1.5;
+    result.m_median = 2.0;
+    result.m_p99 = 3.25;
+    result.m_mean = 2.125;
+    result.m_stddev = 0.5;
+    result.m_data = NULL;
+
+    RE(atf_bench_open("result", &fd));
+    RE(atf_bench_write(&result, fd));
+    close(fd);
+
+    ATF_REQUIRE(atf_utils_compare_file("result.bench",
+        "iterations: 1000\n"
+        "samples: 10\n"
+        "ns_per_op.min: 1.500\n"
+        "ns_per_op.median: 2.000\n"
+        "ns_per_op.p99: 3.250\n"
+        "ns_per_op.mean: 2.125\n"
+        "ns_per_op.stddev: 0.500\n"));
+}
+
+ATF_TC(write_samples);
+ATF_TC_HEAD(write_samples, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks that the samples of a benchmark "
+                      "are recorded in the benchmark file if kept");
+}
+ATF_TC_BODY(write_samples, tc)
+{
+    double samples[] = { 3.0, 1.0, 2.5 };
+    atf_bench_result_t result;
+    int fd;
+
+    atf_bench_summarize(samples, 3, 10, &result);
+    result.m_data = samples;
+
+    RE(atf_bench_open("result", &fd));
+    RE(atf_bench_write(&result, fd));
+    close(fd);
+
+    ATF_REQUIRE(atf_utils_grep_file("^ns_per_op.median: 2.500$",
+                                    "result.bench"));
+    ATF_REQUIRE(atf_utils_grep_file("^ns_per_op.samples: 1.000 2.500 3.000$",
+                                    "result.bench"));
+}
+
+/* ---------------------------------------------------------------------
+ * Main.
+ * --------------------------------------------------------------------- */
+
+ATF_TP_ADD_TCS(tp)
+{
+    ATF_TP_ADD_TC(tp, run);
+    ATF_TP_ADD_TC(tp, summarize);
+    ATF_TP_ADD_TC(tp, write);
+    ATF_TP_ADD_TC(tp, write_samples);
+
+    return atf_no_error();
+}
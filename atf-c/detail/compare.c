@@ -0,0 +1,253 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/compare.h"
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "atf-c/detail/sanity.h"
+#include "atf-c/error.h"
+
+/* Files are memory-mapped when possible so that large golden files are
+ * compared without copying them, and the comparison itself relies on
+ * memcmp(3), which libc implements with vector instructions.  Files that
+ * cannot be mapped, like pipes or devices, are read into memory. */
+
+/* Size of the blocks handed to memcmp(3) while looking for the first
+ * difference.  Large enough to amortize the calls, small enough to keep
+ * the search for the differing byte within a block cheap. */
+static const size_t block_size = 64 * 1024;
+
+/* ---------------------------------------------------------------------
+ * Auxiliary functions.
+ * --------------------------------------------------------------------- */
+
+static
+atf_error_t
+read_all(const int fd, const char *path, atf_file_contents_t *c)
+{
+    size_t capacity = 64 * 1024;
+    char *data;
+    ssize_t n;
+
+    data = malloc(capacity);
+    if (data == NULL)
+        return atf_no_memory_error();
+    c->m_size = 0;
+
+    for (;;) {
+        if (c->m_size == capacity) {
+            char *bigger = realloc(data, capacity * 2);
+            if (bigger == NULL) {
+                free(data);
+                return atf_no_memory_error();
+            }
+            data = bigger;
+            capacity *= 2;
+        }
+
+        n = read(fd, data + c->m_size, capacity - c->m_size);
+        if (n == -1) {
+            if (errno == EINTR)
+                continue;
+            free(data);
+            return atf_libc_error(errno, "Failed to read %s", path);
+        } else if (n == 0)
+            break;
+        c->m_size += (size_t)n;
+    }
+
+    c->m_data = data;
+    c->m_mapped = false;
+    return atf_no_error();
+}
+
+/* Counts the lines up to 'size' eight bytes at a time: calling memchr(3)
+ * once per line is slow on text made of short lines, so each word has its
+ * newline bytes turned into set high bits, which are then added up. */
+static
+size_t
+count_lines(const char *data, const size_t size)
+{
+    const uint64_t ones = UINT64_C(0x0101010101010101);
+    const uint64_t newlines = ones * '\n';
+    const uint64_t low7 = ones * 0x7f;
+    size_t i, lines = 1;
+
+    for (i = 0; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t word, zeros;
+
+        memcpy(&word, data + i, sizeof(word));
+        word ^= newlines;
+        zeros = ~(((word & low7) + low7) | word);
+        lines += (size_t)((((zeros >> 7) & ones) * ones) >> 56);
+    }
+    for (; i < size; i++)
+        lines += data[i] == '\n';
+    return lines;
+}
+
+/* ---------------------------------------------------------------------
+ * The "atf_file_contents" type.
+ * --------------------------------------------------------------------- */
+
+/*
+ * Constructors/destructors.
+ */
+
+atf_error_t
+atf_file_contents_init(atf_file_contents_t *c, const char *path)
+{
+    atf_error_t err;
+    struct stat sb;
+    int fd;
+
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        err = atf_libc_error(errno, "Cannot open %s", path);
+        goto out;
+    }
+
+    if (fstat(fd, &sb) == -1) {
+        err = atf_libc_error(errno, "Cannot stat %s", path);
+        goto out_fd;
+    }
+
+    if (S_ISREG(sb.st_mode) && sb.st_size > 0) {
+        c->m_data = mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE,
+                         fd, 0);
+        if (c->m_data != MAP_FAILED) {
+            (void)posix_madvise(c->m_data, (size_t)sb.st_size,
+                                POSIX_MADV_SEQUENTIAL);
+            c->m_size = (size_t)sb.st_size;
+            c->m_mapped = true;
+            err = atf_no_error();
+            goto out_fd;
+        }
+    }
+
+    err = read_all(fd, path, c);
+
+out_fd:
+    close(fd);
+out:
+    return err;
+}
+
+void
+atf_file_contents_fini(atf_file_contents_t *c)
+{
+    if (c->m_mapped)
+        munmap(c->m_data, c->m_size);
+    else
+        free(c->m_data);
+}
+
+/* ---------------------------------------------------------------------
+ * Free functions.
+ * --------------------------------------------------------------------- */
+
+void
+atf_compare_mem(const void *data1, const size_t size1,
+                const void *data2, const size_t size2,
+                atf_compare_result_t *result)
+{
+    const char *p1 = data1, *p2 = data2;
+    const size_t common = size1 < size2 ? size1 : size2;
+    size_t offset = 0;
+
+    /* Different sizes already tell that the contents differ, but the
+     * common prefix is still scanned to report where they diverge. */
+    while (offset < common) {
+        const size_t len = common - offset < block_size ?
+            common - offset : block_size;
+
+        if (memcmp(p1 + offset, p2 + offset, len) != 0) {
+            while (p1[offset] == p2[offset])
+                offset++;
+            break;
+        }
+        offset += len;
+    }
+
+    result->m_equal = offset == common && size1 == size2;
+    if (result->m_equal) {
+        result->m_offset = 0;
+        result->m_line = 0;
+    } else {
+        result->m_offset = offset;
+        result->m_line = count_lines(p1, offset);
+    }
+}
+
+atf_error_t
+atf_compare_file_mem(const char *path, const void *data, const size_t size,
+                     atf_compare_result_t *result)
+{
+    atf_error_t err;
+    atf_file_contents_t c;
+
+    err = atf_file_contents_init(&c, path);
+    if (atf_is_error(err))
+        return err;
+
+    atf_compare_mem(c.m_data, c.m_size, data, size, result);
+
+    atf_file_contents_fini(&c);
+    return atf_no_error();
+}
+
+atf_error_t
+atf_compare_files(const char *path1, const char *path2,
+                  atf_compare_result_t *result)
+{
+    atf_error_t err;
+    atf_file_contents_t c1, c2;
+
+    err = atf_file_contents_init(&c1, path1);
+    if (atf_is_error(err))
+        goto out;
+
+    err = atf_file_contents_init(&c2, path2);
+    if (atf_is_error(err))
+        goto out_c1;
+
+    atf_compare_mem(c1.m_data, c1.m_size, c2.m_data, c2.m_size, result);
+
+    atf_file_contents_fini(&c2);
+out_c1:
+    atf_file_contents_fini(&c1);
+out:
+    return err;
+}
@@ -0,0 +1,77 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#if !defined(ATF_C_DETAIL_COMPARE_H)
+#define ATF_C_DETAIL_COMPARE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <atf-c/error_fwd.h>
+
+/* ---------------------------------------------------------------------
+ * The "atf_file_contents" type.
+ * --------------------------------------------------------------------- */
+
+/* The contents of a file, which are mapped into memory when the file is
+ * a regular one and read into a buffer otherwise. */
+struct atf_file_contents {
+    void *m_data;
+    size_t m_size;
+    bool m_mapped;
+};
+typedef struct atf_file_contents atf_file_contents_t;
+
+/* Constructors/destructors. */
+atf_error_t atf_file_contents_init(atf_file_contents_t *, const char *);
+void atf_file_contents_fini(atf_file_contents_t *);
+
+/* ---------------------------------------------------------------------
+ * The "atf_compare_result" type.
+ * --------------------------------------------------------------------- */
+
+/* Outcome of a comparison.  When the contents differ, m_offset is the
+ * offset of the first differing byte, which is the size of the shorter
+ * side if it is a prefix of the other one, and m_line is the number,
+ * starting at 1, of the line that contains it. */
+struct atf_compare_result {
+    bool m_equal;
+    size_t m_offset;
+    size_t m_line;
+};
+typedef struct atf_compare_result atf_compare_result_t;
+
+/* ---------------------------------------------------------------------
+ * Free functions.
+ * --------------------------------------------------------------------- */
+
+void atf_compare_mem(const void *, const size_t, const void *, const size_t,
+                     atf_compare_result_t *);
+atf_error_t atf_compare_file_mem(const char *, const void *, const size_t,
+                                 atf_compare_result_t *);
+atf_error_t atf_compare_files(const char *, const char *,
+                              atf_compare_result_t *);
+
+#endif /* !defined(ATF_C_DETAIL_COMPARE_H) */
@@ -0,0 +1,324 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/compare.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <atf-c.h>
+
+#include "atf-c/detail/test_helpers.h"
+
+/* ---------------------------------------------------------------------
+ * Auxiliary functions.
+ * --------------------------------------------------------------------- */
+
+static
+void
+write_file(const char *name, const void *data, const size_t size)
+{
+    const int fd = open(name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    ATF_REQUIRE(fd != -1);
+    ATF_REQUIRE_EQ((ssize_t)size, write(fd, data, size));
+    close(fd);
+}
+
+/* Builds a text of 'size' bytes made of numbered lines. */
+static
+char *
+make_text(const size_t size)
+{
+    char *text = malloc(size + 1);
+    size_t used = 0, line = 0;
+
+    ATF_REQUIRE(text != NULL);
+    while (used < size) {
+        char buf[32];
+        const int len = snprintf(buf, sizeof(buf), "line %zu\n", line++);
+        const size_t n = size - used < (size_t)len ? size - used : (size_t)len;
+        memcpy(text + used, buf, n);
+        used += n;
+    }
+    text[size] = '\0';
+    return text;
+}
+
+static
+size_t
+count_newlines(const char *text, const size_t size)
+{
+    size_t i, lines = 0;
+
+    for (i = 0; i < size; i++)
+        if (text[i] == '\n')
+            lines++;
+    return lines;
+}
+
+/* Size of the files used by the benchmarks. */
+static const size_t bench_size = 32 * 1024 * 1024;
+
+static
+void
+init_bench_files(void)
+{
+    char *text;
+
+    if (access("bench1", F_OK) == 0)
+        return;
+
+    text = make_text(bench_size);
+    write_file("bench1", text, bench_size);
+    text[bench_size - 2] = '!';
+    write_file("bench2", text, bench_size);
+    free(text);
+}
+
+/* ---------------------------------------------------------------------
+ * Test cases for the free functions.
+ * --------------------------------------------------------------------- */
+
+ATF_TC_WITHOUT_HEAD(compare_mem__equal);
+ATF_TC_BODY(compare_mem__equal, tc)
+{
+    atf_compare_result_t result;
+
+    atf_compare_mem("", 0, "", 0, &result);
+    ATF_CHECK(result.m_equal);
+
+    atf_compare_mem("foo\nbar\n", 8, "foo\nbar\n", 8, &result);
+    ATF_CHECK(result.m_equal);
+}
+
+ATF_TC_WITHOUT_HEAD(compare_mem__differ);
+ATF_TC_BODY(compare_mem__differ, tc)
+{
+    atf_compare_result_t result;
+
+    atf_compare_mem("foo\nbar\nbaz\n", 12, "foo\nbar\nbiz\n", 12, &result);
+    ATF_CHECK(!result.m_equal);
+    ATF_CHECK_EQ(9, result.m_offset);
+    ATF_CHECK_EQ(3, result.m_line);
+
+    atf_compare_mem("x", 1, "y", 1, &result);
+    ATF_CHECK(!result.m_equal);
+    ATF_CHECK_EQ(0, result.m_offset);
+    ATF_CHECK_EQ(1, result.m_line);
+}
+
+ATF_TC_WITHOUT_HEAD(compare_mem__prefix);
+ATF_TC_BODY(compare_mem__prefix, tc)
+{
+    atf_compare_result_t result;
+
+    atf_compare_mem("foo\n", 4, "foo\nbar\n", 8, &result);
+    ATF_CHECK(!result.m_equal);
+    ATF_CHECK_EQ(4, result.m_offset);
+    ATF_CHECK_EQ(2, result.m_line);
+
+    atf_compare_mem("foo\nbar\n", 8, "", 0, &result);
+    ATF_CHECK(!result.m_equal);
+    ATF_CHECK_EQ(0, result.m_offset);
+    ATF_CHECK_EQ(1, result.m_line);
+}
+
+ATF_TC_WITHOUT_HEAD(compare_mem__large);
+ATF_TC_BODY(compare_mem__large, tc)
+{
+    const size_t size = 1024 * 1024 + 17;
+    const size_t offsets[] = { 0, 65535, 65536, 65537, 500000, size - 1 };
+    char *text1 = make_text(size);
+    char *text2 = make_text(size);
+    atf_compare_result_t result;
+    size_t i;
+
+    atf_compare_mem(text1, size, text2, size, &result);
+    ATF_CHECK(result.m_equal);
+
+    for (i = 0; i < sizeof(offsets) / sizeof(offsets[0]); i++) {
+        const char saved = text2[offsets[i]];
+
+        text2[offsets[i]] = '#';
+        atf_compare_mem(text1, size, text2, size, &result);
+        ATF_CHECK(!result.m_equal);
+        ATF_CHECK_EQ(offsets[i], result.m_offset);
+        ATF_CHECK_EQ(count_newlines(text1, offsets[i]) + 1, result.m_line);
+        text2[offsets[i]] = saved;
+    }
+
+    free(text2);
+    free(text1);
+}
+
+ATF_TC_WITHOUT_HEAD(compare_file_mem);
+ATF_TC_BODY(compare_file_mem, tc)
+{
+    atf_compare_result_t result;
+
+    write_file("empty", "", 0);
+    write_file("file", "foo\nbar\n", 8);
+
+    RE(atf_compare_file_mem("empty", "", 0, &result));
+    ATF_CHECK(result.m_equal);
+    RE(atf_compare_file_mem("empty", "a", 1, &result));
+    ATF_CHECK(!result.m_equal);
+
+    RE(atf_compare_file_mem("file", "foo\nbar\n", 8, &result));
+    ATF_CHECK(result.m_equal);
+    RE(atf_compare_file_mem("file", "foo\nbaz\n", 8, &result));
+    ATF_CHECK(!result.m_equal);
+    ATF_CHECK_EQ(6, result.m_offset);
+    ATF_CHECK_EQ(2, result.m_line);
+
+    /* Devices cannot be mapped and are read instead. */
+    RE(atf_compare_file_mem("/dev/null", "", 0, &result));
+    ATF_CHECK(result.m_equal);
+}
+
+ATF_TC_WITHOUT_HEAD(compare_files);
+ATF_TC_BODY(compare_files, tc)
+{
+    const size_t size = 300000;
+    char *text = make_text(size);
+    atf_compare_result_t result;
+
+    write_file("file1", text, size);
+    write_file("file2", text, size);
+    RE(atf_compare_files("file1", "file2", &result));
+    ATF_CHECK(result.m_equal);
+
+    text[200000] = '#';
+    write_file("file2", text, size);
+    RE(atf_compare_files("file1", "file2", &result));
+    ATF_CHECK(!result.m_equal);
+    ATF_CHECK_EQ(200000, result.m_offset);
+    ATF_CHECK_EQ(count_newlines(text, 200000) + 1, result.m_line);
+
+    write_file("file2", text, 100);
+    RE(atf_compare_files("file1", "file2", &result));
+    ATF_CHECK(!result.m_equal);
+    ATF_CHECK_EQ(100, result.m_offset);
+
+    free(text);
+}
+
+ATF_TC_WITHOUT_HEAD(compare_files__missing);
+ATF_TC_BODY(compare_files__missing, tc)
+{
+    atf_compare_result_t result;
+    atf_error_t err;
+
+    write_file("file", "foo", 3);
+
+    err = atf_compare_files("file", "missing", &result);
+    ATF_REQUIRE(atf_is_error(err));
+    ATF_CHECK(atf_error_is(err, "libc"));
+    atf_error_free(err);
+
+    err = atf_compare_file_mem("missing", "foo", 3, &result);
+    ATF_REQUIRE(atf_is_error(err));
+    ATF_CHECK(atf_error_is(err, "libc"));
+    atf_error_free(err);
+}
+
+/* ---------------------------------------------------------------------
+ * Benchmarks.
+ * --------------------------------------------------------------------- */
+
+ATF_BENCH(bench_compare_files);
+ATF_BENCH_HEAD(bench_compare_files, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Compares two 32 MB files that differ "
+                      "at their end with atf_compare_files");
+}
+ATF_BENCH_BODY(bench_compare_files, tc, iterations)
+{
+    atf_compare_result_t result;
+    size_t i;
+
+    init_bench_files();
+    for (i = 0; i < iterations; i++) {
+        RE(atf_compare_files("bench1", "bench2", &result));
+        ATF_REQUIRE(!result.m_equal);
+    }
+}
+
+ATF_BENCH(bench_compare_chunks);
+ATF_BENCH_HEAD(bench_compare_chunks, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Compares two 32 MB files that differ "
+                      "at their end by reading them in 512-byte chunks, "
+                      "for comparison with bench_compare_files");
+}
+ATF_BENCH_BODY(bench_compare_chunks, tc, iterations)
+{
+    size_t i;
+
+    init_bench_files();
+    for (i = 0; i < iterations; i++) {
+        FILE *f1 = fopen("bench1", "r");
+        FILE *f2 = fopen("bench2", "r");
+        bool equal = true;
+        size_t n1, n2;
+
+        ATF_REQUIRE(f1 != NULL && f2 != NULL);
+        do {
+            char buf1[512], buf2[512];
+
+            n1 = fread(buf1, 1, sizeof(buf1), f1);
+            n2 = fread(buf2, 1, sizeof(buf2), f2);
+            if (n1 != n2 || memcmp(buf1, buf2, n1) != 0)
+                equal = false;
+        } while (equal && n1 > 0);
+        ATF_REQUIRE(!equal);
+
+        fclose(f2);
+        fclose(f1);
+    }
+}
+
+/* ---------------------------------------------------------------------
+ * Main.
+ * --------------------------------------------------------------------- */
+
+ATF_TP_ADD_TCS(tp)
+{
+    ATF_TP_ADD_TC(tp, compare_mem__equal);
+    ATF_TP_ADD_TC(tp, compare_mem__differ);
+    ATF_TP_ADD_TC(tp, compare_mem__prefix);
+    ATF_TP_ADD_TC(tp, compare_mem__large);
+    ATF_TP_ADD_TC(tp, compare_file_mem);
+    ATF_TP_ADD_TC(tp, compare_files);
+    ATF_TP_ADD_TC(tp, compare_files__missing);
+
+    ATF_TP_ADD_TC(tp, bench_compare_files);
+    ATF_TP_ADD_TC(tp, bench_compare_chunks);
+
+    return atf_no_error();
+}
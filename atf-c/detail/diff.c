@@ -0,0 +1,858 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/diff.h"
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "atf-c/detail/compare.h"
+#include "atf-c/detail/sanity.h"
+#include "atf-c/error.h"
+
+/* The texts are split into lines and every distinct line is given a
+ * number, so that the diff itself only compares integers.  The lines that
+ * both texts share at their beginning and end are left out, and so are
+ * the lines that only appear in one of the texts, which changed.  The
+ * other lines that changed are found with Myers' O(ND) algorithm in its
+ * linear space variant, which splits the problem at the middle snake of
+ * an optimal path and recurses on both halves.
+ *
+ * The cost of the algorithm grows with the number of differences, so it
+ * is bounded twice: a search that goes on for too many edits splits at
+ * the furthest point it reached instead of looking for the middle snake,
+ * and once the whole diff has spent its work budget, the ranges that are
+ * left are reported as entirely changed.  The result is then correct but
+ * not minimal. */
+
+/* Number of edits after which a middle snake search gives up, at least. */
+static const size_t min_max_cost = 256;
+
+/* Number of diagonals that a diff may visit before giving up. */
+static const size_t work_budget = 64 * 1024 * 1024;
+
+/* ---------------------------------------------------------------------
+ * The "side" type.
+ * --------------------------------------------------------------------- */
+
+/* One of the texts being compared. */
+struct side {
+    const char *m_text;
+    size_t m_nlines;
+    size_t *m_starts;  /* m_nlines + 1 offsets; the last one is the size. */
+    size_t *m_ids;
+    bool *m_changed;
+    size_t m_first;    /* Lines [m_first, m_last) are not shared by both */
+    size_t m_last;     /* sides at their beginning nor at their end. */
+    size_t m_nkept;
+    size_t *m_kept;    /* Lines that also appear in the other side. */
+};
+
+static
+atf_error_t
+side_init(struct side *s, const char *text, const size_t size)
+{
+    const char *p, *end = text + size;
+    size_t i;
+
+    s->m_text = text;
+    s->m_nlines = 0;
+    for (p = text; p < end && (p = memchr(p, '\n', (size_t)(end - p))) != NULL;
+         p++)
+        s->m_nlines++;
+    if (size > 0 && text[size - 1] != '\n')
+        s->m_nlines++;
+
+    s->m_starts = malloc((s->m_nlines + 1) * sizeof(size_t));
+    s->m_ids = malloc((s->m_nlines + 1) * sizeof(size_t));
+    s->m_changed = calloc(s->m_nlines + 1, sizeof(bool));
+    s->m_kept = malloc((s->m_nlines + 1) * sizeof(size_t));
+    if (s->m_starts == NULL || s->m_ids == NULL || s->m_changed == NULL ||
+        s->m_kept == NULL) {
+        free(s->m_kept);
+        free(s->m_changed);
+        free(s->m_ids);
+        free(s->m_starts);
+        return atf_no_memory_error();
+    }
+
+    p = text;
+    for (i = 0; i < s->m_nlines; i++) {
+        const char *nl = memchr(p, '\n', (size_t)(end - p));
+        s->m_starts[i] = (size_t)(p - text);
+        p = nl == NULL ? end : nl + 1;
+    }
+    s->m_starts[s->m_nlines] = size;
+
+    return atf_no_error();
+}
+
+static
+void
+side_fini(struct side *s)
+{
+    free(s->m_kept);
+    free(s->m_changed);
+    free(s->m_ids);
+    free(s->m_starts);
+}
+
+static
+const char *
+side_line(const struct side *s, const size_t i, size_t *size)
+{
+    *size = s->m_starts[i + 1] - s->m_starts[i];
+    return s->m_text + s->m_starts[i];
+}
+
+/* Finds the lines that both sides have in common at their beginning and
+ * their end, which are compared directly instead of being numbered. */
+static
+void
+skip_common_lines(struct side *a, struct side *b)
+{
+    size_t size1, size2;
+    const char *data1, *data2;
+
+    a->m_first = b->m_first = 0;
+    while (a->m_first < a->m_nlines && b->m_first < b->m_nlines) {
+        data1 = side_line(a, a->m_first, &size1);
+        data2 = side_line(b, b->m_first, &size2);
+        if (size1 != size2 || memcmp(data1, data2, size1) != 0)
+            break;
+        a->m_first++;
+        b->m_first++;
+    }
+
+    a->m_last = a->m_nlines;
+    b->m_last = b->m_nlines;
+    while (a->m_last > a->m_first && b->m_last > b->m_first) {
+        data1 = side_line(a, a->m_last - 1, &size1);
+        data2 = side_line(b, b->m_last - 1, &size2);
+        if (size1 != size2 || memcmp(data1, data2, size1) != 0)
+            break;
+        a->m_last--;
+        b->m_last--;
+    }
+}
+
+/* ---------------------------------------------------------------------
+ * Line numbering.
+ * --------------------------------------------------------------------- */
+
+static
+uint64_t
+hash_line(const char *data, const size_t size)
+{
+    uint64_t h = UINT64_C(14695981039346656037);
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        h ^= (unsigned char)data[i];
+        h *= UINT64_C(1099511628211);
+    }
+    return h;
+}
+
+/* Gives the same number to equal lines of both sides, using an open
+ * addressing table that maps a line to the first line equal to it.  The
+ * number of a line is the position of that first line in both sides
+ * together, which keeps the slots of the table small. */
+static
+atf_error_t
+number_lines(struct side *a, struct side *b)
+{
+    const size_t nlines = (a->m_last - a->m_first) + (b->m_last - b->m_first);
+    struct side *sides[2] = { a, b };
+    size_t nslots, mask, i, j;
+    struct slot {
+        uint64_t m_hash;
+        size_t m_line;  /* Position of the line plus one; 0 if empty. */
+    } *slots;
+
+    for (nslots = 16; nslots < nlines + nlines / 2; nslots *= 2)
+        ;
+    mask = nslots - 1;
+
+    slots = calloc(nslots, sizeof(struct slot));
+    if (slots == NULL)
+        return atf_no_memory_error();
+
+    for (i = 0; i < 2; i++) {
+        struct side *s = sides[i];
+        const size_t base = i == 0 ? 0 : a->m_nlines;
+
+        for (j = s->m_first; j < s->m_last; j++) {
+            size_t size, pos;
+            const char *data = side_line(s, j, &size);
+            const uint64_t h = hash_line(data, size);
+
+            for (pos = (size_t)h & mask; slots[pos].m_line != 0;
+                 pos = (pos + 1) & mask) {
+                const size_t line = slots[pos].m_line - 1;
+                const char *data2;
+                size_t size2;
+
+                if (slots[pos].m_hash != h)
+                    continue;
+                data2 = line < a->m_nlines ? side_line(a, line, &size2) :
+                    side_line(b, line - a->m_nlines, &size2);
+                if (size2 == size && memcmp(data2, data, size) == 0)
+                    break;
+            }
+            if (slots[pos].m_line == 0) {
+                slots[pos].m_hash = h;
+                slots[pos].m_line = base + j + 1;
+            }
+            s->m_ids[j] = slots[pos].m_line - 1;
+        }
+    }
+
+    free(slots);
+    return atf_no_error();
+}
+
+/* Marks the lines that only appear in one side as changed, as they cannot
+ * be part of any common subsequence, and leaves the others to the diff.
+ * The numbers of the kept lines are moved to the front of m_ids. */
+static
+atf_error_t
+discard_unique_lines(struct side *a, struct side *b)
+{
+    const size_t nids = a->m_nlines + b->m_nlines;
+    struct side *sides[2] = { a, b };
+    unsigned char *seen;
+    size_t i, j;
+
+    seen = calloc(nids + 1, 1);
+    if (seen == NULL)
+        return atf_no_memory_error();
+
+    for (i = 0; i < 2; i++) {
+        for (j = sides[i]->m_first; j < sides[i]->m_last; j++)
+            seen[sides[i]->m_ids[j]] |= (unsigned char)(1 << i);
+    }
+
+    for (i = 0; i < 2; i++) {
+        struct side *s = sides[i];
+
+        s->m_nkept = 0;
+        for (j = s->m_first; j < s->m_last; j++) {
+            if (seen[s->m_ids[j]] == 3) {
+                s->m_ids[s->m_nkept] = s->m_ids[j];
+                s->m_kept[s->m_nkept] = j;
+                s->m_nkept++;
+            } else
+                s->m_changed[j] = true;
+        }
+    }
+
+    free(seen);
+    return atf_no_error();
+}
+
+/* ---------------------------------------------------------------------
+ * The "diff" type.
+ * --------------------------------------------------------------------- */
+
+struct diff {
+    struct side m_a;
+    struct side m_b;
+    ptrdiff_t *m_vf;
+    ptrdiff_t *m_vb;
+    size_t m_budget;
+};
+
+/* Marks the kept lines [first, last) as changed. */
+static
+void
+mark_changed(struct side *s, size_t first, const size_t last)
+{
+    for (; first < last; first++)
+        s->m_changed[s->m_kept[first]] = true;
+}
+
+/* Looks for the point at which the kept lines [a0, a1) and [b0, b1) are
+ * split to be compared recursively.  Returns false if the work budget is
+ * spent, in which case the ranges are to be considered different as a
+ * whole.  Both ranges are non-empty and have no common prefix nor suffix. */
+static
+bool
+find_split(struct diff *d, const size_t a0, const size_t a1,
+           const size_t b0, const size_t b1, size_t *x, size_t *y)
+{
+    const size_t *ida = d->m_a.m_ids + a0, *idb = d->m_b.m_ids + b0;
+    const ptrdiff_t n = (ptrdiff_t)(a1 - a0), m = (ptrdiff_t)(b1 - b0);
+    const ptrdiff_t max_d = (n + m + 1) / 2;
+    const ptrdiff_t delta = n - m;
+    const bool front = (delta % 2) != 0;
+    ptrdiff_t *vf = d->m_vf, *vb = d->m_vb;
+    ptrdiff_t max_cost, dd, k, kfstart = 0, kfend = 0, kbstart = 0,
+        kbend = 0;
+
+    for (max_cost = 1; max_cost * max_cost < n + m; max_cost *= 2)
+        ;
+    if (max_cost < (ptrdiff_t)min_max_cost)
+        max_cost = (ptrdiff_t)min_max_cost;
+
+    for (k = 0; k < 2 * max_d; k++) {
+        vf[k] = -1;
+        vb[k] = -1;
+    }
+    vf[max_d + 1] = 0;
+    vb[max_d + 1] = 0;
+
+    for (dd = 0; dd < max_d; dd++) {
+        if ((size_t)(2 * dd + 2) > d->m_budget)
+            return false;
+        d->m_budget -= (size_t)(2 * dd + 2);
+
+        if (dd > max_cost) {
+            /* Too expensive: split at the furthest point that the
+             * forward search reached. */
+            ptrdiff_t best = -1;
+
+            for (k = -dd + 1 + kfstart; k <= dd - 1 - kfend; k += 2) {
+                const ptrdiff_t fx = vf[max_d + k];
+                if (fx >= 0 && fx <= n && fx - k >= 0 && fx - k <= m &&
+                    2 * fx - k > best) {
+                    best = 2 * fx - k;
+                    *x = a0 + (size_t)fx;
+                    *y = b0 + (size_t)(fx - k);
+                }
+            }
+            if (best > 0)
+                return true;
+        }
+
+        /* Forward search. */
+        for (k = -dd + kfstart; k <= dd - kfend; k += 2) {
+            const ptrdiff_t ko = max_d + k;
+            ptrdiff_t fx, fy;
+
+            if (k == -dd || (k != dd && vf[ko - 1] < vf[ko + 1]))
+                fx = vf[ko + 1];
+            else
+                fx = vf[ko - 1] + 1;
+            fy = fx - k;
+            while (fx < n && fy < m && ida[fx] == idb[fy]) {
+                fx++;
+                fy++;
+            }
+            vf[ko] = fx;
+
+            if (fx > n)
+                kfend += 2;
+            else if (fy > m)
+                kfstart += 2;
+            else if (front) {
+                const ptrdiff_t kbo = max_d + delta - k;
+                if (kbo >= 0 && kbo < 2 * max_d && vb[kbo] != -1 &&
+                    fx >= n - vb[kbo]) {
+                    *x = a0 + (size_t)fx;
+                    *y = b0 + (size_t)fy;
+                    return true;
+                }
+            }
+        }
+
+        /* Backward search, in terms of the reversed ranges. */
+        for (k = -dd + kbstart; k <= dd - kbend; k += 2) {
+            const ptrdiff_t ko = max_d + k;
+            ptrdiff_t bx, by;
+
+            if (k == -dd || (k != dd && vb[ko - 1] < vb[ko + 1]))
+                bx = vb[ko + 1];
+            else
+                bx = vb[ko - 1] + 1;
+            by = bx - k;
+            while (bx < n && by < m && ida[n - bx - 1] == idb[m - by - 1]) {
+                bx++;
+                by++;
+            }
+            vb[ko] = bx;
+
+            if (bx > n)
+                kbend += 2;
+            else if (by > m)
+                kbstart += 2;
+            else if (!front) {
+                const ptrdiff_t kfo = max_d + delta - k;
+                if (kfo >= 0 && kfo < 2 * max_d && vf[kfo] != -1) {
+                    const ptrdiff_t fx = vf[kfo];
+                    if (fx >= n - bx) {
+                        *x = a0 + (size_t)fx;
+                        *y = b0 + (size_t)(fx - (kfo - max_d));
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+
+    /* Not reached for ranges without a common prefix nor suffix, but
+     * report them as different should it happen. */
+    return false;
+}
+
+static
+void
+compare_ranges(struct diff *d, size_t a0, size_t a1, size_t b0, size_t b1)
+{
+    const size_t *ida = d->m_a.m_ids, *idb = d->m_b.m_ids;
+
+    for (;;) {
+        size_t x, y;
+
+        while (a0 < a1 && b0 < b1 && ida[a0] == idb[b0]) {
+            a0++;
+            b0++;
+        }
+        while (a0 < a1 && b0 < b1 && ida[a1 - 1] == idb[b1 - 1]) {
+            a1--;
+            b1--;
+        }
+
+        if (a0 == a1 || b0 == b1 || !find_split(d, a0, a1, b0, b1, &x, &y) ||
+            (x == a0 && y == b0) || (x == a1 && y == b1)) {
+            mark_changed(&d->m_a, a0, a1);
+            mark_changed(&d->m_b, b0, b1);
+            return;
+        }
+
+        /* Recurse on the first half and iterate on the second one to keep
+         * the depth of the recursion low. */
+        compare_ranges(d, a0, x, b0, y);
+        a0 = x;
+        b0 = y;
+    }
+}
+
+static
+atf_error_t
+diff_init(struct diff *d, const char *text1, const size_t size1,
+          const char *text2, const size_t size2)
+{
+    atf_error_t err;
+    size_t nv;
+
+    err = side_init(&d->m_a, text1, size1);
+    if (atf_is_error(err))
+        goto out;
+
+    err = side_init(&d->m_b, text2, size2);
+    if (atf_is_error(err))
+        goto out_a;
+
+    skip_common_lines(&d->m_a, &d->m_b);
+
+    err = number_lines(&d->m_a, &d->m_b);
+    if (atf_is_error(err))
+        goto out_b;
+
+    err = discard_unique_lines(&d->m_a, &d->m_b);
+    if (atf_is_error(err))
+        goto out_b;
+
+    nv = d->m_a.m_nkept + d->m_b.m_nkept + 2;
+    d->m_vf = malloc(nv * sizeof(ptrdiff_t));
+    d->m_vb = malloc(nv * sizeof(ptrdiff_t));
+    if (d->m_vf == NULL || d->m_vb == NULL) {
+        free(d->m_vb);
+        free(d->m_vf);
+        err = atf_no_memory_error();
+        goto out_b;
+    }
+    d->m_budget = work_budget;
+
+    compare_ranges(d, 0, d->m_a.m_nkept, 0, d->m_b.m_nkept);
+
+    INV(!atf_is_error(err));
+    goto out;
+
+out_b:
+    side_fini(&d->m_b);
+out_a:
+    side_fini(&d->m_a);
+out:
+    return err;
+}
+
+static
+void
+diff_fini(struct diff *d)
+{
+    free(d->m_vb);
+    free(d->m_vf);
+    side_fini(&d->m_b);
+    side_fini(&d->m_a);
+}
+
+/* ---------------------------------------------------------------------
+ * The "output" type.
+ * --------------------------------------------------------------------- */
+
+struct output {
+    int m_fd;
+    size_t m_max_bytes;
+    size_t m_written;
+    size_t m_used;
+    char m_buffer[8192];
+};
+
+static
+atf_error_t
+output_flush(struct output *o)
+{
+    size_t done = 0;
+
+    while (done < o->m_used) {
+        const ssize_t n = write(o->m_fd, o->m_buffer + done,
+                                o->m_used - done);
+        if (n == -1) {
+            if (errno == EINTR)
+                continue;
+            return atf_libc_error(errno, "Failed to write diff");
+        }
+        done += (size_t)n;
+    }
+    o->m_used = 0;
+    return atf_no_error();
+}
+
+static
+atf_error_t
+output_append(struct output *o, const char *data, size_t size)
+{
+    o->m_written += size;
+    while (size > 0) {
+        size_t n = sizeof(o->m_buffer) - o->m_used;
+
+        if (n == 0) {
+            atf_error_t err = output_flush(o);
+            if (atf_is_error(err))
+                return err;
+            n = sizeof(o->m_buffer);
+        }
+        if (n > size)
+            n = size;
+        memcpy(o->m_buffer + o->m_used, data, n);
+        o->m_used += n;
+        data += n;
+        size -= n;
+    }
+    return atf_no_error();
+}
+
+static
+atf_error_t
+output_fmt(struct output *o, const char *fmt, ...)
+{
+    char buf[256];
+    va_list ap;
+    int len;
+
+    va_start(ap, fmt);
+    len = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    if (len < 0)
+        return atf_libc_error(errno, "Failed to format diff");
+
+    return output_append(o, buf, (size_t)len < sizeof(buf) ? (size_t)len :
+                         sizeof(buf) - 1);
+}
+
+/* Prints a line of a side prefixed by the given character.  Returns false
+ * in 'fits' without printing anything if the line would exceed the
+ * maximum size of the output. */
+static
+atf_error_t
+output_line(struct output *o, const char prefix, const struct side *s,
+            const size_t i, bool *fits)
+{
+    static const char no_newline[] = "\n\\ No newline at end of file\n";
+    atf_error_t err;
+    size_t size;
+    const char *data = side_line(s, i, &size);
+    const bool newline = size > 0 && data[size - 1] == '\n';
+
+    if (o->m_max_bytes != 0 &&
+        o->m_written + size + sizeof(no_newline) > o->m_max_bytes) {
+        *fits = false;
+        return atf_no_error();
+    }
+    *fits = true;
+
+    err = output_append(o, &prefix, 1);
+    if (atf_is_error(err))
+        return err;
+    if (newline)
+        return output_append(o, data, size);
+
+    err = output_append(o, data, size);
+    if (atf_is_error(err))
+        return err;
+    return output_append(o, no_newline, sizeof(no_newline) - 1);
+}
+
+/* ---------------------------------------------------------------------
+ * Hunks.
+ * --------------------------------------------------------------------- */
+
+/* A run of changed lines: [m_a0, m_a1) were replaced by [m_b0, m_b1). */
+struct change {
+    size_t m_a0, m_a1;
+    size_t m_b0, m_b1;
+};
+
+/* Finds the first change at or after the lines 'i' and 'j', which must be
+ * aligned, and leaves them right after it. */
+static
+bool
+next_change(const struct diff *d, size_t *i, size_t *j, struct change *c)
+{
+    const struct side *a = &d->m_a, *b = &d->m_b;
+
+    while (*i < a->m_nlines && *j < b->m_nlines &&
+           !a->m_changed[*i] && !b->m_changed[*j]) {
+        (*i)++;
+        (*j)++;
+    }
+    if (*i == a->m_nlines && *j == b->m_nlines)
+        return false;
+
+    c->m_a0 = *i;
+    c->m_b0 = *j;
+    while (*i < a->m_nlines && a->m_changed[*i])
+        (*i)++;
+    while (*j < b->m_nlines && b->m_changed[*j])
+        (*j)++;
+    c->m_a1 = *i;
+    c->m_b1 = *j;
+    return true;
+}
+
+static
+atf_error_t
+output_range(struct output *o, const char sign, const size_t start,
+             const size_t count)
+{
+    if (count == 1)
+        return output_fmt(o, "%c%zu", sign, start + 1);
+    else
+        return output_fmt(o, "%c%zu,%zu", sign, count == 0 ? start :
+                          start + 1, count);
+}
+
+/* Prints the hunk that goes from the change 'first' to the change 'last'
+ * with their context.  Sets 'fits' to false if the output was cut short
+ * because of its maximum size. */
+static
+atf_error_t
+output_hunk(struct output *o, const struct diff *d, const size_t context,
+            const struct change *first, const struct change *last,
+            bool *fits)
+{
+    const size_t before = first->m_a0 < context ? first->m_a0 : context;
+    const size_t after = d->m_a.m_nlines - last->m_a1 < context ?
+        d->m_a.m_nlines - last->m_a1 : context;
+    const size_t a_start = first->m_a0 - before;
+    const size_t b_start = first->m_b0 - before;
+    const size_t a_end = last->m_a1 + after;
+    const size_t b_end = last->m_b1 + after;
+    atf_error_t err;
+    size_t i, j, k, pos;
+    struct change c;
+
+    err = output_fmt(o, "@@ ");
+    if (!atf_is_error(err))
+        err = output_range(o, '-', a_start, a_end - a_start);
+    if (!atf_is_error(err))
+        err = output_fmt(o, " ");
+    if (!atf_is_error(err))
+        err = output_range(o, '+', b_start, b_end - b_start);
+    if (!atf_is_error(err))
+        err = output_fmt(o, " @@\n");
+    if (atf_is_error(err))
+        return err;
+
+    *fits = true;
+    pos = a_start;
+    i = first->m_a0;
+    j = first->m_b0;
+    while (*fits && next_change(d, &i, &j, &c) && c.m_a0 <= last->m_a0) {
+        for (; *fits && pos < c.m_a0; pos++) {
+            err = output_line(o, ' ', &d->m_a, pos, fits);
+            if (atf_is_error(err))
+                return err;
+        }
+        for (; *fits && pos < c.m_a1; pos++) {
+            err = output_line(o, '-', &d->m_a, pos, fits);
+            if (atf_is_error(err))
+                return err;
+        }
+        for (k = c.m_b0; *fits && k < c.m_b1; k++) {
+            err = output_line(o, '+', &d->m_b, k, fits);
+            if (atf_is_error(err))
+                return err;
+        }
+        if (c.m_a0 == last->m_a0 && c.m_b0 == last->m_b0)
+            break;
+    }
+    for (; *fits && pos < a_end; pos++) {
+        err = output_line(o, ' ', &d->m_a, pos, fits);
+        if (atf_is_error(err))
+            return err;
+    }
+
+    return atf_no_error();
+}
+
+static
+atf_error_t
+output_diff(struct output *o, const struct diff *d,
+            const atf_diff_options_t *options)
+{
+    atf_error_t err;
+    struct change first, last, next;
+    size_t i = 0, j = 0, nhunks = 0, skipped = 0;
+    bool have, fits = true;
+
+    have = next_change(d, &i, &j, &next);
+    if (!have)
+        return atf_no_error();
+
+    err = output_fmt(o, "--- %s\n+++ %s\n", options->m_label1,
+                     options->m_label2);
+    if (atf_is_error(err))
+        return err;
+
+    while (have) {
+        first = last = next;
+        while ((have = next_change(d, &i, &j, &next)) &&
+               next.m_a0 - last.m_a1 <= 2 * options->m_context)
+            last = next;
+
+        if (!fits || (options->m_max_hunks != 0 &&
+                      nhunks == options->m_max_hunks)) {
+            skipped++;
+            continue;
+        }
+
+        err = output_hunk(o, d, options->m_context, &first, &last, &fits);
+        if (atf_is_error(err))
+            return err;
+        nhunks++;
+    }
+
+    if (!fits)
+        err = output_fmt(o, "[Diff truncated after %zu bytes; %zu more "
+                         "hunks not shown]\n", o->m_written, skipped);
+    else if (skipped > 0)
+        err = output_fmt(o, "[%zu more hunks not shown]\n", skipped);
+    return err;
+}
+
+/* ---------------------------------------------------------------------
+ * The "atf_diff_options" type.
+ * --------------------------------------------------------------------- */
+
+void
+atf_diff_options_init(atf_diff_options_t *options, const char *label1,
+                      const char *label2)
+{
+    options->m_label1 = label1;
+    options->m_label2 = label2;
+    options->m_context = 3;
+    options->m_max_hunks = 0;
+    options->m_max_bytes = 0;
+}
+
+/* ---------------------------------------------------------------------
+ * Free functions.
+ * --------------------------------------------------------------------- */
+
+/* Writes to 'fd' a unified diff that turns the first text into the second
+ * one.  Nothing is written if both texts are equal. */
+atf_error_t
+atf_diff_mem(const void *text1, const size_t size1, const void *text2,
+             const size_t size2, const atf_diff_options_t *options,
+             const int fd)
+{
+    atf_error_t err;
+    struct diff d;
+    struct output o;
+
+    err = diff_init(&d, text1, size1, text2, size2);
+    if (atf_is_error(err))
+        return err;
+
+    o.m_fd = fd;
+    o.m_max_bytes = options->m_max_bytes;
+    o.m_written = 0;
+    o.m_used = 0;
+    err = output_diff(&o, &d, options);
+    if (!atf_is_error(err))
+        err = output_flush(&o);
+    else {
+        atf_error_t err2 = output_flush(&o);
+        if (atf_is_error(err2))
+            atf_error_free(err2);
+    }
+
+    diff_fini(&d);
+    return err;
+}
+
+atf_error_t
+atf_diff_files(const char *path1, const char *path2,
+               const atf_diff_options_t *options, const int fd)
+{
+    atf_error_t err;
+    atf_file_contents_t c1, c2;
+
+    err = atf_file_contents_init(&c1, path1);
+    if (atf_is_error(err))
+        goto out;
+
+    err = atf_file_contents_init(&c2, path2);
+    if (atf_is_error(err))
+        goto out_c1;
+
+    err = atf_diff_mem(c1.m_data, c1.m_size, c2.m_data, c2.m_size, options,
+                       fd);
+
+    atf_file_contents_fini(&c2);
+out_c1:
+    atf_file_contents_fini(&c1);
+out:
+    return err;
+}
@@ -0,0 +1,62 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#if !defined(ATF_C_DETAIL_DIFF_H)
+#define ATF_C_DETAIL_DIFF_H
+
+#include <stddef.h>
+
+#include <atf-c/error_fwd.h>
+
+/* ---------------------------------------------------------------------
+ * The "atf_diff_options" type.
+ * --------------------------------------------------------------------- */
+
+/* Settings of a unified diff.  m_context is the number of unchanged lines
+ * shown around each change.  m_max_hunks and m_max_bytes bound the size of
+ * the output, which is cut short with a note once either is reached; 0
+ * means no limit. */
+struct atf_diff_options {
+    const char *m_label1;
+    const char *m_label2;
+    size_t m_context;
+    size_t m_max_hunks;
+    size_t m_max_bytes;
+};
+typedef struct atf_diff_options atf_diff_options_t;
+
+void atf_diff_options_init(atf_diff_options_t *, const char *, const char *);
+
+/* ---------------------------------------------------------------------
+ * Free functions.
+ * --------------------------------------------------------------------- */
+
+atf_error_t atf_diff_mem(const void *, const size_t, const void *,
+                         const size_t, const atf_diff_options_t *,
+                         const int);
+atf_error_t atf_diff_files(const char *, const char *,
+                           const atf_diff_options_t *, const int);
+
+#endif /* !defined(ATF_C_DETAIL_DIFF_H) */
@@ -0,0 +1,454 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/diff.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <atf-c.h>
+
+#include "atf-c/detail/test_helpers.h"
+
+/* ---------------------------------------------------------------------
+ * Auxiliary functions.
+ * --------------------------------------------------------------------- */
+
+/* Runs the diff of two texts into a file and returns its contents, which
+ * the caller must free. */
+static
+char *
+run_diff(const char *text1, const size_t size1, const char *text2,
+         const size_t size2, const atf_diff_options_t *options)
+{
+    char *output;
+    off_t size;
+    int fd;
+
+    fd = open("diff.txt", O_RDWR | O_CREAT | O_TRUNC, 0644);
+    ATF_REQUIRE(fd != -1);
+    RE(atf_diff_mem(text1, size1, text2, size2, options, fd));
+
+    size = lseek(fd, 0, SEEK_END);
+    ATF_REQUIRE(size != -1);
+    output = malloc((size_t)size + 1);
+    ATF_REQUIRE(output != NULL);
+    ATF_REQUIRE_EQ(size, pread(fd, output, (size_t)size, 0));
+    output[size] = '\0';
+    close(fd);
+
+    return output;
+}
+
+static
+void
+check_diff(const char *text1, const char *text2, const size_t context,
+           const char *exp)
+{
+    atf_diff_options_t options;
+    char *output;
+
+    atf_diff_options_init(&options, "one", "two");
+    options.m_context = context;
+    output = run_diff(text1, strlen(text1), text2, strlen(text2), &options);
+    ATF_CHECK_STREQ_MSG(exp, output, "Diff is:\n%s\nexpected:\n%s", output,
+                        exp);
+    free(output);
+}
+
+static
+size_t
+count_substr(const char *text, const char *str)
+{
+    size_t n = 0;
+
+    while ((text = strstr(text, str)) != NULL) {
+        n++;
+        text++;
+    }
+    return n;
+}
+
+/* Builds a text with 'nlines' numbered lines, of which every 'step'-th
+ * one is altered if 'altered' is true. */
+static
+char *
+make_lines(const size_t nlines, const size_t step, const bool altered,
+           size_t *size)
+{
+    char *text = malloc(nlines * 32 + 1);
+    size_t i;
+
+    ATF_REQUIRE(text != NULL);
+    *size = 0;
+    for (i = 0; i < nlines; i++) {
+        const bool alter = altered && i % step == step / 2;
+        *size += (size_t)sprintf(text + *size, "%s %zu\n",
+                                 alter ? "changed" : "line", i);
+    }
+    return text;
+}
+
+/* ---------------------------------------------------------------------
+ * Test cases for the free functions.
+ * --------------------------------------------------------------------- */
+
+ATF_TC_WITHOUT_HEAD(diff_mem__equal);
+ATF_TC_BODY(diff_mem__equal, tc)
+{
+    check_diff("", "", 3, "");
+    check_diff("a\nb\n", "a\nb\n", 3, "");
+}
+
+ATF_TC_WITHOUT_HEAD(diff_mem__change);
+ATF_TC_BODY(diff_mem__change, tc)
+{
+    check_diff("a\nb\nc\n", "a\nx\nc\n", 3,
+               "--- one\n+++ two\n"
+               "@@ -1,3 +1,3 @@\n a\n-b\n+x\n c\n");
+    check_diff("a\nb\nc\nd\n", "a\nd\n", 0,
+               "--- one\n+++ two\n"
+               "@@ -2,2 +1,0 @@\n-b\n-c\n");
+    check_diff("a\nd\n", "a\nb\nc\nd\n", 0,
+               "--- one\n+++ two\n"
+               "@@ -1,0 +2,2 @@\n+b\n+c\n");
+}
+
+ATF_TC_WITHOUT_HEAD(diff_mem__empty);
+ATF_TC_BODY(diff_mem__empty, tc)
+{
+    check_diff("", "a\nb\n", 3,
+               "--- one\n+++ two\n"
+               "@@ -0,0 +1,2 @@\n+a\n+b\n");
+    check_diff("a\n", "", 3,
+               "--- one\n+++ two\n"
+               "@@ -1 +0,0 @@\n-a\n");
+}
+
+ATF_TC_WITHOUT_HEAD(diff_mem__context);
+ATF_TC_BODY(diff_mem__context, tc)
+{
+    const char *text = "1\n2\n3\n4\n5\n6\n7\n8\n9\n10\n11\n12\n";
+
+    check_diff(text, "1\n2\nx\n4\n5\n6\n7\n8\n9\n10\ny\n12\n", 3,
+               "--- one\n+++ two\n"
+               "@@ -1,6 +1,6 @@\n 1\n 2\n-3\n+x\n 4\n 5\n 6\n"
+               "@@ -8,5 +8,5 @@\n 8\n 9\n 10\n-11\n+y\n 12\n");
+    check_diff(text, "1\n2\nx\n4\n5\n6\n7\n8\n9\ny\n11\n12\n", 3,
+               "--- one\n+++ two\n"
+               "@@ -1,12 +1,12 @@\n 1\n 2\n-3\n+x\n 4\n 5\n 6\n 7\n 8\n 9\n"
+               "-10\n+y\n 11\n 12\n");
+    check_diff(text, "1\n2\nx\n4\n5\n6\n7\n8\n9\ny\n11\n12\n", 1,
+               "--- one\n+++ two\n"
+               "@@ -2,3 +2,3 @@\n 2\n-3\n+x\n 4\n"
+               "@@ -9,3 +9,3 @@\n 9\n-10\n+y\n 11\n");
+}
+
+ATF_TC_WITHOUT_HEAD(diff_mem__no_newline);
+ATF_TC_BODY(diff_mem__no_newline, tc)
+{
+    check_diff("a\nb", "a\nc", 3,
+               "--- one\n+++ two\n"
+               "@@ -1,2 +1,2 @@\n a\n"
+               "-b\n\\ No newline at end of file\n"
+               "+c\n\\ No newline at end of file\n");
+    check_diff("a\nb", "a\nb\n", 3,
+               "--- one\n+++ two\n"
+               "@@ -1,2 +1,2 @@\n a\n"
+               "-b\n\\ No newline at end of file\n"
+               "+b\n");
+}
+
+ATF_TC_WITHOUT_HEAD(diff_mem__binary);
+ATF_TC_BODY(diff_mem__binary, tc)
+{
+    atf_diff_options_t options;
+    char *output;
+
+    atf_diff_options_init(&options, "one", "two");
+    output = run_diff("a\0b\nc\n", 6, "a\0c\nc\n", 6, &options);
+    ATF_CHECK(memcmp(output, "--- one\n+++ two\n@@ -1,2 +1,2 @@\n-a\0b\n"
+                     "+a\0c\n c\n", 42) == 0);
+    free(output);
+}
+
+ATF_TC_WITHOUT_HEAD(diff_mem__max_hunks);
+ATF_TC_BODY(diff_mem__max_hunks, tc)
+{
+    atf_diff_options_t options;
+    size_t size1, size2;
+    char *text1 = make_lines(100, 20, false, &size1);
+    char *text2 = make_lines(100, 20, true, &size2);
+    char *output;
+
+    atf_diff_options_init(&options, "one", "two");
+    output = run_diff(text1, size1, text2, size2, &options);
+    ATF_CHECK_EQ(5, count_substr(output, "\n@@ "));
+    ATF_CHECK(strstr(output, "not shown") == NULL);
+    free(output);
+
+    options.m_max_hunks = 2;
+    output = run_diff(text1, size1, text2, size2, &options);
+    ATF_CHECK_EQ(2, count_substr(output, "\n@@ "));
+    ATF_CHECK(strstr(output, "+changed 30\n") != NULL);
+    ATF_CHECK(strstr(output, "+changed 50\n") == NULL);
+    ATF_CHECK(strstr(output, "\n[3 more hunks not shown]\n") != NULL);
+    free(output);
+
+    free(text2);
+    free(text1);
+}
+
+ATF_TC_WITHOUT_HEAD(diff_mem__max_bytes);
+ATF_TC_BODY(diff_mem__max_bytes, tc)
+{
+    atf_diff_options_t options;
+    size_t size1, size2;
+    char *text1 = make_lines(1000, 2, false, &size1);
+    char *text2 = make_lines(1000, 2, true, &size2);
+    char *output;
+
+    atf_diff_options_init(&options, "one", "two");
+    options.m_max_bytes = 1000;
+    output = run_diff(text1, size1, text2, size2, &options);
+    ATF_CHECK(strlen(output) < 1100);
+    ATF_CHECK(strstr(output, "\n[Diff truncated after ") != NULL);
+    ATF_CHECK(strstr(output, "-line 1\n+changed 1\n") != NULL);
+    free(output);
+
+    free(text2);
+    free(text1);
+}
+
+/* Fills a text with 'nlines' random lines of one letter out of four. */
+static
+void
+random_lines(char *text, const size_t nlines)
+{
+    size_t i;
+
+    for (i = 0; i < nlines; i++) {
+        text[2 * i] = (char)('a' + random() % 4);
+        text[2 * i + 1] = '\n';
+    }
+}
+
+/* Diffs two texts made of one-letter lines with all of their lines as
+ * context, checks that the diff turns the first text into the second one
+ * and returns the number of added and removed lines. */
+static
+size_t
+check_rebuild(const char *text1, const size_t n1, const char *text2,
+              const size_t n2)
+{
+    char *rebuilt1 = malloc(2 * n1 + 2), *rebuilt2 = malloc(2 * n2 + 2);
+    size_t r1 = 0, r2 = 0, edits = 0;
+    atf_diff_options_t options;
+    char *output, *line;
+
+    ATF_REQUIRE(rebuilt1 != NULL && rebuilt2 != NULL);
+    atf_diff_options_init(&options, "one", "two");
+    options.m_context = n1 + n2;
+    output = run_diff(text1, 2 * n1, text2, 2 * n2, &options);
+    for (line = strtok(output, "\n"); line != NULL;
+         line = strtok(NULL, "\n")) {
+        if (strncmp(line, "---", 3) == 0 || strncmp(line, "+++", 3) == 0 ||
+            strncmp(line, "@@", 2) == 0)
+            continue;
+        if ((line[0] == ' ' || line[0] == '-') && r1 < 2 * n1) {
+            rebuilt1[r1++] = line[1];
+            rebuilt1[r1++] = '\n';
+        }
+        if ((line[0] == ' ' || line[0] == '+') && r2 < 2 * n2) {
+            rebuilt2[r2++] = line[1];
+            rebuilt2[r2++] = '\n';
+        }
+        if (line[0] == '-' || line[0] == '+')
+            edits++;
+    }
+    free(output);
+
+    if (edits > 0) {
+        ATF_CHECK(r1 == 2 * n1 && memcmp(rebuilt1, text1, r1) == 0);
+        ATF_CHECK(r2 == 2 * n2 && memcmp(rebuilt2, text2, r2) == 0);
+    }
+    free(rebuilt2);
+    free(rebuilt1);
+    return edits;
+}
+
+/* Compares the diff of random texts with the length of their longest
+ * common subsequence, computed by dynamic programming, to check that the
+ * diff is minimal. */
+ATF_TC_WITHOUT_HEAD(diff_mem__minimal);
+ATF_TC_BODY(diff_mem__minimal, tc)
+{
+    size_t round;
+
+    srandom(1234);
+    for (round = 0; round < 500; round++) {
+        char text1[128], text2[128];
+        size_t lcs[65][65];
+        const size_t n1 = (size_t)random() % 40, n2 = (size_t)random() % 40;
+        size_t i, j;
+
+        random_lines(text1, n1);
+        random_lines(text2, n2);
+
+        for (i = 0; i <= n1; i++) {
+            for (j = 0; j <= n2; j++) {
+                if (i == 0 || j == 0)
+                    lcs[i][j] = 0;
+                else if (text1[2 * (i - 1)] == text2[2 * (j - 1)])
+                    lcs[i][j] = lcs[i - 1][j - 1] + 1;
+                else
+                    lcs[i][j] = lcs[i - 1][j] > lcs[i][j - 1] ?
+                        lcs[i - 1][j] : lcs[i][j - 1];
+            }
+        }
+
+        ATF_CHECK_EQ(n1 + n2 - 2 * lcs[n1][n2],
+                     check_rebuild(text1, n1, text2, n2));
+    }
+}
+
+/* Diffs texts with so many differences that the search for the middle
+ * snake gives up, which must still produce a valid diff. */
+ATF_TC_WITHOUT_HEAD(diff_mem__expensive);
+ATF_TC_BODY(diff_mem__expensive, tc)
+{
+    const size_t n1 = 20000, n2 = 15000;
+    char *text1 = malloc(2 * n1), *text2 = malloc(2 * n2);
+
+    ATF_REQUIRE(text1 != NULL && text2 != NULL);
+    srandom(1234);
+    random_lines(text1, n1);
+    random_lines(text2, n2);
+    ATF_CHECK(check_rebuild(text1, n1, text2, n2) >= n1 - n2);
+
+    free(text2);
+    free(text1);
+}
+
+ATF_TC_WITHOUT_HEAD(diff_mem__large);
+ATF_TC_BODY(diff_mem__large, tc)
+{
+    atf_diff_options_t options;
+    size_t size1, size2;
+    char *text1 = make_lines(200000, 10000, false, &size1);
+    char *text2 = make_lines(200000, 10000, true, &size2);
+    char *output;
+
+    atf_diff_options_init(&options, "one", "two");
+    output = run_diff(text1, size1, text2, size2, &options);
+    ATF_CHECK_EQ(20, count_substr(output, "\n@@ "));
+    ATF_CHECK_EQ(20, count_substr(output, "\n-line "));
+    ATF_CHECK_EQ(20, count_substr(output, "\n+changed "));
+    free(output);
+
+    free(text2);
+    free(text1);
+}
+
+ATF_TC_WITHOUT_HEAD(diff_files);
+ATF_TC_BODY(diff_files, tc)
+{
+    atf_diff_options_t options;
+    atf_error_t err;
+
+    atf_utils_create_file("file1", "a\nb\n");
+    atf_utils_create_file("file2", "a\nc\n");
+    atf_diff_options_init(&options, "file1", "file2");
+
+    {
+        const int fd = open("diff.txt", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        ATF_REQUIRE(fd != -1);
+        RE(atf_diff_files("file1", "file2", &options, fd));
+        close(fd);
+    }
+    ATF_CHECK(atf_utils_compare_file("diff.txt", "--- file1\n+++ file2\n"
+                                     "@@ -1,2 +1,2 @@\n a\n-b\n+c\n"));
+
+    err = atf_diff_files("file1", "missing", &options, STDOUT_FILENO);
+    ATF_REQUIRE(atf_is_error(err));
+    ATF_CHECK(atf_error_is(err, "libc"));
+    atf_error_free(err);
+}
+
+/* ---------------------------------------------------------------------
+ * Benchmarks.
+ * --------------------------------------------------------------------- */
+
+ATF_BENCH(bench_diff);
+ATF_BENCH_HEAD(bench_diff, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Diffs two texts of 100000 lines that "
+                      "differ in 1000 of them");
+}
+ATF_BENCH_BODY(bench_diff, tc, iterations)
+{
+    atf_diff_options_t options;
+    size_t i, size1, size2;
+    char *text1 = make_lines(100000, 100, false, &size1);
+    char *text2 = make_lines(100000, 100, true, &size2);
+    int fd;
+
+    fd = open("/dev/null", O_WRONLY);
+    ATF_REQUIRE(fd != -1);
+    atf_diff_options_init(&options, "one", "two");
+    for (i = 0; i < iterations; i++)
+        RE(atf_diff_mem(text1, size1, text2, size2, &options, fd));
+    close(fd);
+
+    free(text2);
+    free(text1);
+}
+
+/* ---------------------------------------------------------------------
+ * Main.
+ * --------------------------------------------------------------------- */
+
+ATF_TP_ADD_TCS(tp)
+{
+    ATF_TP_ADD_TC(tp, diff_mem__equal);
+    ATF_TP_ADD_TC(tp, diff_mem__change);
+    ATF_TP_ADD_TC(tp, diff_mem__empty);
+    ATF_TP_ADD_TC(tp, diff_mem__context);
+    ATF_TP_ADD_TC(tp, diff_mem__no_newline);
+    ATF_TP_ADD_TC(tp, diff_mem__binary);
+    ATF_TP_ADD_TC(tp, diff_mem__max_hunks);
+    ATF_TP_ADD_TC(tp, diff_mem__max_bytes);
+    ATF_TP_ADD_TC(tp, diff_mem__minimal);
+    ATF_TP_ADD_TC(tp, diff_mem__expensive);
+    ATF_TP_ADD_TC(tp, diff_mem__large);
+    ATF_TP_ADD_TC(tp, diff_files);
+
+    ATF_TP_ADD_TC(tp, bench_diff);
+
+    return atf_no_error();
+}
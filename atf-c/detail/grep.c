@@ -0,0 +1,555 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/grep.h"
+
+#include <errno.h>
+#include <regex.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "atf-c/detail/sanity.h"
+#include "atf-c/error.h"
+
+/* A scan works on a private copy of the text in which every newline has
+ * been replaced by a NUL character, so that each line can be passed to
+ * regexec(3) as is, together with the offsets at which the lines start.
+ *
+ * Expressions are matched in two ways.  When an expression contains a
+ * literal string that any match must include, memchr(3) looks for the
+ * first byte of the literal, which libc implements with vector
+ * instructions, and regexec(3) only runs on the lines that contain the
+ * whole literal.  The remaining expressions are matched against every
+ * line in a single pass shared by all of them.  Both ways stop as soon
+ * as every expression has matched. */
+
+struct atf_grep_pattern {
+    regex_t m_preg;
+
+    /* Longest literal that every match must contain; empty if none. */
+    char *m_literal;
+    size_t m_literal_len;
+
+    bool m_matched;
+    size_t m_line;
+};
+
+/* The text being scanned, as described above. */
+struct text {
+    char *m_data;
+    size_t m_size;
+
+    size_t *m_lines;
+    size_t m_nlines;
+};
+
+/* ---------------------------------------------------------------------
+ * The "invalid_regex" error type.
+ * --------------------------------------------------------------------- */
+
+struct invalid_regex_error_data {
+    char m_regex[1024];
+    char m_reason[256];
+};
+typedef struct invalid_regex_error_data invalid_regex_error_data_t;
+
+static
+void
+invalid_regex_format(const atf_error_t err, char *buf, size_t buflen)
+{
+    const invalid_regex_error_data_t *data;
+
+    PRE(atf_error_is(err, "invalid_regex"));
+
+    data = atf_error_data(err);
+    snprintf(buf, buflen, "Invalid regular expression '%s': %s",
+             data->m_regex, data->m_reason);
+}
+
+static
+atf_error_t
+invalid_regex_error(const char *regex, const regex_t *preg, const int code)
+{
+    invalid_regex_error_data_t data;
+
+    snprintf(data.m_regex, sizeof(data.m_regex), "%s", regex);
+    regerror(code, preg, data.m_reason, sizeof(data.m_reason));
+
+    return atf_error_new("invalid_regex", &data, sizeof(data),
+                         invalid_regex_format);
+}
+
+/* ---------------------------------------------------------------------
+ * Auxiliary functions.
+ * --------------------------------------------------------------------- */
+
+/* Returns a pointer past the bracket expression that starts at 'p', which
+ * points right after the opening bracket. */
+static
+const char *
+skip_bracket(const char *p)
+{
+    if (*p == '^')
+        p++;
+    if (*p == ']')
+        p++;
+    while (*p != '\0' && *p != ']') {
+        if (*p == '[' && (p[1] == ':' || p[1] == '.' || p[1] == '=')) {
+            const char delim = p[1];
+            p += 2;
+            while (*p != '\0' && !(*p == delim && p[1] == ']'))
+                p++;
+            if (*p != '\0')
+                p += 2;
+        } else
+            p++;
+    }
+    return *p == ']' ? p + 1 : p;
+}
+
+/* Finds the longest run of characters that must appear verbatim in any
+ * string matched by the extended regular expression 'regex'.
+ *
+ * This errs on the side of caution: anything that is not obviously a
+ * literal ends the current run, the contents of groups are ignored and
+ * an alternation at the top level means that there is no literal at all.
+ * A shorter literal only makes the prefilter less selective, whereas a
+ * wrong one would hide matches. */
+static
+void
+find_literal(const char *regex, char *literal, size_t *literal_len)
+{
+    const char *p = regex;
+    size_t depth = 0;
+    size_t run_start = 0, run_len = 0;
+    size_t best_start = 0, best_len = 0;
+    size_t used = 0;
+
+#define END_RUN() \
+    do { \
+        if (run_len > best_len) { \
+            best_start = run_start; \
+            best_len = run_len; \
+        } \
+        run_start = used; \
+        run_len = 0; \
+    } while (0)
+
+    while (*p != '\0') {
+        const char c = *p++;
+
+        if (depth > 0) {
+            if (c == '\\' && *p != '\0')
+                p++;
+            else if (c == '[')
+                p = skip_bracket(p);
+            else if (c == '(')
+                depth++;
+            else if (c == ')')
+                depth--;
+            continue;
+        }
+
+        switch (c) {
+        case '|':
+            literal[0] = '\0';
+            *literal_len = 0;
+            return;
+
+        case '(':
+            depth++;
+            END_RUN();
+            break;
+
+        case '[':
+            p = skip_bracket(p);
+            END_RUN();
+            break;
+
+        case '*':
+        case '?':
+        case '{':
+            /* The previous atom is optional: drop it from the run. */
+            if (run_len > 0) {
+                run_len--;
+                used--;
+            }
+            END_RUN();
+            if (c == '{') {
+                while (*p != '\0' && *p != '}')
+                    p++;
+                if (*p == '}')
+                    p++;
+            }
+            break;
+
+        case '+':
+            END_RUN();
+            break;
+
+        case '.':
+        case '^':
+        case '$':
+        case ')':
+            END_RUN();
+            break;
+
+        case '\\':
+            /* Only escaped special characters are known to be literals;
+             * others, like \< in GNU libc, have special meanings. */
+            if (*p != '\0' && strchr("^.[]$()|*+?{}\\/-", *p) != NULL) {
+                literal[used++] = *p++;
+                run_len++;
+            } else {
+                if (*p != '\0')
+                    p++;
+                END_RUN();
+            }
+            break;
+
+        default:
+            literal[used++] = c;
+            run_len++;
+            break;
+        }
+    }
+    END_RUN();
+
+#undef END_RUN
+
+    /* Every literal character of the expression was appended to the
+     * buffer, one run after the other; keep only the best one. */
+    memmove(literal, literal + best_start, best_len);
+    literal[best_len] = '\0';
+    *literal_len = best_len;
+}
+
+static
+atf_error_t
+text_init(struct text *t, const char *data, const size_t size)
+{
+    size_t capacity = 64;
+    size_t start = 0;
+
+    t->m_size = size;
+    t->m_lines = NULL;
+    t->m_nlines = 0;
+
+    t->m_data = malloc(size + 1);
+    if (t->m_data == NULL)
+        return atf_no_memory_error();
+    memcpy(t->m_data, data, size);
+    t->m_data[size] = '\0';
+
+    t->m_lines = malloc(capacity * sizeof(size_t));
+    if (t->m_lines == NULL) {
+        free(t->m_data);
+        return atf_no_memory_error();
+    }
+
+    while (start < size) {
+        char *nl = memchr(t->m_data + start, '\n', size - start);
+
+        if (t->m_nlines == capacity) {
+            size_t *lines = realloc(t->m_lines,
+                                    capacity * 2 * sizeof(size_t));
+            if (lines == NULL) {
+                free(t->m_lines);
+                free(t->m_data);
+                return atf_no_memory_error();
+            }
+            t->m_lines = lines;
+            capacity *= 2;
+        }
+        t->m_lines[t->m_nlines++] = start;
+
+        if (nl == NULL)
+            break;
+        *nl = '\0';
+        start = (size_t)(nl - t->m_data) + 1;
+    }
+
+    return atf_no_error();
+}
+
+static
+void
+text_fini(struct text *t)
+{
+    free(t->m_lines);
+    free(t->m_data);
+}
+
+/* Returns the index of the line that contains the given offset. */
+static
+size_t
+text_line_at(const struct text *t, const size_t offset)
+{
+    size_t low = 0, high = t->m_nlines;
+
+    PRE(t->m_nlines > 0 && offset >= t->m_lines[0]);
+
+    while (high - low > 1) {
+        const size_t mid = low + (high - low) / 2;
+        if (t->m_lines[mid] <= offset)
+            low = mid;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+static
+const char *
+text_line(const struct text *t, const size_t line)
+{
+    return t->m_data + t->m_lines[line];
+}
+
+static
+bool
+line_matches(const struct atf_grep_pattern *p, const char *line)
+{
+    return regexec(&p->m_preg, line, 0, NULL, 0) == 0;
+}
+
+/* Looks for a pattern with a literal by jumping between the occurrences
+ * of the literal in the text. */
+static
+void
+scan_literal(struct atf_grep_pattern *p, const struct text *t)
+{
+    const char first = p->m_literal[0];
+    size_t offset = 0;
+
+    while (offset + p->m_literal_len <= t->m_size) {
+        const char *hit = memchr(t->m_data + offset, first,
+                                 t->m_size - offset - p->m_literal_len + 1);
+        size_t line;
+
+        if (hit == NULL)
+            break;
+        offset = (size_t)(hit - t->m_data);
+
+        if (memcmp(hit, p->m_literal, p->m_literal_len) != 0) {
+            offset++;
+            continue;
+        }
+
+        line = text_line_at(t, offset);
+        if (line_matches(p, text_line(t, line))) {
+            p->m_matched = true;
+            p->m_line = line;
+            break;
+        }
+
+        if (line + 1 == t->m_nlines)
+            break;
+        offset = t->m_lines[line + 1];
+    }
+}
+
+/* Looks for all the pending patterns without a literal in one pass over
+ * the lines of the text. */
+static
+void
+scan_lines(atf_grep_t *g, const struct text *t, size_t pending)
+{
+    size_t line, i;
+
+    for (line = 0; pending > 0 && line < t->m_nlines; line++) {
+        const char *str = text_line(t, line);
+
+        for (i = 0; i < g->m_npatterns; i++) {
+            struct atf_grep_pattern *p = &g->m_patterns[i];
+
+            if (p->m_matched || p->m_literal_len > 0)
+                continue;
+            if (line_matches(p, str)) {
+                p->m_matched = true;
+                p->m_line = line;
+                pending--;
+            }
+        }
+    }
+}
+
+/* ---------------------------------------------------------------------
+ * Constructors/destructors.
+ * --------------------------------------------------------------------- */
+
+atf_error_t
+atf_grep_init(atf_grep_t *g, const char *const *regexes, const size_t n)
+{
+    atf_error_t err;
+    size_t i;
+
+    g->m_patterns = calloc(n > 0 ? n : 1, sizeof(struct atf_grep_pattern));
+    if (g->m_patterns == NULL)
+        return atf_no_memory_error();
+    g->m_npatterns = 0;
+
+    for (i = 0; i < n; i++) {
+        struct atf_grep_pattern *p = &g->m_patterns[i];
+        int code;
+
+        p->m_literal = malloc(strlen(regexes[i]) + 1);
+        if (p->m_literal == NULL) {
+            err = atf_no_memory_error();
+            goto err;
+        }
+        find_literal(regexes[i], p->m_literal, &p->m_literal_len);
+
+        code = regcomp(&p->m_preg, regexes[i], REG_EXTENDED | REG_NOSUB);
+        if (code != 0) {
+            err = invalid_regex_error(regexes[i], &p->m_preg, code);
+            free(p->m_literal);
+            goto err;
+        }
+
+        g->m_npatterns++;
+    }
+
+    return atf_no_error();
+
+err:
+    atf_grep_fini(g);
+    return err;
+}
+
+void
+atf_grep_fini(atf_grep_t *g)
+{
+    size_t i;
+
+    for (i = 0; i < g->m_npatterns; i++) {
+        regfree(&g->m_patterns[i].m_preg);
+        free(g->m_patterns[i].m_literal);
+    }
+    free(g->m_patterns);
+}
+
+/* ---------------------------------------------------------------------
+ * Getters.
+ * --------------------------------------------------------------------- */
+
+const char *
+atf_grep_literal(const atf_grep_t *g, const size_t i)
+{
+    PRE(i < g->m_npatterns);
+    return g->m_patterns[i].m_literal;
+}
+
+bool
+atf_grep_matched(const atf_grep_t *g, const size_t i)
+{
+    PRE(i < g->m_npatterns);
+    return g->m_patterns[i].m_matched;
+}
+
+/* Returns the number, starting at 1, of the first line that matched the
+ * given pattern. */
+size_t
+atf_grep_line(const atf_grep_t *g, const size_t i)
+{
+    PRE(i < g->m_npatterns);
+    PRE(g->m_patterns[i].m_matched);
+    return g->m_patterns[i].m_line + 1;
+}
+
+/* ---------------------------------------------------------------------
+ * Modifiers.
+ * --------------------------------------------------------------------- */
+
+atf_error_t
+atf_grep_scan(atf_grep_t *g, const char *data, const size_t size)
+{
+    atf_error_t err;
+    struct text t;
+    size_t i, pending = 0;
+
+    for (i = 0; i < g->m_npatterns; i++)
+        g->m_patterns[i].m_matched = false;
+
+    err = text_init(&t, data, size);
+    if (atf_is_error(err))
+        return err;
+
+    for (i = 0; i < g->m_npatterns; i++) {
+        struct atf_grep_pattern *p = &g->m_patterns[i];
+
+        if (p->m_literal_len > 0)
+            scan_literal(p, &t);
+        else
+            pending++;
+    }
+    scan_lines(g, &t, pending);
+
+    text_fini(&t);
+    return atf_no_error();
+}
+
+atf_error_t
+atf_grep_scan_fd(atf_grep_t *g, const int fd)
+{
+    atf_error_t err;
+    char *data;
+    size_t size = 0, capacity = 64 * 1024;
+    ssize_t n;
+
+    data = malloc(capacity);
+    if (data == NULL)
+        return atf_no_memory_error();
+
+    for (;;) {
+        if (size == capacity) {
+            char *bigger = realloc(data, capacity * 2);
+            if (bigger == NULL) {
+                err = atf_no_memory_error();
+                goto out;
+            }
+            data = bigger;
+            capacity *= 2;
+        }
+
+        n = read(fd, data + size, capacity - size);
+        if (n == -1) {
+            if (errno == EINTR)
+                continue;
+            err = atf_libc_error(errno, "Failed to read the text to scan");
+            goto out;
+        } else if (n == 0)
+            break;
+        size += (size_t)n;
+    }
+
+    err = atf_grep_scan(g, data, size);
+
+out:
+    free(data);
+    return err;
+}
@@ -0,0 +1,61 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#if !defined(ATF_C_DETAIL_GREP_H)
+#define ATF_C_DETAIL_GREP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <atf-c/error_fwd.h>
+
+/* ---------------------------------------------------------------------
+ * The "atf_grep" type.
+ * --------------------------------------------------------------------- */
+
+/* A set of extended regular expressions that are looked for in the lines
+ * of a text at once.  Scanning a text records, for every expression,
+ * whether any line matches it and which line matched first. */
+struct atf_grep_pattern;
+struct atf_grep {
+    size_t m_npatterns;
+    struct atf_grep_pattern *m_patterns;
+};
+typedef struct atf_grep atf_grep_t;
+
+/* Constructors/destructors. */
+atf_error_t atf_grep_init(atf_grep_t *, const char *const *, const size_t);
+void atf_grep_fini(atf_grep_t *);
+
+/* Getters. */
+const char *atf_grep_literal(const atf_grep_t *, const size_t);
+bool atf_grep_matched(const atf_grep_t *, const size_t);
+size_t atf_grep_line(const atf_grep_t *, const size_t);
+
+/* Modifiers. */
+atf_error_t atf_grep_scan(atf_grep_t *, const char *, const size_t);
+atf_error_t atf_grep_scan_fd(atf_grep_t *, const int);
+
+#endif /* !defined(ATF_C_DETAIL_GREP_H) */
@@ -0,0 +1,334 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/grep.h"
+
+#include <fcntl.h>
+#include <regex.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <atf-c.h>
+
+#include "atf-c/detail/test_helpers.h"
+#include "atf-c/utils.h"
+
+/* ---------------------------------------------------------------------
+ * Auxiliary functions.
+ * --------------------------------------------------------------------- */
+
+static
+void
+check_literal(const char *regex, const char *exp)
+{
+    atf_grep_t grep;
+
+    RE(atf_grep_init(&grep, &regex, 1));
+    ATF_CHECK_STREQ_MSG(exp, atf_grep_literal(&grep, 0),
+                        "Literal of '%s' is '%s'; expected '%s'", regex,
+                        atf_grep_literal(&grep, 0), exp);
+    atf_grep_fini(&grep);
+}
+
+/* Matches the regex against every line of the text with regexec(3), which
+ * is what the scan must be equivalent to.  Returns the number of the first
+ * matching line, or 0 if none matches. */
+static
+size_t
+naive_grep(const char *regex, const char *text)
+{
+    regex_t preg;
+    char *copy, *line, *next;
+    size_t lineno = 0, found = 0;
+
+    ATF_REQUIRE(regcomp(&preg, regex, REG_EXTENDED | REG_NOSUB) == 0);
+    copy = strdup(text);
+    ATF_REQUIRE(copy != NULL);
+
+    for (line = copy; found == 0 && *line != '\0'; line = next) {
+        char *nl = strchr(line, '\n');
+        if (nl != NULL) {
+            *nl = '\0';
+            next = nl + 1;
+        } else
+            next = line + strlen(line);
+
+        lineno++;
+        if (regexec(&preg, line, 0, NULL, 0) == 0)
+            found = lineno;
+    }
+
+    free(copy);
+    regfree(&preg);
+    return found;
+}
+
+/* Large text for the benchmarks: log-like lines in which the expressions
+ * looked for only appear at the very end. */
+static const size_t bench_lines = 65536;
+static char *bench_text;
+static size_t bench_size;
+
+static
+void
+init_bench_text(void)
+{
+    size_t i, capacity;
+
+    if (bench_text != NULL)
+        return;
+
+    capacity = bench_lines * 80;
+    bench_text = malloc(capacity);
+    ATF_REQUIRE(bench_text != NULL);
+    bench_size = 0;
+    for (i = 0; i < bench_lines - 1; i++) {
+        bench_size += (size_t)snprintf(bench_text + bench_size,
+                                       capacity - bench_size,
+                                       "%08zu [info] worker %zu processed "
+                                       "request %zu in %zu us\n",
+                                       i, i % 16, i * 7, i % 1000);
+    }
+    bench_size += (size_t)snprintf(bench_text + bench_size,
+                                   capacity - bench_size,
+                                   "%08zu [error] worker 3 crashed: "
+                                   "Segmentation fault\n", i);
+}
+
+static const char *const bench_regexes[] = {
+    "\\[error\\] worker [0-9]+ crashed",
+    "Segmentation fault$",
+    "^[0-9]+ \\[(warn|fatal)\\]",
+};
+static const size_t bench_nregexes =
+    sizeof(bench_regexes) / sizeof(bench_regexes[0]);
+
+/* ---------------------------------------------------------------------
+ * Test cases for the "atf_grep" type.
+ * --------------------------------------------------------------------- */
+
+ATF_TC_WITHOUT_HEAD(literal);
+ATF_TC_BODY(literal, tc)
+{
+    check_literal("", "");
+    check_literal("foo", "foo");
+    check_literal("^foo$", "foo");
+    check_literal("foo.*barbaz", "barbaz");
+    check_literal("fooo*bar", "foo");
+    check_literal("abc?de", "ab");
+    check_literal("abcd+e", "abcd");
+    check_literal("ab{2}cd", "cd");
+    check_literal("a[bc]+defg", "defg");
+    check_literal("[]a]xyz", "xyz");
+    check_literal("[[:digit:]]+ items", " items");
+    check_literal("foo|bar", "");
+    check_literal("(foo|bar)baz", "baz");
+    check_literal("(abc)+", "");
+    check_literal("1\\.2\\.3", "1.2.3");
+    check_literal("1\\.2\\.3?", "1.2.");
+    check_literal("\\<word\\>", "word");
+    check_literal("a\\\\b", "a\\b");
+}
+
+ATF_TC_WITHOUT_HEAD(scan);
+ATF_TC_BODY(scan, tc)
+{
+    static const char *const regexes[] = {
+        "^second", "line", "^$", "missing", "ird li",
+    };
+    const char *text = "first line\nsecond line\n\nthird line";
+    atf_grep_t grep;
+
+    RE(atf_grep_init(&grep, regexes, 5));
+    RE(atf_grep_scan(&grep, text, strlen(text)));
+
+    ATF_CHECK(atf_grep_matched(&grep, 0));
+    ATF_CHECK_EQ(2, atf_grep_line(&grep, 0));
+    ATF_CHECK(atf_grep_matched(&grep, 1));
+    ATF_CHECK_EQ(1, atf_grep_line(&grep, 1));
+    ATF_CHECK(atf_grep_matched(&grep, 2));
+    ATF_CHECK_EQ(3, atf_grep_line(&grep, 2));
+    ATF_CHECK(!atf_grep_matched(&grep, 3));
+    ATF_CHECK(atf_grep_matched(&grep, 4));
+    ATF_CHECK_EQ(4, atf_grep_line(&grep, 4));
+
+    /* Scanning again forgets the previous results. */
+    RE(atf_grep_scan(&grep, "", 0));
+    ATF_CHECK(!atf_grep_matched(&grep, 0));
+    ATF_CHECK(!atf_grep_matched(&grep, 2));
+
+    atf_grep_fini(&grep);
+}
+
+ATF_TC_WITHOUT_HEAD(scan_lines_only);
+ATF_TC_BODY(scan_lines_only, tc)
+{
+    static const char *const regexes[] = { "a.b", "^b", "ab" };
+    atf_grep_t grep;
+
+    /* Matches never span lines, even when the literal does. */
+    RE(atf_grep_init(&grep, regexes, 3));
+    RE(atf_grep_scan(&grep, "xa\nbx\n", 6));
+    ATF_CHECK(!atf_grep_matched(&grep, 0));
+    ATF_CHECK(atf_grep_matched(&grep, 1));
+    ATF_CHECK_EQ(2, atf_grep_line(&grep, 1));
+    ATF_CHECK(!atf_grep_matched(&grep, 2));
+    atf_grep_fini(&grep);
+}
+
+ATF_TC_WITHOUT_HEAD(scan_like_regexec);
+ATF_TC_BODY(scan_like_regexec, tc)
+{
+    static const char *const regexes[] = {
+        "foo", "^foo", "foo$", "fo+", "f(o|a)o", "o{2}", "[fb]ar",
+        "bar baz", "^$", "x?foo", "\\.", "a\\.b", "(foo)+ bar", "oo b",
+        "^[a-z]+ [a-z]+$", "z$", "^ ", "foofoo", "a|z",
+    };
+    static const char *const texts[] = {
+        "",
+        "\n",
+        "foo",
+        "foo\n",
+        "bar\nfoo bar\nbaz",
+        "xfoo\n\nfaofoo bar\na.b\n",
+        "foofoo bar baz\n foo\nz",
+        "bar baz\n\n\nfoo\n",
+    };
+    const size_t nregexes = sizeof(regexes) / sizeof(regexes[0]);
+    size_t i, j;
+    atf_grep_t grep;
+
+    RE(atf_grep_init(&grep, regexes, nregexes));
+    for (i = 0; i < sizeof(texts) / sizeof(texts[0]); i++) {
+        RE(atf_grep_scan(&grep, texts[i], strlen(texts[i])));
+        for (j = 0; j < nregexes; j++) {
+            const size_t exp = naive_grep(regexes[j], texts[i]);
+            const size_t line = atf_grep_matched(&grep, j) ?
+                atf_grep_line(&grep, j) : 0;
+            ATF_CHECK_EQ_MSG(exp, line, "'%s' in text %zu: line %zu, "
+                             "expected %zu", regexes[j], i, line, exp);
+        }
+    }
+    atf_grep_fini(&grep);
+}
+
+ATF_TC_WITHOUT_HEAD(scan_fd);
+ATF_TC_BODY(scan_fd, tc)
+{
+    static const char *const regexes[] = { "^[0-9]+ \\[error\\]" };
+    atf_grep_t grep;
+    int fd;
+
+    init_bench_text();
+    atf_utils_create_file("text", "%s", bench_text);
+
+    RE(atf_grep_init(&grep, regexes, 1));
+    ATF_REQUIRE((fd = open("text", O_RDONLY)) != -1);
+    RE(atf_grep_scan_fd(&grep, fd));
+    close(fd);
+    ATF_CHECK(atf_grep_matched(&grep, 0));
+    ATF_CHECK_EQ(bench_lines, atf_grep_line(&grep, 0));
+    atf_grep_fini(&grep);
+}
+
+ATF_TC_WITHOUT_HEAD(invalid_regex);
+ATF_TC_BODY(invalid_regex, tc)
+{
+    static const char *const regexes[] = { "foo", "bar[" };
+    atf_grep_t grep;
+    atf_error_t err;
+    char buf[1024];
+
+    err = atf_grep_init(&grep, regexes, 2);
+    ATF_REQUIRE(atf_is_error(err));
+    ATF_REQUIRE(atf_error_is(err, "invalid_regex"));
+    atf_error_format(err, buf, sizeof(buf));
+    ATF_CHECK(atf_utils_grep_string("^Invalid regular expression 'bar\\[': ",
+                                    buf));
+    atf_error_free(err);
+}
+
+/* ---------------------------------------------------------------------
+ * Benchmarks.
+ * --------------------------------------------------------------------- */
+
+ATF_BENCH(bench_scan);
+ATF_BENCH_HEAD(bench_scan, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Looks for three expressions in a 4 MB "
+                      "text with atf_grep_scan");
+}
+ATF_BENCH_BODY(bench_scan, tc, iterations)
+{
+    atf_grep_t grep;
+    size_t i;
+
+    init_bench_text();
+    RE(atf_grep_init(&grep, bench_regexes, bench_nregexes));
+    for (i = 0; i < iterations; i++)
+        RE(atf_grep_scan(&grep, bench_text, bench_size));
+    ATF_REQUIRE(atf_grep_matched(&grep, 0));
+    ATF_REQUIRE(!atf_grep_matched(&grep, 2));
+    atf_grep_fini(&grep);
+}
+
+ATF_BENCH(bench_naive);
+ATF_BENCH_HEAD(bench_naive, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Looks for three expressions in a 4 MB "
+                      "text by running regexec(3) on every line, for "
+                      "comparison with bench_scan");
+}
+ATF_BENCH_BODY(bench_naive, tc, iterations)
+{
+    size_t i, j;
+
+    init_bench_text();
+    for (i = 0; i < iterations; i++) {
+        for (j = 0; j < bench_nregexes; j++)
+            (void)naive_grep(bench_regexes[j], bench_text);
+    }
+}
+
+/* ---------------------------------------------------------------------
+ * Main.
+ * --------------------------------------------------------------------- */
+
+ATF_TP_ADD_TCS(tp)
+{
+    ATF_TP_ADD_TC(tp, literal);
+    ATF_TP_ADD_TC(tp, scan);
+    ATF_TP_ADD_TC(tp, scan_lines_only);
+    ATF_TP_ADD_TC(tp, scan_like_regexec);
+    ATF_TP_ADD_TC(tp, scan_fd);
+    ATF_TP_ADD_TC(tp, invalid_regex);
+
+    ATF_TP_ADD_TC(tp, bench_scan);
+    ATF_TP_ADD_TC(tp, bench_naive);
+
+    return atf_no_error();
+}
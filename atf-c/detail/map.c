@@ -37,31 +37,157 @@
  * Auxiliary functions.
  * --------------------------------------------------------------------- */
 
-struct map_entry {
-    char *m_key;
-    void *m_value;
+/* Keys shorter than this (including their terminating NUL) live inside the
+ * entry itself; longer keys are copied into the map's arena. */
+#define INLINE_KEY_SIZE 24
+
+#define UNCONST(a) ((void *)(uintptr_t)(const void *)(a))
+
+struct atf_map_entry {
+    uint32_t m_hash;
     bool m_managed;
+    bool m_long;
+    void *m_value;
+    union {
+        char m_inline[INLINE_KEY_SIZE];
+        size_t m_offset;
+    } m_key;
 };
 
 static
-struct map_entry *
-new_entry(const char *key, void *value, bool managed)
+uint32_t
+hash_key(const char *key)
 {
-    struct map_entry *me;
-
-    me = (struct map_entry *)malloc(sizeof(*me));
-    if (me != NULL) {
-        me->m_key = strdup(key);
-        if (me->m_key == NULL) {
-            free(me);
-            me = NULL;
-        } else {
-            me->m_value = value;
-            me->m_managed = managed;
-        }
+    uint32_t h = 2166136261u;
+
+    for (; *key != '\0'; key++) {
+        h ^= (unsigned char)*key;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static
+const char *
+entry_key(const atf_map_t *m, const struct atf_map_entry *me)
+{
+    return me->m_long ? m->m_arena + me->m_key.m_offset : me->m_key.m_inline;
+}
+
+/* Returns the slot that holds the given key or, if the key is not in the
+ * map, the empty slot where it would be placed.  The table must have been
+ * allocated and must have at least one empty slot. */
+static
+size_t
+find_slot(const atf_map_t *m, const char *key, const uint32_t hash)
+{
+    const size_t mask = m->m_nslots - 1;
+    size_t pos;
+
+    PRE(m->m_nslots > 0);
+
+    for (pos = hash & mask; m->m_slots[pos] != 0; pos = (pos + 1) & mask) {
+        const struct atf_map_entry *me = &m->m_entries[m->m_slots[pos] - 1];
+
+        if (me->m_hash == hash && strcmp(entry_key(m, me), key) == 0)
+            break;
+    }
+    return pos;
+}
+
+static
+const struct atf_map_entry *
+find_entry(const atf_map_t *m, const char *key)
+{
+    size_t pos;
+
+    if (m->m_size == 0)
+        return NULL;
+
+    pos = find_slot(m, key, hash_key(key));
+    return m->m_slots[pos] == 0 ? NULL : &m->m_entries[m->m_slots[pos] - 1];
+}
+
+/* Makes sure there is room for one more entry while keeping the load
+ * factor of the table at or below one half. */
+static
+atf_error_t
+reserve(atf_map_t *m)
+{
+    struct atf_map_entry *entries;
+    uint32_t *slots;
+    size_t i, nslots;
+
+    if ((m->m_size + 1) * 2 <= m->m_nslots)
+        return atf_no_error();
+
+    nslots = m->m_nslots == 0 ? 8 : m->m_nslots * 2;
+
+    entries = realloc(m->m_entries, sizeof(*entries) * (nslots / 2));
+    if (entries == NULL)
+        return atf_no_memory_error();
+    m->m_entries = entries;
+
+    slots = calloc(nslots, sizeof(*slots));
+    if (slots == NULL)
+        return atf_no_memory_error();
+    free(m->m_slots);
+    m->m_slots = slots;
+    m->m_nslots = nslots;
+
+    for (i = 0; i < m->m_size; i++) {
+        size_t pos;
+
+        for (pos = entries[i].m_hash & (nslots - 1); slots[pos] != 0;
+             pos = (pos + 1) & (nslots - 1))
+            ;
+        slots[pos] = i + 1;
+    }
+
+    return atf_no_error();
+}
+
+static
+atf_error_t
+store_key(atf_map_t *m, struct atf_map_entry *me, const char *key)
+{
+    const size_t len = strlen(key) + 1;
+
+    if (len <= INLINE_KEY_SIZE) {
+        memcpy(me->m_key.m_inline, key, len);
+        me->m_long = false;
+        return atf_no_error();
     }
 
-    return me;
+    if (m->m_arena_size + len > m->m_arena_capacity) {
+        size_t capacity;
+        char *arena;
+
+        capacity = m->m_arena_capacity == 0 ? 256 : m->m_arena_capacity * 2;
+        while (capacity < m->m_arena_size + len)
+            capacity *= 2;
+
+        arena = realloc(m->m_arena, capacity);
+        if (arena == NULL)
+            return atf_no_memory_error();
+        m->m_arena = arena;
+        m->m_arena_capacity = capacity;
+    }
+
+    memcpy(m->m_arena + m->m_arena_size, key, len);
+    me->m_key.m_offset = m->m_arena_size;
+    me->m_long = true;
+    m->m_arena_size += len;
+    return atf_no_error();
+}
+
+static
+const struct atf_map_entry *
+next_entry(const atf_map_t *m, const struct atf_map_entry *me)
+{
+    PRE(me != NULL);
+    me++;
+    return me == m->m_entries + m->m_size ? NULL : me;
 }
 
 /* ---------------------------------------------------------------------
@@ -75,15 +201,15 @@ new_entry(const char *key, void *value, bool managed)
 const char *
 atf_map_citer_key(const atf_map_citer_t citer)
 {
-    const struct map_entry *me = citer.m_entry;
+    const struct atf_map_entry *me = citer.m_entry;
     PRE(me != NULL);
-    return me->m_key;
+    return entry_key(citer.m_map, me);
 }
 
 const void *
 atf_map_citer_data(const atf_map_citer_t citer)
 {
-    const struct map_entry *me = citer.m_entry;
+    const struct atf_map_entry *me = citer.m_entry;
     PRE(me != NULL);
     return me->m_value;
 }
@@ -94,9 +220,7 @@ atf_map_citer_next(const atf_map_citer_t citer)
     atf_map_citer_t newciter;
 
     newciter = citer;
-    newciter.m_listiter = atf_list_citer_next(citer.m_listiter);
-    newciter.m_entry = ((const struct map_entry *)
-                        atf_list_citer_data(newciter.m_listiter));
+    newciter.m_entry = next_entry(citer.m_map, citer.m_entry);
 
     return newciter;
 }
@@ -119,15 +243,15 @@ atf_equal_map_citer_map_citer(const atf_map_citer_t i1,
 const char *
 atf_map_iter_key(const atf_map_iter_t iter)
 {
-    const struct map_entry *me = iter.m_entry;
+    const struct atf_map_entry *me = iter.m_entry;
     PRE(me != NULL);
-    return me->m_key;
+    return entry_key(iter.m_map, me);
 }
 
 void *
 atf_map_iter_data(const atf_map_iter_t iter)
 {
-    const struct map_entry *me = iter.m_entry;
+    const struct atf_map_entry *me = iter.m_entry;
     PRE(me != NULL);
     return me->m_value;
 }
@@ -138,9 +262,7 @@ atf_map_iter_next(const atf_map_iter_t iter)
     atf_map_iter_t newiter;
 
     newiter = iter;
-    newiter.m_listiter = atf_list_iter_next(iter.m_listiter);
-    newiter.m_entry = ((struct map_entry *)
-                       atf_list_iter_data(newiter.m_listiter));
+    newiter.m_entry = UNCONST(next_entry(iter.m_map, iter.m_entry));
 
     return newiter;
 }
@@ -163,7 +285,15 @@ atf_equal_map_iter_map_iter(const atf_map_iter_t i1,
 atf_error_t
 atf_map_init(atf_map_t *m)
 {
-    return atf_list_init(&m->m_list);
+    m->m_entries = NULL;
+    m->m_size = 0;
+    m->m_slots = NULL;
+    m->m_nslots = 0;
+    m->m_arena = NULL;
+    m->m_arena_size = 0;
+    m->m_arena_capacity = 0;
+
+    return atf_no_error();
 }
 
 atf_error_t
@@ -201,17 +331,15 @@ atf_map_init_charpp(atf_map_t *m, const char *const *array)
 void
 atf_map_fini(atf_map_t *m)
 {
-    atf_list_iter_t iter;
-
-    atf_list_for_each(iter, &m->m_list) {
-        struct map_entry *me = atf_list_iter_data(iter);
+    size_t i;
 
-        if (me->m_managed)
-            free(me->m_value);
-        free(me->m_key);
-        free(me);
+    for (i = 0; i < m->m_size; i++) {
+        if (m->m_entries[i].m_managed)
+            free(m->m_entries[i].m_value);
     }
-    atf_list_fini(&m->m_list);
+    free(m->m_entries);
+    free(m->m_slots);
+    free(m->m_arena);
 }
 
 /*
@@ -223,8 +351,7 @@ atf_map_begin(atf_map_t *m)
 {
     atf_map_iter_t iter;
     iter.m_map = m;
-    iter.m_listiter = atf_list_begin(&m->m_list);
-    iter.m_entry = atf_list_iter_data(iter.m_listiter);
+    iter.m_entry = m->m_size == 0 ? NULL : m->m_entries;
     return iter;
 }
 
@@ -233,8 +360,7 @@ atf_map_begin_c(const atf_map_t *m)
 {
     atf_map_citer_t citer;
     citer.m_map = m;
-    citer.m_listiter = atf_list_begin_c(&m->m_list);
-    citer.m_entry = atf_list_citer_data(citer.m_listiter);
+    citer.m_entry = m->m_size == 0 ? NULL : m->m_entries;
     return citer;
 }
 
@@ -244,7 +370,6 @@ atf_map_end(atf_map_t *m)
     atf_map_iter_t iter;
     iter.m_map = m;
     iter.m_entry = NULL;
-    iter.m_listiter = atf_list_end(&m->m_list);
     return iter;
 }
 
@@ -254,54 +379,31 @@ atf_map_end_c(const atf_map_t *m)
     atf_map_citer_t iter;
     iter.m_map = m;
     iter.m_entry = NULL;
-    iter.m_listiter = atf_list_end_c(&m->m_list);
     return iter;
 }
 
 atf_map_iter_t
 atf_map_find(atf_map_t *m, const char *key)
 {
-    atf_list_iter_t iter;
-
-    atf_list_for_each(iter, &m->m_list) {
-        struct map_entry *me = atf_list_iter_data(iter);
-
-        if (strcmp(me->m_key, key) == 0) {
-            atf_map_iter_t i;
-            i.m_map = m;
-            i.m_entry = me;
-            i.m_listiter = iter;
-            return i;
-        }
-    }
-
-    return atf_map_end(m);
+    atf_map_iter_t iter;
+    iter.m_map = m;
+    iter.m_entry = UNCONST(find_entry(m, key));
+    return iter;
 }
 
 atf_map_citer_t
 atf_map_find_c(const atf_map_t *m, const char *key)
 {
-    atf_list_citer_t iter;
-
-    atf_list_for_each_c(iter, &m->m_list) {
-        const struct map_entry *me = atf_list_citer_data(iter);
-
-        if (strcmp(me->m_key, key) == 0) {
-            atf_map_citer_t i;
-            i.m_map = m;
-            i.m_entry = me;
-            i.m_listiter = iter;
-            return i;
-        }
-    }
-
-    return atf_map_end_c(m);
+    atf_map_citer_t citer;
+    citer.m_map = m;
+    citer.m_entry = find_entry(m, key);
+    return citer;
 }
 
 size_t
 atf_map_size(const atf_map_t *m)
 {
-    return atf_list_size(&m->m_list);
+    return m->m_size;
 }
 
 char **
@@ -346,34 +448,44 @@ out:
 atf_error_t
 atf_map_insert(atf_map_t *m, const char *key, void *value, bool managed)
 {
-    struct map_entry *me;
+    struct atf_map_entry *me;
     atf_error_t err;
-    atf_map_iter_t iter;
+    uint32_t hash;
+    size_t pos;
 
-    iter = atf_map_find(m, key);
-    if (atf_equal_map_iter_map_iter(iter, atf_map_end(m))) {
-        me = new_entry(key, value, managed);
-        if (me == NULL)
-            err = atf_no_memory_error();
-        else {
-            err = atf_list_append(&m->m_list, me, false);
-            if (atf_is_error(err)) {
-                if (managed)
-                    free(value);
-                free(me);
-            }
+    err = reserve(m);
+    if (atf_is_error(err)) {
+        if (managed)
+            free(value);
+        goto out;
+    }
+
+    hash = hash_key(key);
+    pos = find_slot(m, key, hash);
+    if (m->m_slots[pos] == 0) {
+        me = &m->m_entries[m->m_size];
+        err = store_key(m, me, key);
+        if (atf_is_error(err)) {
+            if (managed)
+                free(value);
+            goto out;
         }
+        me->m_hash = hash;
+        me->m_value = value;
+        me->m_managed = managed;
+
+        m->m_size++;
+        m->m_slots[pos] = m->m_size;
     } else {
-        me = iter.m_entry;
+        me = &m->m_entries[m->m_slots[pos] - 1];
         if (me->m_managed)
             free(me->m_value);
 
-        INV(strcmp(me->m_key, key) == 0);
+        INV(strcmp(entry_key(m, me), key) == 0);
         me->m_value = value;
         me->m_managed = managed;
-
-        err = atf_no_error();
     }
 
+out:
     return err;
 }
@@ -28,8 +28,9 @@
 
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
-#include <atf-c/detail/list.h>
 #include <atf-c/error_fwd.h>
 
 /* ---------------------------------------------------------------------
@@ -39,7 +40,6 @@
 struct atf_map_citer {
     const struct atf_map *m_map;
     const void *m_entry;
-    atf_list_citer_t m_listiter;
 };
 typedef struct atf_map_citer atf_map_citer_t;
 
@@ -59,7 +59,6 @@ bool atf_equal_map_citer_map_citer(const atf_map_citer_t,
 struct atf_map_iter {
     struct atf_map *m_map;
     void *m_entry;
-    atf_list_iter_t m_listiter;
 };
 typedef struct atf_map_iter atf_map_iter_t;
 
@@ -76,10 +75,22 @@ bool atf_equal_map_iter_map_iter(const atf_map_iter_t,
  * The "atf_map" type.
  * --------------------------------------------------------------------- */
 
-/* A list-based map.  Typically very inefficient, but our maps are small
- * enough. */
+/* A hash table with open addressing.  The entries are stored contiguously
+ * in insertion order, which is also the iteration order, and the slots
+ * hold indexes into them.  Short keys are stored inline in their entries
+ * and longer keys in a single arena per map.  Inserting an element
+ * invalidates all iterators and key pointers obtained from the map. */
+struct atf_map_entry;
 struct atf_map {
-    atf_list_t m_list;
+    struct atf_map_entry *m_entries;
+    size_t m_size;
+
+    uint32_t *m_slots;
+    size_t m_nslots;
+
+    char *m_arena;
+    size_t m_arena_size;
+    size_t m_arena_capacity;
 };
 typedef struct atf_map atf_map_t;
 
@@ -0,0 +1,256 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+/* Microbenchmark for the atf_map type as used by test cases that query
+ * their configuration variables in tight loops.
+ *
+ * Usage: map_bench [nvars [nlookups]]
+ *
+ * Inserts nvars keys into an atf_map and then looks them all up in a
+ * round-robin fashion nlookups times, doing the same with the list-backed
+ * map that atf_map used to be as a baseline.  It then times the
+ * initialization of a test case with nvars configuration variables and
+ * the same lookups through atf_tc_get_config_var. */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "atf-c/defs.h"
+#include "atf-c/detail/list.h"
+#include "atf-c/detail/map.h"
+#include "atf-c/error.h"
+#include "atf-c/tc.h"
+
+static
+double
+now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static
+void
+check(atf_error_t err)
+{
+    if (atf_is_error(err)) {
+        char buf[1024];
+
+        atf_error_format(err, buf, sizeof(buf));
+        fprintf(stderr, "map_bench: %s\n", buf);
+        exit(EXIT_FAILURE);
+    }
+}
+
+static
+void
+dummy_body(const atf_tc_t *tc ATF_DEFS_ATTRIBUTE_UNUSED)
+{
+}
+
+/* ---------------------------------------------------------------------
+ * The baseline: the list-backed map that atf_map used to be.
+ * --------------------------------------------------------------------- */
+
+struct list_map_entry {
+    char *m_key;
+    void *m_value;
+    bool m_managed;
+};
+
+static
+struct list_map_entry *
+list_map_find(atf_list_t *m, const char *key)
+{
+    atf_list_iter_t iter;
+
+    atf_list_for_each(iter, m) {
+        struct list_map_entry *me = atf_list_iter_data(iter);
+
+        if (strcmp(me->m_key, key) == 0)
+            return me;
+    }
+    return NULL;
+}
+
+static
+atf_error_t
+list_map_insert(atf_list_t *m, const char *key, void *value, bool managed)
+{
+    struct list_map_entry *me;
+    atf_error_t err;
+
+    me = list_map_find(m, key);
+    if (me == NULL) {
+        me = malloc(sizeof(*me));
+        if (me == NULL)
+            return atf_no_memory_error();
+        me->m_key = strdup(key);
+        if (me->m_key == NULL) {
+            free(me);
+            return atf_no_memory_error();
+        }
+        me->m_value = value;
+        me->m_managed = managed;
+
+        err = atf_list_append(m, me, false);
+        if (atf_is_error(err)) {
+            free(me->m_key);
+            free(me);
+        }
+    } else {
+        if (me->m_managed)
+            free(me->m_value);
+        me->m_value = value;
+        me->m_managed = managed;
+        err = atf_no_error();
+    }
+
+    return err;
+}
+
+static
+void
+list_map_fini(atf_list_t *m)
+{
+    atf_list_iter_t iter;
+
+    atf_list_for_each(iter, m) {
+        struct list_map_entry *me = atf_list_iter_data(iter);
+
+        if (me->m_managed)
+            free(me->m_value);
+        free(me->m_key);
+        free(me);
+    }
+    atf_list_fini(m);
+}
+
+/* ---------------------------------------------------------------------
+ * Main.
+ * --------------------------------------------------------------------- */
+
+static
+void
+report(const char *name, const long nvars, const double insert_ns,
+       const long nlookups, const double lookup_ns, const size_t total)
+{
+    printf("%s: %.1f ns per insertion, %.1f ns per lookup (checksum %zu)\n",
+           name, insert_ns / nvars, lookup_ns / nlookups, total);
+}
+
+int
+main(int argc, char **argv)
+{
+    const long nvars = argc > 1 ? atol(argv[1]) : 200;
+    const long nlookups = argc > 2 ? atol(argv[2]) : 10000000;
+    char **config, **names;
+    double start, init_ns, lookup_ns, insert_ns;
+    size_t total;
+    atf_list_t list;
+    atf_map_t map;
+    atf_tc_t tc;
+    long i;
+
+    if (nvars <= 0 || nlookups <= 0) {
+        fprintf(stderr, "Usage: map_bench [nvars [nlookups]]\n");
+        return EXIT_FAILURE;
+    }
+
+    config = calloc(nvars * 2 + 1, sizeof(char *));
+    names = calloc(nvars, sizeof(char *));
+    if (config == NULL || names == NULL)
+        return EXIT_FAILURE;
+    for (i = 0; i < nvars; i++) {
+        char buf[64];
+
+        snprintf(buf, sizeof(buf), "config.variable.%ld", i);
+        names[i] = config[i * 2] = strdup(buf);
+        snprintf(buf, sizeof(buf), "value-%ld", i);
+        config[i * 2 + 1] = strdup(buf);
+    }
+
+    printf("variables: %ld\n", nvars);
+
+    start = now_ns();
+    check(atf_list_init(&list));
+    for (i = 0; i < nvars; i++)
+        check(list_map_insert(&list, names[i], config[i * 2 + 1], false));
+    insert_ns = now_ns() - start;
+
+    total = 0;
+    start = now_ns();
+    for (i = 0; i < nlookups; i++) {
+        const struct list_map_entry *me = list_map_find(&list,
+                                                        names[i % nvars]);
+        total += strlen(me->m_value);
+    }
+    lookup_ns = now_ns() - start;
+    list_map_fini(&list);
+    report("list map (baseline)", nvars, insert_ns, nlookups, lookup_ns,
+           total);
+
+    start = now_ns();
+    check(atf_map_init(&map));
+    for (i = 0; i < nvars; i++)
+        check(atf_map_insert(&map, names[i], config[i * 2 + 1], false));
+    insert_ns = now_ns() - start;
+
+    total = 0;
+    start = now_ns();
+    for (i = 0; i < nlookups; i++)
+        total += strlen(atf_map_citer_data(atf_map_find_c(&map,
+                                                          names[i % nvars])));
+    lookup_ns = now_ns() - start;
+    atf_map_fini(&map);
+    report("atf_map", nvars, insert_ns, nlookups, lookup_ns, total);
+
+    start = now_ns();
+    check(atf_tc_init(&tc, "bench", NULL, dummy_body, NULL,
+                      (const char *const *)config));
+    init_ns = now_ns() - start;
+
+    total = 0;
+    start = now_ns();
+    for (i = 0; i < nlookups; i++)
+        total += strlen(atf_tc_get_config_var(&tc, names[i % nvars]));
+    lookup_ns = now_ns() - start;
+    atf_tc_fini(&tc);
+
+    printf("atf_tc_init: %.1f us\n", init_ns / 1000);
+    printf("atf_tc_get_config_var: %.1f ns per lookup (checksum %zu)\n",
+           lookup_ns / nlookups, total);
+
+    for (i = 0; i < nvars * 2; i++)
+        free(config[i]);
+    free(config);
+    free(names);
+    return EXIT_SUCCESS;
+}
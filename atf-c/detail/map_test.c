@@ -388,6 +388,60 @@ ATF_TC_BODY(stable_keys, tc)
     atf_map_fini(&map);
 }
 
+ATF_TC(many_keys);
+ATF_TC_HEAD(many_keys, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks that a map holding many short "
+                      "and long keys keeps them all reachable and iterates "
+                      "over them in insertion order");
+}
+ATF_TC_BODY(many_keys, tc)
+{
+    atf_map_t map;
+    atf_map_citer_t iter;
+    char key[64];
+    int nums[500];
+    size_t i;
+
+    RE(atf_map_init(&map));
+    for (i = 0; i < 500; i++) {
+        nums[i] = i;
+        if (i % 2 == 0)
+            snprintf(key, sizeof(key), "k%zd", i);
+        else
+            snprintf(key, sizeof(key), "a-much-longer-key-than-usual-%zd", i);
+        RE(atf_map_insert(&map, key, &nums[i], false));
+    }
+    ATF_REQUIRE_EQ(atf_map_size(&map), 500);
+
+    i = 0;
+    atf_map_for_each_c(iter, &map) {
+        if (i % 2 == 0)
+            snprintf(key, sizeof(key), "k%zd", i);
+        else
+            snprintf(key, sizeof(key), "a-much-longer-key-than-usual-%zd", i);
+        ATF_REQUIRE_STREQ(key, atf_map_citer_key(iter));
+        ATF_REQUIRE_EQ(&nums[i], atf_map_citer_data(iter));
+        i++;
+    }
+    ATF_REQUIRE_EQ(i, 500);
+
+    for (i = 0; i < 500; i++) {
+        if (i % 2 == 0)
+            snprintf(key, sizeof(key), "k%zd", i);
+        else
+            snprintf(key, sizeof(key), "a-much-longer-key-than-usual-%zd", i);
+        iter = atf_map_find_c(&map, key);
+        ATF_REQUIRE(!atf_equal_map_citer_map_citer(iter,
+                                                   atf_map_end_c(&map)));
+        ATF_REQUIRE_EQ(&nums[i], atf_map_citer_data(iter));
+    }
+    iter = atf_map_find_c(&map, "k1");
+    ATF_REQUIRE(atf_equal_map_citer_map_citer(iter, atf_map_end_c(&map)));
+
+    atf_map_fini(&map);
+}
+
 /* ---------------------------------------------------------------------
  * Main.
  * --------------------------------------------------------------------- */
@@ -416,6 +470,7 @@ ATF_TP_ADD_TCS(tp)
 
     /* Other. */
     ATF_TP_ADD_TC(tp, stable_keys);
+    ATF_TP_ADD_TC(tp, many_keys);
 
     return atf_no_error();
 }
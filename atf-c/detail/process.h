@@ -29,6 +29,9 @@
 #include <sys/types.h>
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
 
 #include <atf-c/detail/fs.h>
 #include <atf-c/detail/list.h>
@@ -75,8 +78,20 @@ int atf_process_stream_type(const atf_process_stream_t *);
  * The "atf_process_status" type.
  * --------------------------------------------------------------------- */
 
+/* Besides the exit status, holds the resources consumed by the process as
+ * returned by wait4(2) and the wall time from its start to its reaping.
+ * Times are in microseconds and the peak RSS is in kilobytes. */
 struct atf_process_status {
     int m_status;
+
+    int64_t m_wall_usec;
+    int64_t m_user_usec;
+    int64_t m_system_usec;
+    long m_maxrss_kb;
+    long m_minflt;
+    long m_majflt;
+    long m_nvcsw;
+    long m_nivcsw;
 };
 typedef struct atf_process_status atf_process_status_t;
 
@@ -87,6 +102,14 @@ int atf_process_status_exitstatus(const atf_process_status_t *);
 bool atf_process_status_signaled(const atf_process_status_t *);
 int atf_process_status_termsig(const atf_process_status_t *);
 bool atf_process_status_coredump(const atf_process_status_t *);
+int64_t atf_process_status_wall_usec(const atf_process_status_t *);
+int64_t atf_process_status_user_usec(const atf_process_status_t *);
+int64_t atf_process_status_system_usec(const atf_process_status_t *);
+long atf_process_status_maxrss_kb(const atf_process_status_t *);
+long atf_process_status_minflt(const atf_process_status_t *);
+long atf_process_status_majflt(const atf_process_status_t *);
+long atf_process_status_nvcsw(const atf_process_status_t *);
+long atf_process_status_nivcsw(const atf_process_status_t *);
 
 /* ---------------------------------------------------------------------
  * The "atf_process_child" type.
@@ -94,6 +117,7 @@ bool atf_process_status_coredump(const atf_process_status_t *);
 
 struct atf_process_child {
     pid_t m_pid;
+    struct timespec m_start;
 
     int m_stdout;
     int m_stderr;
@@ -103,9 +127,81 @@ typedef struct atf_process_child atf_process_child_t;
 atf_error_t atf_process_child_wait(atf_process_child_t *,
                                    atf_process_status_t *);
 pid_t atf_process_child_pid(const atf_process_child_t *);
+void atf_process_child_signal(const atf_process_child_t *, const int);
 int atf_process_child_stdout(atf_process_child_t *);
 int atf_process_child_stderr(atf_process_child_t *);
 
+/* ---------------------------------------------------------------------
+ * The "atf_process_capture" type.
+ * --------------------------------------------------------------------- */
+
+struct atf_process_capture {
+    char *m_stdout;
+    size_t m_stdout_size;
+    char *m_stderr;
+    size_t m_stderr_size;
+};
+typedef struct atf_process_capture atf_process_capture_t;
+
+/* Receives a chunk of the stdout or stderr of a child, identified by its
+ * file descriptor number. */
+typedef atf_error_t (*atf_process_sink_t)(void *, const int, const char *,
+                                          const size_t, bool *);
+
+void atf_process_capture_fini(atf_process_capture_t *);
+
+atf_error_t atf_process_child_drain(atf_process_child_t *,
+                                    atf_process_sink_t, void *);
+atf_error_t atf_process_child_drain_timeout(atf_process_child_t *,
+                                            atf_process_sink_t, void *,
+                                            const int, bool *);
+atf_error_t atf_process_child_capture(atf_process_child_t *,
+                                      atf_process_status_t *,
+                                      atf_process_capture_t *);
+
+/* ---------------------------------------------------------------------
+ * The "atf_process_group" type.
+ * --------------------------------------------------------------------- */
+
+struct atf_process_group_impl;
+struct atf_process_group {
+    struct atf_process_group_impl *pimpl;
+};
+typedef struct atf_process_group atf_process_group_t;
+
+atf_error_t atf_process_group_init(atf_process_group_t *);
+void atf_process_group_fini(atf_process_group_t *);
+
+atf_error_t atf_process_group_fork(atf_process_group_t *,
+                                   void (*)(void *),
+                                   const atf_process_stream_t *,
+                                   const atf_process_stream_t *,
+                                   void *,
+                                   size_t *);
+atf_error_t atf_process_group_spawn(atf_process_group_t *,
+                                    const char *,
+                                    const char *const *,
+                                    const atf_process_stream_t *,
+                                    const atf_process_stream_t *,
+                                    size_t *);
+
+size_t atf_process_group_size(const atf_process_group_t *);
+pid_t atf_process_group_pid(const atf_process_group_t *, const size_t);
+const atf_process_status_t *atf_process_group_status(
+    const atf_process_group_t *, const size_t);
+const char *atf_process_group_stdout(const atf_process_group_t *,
+                                     const size_t, size_t *);
+const char *atf_process_group_stderr(const atf_process_group_t *,
+                                     const size_t, size_t *);
+
+void atf_process_group_kill(atf_process_group_t *, const int);
+void atf_process_group_set_deadline(atf_process_group_t *, const int,
+                                    const int);
+atf_error_t atf_process_group_wait_any(atf_process_group_t *, const int,
+                                       size_t *, bool *);
+atf_error_t atf_process_group_wait_all(atf_process_group_t *, const int,
+                                       bool *);
+
 /* ---------------------------------------------------------------------
  * Free functions.
  * --------------------------------------------------------------------- */
@@ -115,6 +211,16 @@ atf_error_t atf_process_fork(atf_process_child_t *,
                              const atf_process_stream_t *,
                              const atf_process_stream_t *,
                              void *);
+atf_error_t atf_process_spawn(atf_process_child_t *,
+                              const char *,
+                              const char *const *,
+                              const atf_process_stream_t *,
+                              const atf_process_stream_t *);
+atf_error_t atf_process_spawn_pgrp(atf_process_child_t *,
+                                   const char *,
+                                   const char *const *,
+                                   const atf_process_stream_t *,
+                                   const atf_process_stream_t *);
 atf_error_t atf_process_exec_array(atf_process_status_t *,
                                    const atf_fs_path_t *,
                                    const char *const *,
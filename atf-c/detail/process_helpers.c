@@ -63,6 +63,16 @@ h_exit_success(void)
     return EXIT_SUCCESS;
 }
 
+static
+int
+h_print(const char *msg)
+{
+    fprintf(stdout, "stdout: %s\n", msg);
+    fprintf(stderr, "stderr: %s\n", msg);
+
+    return EXIT_SUCCESS;
+}
+
 static
 int
 h_stdout_stderr(const char *id)
@@ -75,6 +85,33 @@ h_stdout_stderr(const char *id)
     return EXIT_SUCCESS;
 }
 
+static
+int
+h_stdout_stderr_large(const char *lines)
+{
+    const int count = atoi(lines);
+    int i;
+
+    for (i = 0; i < count; i++) {
+        fprintf(stdout, "%08d stdout\n", i);
+        fprintf(stderr, "%08d stderr\n", i);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+static
+int
+h_stdout_forever(void)
+{
+    int i;
+
+    for (i = 0; !ferror(stdout); i++)
+        fprintf(stdout, "%08d stdout\n", i);
+
+    return EXIT_FAILURE;
+}
+
 static
 void
 check_args(const int argc, const char *const argv[], const int required)
@@ -101,9 +138,17 @@ main(int argc, const char *const argv[])
         exitcode = h_exit_signal();
     else if (strcmp(argv[1], "exit-success") == 0)
         exitcode = h_exit_success();
-    else if (strcmp(argv[1], "stdout-stderr") == 0) {
+    else if (strcmp(argv[1], "print") == 0) {
+        check_args(argc, argv, 3);
+        exitcode = h_print(argv[2]);
+    } else if (strcmp(argv[1], "stdout-stderr") == 0) {
         check_args(argc, argv, 3);
         exitcode = h_stdout_stderr(argv[2]);
+    } else if (strcmp(argv[1], "stdout-stderr-large") == 0) {
+        check_args(argc, argv, 3);
+        exitcode = h_stdout_stderr_large(argv[2]);
+    } else if (strcmp(argv[1], "stdout-forever") == 0) {
+        exitcode = h_stdout_forever();
     } else {
         fprintf(stderr, "%s: Unknown helper %s\n", argv[0], argv[1]);
         exitcode = EXIT_FAILURE;
@@ -36,6 +36,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 #include <atf-c.h>
@@ -432,6 +433,42 @@ do_fork(const struct base_stream *outfs, void *out,
     atf_process_status_fini(&status);
 }
 
+static
+void
+do_spawn(const atf_tc_t *tc, const struct base_stream *outfs, void *out,
+         const struct base_stream *errfs, void *err)
+{
+    atf_fs_path_t process_helpers;
+    atf_process_child_t child;
+    atf_process_status_t status;
+    const char *argv[4];
+
+    get_process_helpers_path(tc, true, &process_helpers);
+    argv[0] = atf_fs_path_cstring(&process_helpers);
+    argv[1] = "print";
+    argv[2] = "msg";
+    argv[3] = NULL;
+
+    outfs->init(out);
+    errfs->init(err);
+
+    RE(atf_process_spawn(&child, argv[0], argv, outfs->m_sb_ptr,
+                         errfs->m_sb_ptr));
+    if (outfs->process != NULL)
+        outfs->process(out, &child);
+    if (errfs->process != NULL)
+        errfs->process(err, &child);
+    RE(atf_process_child_wait(&child, &status));
+    ATF_CHECK(atf_process_status_exited(&status));
+    ATF_CHECK_EQ(atf_process_status_exitstatus(&status), EXIT_SUCCESS);
+
+    outfs->fini(out);
+    errfs->fini(err);
+
+    atf_process_status_fini(&status);
+    atf_fs_path_fini(&process_helpers);
+}
+
 /* ---------------------------------------------------------------------
  * Test cases for the "stream" type.
  * --------------------------------------------------------------------- */
@@ -677,6 +714,61 @@ ATF_TC_BODY(status_coredump, tc)
     atf_process_status_fini(&s);
 }
 
+static void child_use_resources(void *) ATF_DEFS_ATTRIBUTE_NORETURN;
+
+static
+void
+child_use_resources(void *v ATF_DEFS_ATTRIBUTE_UNUSED)
+{
+    const size_t size = 32 * 1024 * 1024;
+    volatile char *buf;
+    size_t i;
+
+    buf = malloc(size);
+    if (buf == NULL)
+        abort();
+    for (i = 0; i < size; i += 512)
+        buf[i] = (char)i;
+    usleep(100000);
+    exit(EXIT_SUCCESS);
+}
+
+ATF_TC(status_usage);
+ATF_TC_HEAD(status_usage, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that the status of a waited "
+                      "process holds the resources that it consumed");
+}
+ATF_TC_BODY(status_usage, tc)
+{
+    atf_process_child_t child;
+    atf_process_status_t status;
+
+    RE(atf_process_fork(&child, child_use_resources, NULL, NULL, NULL));
+    RE(atf_process_child_wait(&child, &status));
+    ATF_CHECK(atf_process_status_exited(&status));
+
+    printf("wall %lld us, user %lld us, system %lld us, maxrss %ld KB, "
+           "minflt %ld, majflt %ld, nvcsw %ld, nivcsw %ld\n",
+           (long long)atf_process_status_wall_usec(&status),
+           (long long)atf_process_status_user_usec(&status),
+           (long long)atf_process_status_system_usec(&status),
+           atf_process_status_maxrss_kb(&status),
+           atf_process_status_minflt(&status),
+           atf_process_status_majflt(&status),
+           atf_process_status_nvcsw(&status),
+           atf_process_status_nivcsw(&status));
+    ATF_CHECK(atf_process_status_wall_usec(&status) >= 100000);
+    ATF_CHECK(atf_process_status_user_usec(&status) +
+              atf_process_status_system_usec(&status) > 0);
+    ATF_CHECK(atf_process_status_maxrss_kb(&status) >= 32 * 1024);
+    ATF_CHECK(atf_process_status_minflt(&status) >= 32 * 1024 * 1024 /
+              sysconf(_SC_PAGESIZE));
+    ATF_CHECK(atf_process_status_nvcsw(&status) > 0);
+
+    atf_process_status_fini(&status);
+}
+
 /* ---------------------------------------------------------------------
  * Test cases for the "child" type.
  * --------------------------------------------------------------------- */
@@ -850,6 +942,529 @@ ATF_TC_BODY(child_wait_eintr, tc)
     atf_process_status_fini(&status);
 }
 
+/* ---------------------------------------------------------------------
+ * Test cases for the "capture" type.
+ * --------------------------------------------------------------------- */
+
+static
+void
+spawn_helper(const atf_tc_t *tc, atf_process_child_t *child,
+             const char *helper_name, const char *arg,
+             const atf_process_stream_t *outsb,
+             const atf_process_stream_t *errsb)
+{
+    atf_fs_path_t process_helpers;
+    const char *argv[4];
+
+    get_process_helpers_path(tc, true, &process_helpers);
+    argv[0] = atf_fs_path_cstring(&process_helpers);
+    argv[1] = helper_name;
+    argv[2] = arg;
+    argv[3] = NULL;
+
+    RE(atf_process_spawn(child, argv[0], argv, outsb, errsb));
+    atf_fs_path_fini(&process_helpers);
+}
+
+ATF_TC(child_capture);
+ATF_TC_HEAD(child_capture, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that atf_process_child_capture "
+                      "collects large outputs on both streams at once");
+}
+ATF_TC_BODY(child_capture, tc)
+{
+    atf_process_stream_t capturesb;
+    atf_process_child_t child;
+    atf_process_status_t status;
+    atf_process_capture_t cap;
+    const size_t lines = 200000;
+
+    RE(atf_process_stream_init_capture(&capturesb));
+    spawn_helper(tc, &child, "stdout-stderr-large", "200000", &capturesb,
+                 &capturesb);
+    RE(atf_process_child_capture(&child, &status, &cap));
+
+    ATF_CHECK(atf_process_status_exited(&status));
+    ATF_CHECK_EQ(EXIT_SUCCESS, atf_process_status_exitstatus(&status));
+    ATF_REQUIRE_EQ(lines * 16, cap.m_stdout_size);
+    ATF_REQUIRE_EQ(lines * 16, cap.m_stderr_size);
+    ATF_CHECK(strncmp(cap.m_stdout, "00000000 stdout\n", 16) == 0);
+    ATF_CHECK(strncmp(cap.m_stdout + cap.m_stdout_size - 16,
+                      "00199999 stdout\n", 16) == 0);
+    ATF_CHECK(strncmp(cap.m_stderr + cap.m_stderr_size - 16,
+                      "00199999 stderr\n", 16) == 0);
+
+    atf_process_capture_fini(&cap);
+    atf_process_status_fini(&status);
+    atf_process_stream_fini(&capturesb);
+}
+
+ATF_TC(child_capture_inherit);
+ATF_TC_HEAD(child_capture_inherit, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that atf_process_child_capture "
+                      "ignores the streams that are not captured");
+}
+ATF_TC_BODY(child_capture_inherit, tc)
+{
+    atf_process_stream_t capturesb, pathsb;
+    atf_process_child_t child;
+    atf_process_status_t status;
+    atf_process_capture_t cap;
+    atf_fs_path_t path;
+
+    RE(atf_fs_path_init_fmt(&path, "stderr"));
+    RE(atf_process_stream_init_capture(&capturesb));
+    RE(atf_process_stream_init_redirect_path(&pathsb, &path));
+    spawn_helper(tc, &child, "stdout-stderr", "msg", &capturesb, &pathsb);
+    RE(atf_process_child_capture(&child, &status, &cap));
+
+    ATF_CHECK(atf_process_status_exited(&status));
+    ATF_CHECK_EQ(50, cap.m_stdout_size);
+    ATF_CHECK(cap.m_stderr == NULL);
+    ATF_CHECK_EQ(0, cap.m_stderr_size);
+    ATF_CHECK(atf_utils_grep_file("Line 2 to stderr for msg", "stderr"));
+
+    atf_process_capture_fini(&cap);
+    atf_process_status_fini(&status);
+    atf_process_stream_fini(&pathsb);
+    atf_process_stream_fini(&capturesb);
+    atf_fs_path_fini(&path);
+}
+
+struct stop_sink_data {
+    pid_t m_pid;
+    size_t m_read;
+};
+
+static
+atf_error_t
+stop_sink(void *v, const int fd, const char *buf ATF_DEFS_ATTRIBUTE_UNUSED,
+          const size_t len, bool *stop)
+{
+    struct stop_sink_data *data = v;
+
+    ATF_CHECK_EQ(STDOUT_FILENO, fd);
+    data->m_read += len;
+    if (data->m_read >= 100000) {
+        kill(data->m_pid, SIGKILL);
+        *stop = true;
+    }
+
+    return atf_no_error();
+}
+
+ATF_TC(child_drain_stop);
+ATF_TC_HEAD(child_drain_stop, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that atf_process_child_drain "
+                      "stops reading a stream when the sink asks to");
+    atf_tc_set_md_var(tc, "timeout", "30");
+}
+ATF_TC_BODY(child_drain_stop, tc)
+{
+    atf_process_stream_t capturesb;
+    atf_process_child_t child;
+    atf_process_status_t status;
+    struct stop_sink_data data;
+
+    RE(atf_process_stream_init_capture(&capturesb));
+    spawn_helper(tc, &child, "stdout-forever", NULL, &capturesb, NULL);
+
+    data.m_pid = atf_process_child_pid(&child);
+    data.m_read = 0;
+    RE(atf_process_child_drain(&child, stop_sink, &data));
+    ATF_CHECK(data.m_read >= 100000);
+
+    RE(atf_process_child_wait(&child, &status));
+    ATF_CHECK(atf_process_status_signaled(&status));
+    ATF_CHECK_EQ(SIGKILL, atf_process_status_termsig(&status));
+
+    atf_process_status_fini(&status);
+    atf_process_stream_fini(&capturesb);
+}
+
+struct partial_sink_data {
+    char m_buf[64];
+    size_t m_size;
+};
+
+static
+atf_error_t
+partial_sink(void *v, const int fd, const char *buf, const size_t len,
+             bool *stop ATF_DEFS_ATTRIBUTE_UNUSED)
+{
+    struct partial_sink_data *data = v;
+
+    ATF_CHECK_EQ(STDOUT_FILENO, fd);
+    ATF_REQUIRE(data->m_size + len < sizeof(data->m_buf));
+    memcpy(data->m_buf + data->m_size, buf, len);
+    data->m_size += len;
+    data->m_buf[data->m_size] = '\0';
+
+    return atf_no_error();
+}
+
+static
+void
+do_drain_timeout(const char *script, const int signo)
+{
+    atf_process_stream_t capturesb;
+    atf_process_child_t child;
+    atf_process_status_t status;
+    struct partial_sink_data data;
+    const char *argv[4];
+    bool timed_out;
+
+    argv[0] = "/bin/sh";
+    argv[1] = "-c";
+    argv[2] = script;
+    argv[3] = NULL;
+
+    RE(atf_process_stream_init_capture(&capturesb));
+    RE(atf_process_spawn_pgrp(&child, argv[0], argv, &capturesb, NULL));
+    data.m_size = 0;
+    RE(atf_process_child_drain_timeout(&child, partial_sink, &data, 200,
+                                       &timed_out));
+    ATF_CHECK(timed_out);
+    ATF_CHECK_STREQ("partial\n", data.m_buf);
+
+    RE(atf_process_child_wait(&child, &status));
+    ATF_CHECK(atf_process_status_signaled(&status));
+    ATF_CHECK_EQ(signo, atf_process_status_termsig(&status));
+    ATF_CHECK(atf_process_status_wall_usec(&status) < 10000000);
+
+    atf_process_status_fini(&status);
+    atf_process_stream_fini(&capturesb);
+}
+
+ATF_TC(child_drain_timeout);
+ATF_TC_HEAD(child_drain_timeout, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that atf_process_child_drain_timeout "
+                      "terminates a child that runs for too long and keeps "
+                      "its partial output");
+    atf_tc_set_md_var(tc, "timeout", "30");
+}
+ATF_TC_BODY(child_drain_timeout, tc)
+{
+    do_drain_timeout("echo partial; sleep 60", SIGTERM);
+}
+
+ATF_TC(child_drain_timeout_kill);
+ATF_TC_HEAD(child_drain_timeout_kill, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that atf_process_child_drain_timeout "
+                      "kills a child that ignores SIGTERM, along with the "
+                      "processes that it started");
+    atf_tc_set_md_var(tc, "timeout", "30");
+}
+ATF_TC_BODY(child_drain_timeout_kill, tc)
+{
+    do_drain_timeout("trap '' TERM; echo partial; sleep 60 & wait",
+                     SIGKILL);
+}
+
+ATF_TC(child_drain_timeout_success);
+ATF_TC_HEAD(child_drain_timeout_success, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that atf_process_child_drain_timeout "
+                      "does not affect a child that finishes in time");
+}
+ATF_TC_BODY(child_drain_timeout_success, tc)
+{
+    atf_process_stream_t capturesb;
+    atf_process_child_t child;
+    atf_process_status_t status;
+    struct partial_sink_data data;
+    const char *argv[4];
+    bool timed_out;
+
+    argv[0] = "/bin/sh";
+    argv[1] = "-c";
+    argv[2] = "echo partial";
+    argv[3] = NULL;
+
+    RE(atf_process_stream_init_capture(&capturesb));
+    RE(atf_process_spawn_pgrp(&child, argv[0], argv, &capturesb, NULL));
+    data.m_size = 0;
+    RE(atf_process_child_drain_timeout(&child, partial_sink, &data, 10000,
+                                       &timed_out));
+    ATF_CHECK(!timed_out);
+    ATF_CHECK_STREQ("partial\n", data.m_buf);
+
+    RE(atf_process_child_wait(&child, &status));
+    ATF_CHECK(atf_process_status_exited(&status));
+    ATF_CHECK_EQ(EXIT_SUCCESS, atf_process_status_exitstatus(&status));
+
+    atf_process_status_fini(&status);
+    atf_process_stream_fini(&capturesb);
+}
+
+/* ---------------------------------------------------------------------
+ * Test cases for the "group" type.
+ * --------------------------------------------------------------------- */
+
+void atf_process_set_pidfd(const bool);
+
+struct child_sleep_data {
+    int m_ms;
+    int m_exitcode;
+};
+
+static void child_sleep(void *) ATF_DEFS_ATTRIBUTE_NORETURN;
+
+static
+void
+child_sleep(void *v)
+{
+    const struct child_sleep_data *csd = v;
+    struct timespec ts;
+
+    ts.tv_sec = csd->m_ms / 1000;
+    ts.tv_nsec = (csd->m_ms % 1000) * 1000000L;
+    while (nanosleep(&ts, &ts) == -1 && errno == EINTR)
+        continue;
+
+    exit(csd->m_exitcode);
+}
+
+static
+void
+do_group_wait_any(void)
+{
+    static struct child_sleep_data csd[3] = {
+        { 800, 3 }, { 0, 1 }, { 400, 2 } };
+    atf_process_group_t group;
+    size_t i, index;
+    bool found;
+
+    RE(atf_process_group_init(&group));
+    for (i = 0; i < 3; i++) {
+        RE(atf_process_group_fork(&group, child_sleep, NULL, NULL, &csd[i],
+                                  &index));
+        ATF_REQUIRE_EQ(i, index);
+        ATF_REQUIRE(atf_process_group_status(&group, i) == NULL);
+    }
+    ATF_REQUIRE_EQ(3, atf_process_group_size(&group));
+
+    for (i = 0; i < 3; i++) {
+        const atf_process_status_t *status;
+
+        RE(atf_process_group_wait_any(&group, -1, &index, &found));
+        ATF_REQUIRE(found);
+        status = atf_process_group_status(&group, index);
+        ATF_REQUIRE(status != NULL);
+        ATF_REQUIRE(atf_process_status_exited(status));
+        ATF_CHECK_EQ(i + 1, (size_t)atf_process_status_exitstatus(status));
+    }
+
+    RE(atf_process_group_wait_any(&group, -1, &index, &found));
+    ATF_CHECK(!found);
+
+    atf_process_group_fini(&group);
+}
+
+static
+void
+do_group_capture(const atf_tc_t *tc)
+{
+    atf_fs_path_t process_helpers;
+    atf_process_stream_t capturesb;
+    atf_process_group_t group;
+    const char *argv[4];
+    size_t i, index;
+    bool finished;
+
+    get_process_helpers_path(tc, true, &process_helpers);
+    argv[0] = atf_fs_path_cstring(&process_helpers);
+    argv[1] = "stdout-stderr-large";
+    argv[2] = "10000";
+    argv[3] = NULL;
+
+    RE(atf_process_stream_init_capture(&capturesb));
+    RE(atf_process_group_init(&group));
+    for (i = 0; i < 8; i++)
+        RE(atf_process_group_spawn(&group, argv[0], argv, &capturesb,
+                                   &capturesb, &index));
+
+    /* Each child writes more than fits in its pipes, so they only finish
+     * if their outputs are read while waiting. */
+    RE(atf_process_group_wait_all(&group, -1, &finished));
+    ATF_REQUIRE(finished);
+
+    for (i = 0; i < 8; i++) {
+        const atf_process_status_t *status;
+        const char *data;
+        size_t size;
+
+        status = atf_process_group_status(&group, i);
+        ATF_REQUIRE(status != NULL);
+        ATF_CHECK(atf_process_status_exited(status));
+        ATF_CHECK_EQ(EXIT_SUCCESS, atf_process_status_exitstatus(status));
+        ATF_CHECK(atf_process_status_wall_usec(status) > 0);
+        ATF_CHECK(atf_process_status_maxrss_kb(status) > 0);
+
+        data = atf_process_group_stdout(&group, i, &size);
+        ATF_CHECK_EQ(10000 * 16, size);
+        ATF_CHECK(data != NULL && strncmp(data, "00000000 stdout\n", 16) == 0);
+        data = atf_process_group_stderr(&group, i, &size);
+        ATF_CHECK_EQ(10000 * 16, size);
+        ATF_CHECK(data != NULL &&
+                  strncmp(data + size - 16, "00009999 stderr\n", 16) == 0);
+    }
+
+    atf_process_group_fini(&group);
+    atf_process_stream_fini(&capturesb);
+    atf_fs_path_fini(&process_helpers);
+}
+
+ATF_TC(group_wait_any);
+ATF_TC_HEAD(group_wait_any, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that atf_process_group_wait_any "
+                      "returns children in the order they terminate");
+}
+ATF_TC_BODY(group_wait_any, tc)
+{
+    do_group_wait_any();
+}
+
+ATF_TC(group_wait_any_sigchld);
+ATF_TC_HEAD(group_wait_any_sigchld, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that atf_process_group_wait_any "
+                      "returns children in the order they terminate when "
+                      "notified through SIGCHLD");
+}
+ATF_TC_BODY(group_wait_any_sigchld, tc)
+{
+    atf_process_set_pidfd(false);
+    do_group_wait_any();
+}
+
+ATF_TC(group_capture);
+ATF_TC_HEAD(group_capture, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that a group captures the "
+                      "outputs of all its children at once");
+}
+ATF_TC_BODY(group_capture, tc)
+{
+    do_group_capture(tc);
+}
+
+ATF_TC(group_capture_sigchld);
+ATF_TC_HEAD(group_capture_sigchld, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that a group captures the "
+                      "outputs of all its children at once when notified "
+                      "through SIGCHLD");
+}
+ATF_TC_BODY(group_capture_sigchld, tc)
+{
+    atf_process_set_pidfd(false);
+    do_group_capture(tc);
+}
+
+ATF_TC(group_wait_all_timeout);
+ATF_TC_HEAD(group_wait_all_timeout, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that atf_process_group_wait_all "
+                      "and atf_process_group_wait_any give up after their "
+                      "timeout");
+}
+ATF_TC_BODY(group_wait_all_timeout, tc)
+{
+    struct child_sleep_data csd = { 60000, EXIT_SUCCESS };
+    const atf_process_status_t *status;
+    atf_process_group_t group;
+    size_t index;
+    bool finished, found;
+
+    RE(atf_process_group_init(&group));
+    RE(atf_process_group_fork(&group, child_sleep, NULL, NULL, &csd,
+                              &index));
+
+    RE(atf_process_group_wait_all(&group, 100, &finished));
+    ATF_CHECK(!finished);
+    RE(atf_process_group_wait_any(&group, 0, &index, &found));
+    ATF_CHECK(!found);
+    ATF_CHECK(atf_process_group_status(&group, 0) == NULL);
+
+    atf_process_group_kill(&group, SIGTERM);
+    RE(atf_process_group_wait_all(&group, -1, &finished));
+    ATF_REQUIRE(finished);
+    status = atf_process_group_status(&group, 0);
+    ATF_REQUIRE(status != NULL);
+    ATF_REQUIRE(atf_process_status_signaled(status));
+    ATF_CHECK_EQ(SIGTERM, atf_process_status_termsig(status));
+
+    atf_process_group_fini(&group);
+}
+
+ATF_TC(group_deadline);
+ATF_TC_HEAD(group_deadline, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that the children of a group are "
+                      "killed once its deadline passes");
+    atf_tc_set_md_var(tc, "timeout", "30");
+}
+ATF_TC_BODY(group_deadline, tc)
+{
+    struct child_sleep_data fast = { 0, EXIT_SUCCESS };
+    struct child_sleep_data slow = { 60000, EXIT_SUCCESS };
+    atf_process_group_t group;
+    size_t i, index;
+    bool finished;
+
+    RE(atf_process_group_init(&group));
+    RE(atf_process_group_fork(&group, child_sleep, NULL, NULL, &fast,
+                              &index));
+    for (i = 0; i < 4; i++)
+        RE(atf_process_group_fork(&group, child_sleep, NULL, NULL, &slow,
+                                  &index));
+
+    atf_process_group_set_deadline(&group, 200, SIGKILL);
+    RE(atf_process_group_wait_all(&group, -1, &finished));
+    ATF_REQUIRE(finished);
+
+    ATF_CHECK(atf_process_status_exited(atf_process_group_status(&group, 0)));
+    for (i = 1; i < 5; i++) {
+        const atf_process_status_t *status =
+            atf_process_group_status(&group, i);
+
+        ATF_REQUIRE(atf_process_status_signaled(status));
+        ATF_CHECK_EQ(SIGKILL, atf_process_status_termsig(status));
+    }
+
+    atf_process_group_fini(&group);
+}
+
+ATF_TC(group_fini_running);
+ATF_TC_HEAD(group_fini_running, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that atf_process_group_fini "
+                      "kills and collects the children that are still "
+                      "running");
+}
+ATF_TC_BODY(group_fini_running, tc)
+{
+    struct child_sleep_data csd = { 60000, EXIT_SUCCESS };
+    atf_process_group_t group;
+    size_t index;
+    pid_t pid;
+
+    RE(atf_process_group_init(&group));
+    RE(atf_process_group_fork(&group, child_sleep, NULL, NULL, &csd,
+                              &index));
+    pid = atf_process_group_pid(&group, index);
+    atf_process_group_fini(&group);
+
+    ATF_CHECK(waitpid(pid, NULL, WNOHANG) == -1 && errno == ECHILD);
+}
+
 /* ---------------------------------------------------------------------
  * Tests cases for the free functions.
  * --------------------------------------------------------------------- */
@@ -963,6 +1578,30 @@ ATF_TC_BODY(exec_prehook, tc)
     atf_process_status_fini(&status);
 }
 
+ATF_TC(exec_unknown);
+ATF_TC_HEAD(exec_unknown, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests execing a command that does not "
+                      "exist");
+}
+ATF_TC_BODY(exec_unknown, tc)
+{
+    atf_fs_path_t prog;
+    atf_process_status_t status;
+    const char *argv[2];
+
+    RE(atf_fs_path_init_fmt(&prog, "/foo/bar/non-existent"));
+    argv[0] = atf_fs_path_cstring(&prog);
+    argv[1] = NULL;
+
+    RE(atf_process_exec_array(&status, &prog, argv, NULL, NULL, NULL));
+    ATF_CHECK(atf_process_status_exited(&status));
+    ATF_CHECK_EQ(atf_process_status_exitstatus(&status), EXIT_FAILURE);
+    atf_process_status_fini(&status);
+
+    atf_fs_path_fini(&prog);
+}
+
 ATF_TC(exec_success);
 ATF_TC_HEAD(exec_success, tc)
 {
@@ -1090,6 +1729,199 @@ TC_FORK_STREAMS(redirect_path, REDIRECT_PATH, redirect_path, REDIRECT_PATH);
 
 #undef TC_FORK_STREAMS
 
+ATF_TC(spawn_unknown);
+ATF_TC_HEAD(spawn_unknown, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests spawning a command that does not "
+                      "exist");
+}
+ATF_TC_BODY(spawn_unknown, tc)
+{
+    atf_process_child_t child;
+    atf_process_status_t status;
+    const char *argv[2];
+    atf_error_t err;
+
+    argv[0] = "/foo/bar/non-existent";
+    argv[1] = NULL;
+
+    err = atf_process_spawn(&child, argv[0], argv, NULL, NULL);
+    if (atf_is_error(err)) {
+        ATF_CHECK(atf_error_is(err, "libc"));
+        ATF_CHECK_EQ(atf_libc_error_code(err), ENOENT);
+        atf_error_free(err);
+    } else {
+        /* Without posix_spawn, the child reports the failure itself. */
+        RE(atf_process_child_wait(&child, &status));
+        ATF_CHECK(atf_process_status_exited(&status));
+        ATF_CHECK_EQ(atf_process_status_exitstatus(&status), EXIT_FAILURE);
+        atf_process_status_fini(&status);
+    }
+}
+
+#define TC_SPAWN_STREAMS(outlc, outuc, errlc, erruc) \
+    ATF_TC(spawn_out_ ## outlc ## _err_ ## errlc); \
+    ATF_TC_HEAD(spawn_out_ ## outlc ## _err_ ## errlc, tc) \
+    { \
+        atf_tc_set_md_var(tc, "descr", "Tests spawning a command, with " \
+                          "stdout " #outlc " and stderr " #errlc); \
+    } \
+    ATF_TC_BODY(spawn_out_ ## outlc ## _err_ ## errlc, tc) \
+    { \
+        struct outlc ## _stream out = outuc ## _STREAM(stdout_type); \
+        struct errlc ## _stream err = erruc ## _STREAM(stderr_type); \
+        do_spawn(tc, &out.m_base, &out, &err.m_base, &err); \
+    }
+
+TC_SPAWN_STREAMS(capture, CAPTURE, capture, CAPTURE);
+TC_SPAWN_STREAMS(capture, CAPTURE, connect, CONNECT);
+TC_SPAWN_STREAMS(capture, CAPTURE, default, DEFAULT);
+TC_SPAWN_STREAMS(capture, CAPTURE, inherit, INHERIT);
+TC_SPAWN_STREAMS(capture, CAPTURE, redirect_fd, REDIRECT_FD);
+TC_SPAWN_STREAMS(capture, CAPTURE, redirect_path, REDIRECT_PATH);
+TC_SPAWN_STREAMS(connect, CONNECT, capture, CAPTURE);
+TC_SPAWN_STREAMS(connect, CONNECT, connect, CONNECT);
+TC_SPAWN_STREAMS(connect, CONNECT, default, DEFAULT);
+TC_SPAWN_STREAMS(connect, CONNECT, inherit, INHERIT);
+TC_SPAWN_STREAMS(connect, CONNECT, redirect_fd, REDIRECT_FD);
+TC_SPAWN_STREAMS(connect, CONNECT, redirect_path, REDIRECT_PATH);
+TC_SPAWN_STREAMS(default, DEFAULT, capture, CAPTURE);
+TC_SPAWN_STREAMS(default, DEFAULT, connect, CONNECT);
+TC_SPAWN_STREAMS(default, DEFAULT, default, DEFAULT);
+TC_SPAWN_STREAMS(default, DEFAULT, inherit, INHERIT);
+TC_SPAWN_STREAMS(default, DEFAULT, redirect_fd, REDIRECT_FD);
+TC_SPAWN_STREAMS(default, DEFAULT, redirect_path, REDIRECT_PATH);
+TC_SPAWN_STREAMS(inherit, INHERIT, capture, CAPTURE);
+TC_SPAWN_STREAMS(inherit, INHERIT, connect, CONNECT);
+TC_SPAWN_STREAMS(inherit, INHERIT, default, DEFAULT);
+TC_SPAWN_STREAMS(inherit, INHERIT, inherit, INHERIT);
+TC_SPAWN_STREAMS(inherit, INHERIT, redirect_fd, REDIRECT_FD);
+TC_SPAWN_STREAMS(inherit, INHERIT, redirect_path, REDIRECT_PATH);
+TC_SPAWN_STREAMS(redirect_fd, REDIRECT_FD, capture, CAPTURE);
+TC_SPAWN_STREAMS(redirect_fd, REDIRECT_FD, connect, CONNECT);
+TC_SPAWN_STREAMS(redirect_fd, REDIRECT_FD, default, DEFAULT);
+TC_SPAWN_STREAMS(redirect_fd, REDIRECT_FD, inherit, INHERIT);
+TC_SPAWN_STREAMS(redirect_fd, REDIRECT_FD, redirect_fd, REDIRECT_FD);
+TC_SPAWN_STREAMS(redirect_fd, REDIRECT_FD, redirect_path, REDIRECT_PATH);
+TC_SPAWN_STREAMS(redirect_path, REDIRECT_PATH, capture, CAPTURE);
+TC_SPAWN_STREAMS(redirect_path, REDIRECT_PATH, connect, CONNECT);
+TC_SPAWN_STREAMS(redirect_path, REDIRECT_PATH, default, DEFAULT);
+TC_SPAWN_STREAMS(redirect_path, REDIRECT_PATH, inherit, INHERIT);
+TC_SPAWN_STREAMS(redirect_path, REDIRECT_PATH, redirect_fd, REDIRECT_FD);
+TC_SPAWN_STREAMS(redirect_path, REDIRECT_PATH, redirect_path, REDIRECT_PATH);
+
+#undef TC_SPAWN_STREAMS
+
+/* ---------------------------------------------------------------------
+ * Benchmarks.
+ * --------------------------------------------------------------------- */
+
+/* Grows the resident set of the benchmark to the size in megabytes given
+ * by the rss_mb configuration variable, which defaults to 256, so that
+ * the cost of duplicating the address space of the parent shows. */
+static
+void
+init_bench_rss(const atf_tc_t *tc)
+{
+    static char *ballast = NULL;
+
+    if (ballast == NULL) {
+        const size_t size = (size_t)atf_tc_get_config_var_as_long_wd(
+            tc, "rss_mb", 256) * 1024 * 1024;
+
+        ballast = malloc(size);
+        ATF_REQUIRE(ballast != NULL);
+        memset(ballast, 1, size);
+    }
+}
+
+static
+void
+noop_prehook(void)
+{
+}
+
+static
+void
+do_bench_exec(const atf_tc_t *tc, const size_t iterations,
+              void (*prehook)(void))
+{
+    atf_fs_path_t process_helpers;
+    const char *argv[3];
+    size_t i;
+
+    init_bench_rss(tc);
+
+    get_process_helpers_path(tc, true, &process_helpers);
+    argv[0] = atf_fs_path_cstring(&process_helpers);
+    argv[1] = "exit-success";
+    argv[2] = NULL;
+
+    for (i = 0; i < iterations; i++) {
+        atf_process_status_t status;
+
+        RE(atf_process_exec_array(&status, &process_helpers, argv, NULL,
+                                  NULL, prehook));
+        ATF_REQUIRE(atf_process_status_exited(&status));
+        atf_process_status_fini(&status);
+    }
+
+    atf_fs_path_fini(&process_helpers);
+}
+
+ATF_BENCH(bench_child_capture);
+ATF_BENCH_HEAD(bench_child_capture, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Captures 4 MB written by a command to "
+                      "each of its stdout and stderr with "
+                      "atf_process_child_capture");
+}
+ATF_BENCH_BODY(bench_child_capture, tc, iterations)
+{
+    atf_process_stream_t capturesb;
+    size_t i;
+
+    RE(atf_process_stream_init_capture(&capturesb));
+    for (i = 0; i < iterations; i++) {
+        atf_process_child_t child;
+        atf_process_status_t status;
+        atf_process_capture_t cap;
+
+        spawn_helper(tc, &child, "stdout-stderr-large", "262144", &capturesb,
+                     &capturesb);
+        RE(atf_process_child_capture(&child, &status, &cap));
+        ATF_REQUIRE_EQ(4 * 1024 * 1024, cap.m_stdout_size);
+        atf_process_capture_fini(&cap);
+        atf_process_status_fini(&status);
+    }
+    atf_process_stream_fini(&capturesb);
+}
+
+ATF_BENCH(bench_exec_spawn);
+ATF_BENCH_HEAD(bench_exec_spawn, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Runs a command with "
+                      "atf_process_exec_array from a parent with a large "
+                      "resident set, which spawns the command");
+}
+ATF_BENCH_BODY(bench_exec_spawn, tc, iterations)
+{
+    do_bench_exec(tc, iterations, NULL);
+}
+
+ATF_BENCH(bench_exec_fork);
+ATF_BENCH_HEAD(bench_exec_fork, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Runs a command with "
+                      "atf_process_exec_array from a parent with a large "
+                      "resident set, using a prehook to force a fork, for "
+                      "comparison with bench_exec_spawn");
+}
+ATF_BENCH_BODY(bench_exec_fork, tc, iterations)
+{
+    do_bench_exec(tc, iterations, noop_prehook);
+}
+
 /* ---------------------------------------------------------------------
  * Main.
  * --------------------------------------------------------------------- */
@@ -1107,16 +1939,35 @@ ATF_TP_ADD_TCS(tp)
     ATF_TP_ADD_TC(tp, status_exited);
     ATF_TP_ADD_TC(tp, status_signaled);
     ATF_TP_ADD_TC(tp, status_coredump);
+    ATF_TP_ADD_TC(tp, status_usage);
 
     /* Add the tests for the "child" type. */
     ATF_TP_ADD_TC(tp, child_pid);
     ATF_TP_ADD_TC(tp, child_wait_eintr);
 
+    /* Add the tests for the "capture" type. */
+    ATF_TP_ADD_TC(tp, child_capture);
+    ATF_TP_ADD_TC(tp, child_capture_inherit);
+    ATF_TP_ADD_TC(tp, child_drain_stop);
+    ATF_TP_ADD_TC(tp, child_drain_timeout);
+    ATF_TP_ADD_TC(tp, child_drain_timeout_kill);
+    ATF_TP_ADD_TC(tp, child_drain_timeout_success);
+
+    /* Add the tests for the "group" type. */
+    ATF_TP_ADD_TC(tp, group_wait_any);
+    ATF_TP_ADD_TC(tp, group_wait_any_sigchld);
+    ATF_TP_ADD_TC(tp, group_capture);
+    ATF_TP_ADD_TC(tp, group_capture_sigchld);
+    ATF_TP_ADD_TC(tp, group_wait_all_timeout);
+    ATF_TP_ADD_TC(tp, group_deadline);
+    ATF_TP_ADD_TC(tp, group_fini_running);
+
     /* Add the tests for the free functions. */
     ATF_TP_ADD_TC(tp, exec_failure);
     ATF_TP_ADD_TC(tp, exec_list);
     ATF_TP_ADD_TC(tp, exec_prehook);
     ATF_TP_ADD_TC(tp, exec_success);
+    ATF_TP_ADD_TC(tp, exec_unknown);
     ATF_TP_ADD_TC(tp, fork_cookie);
     ATF_TP_ADD_TC(tp, fork_out_capture_err_capture);
     ATF_TP_ADD_TC(tp, fork_out_capture_err_connect);
@@ -1154,6 +2005,48 @@ ATF_TP_ADD_TCS(tp)
     ATF_TP_ADD_TC(tp, fork_out_redirect_path_err_inherit);
     ATF_TP_ADD_TC(tp, fork_out_redirect_path_err_redirect_fd);
     ATF_TP_ADD_TC(tp, fork_out_redirect_path_err_redirect_path);
+    ATF_TP_ADD_TC(tp, spawn_unknown);
+    ATF_TP_ADD_TC(tp, spawn_out_capture_err_capture);
+    ATF_TP_ADD_TC(tp, spawn_out_capture_err_connect);
+    ATF_TP_ADD_TC(tp, spawn_out_capture_err_default);
+    ATF_TP_ADD_TC(tp, spawn_out_capture_err_inherit);
+    ATF_TP_ADD_TC(tp, spawn_out_capture_err_redirect_fd);
+    ATF_TP_ADD_TC(tp, spawn_out_capture_err_redirect_path);
+    ATF_TP_ADD_TC(tp, spawn_out_connect_err_capture);
+    ATF_TP_ADD_TC(tp, spawn_out_connect_err_connect);
+    ATF_TP_ADD_TC(tp, spawn_out_connect_err_default);
+    ATF_TP_ADD_TC(tp, spawn_out_connect_err_inherit);
+    ATF_TP_ADD_TC(tp, spawn_out_connect_err_redirect_fd);
+    ATF_TP_ADD_TC(tp, spawn_out_connect_err_redirect_path);
+    ATF_TP_ADD_TC(tp, spawn_out_default_err_capture);
+    ATF_TP_ADD_TC(tp, spawn_out_default_err_connect);
+    ATF_TP_ADD_TC(tp, spawn_out_default_err_default);
+    ATF_TP_ADD_TC(tp, spawn_out_default_err_inherit);
+    ATF_TP_ADD_TC(tp, spawn_out_default_err_redirect_fd);
+    ATF_TP_ADD_TC(tp, spawn_out_default_err_redirect_path);
+    ATF_TP_ADD_TC(tp, spawn_out_inherit_err_capture);
+    ATF_TP_ADD_TC(tp, spawn_out_inherit_err_connect);
+    ATF_TP_ADD_TC(tp, spawn_out_inherit_err_default);
+    ATF_TP_ADD_TC(tp, spawn_out_inherit_err_inherit);
+    ATF_TP_ADD_TC(tp, spawn_out_inherit_err_redirect_fd);
+    ATF_TP_ADD_TC(tp, spawn_out_inherit_err_redirect_path);
+    ATF_TP_ADD_TC(tp, spawn_out_redirect_fd_err_capture);
+    ATF_TP_ADD_TC(tp, spawn_out_redirect_fd_err_connect);
+    ATF_TP_ADD_TC(tp, spawn_out_redirect_fd_err_default);
+    ATF_TP_ADD_TC(tp, spawn_out_redirect_fd_err_inherit);
+    ATF_TP_ADD_TC(tp, spawn_out_redirect_fd_err_redirect_fd);
+    ATF_TP_ADD_TC(tp, spawn_out_redirect_fd_err_redirect_path);
+    ATF_TP_ADD_TC(tp, spawn_out_redirect_path_err_capture);
+    ATF_TP_ADD_TC(tp, spawn_out_redirect_path_err_connect);
+    ATF_TP_ADD_TC(tp, spawn_out_redirect_path_err_default);
+    ATF_TP_ADD_TC(tp, spawn_out_redirect_path_err_inherit);
+    ATF_TP_ADD_TC(tp, spawn_out_redirect_path_err_redirect_fd);
+    ATF_TP_ADD_TC(tp, spawn_out_redirect_path_err_redirect_path);
+
+    /* Add the benchmarks. */
+    ATF_TP_ADD_TC(tp, bench_child_capture);
+    ATF_TP_ADD_TC(tp, bench_exec_spawn);
+    ATF_TP_ADD_TC(tp, bench_exec_fork);
 
     return atf_no_error();
 }
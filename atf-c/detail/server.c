@@ -0,0 +1,486 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/server.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "atf-c/detail/fs.h"
+#include "atf-c/detail/map.h"
+#include "atf-c/detail/process.h"
+#include "atf-c/detail/sanity.h"
+#include "atf-c/detail/tc_index.h"
+#include "atf-c/error.h"
+#include "atf-c/tc.h"
+
+/* The server reads requests from its input stream and answers each of
+ * them on its output stream once the requested test case part has run in
+ * a subprocess forked from the server.  Both requests and responses are
+ * blocks of "name: value" lines terminated by an empty line, following
+ * the same conventions as the application/X-atf-tp format.
+ *
+ * A request accepts the following properties:
+ *
+ *     ident: the name of the test case to run; required.
+ *     part: either "body" (the default) or "cleanup".
+ *     resfile: the results file of the body; required for the body.
+ *     workdir: the directory in which to run the test case.
+ *     stdout: the file that receives the standard output of the test case;
+ *         defaults to /dev/null as the server's own output is the response
+ *         channel.
+ *     stderr: the file that receives the standard error of the test case;
+ *         defaults to the standard error of the server.
+ *     config: a "var=value" pair that overrides the configuration of the
+ *         test program for this request only; can be repeated.
+ *
+ * The response carries the "ident" of the test case and a "status"
+ * property, either "exited <code>" or "signaled <signo>", or a single
+ * "error" property if the request could not be honored. */
+
+enum request_part {
+    BODY,
+    CLEANUP,
+};
+
+/* ---------------------------------------------------------------------
+ * The "request" error type.
+ * --------------------------------------------------------------------- */
+
+struct request_error_data {
+    char m_what[1024];
+};
+
+static
+void
+request_format(const atf_error_t err, char *buf, size_t buflen)
+{
+    const struct request_error_data *data;
+
+    PRE(atf_error_is(err, "request"));
+
+    data = atf_error_data(err);
+    snprintf(buf, buflen, "%s", data->m_what);
+}
+
+static
+atf_error_t
+request_error(const char *fmt, ...)
+{
+    struct request_error_data data;
+    va_list ap;
+
+    va_start(ap, fmt);
+    vsnprintf(data.m_what, sizeof(data.m_what), fmt, ap);
+    va_end(ap);
+
+    return atf_error_new("request", &data, sizeof(data), request_format);
+}
+
+/* ---------------------------------------------------------------------
+ * The "request" type.
+ * --------------------------------------------------------------------- */
+
+struct request {
+    const atf_tc_t *m_tc;
+    enum request_part m_part;
+    char *m_resfile;
+    char *m_workdir;
+    char *m_stdout;
+    char *m_stderr;
+    atf_map_t m_config;
+};
+
+static
+atf_error_t
+request_init(struct request *r)
+{
+    r->m_tc = NULL;
+    r->m_part = BODY;
+    r->m_resfile = NULL;
+    r->m_workdir = NULL;
+    r->m_stdout = NULL;
+    r->m_stderr = NULL;
+    return atf_map_init(&r->m_config);
+}
+
+static
+void
+request_fini(struct request *r)
+{
+    atf_map_fini(&r->m_config);
+    free(r->m_stderr);
+    free(r->m_stdout);
+    free(r->m_workdir);
+    free(r->m_resfile);
+}
+
+static
+atf_error_t
+set_string(char **field, const char *name, const char *value)
+{
+    if (*field != NULL)
+        return request_error("Duplicate property `%s'", name);
+
+    *field = strdup(value);
+    if (*field == NULL)
+        return atf_no_memory_error();
+    return atf_no_error();
+}
+
+static
+atf_error_t
+add_config(struct request *r, const char *value)
+{
+    const char *split;
+    char *name, *copy;
+    atf_error_t err;
+
+    split = strchr(value, '=');
+    if (split == NULL || split == value)
+        return request_error("config requires a value of the form "
+                             "var=value; got `%s'", value);
+
+    name = strndup(value, split - value);
+    copy = strdup(split + 1);
+    if (name == NULL || copy == NULL) {
+        free(copy);
+        free(name);
+        return atf_no_memory_error();
+    }
+
+    err = atf_map_insert(&r->m_config, name, copy, true);
+    free(name);
+    return err;
+}
+
+static
+atf_error_t
+request_set(struct request *r, const atf_tc_index_t *tcindex,
+            const char *name, const char *value)
+{
+    atf_error_t err;
+
+    if (strcmp(name, "ident") == 0) {
+        if (r->m_tc != NULL)
+            err = request_error("Duplicate property `%s'", name);
+        else if ((r->m_tc = atf_tc_index_find(tcindex, value)) == NULL)
+            err = request_error("Unknown test case `%s'", value);
+        else
+            err = atf_no_error();
+    } else if (strcmp(name, "part") == 0) {
+        if (strcmp(value, "body") == 0) {
+            r->m_part = BODY;
+            err = atf_no_error();
+        } else if (strcmp(value, "cleanup") == 0) {
+            r->m_part = CLEANUP;
+            err = atf_no_error();
+        } else
+            err = request_error("Invalid test case part `%s'", value);
+    } else if (strcmp(name, "resfile") == 0)
+        err = set_string(&r->m_resfile, name, value);
+    else if (strcmp(name, "workdir") == 0)
+        err = set_string(&r->m_workdir, name, value);
+    else if (strcmp(name, "stdout") == 0)
+        err = set_string(&r->m_stdout, name, value);
+    else if (strcmp(name, "stderr") == 0)
+        err = set_string(&r->m_stderr, name, value);
+    else if (strcmp(name, "config") == 0)
+        err = add_config(r, value);
+    else
+        err = request_error("Unknown property `%s'", name);
+
+    return err;
+}
+
+static
+atf_error_t
+request_validate(const struct request *r)
+{
+    if (r->m_tc == NULL)
+        return request_error("Missing property `ident'");
+    if (r->m_part == BODY && r->m_resfile == NULL)
+        return request_error("Missing property `resfile'");
+    if (r->m_part == CLEANUP && r->m_resfile != NULL)
+        return request_error("Cannot provide `resfile' for the cleanup "
+                             "part");
+    return atf_no_error();
+}
+
+/* Reads the next request from the input stream.  Always consumes the whole
+ * request block, even if it is malformed, so that the server can carry on
+ * with the following one.  Sets eof to true if there are no more requests
+ * to process. */
+static
+atf_error_t
+request_read(struct request *r, const atf_tc_index_t *tcindex, FILE *in,
+             bool *eof)
+{
+    atf_error_t err;
+    char *line;
+    size_t linecap;
+    ssize_t len;
+    bool empty;
+
+    err = atf_no_error();
+    line = NULL;
+    linecap = 0;
+    empty = true;
+    while ((len = getline(&line, &linecap, in)) != -1) {
+        char *value;
+
+        if (len > 0 && line[len - 1] == '\n')
+            line[--len] = '\0';
+
+        if (len == 0) {
+            if (empty)
+                continue;
+            break;
+        }
+        empty = false;
+
+        if (atf_is_error(err))
+            continue;
+
+        value = strstr(line, ": ");
+        if (value == NULL)
+            err = request_error("Invalid request line `%s'", line);
+        else {
+            *value = '\0';
+            value += 2;
+            err = request_set(r, tcindex, line, value);
+        }
+    }
+    if (len == -1 && ferror(in)) {
+        if (atf_is_error(err))
+            atf_error_free(err);
+        err = atf_libc_error(errno, "Failed to read request");
+    }
+    free(line);
+
+    *eof = empty;
+    if (!atf_is_error(err) && !empty)
+        err = request_validate(r);
+    return err;
+}
+
+static
+void
+request_child(void *v)
+{
+#define UNCONST(a) ((void *)(uintptr_t)(const void *)(a))
+    const struct request *r = v;
+    /* The child owns a private copy of the test case, so overriding its
+     * configuration does not leak into any other request. */
+    atf_tc_t *tc = UNCONST(r->m_tc);
+#undef UNCONST
+    atf_map_citer_t iter;
+    atf_error_t err;
+    int fd;
+
+    fd = open("/dev/zero", O_RDONLY);
+    if (fd != -1 && fd != STDIN_FILENO) {
+        dup2(fd, STDIN_FILENO);
+        close(fd);
+    }
+
+    err = atf_no_error();
+    atf_map_for_each_c(iter, &r->m_config) {
+        err = atf_tc_set_config_var(tc, atf_map_citer_key(iter),
+                                    atf_map_citer_data(iter));
+        if (atf_is_error(err))
+            break;
+    }
+
+    if (!atf_is_error(err) && r->m_workdir != NULL &&
+        chdir(r->m_workdir) == -1)
+        err = atf_libc_error(errno, "Cannot enter work directory %s",
+                             r->m_workdir);
+
+    if (!atf_is_error(err)) {
+        if (r->m_part == BODY)
+            err = atf_tc_run(tc, r->m_resfile);
+        else
+            err = atf_tc_cleanup(tc);
+    }
+
+    if (atf_is_error(err)) {
+        char buf[1024];
+
+        atf_error_format(err, buf, sizeof(buf));
+        fprintf(stderr, "ERROR: %s\n", buf);
+        atf_error_free(err);
+        exit(EXIT_FAILURE);
+    }
+    exit(EXIT_SUCCESS);
+}
+
+static
+atf_error_t
+request_run(struct request *r, atf_process_status_t *status)
+{
+    atf_error_t err;
+    atf_fs_path_t outpath, errpath;
+    atf_process_stream_t outsb, errsb;
+    atf_process_child_t child;
+
+    err = atf_fs_path_init_fmt(&outpath, "%s", r->m_stdout != NULL ?
+                               r->m_stdout : "/dev/null");
+    if (atf_is_error(err))
+        goto out;
+
+    err = atf_process_stream_init_redirect_path(&outsb, &outpath);
+    if (atf_is_error(err))
+        goto out_outpath;
+
+    if (r->m_stderr != NULL) {
+        err = atf_fs_path_init_fmt(&errpath, "%s", r->m_stderr);
+        if (atf_is_error(err))
+            goto out_outsb;
+        err = atf_process_stream_init_redirect_path(&errsb, &errpath);
+    } else
+        err = atf_process_stream_init_inherit(&errsb);
+    if (atf_is_error(err))
+        goto out_errpath;
+
+    fflush(stdout);
+    fflush(stderr);
+    err = atf_process_fork(&child, request_child, &outsb, &errsb, r);
+    if (!atf_is_error(err))
+        err = atf_process_child_wait(&child, status);
+
+    atf_process_stream_fini(&errsb);
+out_errpath:
+    if (r->m_stderr != NULL)
+        atf_fs_path_fini(&errpath);
+out_outsb:
+    atf_process_stream_fini(&outsb);
+out_outpath:
+    atf_fs_path_fini(&outpath);
+out:
+    return err;
+}
+
+static
+atf_error_t
+write_response(FILE *out, const struct request *r,
+               const atf_process_status_t *status)
+{
+    fprintf(out, "ident: %s\n", atf_tc_get_ident(r->m_tc));
+    if (atf_process_status_exited(status))
+        fprintf(out, "status: exited %d\n",
+                atf_process_status_exitstatus(status));
+    else {
+        INV(atf_process_status_signaled(status));
+        fprintf(out, "status: signaled %d\n",
+                atf_process_status_termsig(status));
+    }
+    fprintf(out, "\n");
+
+    if (fflush(out) == EOF)
+        return atf_libc_error(errno, "Failed to write response");
+    return atf_no_error();
+}
+
+static
+atf_error_t
+write_error(FILE *out, const atf_error_t reqerr)
+{
+    char buf[1024];
+
+    atf_error_format(reqerr, buf, sizeof(buf));
+    fprintf(out, "error: %s\n\n", buf);
+
+    if (fflush(out) == EOF)
+        return atf_libc_error(errno, "Failed to write response");
+    return atf_no_error();
+}
+
+/* ---------------------------------------------------------------------
+ * Free functions.
+ * --------------------------------------------------------------------- */
+
+atf_error_t
+atf_server_run(const atf_tc_t *const *tcs, FILE *in, FILE *out)
+{
+    atf_error_t err;
+    atf_tc_index_t tcindex;
+    const atf_tc_t *const *tcp;
+
+    err = atf_tc_index_init_array(&tcindex, tcs);
+    if (atf_is_error(err))
+        return err;
+
+    /* Heads only run the first time the metadata of a test case is needed.
+     * Force them all here so that they run once, with the configuration of
+     * the test program, instead of in every child after the configuration
+     * of the request has been applied. */
+    for (tcp = tcs; *tcp != NULL; tcp++)
+        (void)atf_tc_has_md_var(*tcp, "ident");
+
+    fprintf(out, "Content-Type: application/X-atf-server; version=\"1\"\n\n");
+    if (fflush(out) == EOF) {
+        err = atf_libc_error(errno, "Failed to write response");
+        goto out;
+    }
+
+    for (;;) {
+        struct request r;
+        bool eof;
+
+        err = request_init(&r);
+        if (atf_is_error(err))
+            break;
+
+        err = request_read(&r, &tcindex, in, &eof);
+        if (atf_is_error(err) && atf_error_is(err, "request")) {
+            atf_error_t reqerr = err;
+
+            err = write_error(out, reqerr);
+            atf_error_free(reqerr);
+        } else if (!atf_is_error(err) && !eof) {
+            atf_process_status_t status;
+
+            err = request_run(&r, &status);
+            if (!atf_is_error(err)) {
+                err = write_response(out, &r, &status);
+                atf_process_status_fini(&status);
+            }
+        }
+
+        request_fini(&r);
+        if (atf_is_error(err) || eof)
+            break;
+    }
+
+out:
+    atf_tc_index_fini(&tcindex);
+    return err;
+}
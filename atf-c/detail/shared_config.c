@@ -0,0 +1,150 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/shared_config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "atf-c/detail/sanity.h"
+#include "atf-c/error.h"
+
+/* ---------------------------------------------------------------------
+ * The "atf_shared_config" type.
+ * --------------------------------------------------------------------- */
+
+/*
+ * Constructors/destructors.
+ */
+
+atf_error_t
+atf_shared_config_new(atf_shared_config_t **configp, const char *const *array)
+{
+    atf_shared_config_t *config;
+    atf_error_t err;
+
+    config = malloc(sizeof(*config));
+    if (config == NULL)
+        return atf_no_memory_error();
+
+    err = atf_map_init_charpp(&config->m_vars, array);
+    if (atf_is_error(err)) {
+        free(config);
+        return err;
+    }
+    config->m_refcount = 1;
+
+    *configp = config;
+    return err;
+}
+
+atf_error_t
+atf_shared_config_copy(atf_shared_config_t **configp,
+                       const atf_shared_config_t *src)
+{
+    atf_shared_config_t *config;
+    atf_map_citer_t iter;
+    atf_error_t err;
+
+    err = atf_shared_config_new(&config, NULL);
+    if (atf_is_error(err))
+        return err;
+
+    atf_map_for_each_c(iter, &src->m_vars) {
+        err = atf_shared_config_set(config, atf_map_citer_key(iter),
+                                    atf_map_citer_data(iter));
+        if (atf_is_error(err)) {
+            atf_shared_config_unref(config);
+            return err;
+        }
+    }
+
+    *configp = config;
+    return err;
+}
+
+atf_shared_config_t *
+atf_shared_config_ref(atf_shared_config_t *config)
+{
+    PRE(config->m_refcount > 0);
+    config->m_refcount++;
+    return config;
+}
+
+void
+atf_shared_config_unref(atf_shared_config_t *config)
+{
+    PRE(config->m_refcount > 0);
+    config->m_refcount--;
+    if (config->m_refcount == 0) {
+        atf_map_fini(&config->m_vars);
+        free(config);
+    }
+}
+
+/*
+ * Getters.
+ */
+
+const char *
+atf_shared_config_get(const atf_shared_config_t *config, const char *name)
+{
+    atf_map_citer_t iter;
+
+    iter = atf_map_find_c(&config->m_vars, name);
+    if (atf_equal_map_citer_map_citer(iter, atf_map_end_c(&config->m_vars)))
+        return NULL;
+    return atf_map_citer_data(iter);
+}
+
+bool
+atf_shared_config_is_shared(const atf_shared_config_t *config)
+{
+    return config->m_refcount > 1;
+}
+
+char **
+atf_shared_config_to_charpp(const atf_shared_config_t *config)
+{
+    return atf_map_to_charpp(&config->m_vars);
+}
+
+/*
+ * Modifiers.
+ */
+
+atf_error_t
+atf_shared_config_set(atf_shared_config_t *config, const char *name,
+                      const char *value)
+{
+    char *copy;
+
+    PRE(!atf_shared_config_is_shared(config));
+
+    copy = strdup(value);
+    if (copy == NULL)
+        return atf_no_memory_error();
+    return atf_map_insert(&config->m_vars, name, copy, true);
+}
@@ -0,0 +1,65 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#if !defined(ATF_C_DETAIL_SHARED_CONFIG_H)
+#define ATF_C_DETAIL_SHARED_CONFIG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <atf-c/detail/map.h>
+#include <atf-c/error_fwd.h>
+
+/* ---------------------------------------------------------------------
+ * The "atf_shared_config" type.
+ * --------------------------------------------------------------------- */
+
+/* Reference-counted set of configuration variables.  A test program builds
+ * a single one and all of its test cases hold references to it, so the
+ * variables are not copied once per test case.  The variables can only be
+ * modified while there is a single reference to the object. */
+struct atf_shared_config {
+    atf_map_t m_vars;
+    size_t m_refcount;
+};
+typedef struct atf_shared_config atf_shared_config_t;
+
+/* Constructors/destructors. */
+atf_error_t atf_shared_config_new(atf_shared_config_t **, const char *const *);
+atf_error_t atf_shared_config_copy(atf_shared_config_t **,
+                                   const atf_shared_config_t *);
+atf_shared_config_t *atf_shared_config_ref(atf_shared_config_t *);
+void atf_shared_config_unref(atf_shared_config_t *);
+
+/* Getters. */
+const char *atf_shared_config_get(const atf_shared_config_t *, const char *);
+bool atf_shared_config_is_shared(const atf_shared_config_t *);
+char **atf_shared_config_to_charpp(const atf_shared_config_t *);
+
+/* Modifiers. */
+atf_error_t atf_shared_config_set(atf_shared_config_t *, const char *,
+                                  const char *);
+
+#endif /* !defined(ATF_C_DETAIL_SHARED_CONFIG_H) */
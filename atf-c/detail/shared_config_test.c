@@ -0,0 +1,214 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/shared_config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <atf-c.h>
+
+#include "atf-c/detail/test_helpers.h"
+#include "atf-c/utils.h"
+
+/* ---------------------------------------------------------------------
+ * Auxiliary functions.
+ * --------------------------------------------------------------------- */
+
+static
+void
+dummy_body(const atf_tc_t *tc ATF_DEFS_ATTRIBUTE_UNUSED)
+{
+}
+
+/* ---------------------------------------------------------------------
+ * Tests for the "atf_shared_config" type.
+ * --------------------------------------------------------------------- */
+
+/*
+ * Constructors and destructors.
+ */
+
+ATF_TC(shared_config_new);
+ATF_TC_HEAD(shared_config_new, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks the atf_shared_config_new "
+                      "function");
+}
+ATF_TC_BODY(shared_config_new, tc)
+{
+    const char *const array[] = { "K1", "V1", "K2", "V2", NULL };
+    const char *const short_array[] = { "K1", "V1", "K2", NULL };
+    atf_shared_config_t *config;
+    atf_error_t err;
+
+    RE(atf_shared_config_new(&config, NULL));
+    ATF_REQUIRE(atf_shared_config_get(config, "K1") == NULL);
+    ATF_REQUIRE(!atf_shared_config_is_shared(config));
+    atf_shared_config_unref(config);
+
+    RE(atf_shared_config_new(&config, array));
+    ATF_REQUIRE_STREQ("V1", atf_shared_config_get(config, "K1"));
+    ATF_REQUIRE_STREQ("V2", atf_shared_config_get(config, "K2"));
+    ATF_REQUIRE(atf_shared_config_get(config, "K3") == NULL);
+    atf_shared_config_unref(config);
+
+    err = atf_shared_config_new(&config, short_array);
+    ATF_REQUIRE(atf_is_error(err));
+    atf_error_free(err);
+}
+
+ATF_TC(shared_config_ref);
+ATF_TC_HEAD(shared_config_ref, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks the atf_shared_config_ref and "
+                      "atf_shared_config_unref functions");
+}
+ATF_TC_BODY(shared_config_ref, tc)
+{
+    const char *const array[] = { "K1", "V1", NULL };
+    atf_shared_config_t *config, *ref;
+
+    RE(atf_shared_config_new(&config, array));
+    ref = atf_shared_config_ref(config);
+    ATF_REQUIRE(ref == config);
+    ATF_REQUIRE(atf_shared_config_is_shared(config));
+
+    atf_shared_config_unref(config);
+    ATF_REQUIRE(!atf_shared_config_is_shared(ref));
+    ATF_REQUIRE_STREQ("V1", atf_shared_config_get(ref, "K1"));
+    atf_shared_config_unref(ref);
+}
+
+ATF_TC(shared_config_copy);
+ATF_TC_HEAD(shared_config_copy, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks that atf_shared_config_copy "
+                      "returns an independent object");
+}
+ATF_TC_BODY(shared_config_copy, tc)
+{
+    const char *const array[] = { "K1", "V1", "K2", "V2", NULL };
+    atf_shared_config_t *config, *copy;
+
+    RE(atf_shared_config_new(&config, array));
+    atf_shared_config_ref(config);
+
+    RE(atf_shared_config_copy(&copy, config));
+    ATF_REQUIRE(!atf_shared_config_is_shared(copy));
+    RE(atf_shared_config_set(copy, "K1", "new-value"));
+    RE(atf_shared_config_set(copy, "K3", "V3"));
+
+    ATF_REQUIRE_STREQ("new-value", atf_shared_config_get(copy, "K1"));
+    ATF_REQUIRE_STREQ("V2", atf_shared_config_get(copy, "K2"));
+    ATF_REQUIRE_STREQ("V3", atf_shared_config_get(copy, "K3"));
+    ATF_REQUIRE_STREQ("V1", atf_shared_config_get(config, "K1"));
+    ATF_REQUIRE(atf_shared_config_get(config, "K3") == NULL);
+
+    atf_shared_config_unref(copy);
+    atf_shared_config_unref(config);
+    atf_shared_config_unref(config);
+}
+
+/*
+ * Getters.
+ */
+
+ATF_TC(shared_config_to_charpp);
+ATF_TC_HEAD(shared_config_to_charpp, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks the atf_shared_config_to_charpp "
+                      "function");
+}
+ATF_TC_BODY(shared_config_to_charpp, tc)
+{
+    const char *const array[] = { "K1", "V1", "K2", "V2", NULL };
+    atf_shared_config_t *config;
+    char **charpp;
+
+    RE(atf_shared_config_new(&config, array));
+    charpp = atf_shared_config_to_charpp(config);
+    ATF_REQUIRE(charpp != NULL);
+    ATF_REQUIRE_STREQ("K1", charpp[0]);
+    ATF_REQUIRE_STREQ("V1", charpp[1]);
+    ATF_REQUIRE_STREQ("K2", charpp[2]);
+    ATF_REQUIRE_STREQ("V2", charpp[3]);
+    ATF_REQUIRE(charpp[4] == NULL);
+    atf_utils_free_charpp(charpp);
+    atf_shared_config_unref(config);
+}
+
+/*
+ * Test cases.
+ */
+
+ATF_TC(shared_config_tcs);
+ATF_TC_HEAD(shared_config_tcs, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks that test cases share their "
+                      "configuration until one of them overrides it");
+}
+ATF_TC_BODY(shared_config_tcs, tc)
+{
+    const char *const array[] = { "K1", "V1", NULL };
+    atf_shared_config_t *config;
+    atf_tc_t tc1, tc2;
+
+    RE(atf_shared_config_new(&config, array));
+    RE(atf_tc_init_config(&tc1, "tc1", NULL, dummy_body, NULL, config));
+    RE(atf_tc_init_config(&tc2, "tc2", NULL, dummy_body, NULL, config));
+    atf_shared_config_unref(config);
+
+    ATF_REQUIRE(atf_tc_get_config_var(&tc1, "K1") ==
+                atf_tc_get_config_var(&tc2, "K1"));
+
+    RE(atf_tc_set_config_var(&tc1, "K1", "new-value"));
+    ATF_REQUIRE_STREQ("new-value", atf_tc_get_config_var(&tc1, "K1"));
+    ATF_REQUIRE_STREQ("V1", atf_tc_get_config_var(&tc2, "K1"));
+
+    atf_tc_fini(&tc1);
+    ATF_REQUIRE_STREQ("V1", atf_tc_get_config_var(&tc2, "K1"));
+    atf_tc_fini(&tc2);
+}
+
+/* ---------------------------------------------------------------------
+ * Main.
+ * --------------------------------------------------------------------- */
+
+ATF_TP_ADD_TCS(tp)
+{
+    /* Constructors and destructors. */
+    ATF_TP_ADD_TC(tp, shared_config_new);
+    ATF_TP_ADD_TC(tp, shared_config_ref);
+    ATF_TP_ADD_TC(tp, shared_config_copy);
+
+    /* Getters. */
+    ATF_TP_ADD_TC(tp, shared_config_to_charpp);
+
+    /* Test cases. */
+    ATF_TP_ADD_TC(tp, shared_config_tcs);
+
+    return atf_no_error();
+}
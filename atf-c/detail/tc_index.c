@@ -0,0 +1,208 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/tc_index.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "atf-c/detail/sanity.h"
+#include "atf-c/error.h"
+#include "atf-c/tc.h"
+
+/* The index is an open-addressing table with linear probing whose number
+ * of slots is always a power of two and at least twice the number of test
+ * cases it holds, which keeps probe sequences short. */
+
+static const size_t initial_nslots = 16;
+
+/* ---------------------------------------------------------------------
+ * Auxiliary functions.
+ * --------------------------------------------------------------------- */
+
+/* FNV-1a hash of a nul-terminated string. */
+static
+uint32_t
+hash_string(const char *str)
+{
+    uint32_t h = 2166136261u;
+
+    for (; *str != '\0'; str++) {
+        h ^= (unsigned char)*str;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static
+size_t
+find_slot(const struct atf_tc **slots, const size_t nslots, const char *ident)
+{
+    size_t i;
+
+    PRE((nslots & (nslots - 1)) == 0);
+
+    i = hash_string(ident) & (nslots - 1);
+    while (slots[i] != NULL && strcmp(atf_tc_get_ident(slots[i]), ident) != 0)
+        i = (i + 1) & (nslots - 1);
+    return i;
+}
+
+static
+atf_error_t
+resize(atf_tc_index_t *idx, const size_t nslots)
+{
+    const struct atf_tc **slots;
+    size_t i;
+
+    slots = calloc(nslots, sizeof(const struct atf_tc *));
+    if (slots == NULL)
+        return atf_no_memory_error();
+
+    for (i = 0; i < idx->m_nslots; i++) {
+        const struct atf_tc *tc = idx->m_slots[i];
+
+        if (tc != NULL)
+            slots[find_slot(slots, nslots, atf_tc_get_ident(tc))] = tc;
+    }
+
+    free(idx->m_slots);
+    idx->m_slots = slots;
+    idx->m_nslots = nslots;
+    return atf_no_error();
+}
+
+/* ---------------------------------------------------------------------
+ * The "atf_tc_index" type.
+ * --------------------------------------------------------------------- */
+
+/*
+ * Constructors/destructors.
+ */
+
+atf_error_t
+atf_tc_index_init(atf_tc_index_t *idx)
+{
+    idx->m_slots = NULL;
+    idx->m_nslots = 0;
+    idx->m_size = 0;
+
+    return resize(idx, initial_nslots);
+}
+
+atf_error_t
+atf_tc_index_init_array(atf_tc_index_t *idx, const struct atf_tc *const *tcs)
+{
+    atf_error_t err;
+    const struct atf_tc *const *tcsptr;
+    size_t ntcs;
+
+    ntcs = 0;
+    for (tcsptr = tcs; *tcsptr != NULL; tcsptr++)
+        ntcs++;
+
+    err = atf_tc_index_init(idx);
+    if (atf_is_error(err))
+        return err;
+
+    err = atf_tc_index_reserve(idx, ntcs);
+    if (atf_is_error(err)) {
+        atf_tc_index_fini(idx);
+        return err;
+    }
+
+    for (tcsptr = tcs; *tcsptr != NULL; tcsptr++) {
+        err = atf_tc_index_add(idx, *tcsptr);
+        if (atf_is_error(err)) {
+            atf_tc_index_fini(idx);
+            break;
+        }
+    }
+
+    return err;
+}
+
+void
+atf_tc_index_fini(atf_tc_index_t *idx)
+{
+    free(idx->m_slots);
+}
+
+/*
+ * Getters.
+ */
+
+const struct atf_tc *
+atf_tc_index_find(const atf_tc_index_t *idx, const char *ident)
+{
+    return idx->m_slots[find_slot(idx->m_slots, idx->m_nslots, ident)];
+}
+
+size_t
+atf_tc_index_size(const atf_tc_index_t *idx)
+{
+    return idx->m_size;
+}
+
+/*
+ * Modifiers.
+ */
+
+/* Makes room for the given number of test cases in total, so that adding
+ * test cases up to that number cannot fail. */
+atf_error_t
+atf_tc_index_reserve(atf_tc_index_t *idx, const size_t ntcs)
+{
+    size_t nslots;
+
+    for (nslots = idx->m_nslots; nslots < ntcs * 2; nslots *= 2)
+        continue;
+    if (nslots == idx->m_nslots)
+        return atf_no_error();
+    return resize(idx, nslots);
+}
+
+atf_error_t
+atf_tc_index_add(atf_tc_index_t *idx, const struct atf_tc *tc)
+{
+    atf_error_t err;
+    size_t i;
+
+    PRE(atf_tc_index_find(idx, atf_tc_get_ident(tc)) == NULL);
+
+    if ((idx->m_size + 1) * 2 > idx->m_nslots) {
+        err = atf_tc_index_reserve(idx, idx->m_size + 1);
+        if (atf_is_error(err))
+            return err;
+    }
+
+    i = find_slot(idx->m_slots, idx->m_nslots, atf_tc_get_ident(tc));
+    INV(idx->m_slots[i] == NULL);
+    idx->m_slots[i] = tc;
+    idx->m_size++;
+
+    return atf_no_error();
+}
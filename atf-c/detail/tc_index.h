@@ -0,0 +1,62 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#if !defined(ATF_C_DETAIL_TC_INDEX_H)
+#define ATF_C_DETAIL_TC_INDEX_H
+
+#include <stddef.h>
+
+#include <atf-c/error_fwd.h>
+
+struct atf_tc;
+
+/* ---------------------------------------------------------------------
+ * The "atf_tc_index" type.
+ * --------------------------------------------------------------------- */
+
+/* Hash table of test cases keyed by their identifier.  The index does not
+ * own the test cases, which must outlive it. */
+struct atf_tc_index {
+    const struct atf_tc **m_slots;
+    size_t m_nslots;
+    size_t m_size;
+};
+typedef struct atf_tc_index atf_tc_index_t;
+
+/* Constructors/destructors. */
+atf_error_t atf_tc_index_init(atf_tc_index_t *);
+atf_error_t atf_tc_index_init_array(atf_tc_index_t *,
+                                    const struct atf_tc *const *);
+void atf_tc_index_fini(atf_tc_index_t *);
+
+/* Getters. */
+const struct atf_tc *atf_tc_index_find(const atf_tc_index_t *, const char *);
+size_t atf_tc_index_size(const atf_tc_index_t *);
+
+/* Modifiers. */
+atf_error_t atf_tc_index_reserve(atf_tc_index_t *, const size_t);
+atf_error_t atf_tc_index_add(atf_tc_index_t *, const struct atf_tc *);
+
+#endif /* !defined(ATF_C_DETAIL_TC_INDEX_H) */
@@ -0,0 +1,234 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/tc_index.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atf-c.h>
+
+#include "atf-c/detail/test_helpers.h"
+
+/* ---------------------------------------------------------------------
+ * Auxiliary functions.
+ * --------------------------------------------------------------------- */
+
+#define NTCS 1000
+
+static const char *const empty_config[] = { NULL };
+static char idents[NTCS][16];
+static atf_tc_t tcs[NTCS];
+
+static
+void
+dummy_body(const atf_tc_t *tc ATF_DEFS_ATTRIBUTE_UNUSED)
+{
+}
+
+static
+void
+init_tcs(const size_t ntcs)
+{
+    size_t i;
+
+    for (i = 0; i < ntcs; i++) {
+        snprintf(idents[i], sizeof(idents[i]), "tc%zu", i);
+        RE(atf_tc_init(&tcs[i], idents[i], NULL, dummy_body, NULL,
+                       empty_config));
+    }
+}
+
+static
+void
+fini_tcs(const size_t ntcs)
+{
+    size_t i;
+
+    for (i = 0; i < ntcs; i++)
+        atf_tc_fini(&tcs[i]);
+}
+
+/* ---------------------------------------------------------------------
+ * Tests for the "atf_tc_index" type.
+ * --------------------------------------------------------------------- */
+
+/*
+ * Constructors and destructors.
+ */
+
+ATF_TC(tc_index_init);
+ATF_TC_HEAD(tc_index_init, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks the atf_tc_index_init function");
+}
+ATF_TC_BODY(tc_index_init, tc)
+{
+    atf_tc_index_t idx;
+
+    RE(atf_tc_index_init(&idx));
+    ATF_REQUIRE_EQ(atf_tc_index_size(&idx), 0);
+    ATF_REQUIRE(atf_tc_index_find(&idx, "tc0") == NULL);
+    atf_tc_index_fini(&idx);
+}
+
+ATF_TC(tc_index_init_array);
+ATF_TC_HEAD(tc_index_init_array, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks the atf_tc_index_init_array "
+                      "function");
+}
+ATF_TC_BODY(tc_index_init_array, tc)
+{
+    const atf_tc_t *array[NTCS + 1];
+    atf_tc_index_t idx;
+    size_t i;
+
+    init_tcs(NTCS);
+    for (i = 0; i < NTCS; i++)
+        array[i] = &tcs[i];
+    array[NTCS] = NULL;
+
+    RE(atf_tc_index_init_array(&idx, array));
+    ATF_REQUIRE_EQ(atf_tc_index_size(&idx), NTCS);
+    for (i = 0; i < NTCS; i++)
+        ATF_REQUIRE(atf_tc_index_find(&idx, idents[i]) == &tcs[i]);
+    ATF_REQUIRE(atf_tc_index_find(&idx, "tc") == NULL);
+    atf_tc_index_fini(&idx);
+
+    fini_tcs(NTCS);
+}
+
+/*
+ * Getters and modifiers.
+ */
+
+ATF_TC(tc_index_add_find);
+ATF_TC_HEAD(tc_index_add_find, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks the atf_tc_index_add and "
+                      "atf_tc_index_find functions");
+}
+ATF_TC_BODY(tc_index_add_find, tc)
+{
+    atf_tc_index_t idx;
+
+    init_tcs(3);
+
+    RE(atf_tc_index_init(&idx));
+    RE(atf_tc_index_add(&idx, &tcs[0]));
+    RE(atf_tc_index_add(&idx, &tcs[2]));
+    ATF_REQUIRE_EQ(atf_tc_index_size(&idx), 2);
+
+    ATF_CHECK(atf_tc_index_find(&idx, "tc0") == &tcs[0]);
+    ATF_CHECK(atf_tc_index_find(&idx, "tc1") == NULL);
+    ATF_CHECK(atf_tc_index_find(&idx, "tc2") == &tcs[2]);
+    ATF_CHECK(atf_tc_index_find(&idx, "tc00") == NULL);
+    ATF_CHECK(atf_tc_index_find(&idx, "") == NULL);
+    atf_tc_index_fini(&idx);
+
+    fini_tcs(3);
+}
+
+ATF_TC(tc_index_add_grow);
+ATF_TC_HEAD(tc_index_add_grow, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks that atf_tc_index_add keeps all "
+                      "test cases reachable when the index grows");
+}
+ATF_TC_BODY(tc_index_add_grow, tc)
+{
+    atf_tc_index_t idx;
+    size_t i, j;
+
+    init_tcs(NTCS);
+
+    RE(atf_tc_index_init(&idx));
+    for (i = 0; i < NTCS; i++) {
+        RE(atf_tc_index_add(&idx, &tcs[i]));
+        ATF_REQUIRE_EQ(atf_tc_index_size(&idx), i + 1);
+        if ((i & (i + 1)) == 0) {
+            /* Check everything right after each power of two, which is
+             * around the points where the index is resized. */
+            for (j = 0; j <= i; j++)
+                ATF_REQUIRE(atf_tc_index_find(&idx, idents[j]) == &tcs[j]);
+        }
+    }
+    for (i = 0; i < NTCS; i++)
+        ATF_REQUIRE(atf_tc_index_find(&idx, idents[i]) == &tcs[i]);
+    atf_tc_index_fini(&idx);
+
+    fini_tcs(NTCS);
+}
+
+ATF_TC(tc_index_reserve);
+ATF_TC_HEAD(tc_index_reserve, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks that atf_tc_index_add does not "
+                      "need to grow the index after atf_tc_index_reserve");
+}
+ATF_TC_BODY(tc_index_reserve, tc)
+{
+    atf_tc_index_t idx;
+    size_t i, nslots;
+
+    init_tcs(NTCS);
+
+    RE(atf_tc_index_init(&idx));
+    RE(atf_tc_index_reserve(&idx, NTCS));
+    nslots = idx.m_nslots;
+    ATF_REQUIRE(nslots >= NTCS * 2);
+    RE(atf_tc_index_reserve(&idx, 1));
+    ATF_REQUIRE_EQ(idx.m_nslots, nslots);
+
+    for (i = 0; i < NTCS; i++) {
+        RE(atf_tc_index_add(&idx, &tcs[i]));
+        ATF_REQUIRE_EQ(idx.m_nslots, nslots);
+    }
+    for (i = 0; i < NTCS; i++)
+        ATF_REQUIRE(atf_tc_index_find(&idx, idents[i]) == &tcs[i]);
+    atf_tc_index_fini(&idx);
+
+    fini_tcs(NTCS);
+}
+
+/* ---------------------------------------------------------------------
+ * Main.
+ * --------------------------------------------------------------------- */
+
+ATF_TP_ADD_TCS(tp)
+{
+    /* Constructors and destructors. */
+    ATF_TP_ADD_TC(tp, tc_index_init);
+    ATF_TP_ADD_TC(tp, tc_index_init_array);
+
+    /* Getters and modifiers. */
+    ATF_TP_ADD_TC(tp, tc_index_add_find);
+    ATF_TP_ADD_TC(tp, tc_index_add_grow);
+    ATF_TP_ADD_TC(tp, tc_index_reserve);
+
+    return atf_no_error();
+}
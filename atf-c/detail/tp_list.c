@@ -0,0 +1,668 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/tp_list.h"
+
+#if defined(HAVE_CONFIG_H)
+#include "config.h"
+#endif
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "atf-c/detail/dynstr.h"
+#include "atf-c/detail/sanity.h"
+#include "atf-c/error.h"
+
+/* ---------------------------------------------------------------------
+ * Auxiliary functions.
+ * --------------------------------------------------------------------- */
+
+static const char binary_magic[4] = { 'A', 'T', 'F', 'L' };
+static const uint32_t binary_version = 1;
+
+/* Offset of the test case count in the binary header. */
+#define BINARY_NTCS_OFFSET 8
+
+static const char *const format_names[] = {
+    [atf_tp_list_atf] = "atf",
+    [atf_tp_list_json] = "json",
+    [atf_tp_list_binary] = "binary",
+};
+
+static
+atf_error_t
+append(atf_tp_list_t *list, const void *data, const size_t length)
+{
+    if (list->m_length + length > list->m_size) {
+        size_t size;
+        char *newdata;
+
+        size = list->m_size == 0 ? 1024 : list->m_size;
+        while (list->m_length + length > size)
+            size *= 2;
+
+        newdata = realloc(list->m_data, size);
+        if (newdata == NULL)
+            return atf_no_memory_error();
+        list->m_data = newdata;
+        list->m_size = size;
+    }
+
+    memcpy(list->m_data + list->m_length, data, length);
+    list->m_length += length;
+    return atf_no_error();
+}
+
+static
+atf_error_t
+append_str(atf_tp_list_t *list, const char *str)
+{
+    return append(list, str, strlen(str));
+}
+
+static
+void
+put_u32(char *buf, const uint32_t value)
+{
+    buf[0] = (char)((value >> 24) & 0xff);
+    buf[1] = (char)((value >> 16) & 0xff);
+    buf[2] = (char)((value >> 8) & 0xff);
+    buf[3] = (char)(value & 0xff);
+}
+
+static
+atf_error_t
+append_u32(atf_tp_list_t *list, const uint32_t value)
+{
+    char buf[4];
+
+    put_u32(buf, value);
+    return append(list, buf, sizeof(buf));
+}
+
+static
+atf_error_t
+append_binary_str(atf_tp_list_t *list, const char *str)
+{
+    atf_error_t err;
+    const size_t length = strlen(str);
+
+    if (length > UINT32_MAX)
+        return atf_libc_error(EOVERFLOW, "String too long to be listed");
+
+    err = append_u32(list, (uint32_t)length);
+    if (!atf_is_error(err))
+        err = append(list, str, length);
+    return err;
+}
+
+static
+atf_error_t
+append_json_str(atf_tp_list_t *list, const char *str)
+{
+    atf_error_t err;
+    const char *start, *ptr;
+
+    err = append_str(list, "\"");
+    for (start = ptr = str; !atf_is_error(err) && *ptr != '\0'; ptr++) {
+        const unsigned char ch = (unsigned char)*ptr;
+        char escape[7];
+
+        if (ch == '"' || ch == '\\')
+            snprintf(escape, sizeof(escape), "\\%c", ch);
+        else if (ch == '\n')
+            strcpy(escape, "\\n");
+        else if (ch == '\t')
+            strcpy(escape, "\\t");
+        else if (ch < 0x20)
+            snprintf(escape, sizeof(escape), "\\u%04x", ch);
+        else
+            continue;
+
+        err = append(list, start, (size_t)(ptr - start));
+        if (!atf_is_error(err))
+            err = append_str(list, escape);
+        start = ptr + 1;
+    }
+    if (!atf_is_error(err))
+        err = append(list, start, (size_t)(ptr - start));
+    if (!atf_is_error(err))
+        err = append_str(list, "\"");
+    return err;
+}
+
+static
+atf_error_t
+append_json_pair(atf_tp_list_t *list, const char *name, const char *value)
+{
+    atf_error_t err;
+
+    err = append_json_str(list, name);
+    if (!atf_is_error(err))
+        err = append_str(list, ": ");
+    if (!atf_is_error(err))
+        err = append_json_str(list, value);
+    return err;
+}
+
+static
+uint64_t
+fnv1a_update(uint64_t h, const char *str)
+{
+    /* Include the terminating nul so that "ab","c" and "a","bc" differ. */
+    do {
+        h ^= (unsigned char)*str;
+        h *= UINT64_C(1099511628211);
+    } while (*str++ != '\0');
+    return h;
+}
+
+static
+int
+compare_config_names(const void *a, const void *b)
+{
+    const char *const *pa = a;
+    const char *const *pb = b;
+
+    return strcmp(*pa, *pb);
+}
+
+/* Hashes the configuration variables in 'config', an array of name/value
+ * pairs, independently of their order. */
+static
+atf_error_t
+config_hash(const char *const *config, uint64_t *hash)
+{
+    const char **pairs;
+    size_t i, npairs;
+
+    *hash = UINT64_C(14695981039346656037);
+
+    npairs = 0;
+    while (config[npairs * 2] != NULL)
+        npairs++;
+
+    pairs = malloc((npairs == 0 ? 1 : npairs) * 2 * sizeof(const char *));
+    if (pairs == NULL)
+        return atf_no_memory_error();
+    memcpy(pairs, config, npairs * 2 * sizeof(const char *));
+    qsort(pairs, npairs, 2 * sizeof(const char *), compare_config_names);
+
+    for (i = 0; i < npairs * 2; i++)
+        *hash = fnv1a_update(*hash, pairs[i]);
+
+    free(pairs);
+    return atf_no_error();
+}
+
+/* Computes the line that identifies a cached listing, which is built from
+ * the identity of the binary, the configuration variables that the heads
+ * of the test cases can see and the format of the listing.  The
+ * modification time is taken with its full precision, where available, so
+ * that a binary rebuilt within the same second does not match. */
+static
+atf_error_t
+cache_key(const char *binary, const char *const *config,
+          const enum atf_tp_list_format format, atf_dynstr_t *key)
+{
+    atf_error_t err;
+    struct stat sb;
+    uint64_t hash;
+    long nsec;
+
+    if (stat(binary, &sb) == -1)
+        return atf_libc_error(errno, "Cannot stat %s", binary);
+
+#if defined(HAVE_STRUCT_STAT_ST_MTIM)
+    nsec = sb.st_mtim.tv_nsec;
+#else
+    nsec = 0;
+#endif
+
+    err = config_hash(config, &hash);
+    if (atf_is_error(err))
+        return err;
+
+    return atf_dynstr_init_fmt(key, "atf-tp-list-cache 3 %s %ju %ju %jd.%09ld "
+                               "%jd %016jx\n", format_names[format],
+                               (uintmax_t)sb.st_dev, (uintmax_t)sb.st_ino,
+                               (intmax_t)sb.st_mtime, nsec,
+                               (intmax_t)sb.st_size, (uintmax_t)hash);
+}
+
+static
+bool
+read_file(const char *path, char **datap, size_t *lengthp)
+{
+    struct stat sb;
+    char *data;
+    size_t length;
+    int fd;
+
+    fd = open(path, O_RDONLY);
+    if (fd == -1)
+        return false;
+
+    data = NULL;
+    if (fstat(fd, &sb) == -1 || sb.st_size < 0)
+        goto err;
+
+    data = malloc((size_t)sb.st_size + 1);
+    if (data == NULL)
+        goto err;
+
+    length = 0;
+    while (length < (size_t)sb.st_size) {
+        const ssize_t ret = read(fd, data + length,
+                                 (size_t)sb.st_size - length);
+        if (ret == -1 && errno == EINTR)
+            continue;
+        if (ret <= 0)
+            goto err;
+        length += (size_t)ret;
+    }
+    data[length] = '\0';
+    close(fd);
+
+    *datap = data;
+    *lengthp = length;
+    return true;
+
+err:
+    free(data);
+    close(fd);
+    return false;
+}
+
+static
+atf_error_t
+write_all(const int fd, const char *data, size_t length)
+{
+    while (length > 0) {
+        const ssize_t ret = write(fd, data, length);
+        if (ret == -1) {
+            if (errno == EINTR)
+                continue;
+            return atf_libc_error(errno, "Cannot write the listing cache");
+        }
+        data += ret;
+        length -= (size_t)ret;
+    }
+    return atf_no_error();
+}
+
+/* ---------------------------------------------------------------------
+ * The "atf_tp_list" type.
+ * --------------------------------------------------------------------- */
+
+/*
+ * Constructors/destructors.
+ */
+
+atf_error_t
+atf_tp_list_init(atf_tp_list_t *list, enum atf_tp_list_format format)
+{
+    atf_error_t err;
+
+    list->m_format = format;
+    list->m_data = NULL;
+    list->m_length = 0;
+    list->m_size = 0;
+    list->m_ntcs = 0;
+    list->m_npairs = 0;
+    list->m_npairs_offset = 0;
+    list->m_finished = false;
+
+    switch (format) {
+    case atf_tp_list_atf:
+        err = append_str(list, "Content-Type: application/X-atf-tp; "
+                         "version=\"1\"\n\n");
+        break;
+
+    case atf_tp_list_json:
+        err = append_str(list, "{\"version\": 1, \"test_cases\": [");
+        break;
+
+    case atf_tp_list_binary:
+        err = append(list, binary_magic, sizeof(binary_magic));
+        if (!atf_is_error(err))
+            err = append_u32(list, binary_version);
+        if (!atf_is_error(err)) {
+            INV(list->m_length == BINARY_NTCS_OFFSET);
+            err = append_u32(list, 0);
+        }
+        break;
+
+    default:
+        UNREACHABLE;
+        err = atf_no_error();
+    }
+
+    if (atf_is_error(err))
+        free(list->m_data);
+    return err;
+}
+
+void
+atf_tp_list_fini(atf_tp_list_t *list)
+{
+    free(list->m_data);
+}
+
+/*
+ * Getters.
+ */
+
+const void *
+atf_tp_list_data(const atf_tp_list_t *list)
+{
+    PRE(list->m_finished);
+    return list->m_data;
+}
+
+size_t
+atf_tp_list_length(const atf_tp_list_t *list)
+{
+    PRE(list->m_finished);
+    return list->m_length;
+}
+
+/*
+ * Modifiers.
+ */
+
+atf_error_t
+atf_tp_list_start_tc(atf_tp_list_t *list, const char *ident)
+{
+    atf_error_t err;
+
+    PRE(!list->m_finished);
+
+    switch (list->m_format) {
+    case atf_tp_list_atf:
+        err = append_str(list, list->m_ntcs == 0 ? "ident: " : "\nident: ");
+        if (!atf_is_error(err))
+            err = append_str(list, ident);
+        if (!atf_is_error(err))
+            err = append_str(list, "\n");
+        break;
+
+    case atf_tp_list_json:
+        err = append_str(list, list->m_ntcs == 0 ? "\n{" : ",\n{");
+        if (!atf_is_error(err))
+            err = append_json_pair(list, "ident", ident);
+        break;
+
+    case atf_tp_list_binary:
+        list->m_npairs_offset = list->m_length;
+        err = append_u32(list, 0);
+        if (!atf_is_error(err))
+            err = append_binary_str(list, "ident");
+        if (!atf_is_error(err))
+            err = append_binary_str(list, ident);
+        break;
+
+    default:
+        UNREACHABLE;
+        err = atf_no_error();
+    }
+
+    list->m_npairs = 1;
+    return err;
+}
+
+atf_error_t
+atf_tp_list_tc_md(atf_tp_list_t *list, const char *name, const char *value)
+{
+    atf_error_t err;
+
+    PRE(!list->m_finished);
+    PRE(strcmp(name, "ident") != 0);
+
+    switch (list->m_format) {
+    case atf_tp_list_atf:
+        err = append_str(list, name);
+        if (!atf_is_error(err))
+            err = append_str(list, ": ");
+        if (!atf_is_error(err))
+            err = append_str(list, value);
+        if (!atf_is_error(err))
+            err = append_str(list, "\n");
+        break;
+
+    case atf_tp_list_json:
+        err = append_str(list, ", ");
+        if (!atf_is_error(err))
+            err = append_json_pair(list, name, value);
+        break;
+
+    case atf_tp_list_binary:
+        err = append_binary_str(list, name);
+        if (!atf_is_error(err))
+            err = append_binary_str(list, value);
+        break;
+
+    default:
+        UNREACHABLE;
+        err = atf_no_error();
+    }
+
+    list->m_npairs++;
+    return err;
+}
+
+atf_error_t
+atf_tp_list_end_tc(atf_tp_list_t *list)
+{
+    atf_error_t err;
+
+    PRE(!list->m_finished);
+
+    err = atf_no_error();
+    if (list->m_format == atf_tp_list_json)
+        err = append_str(list, "}");
+    else if (list->m_format == atf_tp_list_binary)
+        put_u32(list->m_data + list->m_npairs_offset,
+                (uint32_t)list->m_npairs);
+
+    if (!atf_is_error(err))
+        list->m_ntcs++;
+    return err;
+}
+
+atf_error_t
+atf_tp_list_finish(atf_tp_list_t *list)
+{
+    atf_error_t err;
+
+    PRE(!list->m_finished);
+
+    switch (list->m_format) {
+    case atf_tp_list_atf:
+        err = atf_no_error();
+        break;
+
+    case atf_tp_list_json:
+        err = append_str(list, list->m_ntcs == 0 ? "]}\n" : "\n]}\n");
+        break;
+
+    case atf_tp_list_binary:
+        put_u32(list->m_data + BINARY_NTCS_OFFSET, (uint32_t)list->m_ntcs);
+        err = atf_no_error();
+        break;
+
+    default:
+        UNREACHABLE;
+        err = atf_no_error();
+    }
+
+    if (!atf_is_error(err))
+        list->m_finished = true;
+    return err;
+}
+
+/*
+ * Output.
+ */
+
+atf_error_t
+atf_tp_list_write(const atf_tp_list_t *list, FILE *file)
+{
+    PRE(list->m_finished);
+
+    if (fwrite(list->m_data, 1, list->m_length, file) != list->m_length ||
+        fflush(file) == EOF)
+        return atf_libc_error(errno, "Cannot write the list of test cases");
+    return atf_no_error();
+}
+
+/* ---------------------------------------------------------------------
+ * Free functions.
+ * --------------------------------------------------------------------- */
+
+bool
+atf_tp_list_parse_format(const char *name, enum atf_tp_list_format *format)
+{
+    size_t i;
+
+    for (i = 0; i < sizeof(format_names) / sizeof(format_names[0]); i++) {
+        if (strcmp(name, format_names[i]) == 0) {
+            *format = (enum atf_tp_list_format)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Returns the path by which the running test program can be found, given
+ * the name it was invoked by.  That name may have been looked up in the
+ * PATH or may not name the program at all, so the executable of the
+ * process is preferred where the system exposes it. */
+const char *
+atf_tp_list_cache_binary(const char *argv0)
+{
+    struct stat sb;
+
+    if (stat("/proc/self/exe", &sb) != -1)
+        return "/proc/self/exe";
+    return argv0;
+}
+
+/* Writes the listing cached in 'cachefile' to 'file' if the cache exists
+ * and was created from the current 'binary' with the same configuration
+ * variables in 'config' and in the requested format.  Returns false,
+ * without writing anything, in any other case. */
+bool
+atf_tp_list_cache_load(const char *cachefile, const char *binary,
+                       const char *const *config,
+                       enum atf_tp_list_format format, FILE *file)
+{
+    atf_error_t err;
+    atf_dynstr_t key;
+    char *data;
+    size_t length, keylen;
+    bool found;
+
+    err = cache_key(binary, config, format, &key);
+    if (atf_is_error(err)) {
+        atf_error_free(err);
+        return false;
+    }
+
+    found = false;
+    if (read_file(cachefile, &data, &length)) {
+        keylen = atf_dynstr_length(&key);
+        if (length >= keylen &&
+            memcmp(data, atf_dynstr_cstring(&key), keylen) == 0) {
+            found = fwrite(data + keylen, 1, length - keylen, file) ==
+                length - keylen && fflush(file) != EOF;
+        }
+        free(data);
+    }
+
+    atf_dynstr_fini(&key);
+    return found;
+}
+
+/* Stores a finished listing in 'cachefile', keyed on 'binary' and on the
+ * configuration variables in 'config'.  The cache is replaced atomically
+ * so that concurrent readers never see a partial file. */
+atf_error_t
+atf_tp_list_cache_store(const atf_tp_list_t *list, const char *cachefile,
+                        const char *binary, const char *const *config)
+{
+    atf_error_t err;
+    atf_dynstr_t key, tmpfile;
+    char *tmpname;
+    int fd;
+
+    PRE(list->m_finished);
+
+    err = cache_key(binary, config, list->m_format, &key);
+    if (atf_is_error(err))
+        goto out;
+
+    err = atf_dynstr_init_fmt(&tmpfile, "%s.XXXXXX", cachefile);
+    if (atf_is_error(err))
+        goto out_key;
+    tmpname = atf_dynstr_fini_disown(&tmpfile);
+
+    fd = mkstemp(tmpname);
+    if (fd == -1) {
+        err = atf_libc_error(errno, "Cannot create temporary file %s",
+                             tmpname);
+        goto out_tmpname;
+    }
+
+    if (fchmod(fd, 0644) == -1)
+        err = atf_libc_error(errno, "Cannot set the mode of %s", tmpname);
+    if (!atf_is_error(err))
+        err = write_all(fd, atf_dynstr_cstring(&key),
+                        atf_dynstr_length(&key));
+    if (!atf_is_error(err))
+        err = write_all(fd, list->m_data, list->m_length);
+    if (close(fd) == -1 && !atf_is_error(err))
+        err = atf_libc_error(errno, "Cannot write the listing cache");
+    if (!atf_is_error(err) && rename(tmpname, cachefile) == -1)
+        err = atf_libc_error(errno, "Cannot rename %s to %s", tmpname,
+                             cachefile);
+    if (atf_is_error(err))
+        unlink(tmpname);
+
+out_tmpname:
+    free(tmpname);
+out_key:
+    atf_dynstr_fini(&key);
+out:
+    return err;
+}
@@ -0,0 +1,93 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#if !defined(ATF_C_DETAIL_TP_LIST_H)
+#define ATF_C_DETAIL_TP_LIST_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include <atf-c/error_fwd.h>
+
+/* ---------------------------------------------------------------------
+ * The "atf_tp_list" type.
+ * --------------------------------------------------------------------- */
+
+enum atf_tp_list_format {
+    atf_tp_list_atf,
+    atf_tp_list_json,
+    atf_tp_list_binary,
+};
+
+/* In-memory listing of the test cases of a test program in one of the
+ * supported formats.  Test cases are added one at a time with start_tc,
+ * tc_md and end_tc, and the listing must be finished before writing it
+ * out.  See atf-test-program(1) for a description of the formats. */
+struct atf_tp_list {
+    enum atf_tp_list_format m_format;
+    char *m_data;
+    size_t m_length;
+    size_t m_size;
+    size_t m_ntcs;
+    size_t m_npairs;
+    size_t m_npairs_offset;
+    bool m_finished;
+};
+typedef struct atf_tp_list atf_tp_list_t;
+
+/* Constructors/destructors. */
+atf_error_t atf_tp_list_init(atf_tp_list_t *, enum atf_tp_list_format);
+void atf_tp_list_fini(atf_tp_list_t *);
+
+/* Getters. */
+const void *atf_tp_list_data(const atf_tp_list_t *);
+size_t atf_tp_list_length(const atf_tp_list_t *);
+
+/* Modifiers. */
+atf_error_t atf_tp_list_start_tc(atf_tp_list_t *, const char *);
+atf_error_t atf_tp_list_tc_md(atf_tp_list_t *, const char *, const char *);
+atf_error_t atf_tp_list_end_tc(atf_tp_list_t *);
+atf_error_t atf_tp_list_finish(atf_tp_list_t *);
+
+/* Output. */
+atf_error_t atf_tp_list_write(const atf_tp_list_t *, FILE *);
+
+/* ---------------------------------------------------------------------
+ * Free functions.
+ * --------------------------------------------------------------------- */
+
+bool atf_tp_list_parse_format(const char *, enum atf_tp_list_format *);
+
+/* Sidecar cache of a listing, keyed on the identity of the test program
+ * binary so that it is invalidated when the binary is rebuilt, and on the
+ * configuration variables given to the test cases. */
+const char *atf_tp_list_cache_binary(const char *);
+bool atf_tp_list_cache_load(const char *, const char *, const char *const *,
+                            enum atf_tp_list_format, FILE *);
+atf_error_t atf_tp_list_cache_store(const atf_tp_list_t *, const char *,
+                                    const char *, const char *const *);
+
+#endif /* !defined(ATF_C_DETAIL_TP_LIST_H) */
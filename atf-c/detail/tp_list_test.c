@@ -0,0 +1,307 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/tp_list.h"
+
+#if defined(HAVE_CONFIG_H)
+#include "config.h"
+#endif
+
+#include <sys/stat.h>
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atf-c.h>
+
+#include "atf-c/detail/test_helpers.h"
+#include "atf-c/utils.h"
+
+/* ---------------------------------------------------------------------
+ * Auxiliary functions.
+ * --------------------------------------------------------------------- */
+
+/* Builds a listing of two test cases, the first of which has metadata
+ * that needs escaping in JSON. */
+static
+void
+build_list(atf_tp_list_t *list, enum atf_tp_list_format format)
+{
+    RE(atf_tp_list_init(list, format));
+    RE(atf_tp_list_start_tc(list, "first"));
+    RE(atf_tp_list_tc_md(list, "descr", "A \"quoted\"\tvalue\\"));
+    RE(atf_tp_list_end_tc(list));
+    RE(atf_tp_list_start_tc(list, "second"));
+    RE(atf_tp_list_end_tc(list));
+    RE(atf_tp_list_finish(list));
+}
+
+static
+void
+write_list(const atf_tp_list_t *list, const char *path)
+{
+    FILE *file;
+
+    file = fopen(path, "w");
+    ATF_REQUIRE(file != NULL);
+    RE(atf_tp_list_write(list, file));
+    fclose(file);
+}
+
+static const char *const no_config[] = { NULL };
+
+static
+bool
+load_cache_config(const char *binary, const char *const *config,
+                  enum atf_tp_list_format format)
+{
+    FILE *file;
+    bool found;
+
+    file = fopen("out", "w");
+    ATF_REQUIRE(file != NULL);
+    found = atf_tp_list_cache_load("cache", binary, config, format, file);
+    fclose(file);
+    return found;
+}
+
+static
+bool
+load_cache(const char *binary, enum atf_tp_list_format format)
+{
+    return load_cache_config(binary, no_config, format);
+}
+
+/* ---------------------------------------------------------------------
+ * Tests for the "atf_tp_list" type.
+ * --------------------------------------------------------------------- */
+
+ATF_TC_WITHOUT_HEAD(atf_format);
+ATF_TC_BODY(atf_format, tc)
+{
+    atf_tp_list_t list;
+
+    build_list(&list, atf_tp_list_atf);
+    write_list(&list, "out");
+    atf_tp_list_fini(&list);
+
+    ATF_REQUIRE(atf_utils_compare_file("out",
+        "Content-Type: application/X-atf-tp; version=\"1\"\n\n"
+        "ident: first\n"
+        "descr: A \"quoted\"\tvalue\\\n"
+        "\n"
+        "ident: second\n"));
+}
+
+ATF_TC_WITHOUT_HEAD(json_format);
+ATF_TC_BODY(json_format, tc)
+{
+    atf_tp_list_t list;
+
+    build_list(&list, atf_tp_list_json);
+    write_list(&list, "out");
+    atf_tp_list_fini(&list);
+
+    ATF_REQUIRE(atf_utils_compare_file("out",
+        "{\"version\": 1, \"test_cases\": [\n"
+        "{\"ident\": \"first\", "
+        "\"descr\": \"A \\\"quoted\\\"\\tvalue\\\\\"},\n"
+        "{\"ident\": \"second\"}\n"
+        "]}\n"));
+}
+
+ATF_TC_WITHOUT_HEAD(json_format_empty);
+ATF_TC_BODY(json_format_empty, tc)
+{
+    atf_tp_list_t list;
+
+    RE(atf_tp_list_init(&list, atf_tp_list_json));
+    RE(atf_tp_list_finish(&list));
+    write_list(&list, "out");
+    atf_tp_list_fini(&list);
+
+    ATF_REQUIRE(atf_utils_compare_file("out",
+        "{\"version\": 1, \"test_cases\": []}\n"));
+}
+
+ATF_TC_WITHOUT_HEAD(binary_format);
+ATF_TC_BODY(binary_format, tc)
+{
+    static const char expected[] =
+        "ATFL" "\0\0\0\1" "\0\0\0\2"
+        "\0\0\0\2"
+            "\0\0\0\5" "ident" "\0\0\0\5" "first"
+            "\0\0\0\5" "descr" "\0\0\0\021" "A \"quoted\"\tvalue\\"
+        "\0\0\0\1"
+            "\0\0\0\5" "ident" "\0\0\0\6" "second";
+    atf_tp_list_t list;
+
+    build_list(&list, atf_tp_list_binary);
+    ATF_REQUIRE_EQ(sizeof(expected) - 1, atf_tp_list_length(&list));
+    ATF_REQUIRE(memcmp(expected, atf_tp_list_data(&list),
+                       sizeof(expected) - 1) == 0);
+    atf_tp_list_fini(&list);
+}
+
+/* ---------------------------------------------------------------------
+ * Tests for the free functions.
+ * --------------------------------------------------------------------- */
+
+ATF_TC_WITHOUT_HEAD(parse_format);
+ATF_TC_BODY(parse_format, tc)
+{
+    enum atf_tp_list_format format;
+
+    ATF_REQUIRE(atf_tp_list_parse_format("atf", &format));
+    ATF_REQUIRE_EQ(atf_tp_list_atf, format);
+    ATF_REQUIRE(atf_tp_list_parse_format("json", &format));
+    ATF_REQUIRE_EQ(atf_tp_list_json, format);
+    ATF_REQUIRE(atf_tp_list_parse_format("binary", &format));
+    ATF_REQUIRE_EQ(atf_tp_list_binary, format);
+    ATF_REQUIRE(!atf_tp_list_parse_format("xml", &format));
+    ATF_REQUIRE(!atf_tp_list_parse_format("", &format));
+}
+
+ATF_TC_WITHOUT_HEAD(cache);
+ATF_TC_BODY(cache, tc)
+{
+    atf_tp_list_t list;
+
+    atf_utils_create_file("binary", "contents");
+    ATF_REQUIRE(!load_cache("binary", atf_tp_list_json));
+
+    build_list(&list, atf_tp_list_json);
+    write_list(&list, "expected");
+    RE(atf_tp_list_cache_store(&list, "cache", "binary", no_config));
+    atf_tp_list_fini(&list);
+
+    ATF_REQUIRE(load_cache("binary", atf_tp_list_json));
+    ATF_REQUIRE(atf_utils_compare_file("out",
+                                       "{\"version\": 1, \"test_cases\": [\n"
+                                       "{\"ident\": \"first\", "
+                                       "\"descr\": \"A \\\"quoted\\\"\\tvalue"
+                                       "\\\\\"},\n"
+                                       "{\"ident\": \"second\"}\n"
+                                       "]}\n"));
+
+    ATF_REQUIRE(!load_cache("binary", atf_tp_list_atf));
+    ATF_REQUIRE(!load_cache("missing", atf_tp_list_json));
+
+    atf_utils_create_file("binary", "different contents");
+    ATF_REQUIRE(!load_cache("binary", atf_tp_list_json));
+}
+
+ATF_TC_WITHOUT_HEAD(cache_mtime_nsec);
+ATF_TC_BODY(cache_mtime_nsec, tc)
+{
+#if defined(HAVE_STRUCT_STAT_ST_MTIM)
+    struct timespec times[2] = { { 1000000000, 100 }, { 1000000000, 100 } };
+    atf_tp_list_t list;
+    struct stat sb;
+
+    atf_utils_create_file("binary", "contents");
+    ATF_REQUIRE(utimensat(AT_FDCWD, "binary", times, 0) != -1);
+
+    build_list(&list, atf_tp_list_atf);
+    RE(atf_tp_list_cache_store(&list, "cache", "binary", no_config));
+    atf_tp_list_fini(&list);
+    ATF_REQUIRE(load_cache("binary", atf_tp_list_atf));
+
+    times[1].tv_nsec = 200;
+    ATF_REQUIRE(utimensat(AT_FDCWD, "binary", times, 0) != -1);
+    ATF_REQUIRE(stat("binary", &sb) != -1);
+    if (sb.st_mtim.tv_nsec != 200)
+        atf_tc_skip("The file system does not store sub-second times");
+    ATF_REQUIRE(!load_cache("binary", atf_tp_list_atf));
+#else
+    atf_tc_skip("struct stat has no sub-second modification time");
+#endif
+}
+
+ATF_TC_WITHOUT_HEAD(cache_config);
+ATF_TC_BODY(cache_config, tc)
+{
+    const char *const config[] = { "srcdir", "/a", "var", "1", NULL };
+    const char *const reordered[] = { "var", "1", "srcdir", "/a", NULL };
+    const char *const other_srcdir[] = { "srcdir", "/b", "var", "1", NULL };
+    const char *const other_value[] = { "srcdir", "/a", "var", "2", NULL };
+    const char *const shifted[] = { "srcdir", "/a", "var1", "", NULL };
+    atf_tp_list_t list;
+
+    atf_utils_create_file("binary", "contents");
+
+    build_list(&list, atf_tp_list_atf);
+    RE(atf_tp_list_cache_store(&list, "cache", "binary", config));
+    atf_tp_list_fini(&list);
+
+    ATF_REQUIRE(load_cache_config("binary", config, atf_tp_list_atf));
+    ATF_REQUIRE(load_cache_config("binary", reordered, atf_tp_list_atf));
+    ATF_REQUIRE(!load_cache_config("binary", other_srcdir, atf_tp_list_atf));
+    ATF_REQUIRE(!load_cache_config("binary", other_value, atf_tp_list_atf));
+    ATF_REQUIRE(!load_cache_config("binary", shifted, atf_tp_list_atf));
+    ATF_REQUIRE(!load_cache("binary", atf_tp_list_atf));
+}
+
+ATF_TC_WITHOUT_HEAD(cache_store_error);
+ATF_TC_BODY(cache_store_error, tc)
+{
+    atf_tp_list_t list;
+    atf_error_t err;
+
+    build_list(&list, atf_tp_list_atf);
+
+    err = atf_tp_list_cache_store(&list, "cache", "missing", no_config);
+    ATF_REQUIRE(atf_is_error(err));
+    atf_error_free(err);
+
+    atf_utils_create_file("binary", "contents");
+    err = atf_tp_list_cache_store(&list, "nonexistent/cache", "binary", no_config);
+    ATF_REQUIRE(atf_is_error(err));
+    atf_error_free(err);
+
+    atf_tp_list_fini(&list);
+}
+
+/* ---------------------------------------------------------------------
+ * Main.
+ * --------------------------------------------------------------------- */
+
+ATF_TP_ADD_TCS(tp)
+{
+    ATF_TP_ADD_TC(tp, atf_format);
+    ATF_TP_ADD_TC(tp, json_format);
+    ATF_TP_ADD_TC(tp, json_format_empty);
+    ATF_TP_ADD_TC(tp, binary_format);
+
+    ATF_TP_ADD_TC(tp, parse_format);
+    ATF_TP_ADD_TC(tp, cache);
+    ATF_TP_ADD_TC(tp, cache_mtime_nsec);
+    ATF_TP_ADD_TC(tp, cache_config);
+    ATF_TP_ADD_TC(tp, cache_store_error);
+
+    return atf_no_error();
+}
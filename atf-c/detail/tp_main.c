@@ -28,17 +28,22 @@
 #endif
 
 #include <ctype.h>
+#include <limits.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
+#include "atf-c/detail/batch.h"
 #include "atf-c/detail/dynstr.h"
 #include "atf-c/detail/env.h"
 #include "atf-c/detail/fs.h"
 #include "atf-c/detail/map.h"
 #include "atf-c/detail/sanity.h"
+#include "atf-c/detail/server.h"
+#include "atf-c/detail/text.h"
+#include "atf-c/detail/tp_list.h"
 #include "atf-c/error.h"
 #include "atf-c/tc.h"
 #include "atf-c/tp.h"
@@ -52,10 +57,19 @@
 
 static const char *progname = NULL;
 
-/* This prototype is provided by macros.h during instantiation of the test
- * program, so it can be kept private.  Don't know if that's the best idea
- * though. */
+/* These prototypes are provided by macros.h during instantiation of the
+ * test program, so they can be kept private.  Don't know if that's the best
+ * idea though. */
 int atf_tp_main(int, char **, atf_error_t (*)(atf_tp_t *));
+int atf_tp_main_descs(int, char **, atf_error_t (*)(atf_tp_t *),
+                      atf_tc_desc_t *const *, atf_tc_desc_t *const *);
+
+/* The descriptors of the test cases registered at compile time, which live
+ * in a dedicated section of the test program. */
+struct tc_descs {
+    atf_tc_desc_t *const *m_begin;
+    atf_tc_desc_t *const *m_end;
+};
 
 enum tc_part {
     BODY,
@@ -130,16 +144,37 @@ print_warning(const char *message)
     fprintf(stderr, "%s: WARNING: %s\n", progname, message);
 }
 
+static
+void
+warn_if_unsupervised(void)
+{
+    if (!atf_env_has("__RUNNING_INSIDE_ATF_RUN") || strcmp(atf_env_get(
+        "__RUNNING_INSIDE_ATF_RUN"), "internal-yes-value") != 0)
+    {
+        print_warning("Running test cases outside of kyua(1) is unsupported");
+        print_warning("No isolation nor timeout control is being applied; you "
+                      "may get unexpected failures; see atf-test-case(4)");
+    }
+}
+
 /* ---------------------------------------------------------------------
  * Options handling.
  * --------------------------------------------------------------------- */
 
 struct params {
     bool m_do_list;
+    enum atf_tp_list_format m_list_format;
+    const char *m_cachefile;  /* NULL if the listing is not cached. */
+    bool m_do_batch;
+    bool m_do_server;
     atf_fs_path_t m_srcdir;
     char *m_tcname;
     enum tc_part m_tcpart;
     atf_fs_path_t m_resfile;
+    atf_fs_path_t m_resdir;  /* Valid if m_do_batch. */
+    char *const *m_batch_tcnames;
+    int m_batch_ntcnames;
+    unsigned int m_jobs;
     atf_map_t m_config;
 };
 
@@ -168,8 +203,15 @@ params_init(struct params *p, const char *argv0)
     atf_error_t err;
 
     p->m_do_list = false;
+    p->m_list_format = atf_tp_list_atf;
+    p->m_cachefile = NULL;
+    p->m_do_batch = false;
+    p->m_do_server = false;
     p->m_tcname = NULL;
     p->m_tcpart = BODY;
+    p->m_batch_tcnames = NULL;
+    p->m_batch_ntcnames = 0;
+    p->m_jobs = 1;
 
     err = argv0_to_dir(argv0, &p->m_srcdir);
     if (atf_is_error(err))
@@ -196,6 +238,8 @@ void
 params_fini(struct params *p)
 {
     atf_map_fini(&p->m_config);
+    if (p->m_do_batch)
+        atf_fs_path_fini(&p->m_resdir);
     atf_fs_path_fini(&p->m_resfile);
     atf_fs_path_fini(&p->m_srcdir);
     if (p->m_tcname != NULL)
@@ -240,46 +284,296 @@ replace_path_param(atf_fs_path_t *param, const char *value)
     return err;
 }
 
+static
+atf_error_t
+set_resdir_param(struct params *p, const char *value)
+{
+    atf_error_t err;
+
+    if (p->m_do_batch)
+        err = replace_path_param(&p->m_resdir, value);
+    else {
+        err = atf_fs_path_init_fmt(&p->m_resdir, "%s", value);
+        if (!atf_is_error(err))
+            p->m_do_batch = true;
+    }
+
+    return err;
+}
+
+static
+atf_error_t
+parse_jflag(const char *arg, unsigned int *jobs)
+{
+    atf_error_t err;
+    long value;
+
+    err = atf_text_to_long(arg, &value);
+    if (atf_is_error(err)) {
+        atf_error_free(err);
+        value = 0;
+    }
+
+    if (value <= 0 || value > UINT_MAX / 2)
+        err = usage_error("-j requires a positive integer; got `%s'", arg);
+    else {
+        *jobs = (unsigned int)value;
+        err = atf_no_error();
+    }
+
+    return err;
+}
+
 /* ---------------------------------------------------------------------
  * Test case listing.
  * --------------------------------------------------------------------- */
 
 static
-void
-list_tcs(const atf_tp_t *tp)
+atf_error_t
+list_tc(atf_tp_list_t *list, const atf_tc_t *tc)
 {
+    atf_error_t err;
+    char **vars;
+    char **ptr;
+
+    vars = atf_tc_get_md_vars(tc);
+    if (vars == NULL)
+        return atf_no_memory_error();
+
+    err = atf_tp_list_start_tc(list, atf_tc_get_ident(tc));
+    for (ptr = vars; !atf_is_error(err) && *ptr != NULL; ptr += 2) {
+        if (strcmp(*ptr, "ident") != 0)
+            err = atf_tp_list_tc_md(list, *ptr, *(ptr + 1));
+    }
+    if (!atf_is_error(err))
+        err = atf_tp_list_end_tc(list);
+
+    atf_utils_free_charpp(vars);
+    return err;
+}
+
+/* Lists a test case registered at compile time straight from its
+ * descriptor, without initializing the test case. */
+static
+atf_error_t
+list_tc_desc(atf_tp_list_t *list, const atf_tc_desc_t *desc)
+{
+    atf_error_t err;
+    const char *const *ptr;
+
+    err = atf_tp_list_start_tc(list, desc->m_ident);
+    if (!atf_is_error(err) && desc->m_cleanup != NULL)
+        err = atf_tp_list_tc_md(list, "has.cleanup", "true");
+    for (ptr = desc->m_md + 2; !atf_is_error(err) && *ptr != NULL; ptr += 2)
+        err = atf_tp_list_tc_md(list, *ptr, *(ptr + 1));
+    if (!atf_is_error(err))
+        err = atf_tp_list_end_tc(list);
+
+    return err;
+}
+
+static
+atf_error_t
+list_tcs(const atf_tp_t *tp, const struct tc_descs *descs,
+         const struct params *p, const char *binary,
+         const char *const *config)
+{
+    atf_error_t err;
+    atf_tp_list_t list;
     const atf_tc_t **tcs;
     const atf_tc_t *const *tcsptr;
+    atf_tc_desc_t *const *descptr;
 
-    printf("Content-Type: application/X-atf-tp; version=\"1\"\n\n");
+    err = atf_tp_list_init(&list, p->m_list_format);
+    if (atf_is_error(err))
+        goto out;
 
     tcs = atf_tp_get_tcs(tp);
-    INV(tcs != NULL);  /* Should be checked. */
-    for (tcsptr = tcs; *tcsptr != NULL; tcsptr++) {
-        const atf_tc_t *tc = *tcsptr;
-        char **vars = atf_tc_get_md_vars(tc);
-        char **ptr;
+    if (tcs == NULL) {
+        err = atf_no_memory_error();
+        goto out_list;
+    }
+    for (tcsptr = tcs; !atf_is_error(err) && *tcsptr != NULL; tcsptr++)
+        err = list_tc(&list, *tcsptr);
+    free(tcs);
+
+    /* A test case registered at run time takes precedence over a static
+     * descriptor with the same name, as it does when running it. */
+    for (descptr = descs->m_begin;
+         !atf_is_error(err) && descptr != descs->m_end; descptr++) {
+        if (!atf_tp_has_tc(tp, (*descptr)->m_ident))
+            err = list_tc_desc(&list, *descptr);
+    }
 
-        INV(vars != NULL);  /* Should be checked. */
+    if (!atf_is_error(err))
+        err = atf_tp_list_finish(&list);
+    if (!atf_is_error(err))
+        err = atf_tp_list_write(&list, stdout);
 
-        if (tcsptr != tcs)  /* Not first. */
-            printf("\n");
+    if (!atf_is_error(err) && p->m_cachefile != NULL) {
+        atf_error_t err2 = atf_tp_list_cache_store(&list, p->m_cachefile,
+                                                   binary, config);
+        if (atf_is_error(err2)) {
+            char buf[4096];
 
-        for (ptr = vars; *ptr != NULL; ptr += 2) {
-            if (strcmp(*ptr, "ident") == 0) {
-                printf("ident: %s\n", *(ptr + 1));
-                break;
-            }
+            atf_error_format(err2, buf, sizeof(buf));
+            print_warning(buf);
+            atf_error_free(err2);
         }
+    }
 
-        for (ptr = vars; *ptr != NULL; ptr += 2) {
-            if (strcmp(*ptr, "ident") != 0) {
-                printf("%s: %s\n", *ptr, *(ptr + 1));
-            }
+out_list:
+    atf_tp_list_fini(&list);
+out:
+    return err;
+}
+
+/* ---------------------------------------------------------------------
+ * Static test cases.
+ * --------------------------------------------------------------------- */
+
+static
+atf_error_t
+add_desc_tc(atf_tp_t *tp, const struct tc_descs *descs, const char *tcname)
+{
+    atf_tc_desc_t *const *descptr;
+
+    if (atf_tp_has_tc(tp, tcname))
+        return atf_no_error();
+
+    for (descptr = descs->m_begin; descptr != descs->m_end; descptr++) {
+        if (strcmp((*descptr)->m_ident, tcname) == 0)
+            return atf_tp_add_tc_desc(tp, *descptr);
+    }
+    return atf_no_error();
+}
+
+/* Initializes the test cases registered at compile time that the requested
+ * operation needs, which is none of them when running a single test case
+ * that was registered at run time. */
+static
+atf_error_t
+add_desc_tcs(atf_tp_t *tp, const struct params *p,
+             const struct tc_descs *descs)
+{
+    atf_error_t err;
+    int i;
+
+    err = atf_no_error();
+    if (p->m_do_server || (p->m_do_batch && p->m_batch_ntcnames == 1 &&
+                           strcmp(p->m_batch_tcnames[0], "all") == 0)) {
+        atf_tc_desc_t *const *descptr;
+
+        for (descptr = descs->m_begin;
+             !atf_is_error(err) && descptr != descs->m_end; descptr++) {
+            err = add_desc_tc(tp, descs, (*descptr)->m_ident);
         }
+    } else if (p->m_do_batch) {
+        for (i = 0; !atf_is_error(err) && i < p->m_batch_ntcnames; i++)
+            err = add_desc_tc(tp, descs, p->m_batch_tcnames[i]);
+    } else {
+        err = add_desc_tc(tp, descs, p->m_tcname);
+    }
+
+    return err;
+}
+
+/* ---------------------------------------------------------------------
+ * Batch execution.
+ * --------------------------------------------------------------------- */
+
+static
+atf_error_t
+batch_collect_tcs(const atf_tp_t *tp, const struct params *p,
+                  const atf_tc_t ***tcsp)
+{
+    atf_error_t err;
+    const atf_tc_t **tcs;
+    int i;
+
+    if (p->m_batch_ntcnames == 1 && strcmp(p->m_batch_tcnames[0], "all") == 0)
+    {
+        tcs = atf_tp_get_tcs(tp);
+        if (tcs == NULL)
+            return atf_no_memory_error();
+        *tcsp = tcs;
+        return atf_no_error();
+    }
+
+    tcs = malloc(sizeof(const atf_tc_t *) * (p->m_batch_ntcnames + 1));
+    if (tcs == NULL)
+        return atf_no_memory_error();
+
+    err = atf_no_error();
+    for (i = 0; i < p->m_batch_ntcnames; i++) {
+        const char *tcname = p->m_batch_tcnames[i];
 
-        atf_utils_free_charpp(vars);
+        if (strchr(tcname, ':') != NULL) {
+            err = usage_error("Cannot select a test case part in batch "
+                              "mode (`%s')", tcname);
+            break;
+        } else if (!atf_tp_has_tc(tp, tcname)) {
+            err = usage_error("Unknown test case `%s'", tcname);
+            break;
+        }
+        tcs[i] = atf_tp_get_tc(tp, tcname);
     }
+    tcs[i] = NULL;
+
+    if (atf_is_error(err))
+        free(tcs);
+    else
+        *tcsp = tcs;
+    return err;
+}
+
+static
+atf_error_t
+run_batch(const atf_tp_t *tp, struct params *p, int *exitcode)
+{
+    atf_error_t err;
+    const atf_tc_t **tcs;
+    bool success;
+
+    tcs = NULL;  /* Silence GCC warning. */
+    err = batch_collect_tcs(tp, p, &tcs);
+    if (atf_is_error(err))
+        goto out;
+
+    warn_if_unsupervised();
+
+    err = atf_batch_run(tcs, &p->m_resdir, p->m_jobs, &success);
+    if (!atf_is_error(err))
+        *exitcode = success ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    free(tcs);
+out:
+    return err;
+}
+
+/* ---------------------------------------------------------------------
+ * Server mode.
+ * --------------------------------------------------------------------- */
+
+static
+atf_error_t
+run_server(const atf_tp_t *tp, int *exitcode)
+{
+    atf_error_t err;
+    const atf_tc_t **tcs;
+
+    tcs = atf_tp_get_tcs(tp);
+    if (tcs == NULL)
+        return atf_no_memory_error();
+
+    warn_if_unsupervised();
+
+    err = atf_server_run(tcs, stdin, stdout);
+    if (!atf_is_error(err))
+        *exitcode = EXIT_SUCCESS;
+
+    free(tcs);
+    return err;
 }
 
 /* ---------------------------------------------------------------------
@@ -326,22 +620,48 @@ process_params(int argc, char **argv, struct params *p)
     atf_error_t err;
     int ch;
     int old_opterr;
+    bool Fflag, jflag, rflag;
 
     err = params_init(p, argv[0]);
     if (atf_is_error(err))
         goto out;
 
+    Fflag = jflag = rflag = false;
     old_opterr = opterr;
     opterr = 0;
     while (!atf_is_error(err) &&
-           (ch = getopt(argc, argv, GETOPT_POSIX ":lr:s:v:")) != -1) {
+           (ch = getopt(argc, argv, GETOPT_POSIX ":C:F:j:lR:r:Ss:v:")) != -1) {
         switch (ch) {
+        case 'C':
+            p->m_cachefile = optarg;
+            break;
+
+        case 'F':
+            if (!atf_tp_list_parse_format(optarg, &p->m_list_format))
+                err = usage_error("Unknown listing format `%s'", optarg);
+            Fflag = true;
+            break;
+
+        case 'j':
+            err = parse_jflag(optarg, &p->m_jobs);
+            jflag = true;
+            break;
+
         case 'l':
             p->m_do_list = true;
             break;
 
+        case 'R':
+            err = set_resdir_param(p, optarg);
+            break;
+
         case 'r':
             err = replace_path_param(&p->m_resfile, optarg);
+            rflag = true;
+            break;
+
+        case 'S':
+            p->m_do_server = true;
             break;
 
         case 's':
@@ -372,9 +692,38 @@ process_params(int argc, char **argv, struct params *p)
 #endif
 
     if (!atf_is_error(err)) {
-        if (p->m_do_list) {
+        if (jflag && !p->m_do_batch) {
+            err = usage_error("Cannot provide -j without -R");
+        } else if (Fflag && !p->m_do_list) {
+            err = usage_error("Cannot provide -F without -l");
+        } else if (p->m_cachefile != NULL && !p->m_do_list) {
+            err = usage_error("Cannot provide -C without -l");
+        } else if (p->m_do_list) {
             if (argc > 0)
                 err = usage_error("Cannot provide test case names with -l");
+            else if (p->m_do_batch)
+                err = usage_error("Cannot provide -R with -l");
+            else if (p->m_do_server)
+                err = usage_error("Cannot provide -S with -l");
+        } else if (p->m_do_server) {
+            if (argc > 0)
+                err = usage_error("Cannot provide test case names with -S");
+            else if (p->m_do_batch)
+                err = usage_error("Cannot provide -R with -S");
+            else if (rflag)
+                err = usage_error("Cannot provide -r with -S; each request "
+                                  "names its own results file");
+        } else if (p->m_do_batch) {
+            if (argc == 0)
+                err = usage_error("Must provide at least one test case name "
+                                  "or `all'");
+            else if (rflag)
+                err = usage_error("Cannot provide -r with -R; results are "
+                                  "stored in the results directory");
+            else {
+                p->m_batch_tcnames = argv;
+                p->m_batch_ntcnames = argc;
+            }
         } else {
             if (argc == 0)
                 err = usage_error("Must provide a test case name");
@@ -491,13 +840,7 @@ run_tc(const atf_tp_t *tp, struct params *p, int *exitcode)
         goto out;
     }
 
-    if (!atf_env_has("__RUNNING_INSIDE_ATF_RUN") || strcmp(atf_env_get(
-        "__RUNNING_INSIDE_ATF_RUN"), "internal-yes-value") != 0)
-    {
-        print_warning("Running test cases outside of kyua(1) is unsupported");
-        print_warning("No isolation nor timeout control is being applied; you "
-                      "may get unexpected failures; see atf-test-case(4)");
-    }
+    warn_if_unsupervised();
 
     switch (p->m_tcpart) {
     case BODY:
@@ -537,7 +880,7 @@ static
 atf_error_t
 controlled_main(int argc, char **argv,
                 atf_error_t (*add_tcs_hook)(atf_tp_t *),
-                int *exitcode)
+                const struct tc_descs *descs, int *exitcode)
 {
     atf_error_t err;
     struct params p;
@@ -557,25 +900,46 @@ controlled_main(int argc, char **argv,
         err = atf_no_memory_error();
         goto out_p;
     }
+
+    if (p.m_do_list && p.m_cachefile != NULL &&
+        atf_tp_list_cache_load(p.m_cachefile,
+                               atf_tp_list_cache_binary(argv[0]),
+                               (const char *const *)raw_config,
+                               p.m_list_format, stdout)) {
+        *exitcode = EXIT_SUCCESS;
+        goto out_raw_config;
+    }
+
     err = atf_tp_init(&tp, (const char* const*)raw_config);
-    atf_utils_free_charpp(raw_config);
     if (atf_is_error(err))
-        goto out_p;
+        goto out_raw_config;
 
     err = add_tcs_hook(&tp);
     if (atf_is_error(err))
         goto out_tp;
 
+    if (!p.m_do_list) {
+        err = add_desc_tcs(&tp, &p, descs);
+        if (atf_is_error(err))
+            goto out_tp;
+    }
+
     if (p.m_do_list) {
-        list_tcs(&tp);
-        INV(!atf_is_error(err));
+        err = list_tcs(&tp, descs, &p, atf_tp_list_cache_binary(argv[0]),
+                       (const char *const *)raw_config);
         *exitcode = EXIT_SUCCESS;
+    } else if (p.m_do_server) {
+        err = run_server(&tp, exitcode);
+    } else if (p.m_do_batch) {
+        err = run_batch(&tp, &p, exitcode);
     } else {
         err = run_tc(&tp, &p, exitcode);
     }
 
 out_tp:
     atf_tp_fini(&tp);
+out_raw_config:
+    atf_utils_free_charpp(raw_config);
 out_p:
     params_fini(&p);
 out:
@@ -585,9 +949,22 @@ out:
 int
 atf_tp_main(int argc, char **argv, atf_error_t (*add_tcs_hook)(atf_tp_t *))
 {
+    return atf_tp_main_descs(argc, argv, add_tcs_hook, NULL, NULL);
+}
+
+int
+atf_tp_main_descs(int argc, char **argv,
+                  atf_error_t (*add_tcs_hook)(atf_tp_t *),
+                  atf_tc_desc_t *const *descs_begin,
+                  atf_tc_desc_t *const *descs_end)
+{
+    struct tc_descs descs;
     atf_error_t err;
     int exitcode;
 
+    descs.m_begin = descs_begin;
+    descs.m_end = descs_end;
+
     progname = strrchr(argv[0], '/');
     if (progname == NULL)
         progname = argv[0];
@@ -601,7 +978,7 @@ atf_tp_main(int argc, char **argv, atf_error_t (*add_tcs_hook)(atf_tp_t *))
         progname += 3;
 
     exitcode = EXIT_FAILURE; /* Silence GCC warning. */
-    err = controlled_main(argc, argv, add_tcs_hook, &exitcode);
+    err = controlled_main(argc, argv, add_tcs_hook, &descs, &exitcode);
     if (atf_is_error(err)) {
         print_error(err);
         atf_error_free(err);
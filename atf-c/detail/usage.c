@@ -0,0 +1,214 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/usage.h"
+
+#include <sys/stat.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "atf-c/detail/dynstr.h"
+#include "atf-c/detail/sanity.h"
+#include "atf-c/error.h"
+
+/* The usage of a test case is stored next to its results file, in a file
+ * named after it with a ".usage" suffix, as a list of "name: value" lines.
+ * Consumers that do not know about this file are not affected by it. */
+
+/* ---------------------------------------------------------------------
+ * Auxiliary functions.
+ * --------------------------------------------------------------------- */
+
+static
+int64_t
+timeval_usec(const struct timeval *tv)
+{
+    return (int64_t)tv->tv_sec * 1000000 + tv->tv_usec;
+}
+
+/* Returns the size of the file behind 'fd' if it is a regular file. */
+static
+int64_t
+output_size(const int fd)
+{
+    struct stat sb;
+
+    if (fd == -1 || fstat(fd, &sb) == -1 || !S_ISREG(sb.st_mode))
+        return -1;
+    return (int64_t)sb.st_size;
+}
+
+static
+int64_t
+output_delta(const int fd, const int64_t start)
+{
+    const int64_t size = output_size(fd);
+
+    if (start == -1 || size == -1 || size < start)
+        return -1;
+    return size - start;
+}
+
+static
+long
+maxrss_kb(const struct rusage *ru)
+{
+#if defined(__APPLE__)
+    return ru->ru_maxrss / 1024;  /* Reported in bytes. */
+#else
+    return ru->ru_maxrss;
+#endif
+}
+
+/* Fills in the fields of 'u' that do not depend on how the CPU usage was
+ * obtained. */
+static
+void
+fill_common(const atf_usage_mark_t *m, atf_usage_t *u)
+{
+    struct timespec now;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &now) == -1)
+        UNREACHABLE;
+    u->m_wall_usec = (int64_t)(now.tv_sec - m->m_start.tv_sec) * 1000000 +
+        (now.tv_nsec - m->m_start.tv_nsec) / 1000;
+
+    u->m_stdout_bytes = output_delta(m->m_outfd, m->m_stdout_size);
+    u->m_stderr_bytes = output_delta(m->m_errfd, m->m_stderr_size);
+}
+
+/* ---------------------------------------------------------------------
+ * The "atf_usage" type.
+ * --------------------------------------------------------------------- */
+
+/* Starts accounting resources now.  'outfd' and 'errfd' are the
+ * descriptors that receive the output of the test case, or -1 if it is
+ * not to be accounted. */
+void
+atf_usage_mark_init(atf_usage_mark_t *m, const int outfd, const int errfd)
+{
+    if (clock_gettime(CLOCK_MONOTONIC, &m->m_start) == -1)
+        UNREACHABLE;
+    if (getrusage(RUSAGE_SELF, &m->m_self) == -1)
+        UNREACHABLE;
+    if (getrusage(RUSAGE_CHILDREN, &m->m_children) == -1)
+        UNREACHABLE;
+
+    m->m_outfd = outfd;
+    m->m_errfd = errfd;
+    m->m_stdout_size = output_size(outfd);
+    m->m_stderr_size = output_size(errfd);
+}
+
+/* Computes the resources consumed by the current process, and by the
+ * children it has waited for, since the mark was set.  The peak RSS is
+ * that of the whole life of the process, as it cannot be reset. */
+void
+atf_usage_since_self(const atf_usage_mark_t *m, atf_usage_t *u)
+{
+    struct rusage self, children;
+
+    if (getrusage(RUSAGE_SELF, &self) == -1)
+        UNREACHABLE;
+    if (getrusage(RUSAGE_CHILDREN, &children) == -1)
+        UNREACHABLE;
+
+    fill_common(m, u);
+    u->m_user_usec =
+        timeval_usec(&self.ru_utime) - timeval_usec(&m->m_self.ru_utime) +
+        timeval_usec(&children.ru_utime) -
+        timeval_usec(&m->m_children.ru_utime);
+    u->m_system_usec =
+        timeval_usec(&self.ru_stime) - timeval_usec(&m->m_self.ru_stime) +
+        timeval_usec(&children.ru_stime) -
+        timeval_usec(&m->m_children.ru_stime);
+    u->m_maxrss_kb = maxrss_kb(&self) > maxrss_kb(&children) ?
+        maxrss_kb(&self) : maxrss_kb(&children);
+    u->m_nvcsw = (self.ru_nvcsw - m->m_self.ru_nvcsw) +
+        (children.ru_nvcsw - m->m_children.ru_nvcsw);
+    u->m_nivcsw = (self.ru_nivcsw - m->m_self.ru_nivcsw) +
+        (children.ru_nivcsw - m->m_children.ru_nivcsw);
+}
+
+/* Computes the resources consumed by a child process that was started
+ * when the mark was set, given the usage returned by wait4(2). */
+void
+atf_usage_since_child(const atf_usage_mark_t *m, const struct rusage *ru,
+                      atf_usage_t *u)
+{
+    fill_common(m, u);
+    u->m_user_usec = timeval_usec(&ru->ru_utime);
+    u->m_system_usec = timeval_usec(&ru->ru_stime);
+    u->m_maxrss_kb = maxrss_kb(ru);
+    u->m_nvcsw = ru->ru_nvcsw;
+    u->m_nivcsw = ru->ru_nivcsw;
+}
+
+/* Opens the usage file that goes along the given results file. */
+atf_error_t
+atf_usage_open(const char *resfile, int *fd)
+{
+    atf_error_t err;
+    atf_dynstr_t path;
+
+    err = atf_dynstr_init_fmt(&path, "%s.usage", resfile);
+    if (atf_is_error(err))
+        return err;
+
+    *fd = open(atf_dynstr_cstring(&path),
+               O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (*fd == -1)
+        err = atf_libc_error(errno, "Cannot create usage file '%s'",
+                             atf_dynstr_cstring(&path));
+
+    atf_dynstr_fini(&path);
+    return err;
+}
+
+/* Replaces the contents of an open usage file. */
+atf_error_t
+atf_usage_write(const atf_usage_t *u, const int fd)
+{
+    if (ftruncate(fd, 0) == -1 || lseek(fd, 0, SEEK_SET) == -1 ||
+        dprintf(fd, "wall.usec: %" PRId64 "\n"
+                "user.usec: %" PRId64 "\n"
+                "system.usec: %" PRId64 "\n"
+                "maxrss.kb: %ld\n"
+                "nvcsw: %ld\n"
+                "nivcsw: %ld\n",
+                u->m_wall_usec, u->m_user_usec, u->m_system_usec,
+                u->m_maxrss_kb, u->m_nvcsw, u->m_nivcsw) < 0 ||
+        (u->m_stdout_bytes != -1 &&
+         dprintf(fd, "stdout.bytes: %" PRId64 "\n", u->m_stdout_bytes) < 0) ||
+        (u->m_stderr_bytes != -1 &&
+         dprintf(fd, "stderr.bytes: %" PRId64 "\n", u->m_stderr_bytes) < 0))
+        return atf_libc_error(errno, "Cannot write usage file");
+    return atf_no_error();
+}
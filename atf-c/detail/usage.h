@@ -0,0 +1,76 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#if !defined(ATF_C_DETAIL_USAGE_H)
+#define ATF_C_DETAIL_USAGE_H
+
+#include <sys/types.h>
+#include <sys/resource.h>
+
+#include <stdint.h>
+#include <time.h>
+
+#include <atf-c/error_fwd.h>
+
+/* ---------------------------------------------------------------------
+ * The "atf_usage" type.
+ * --------------------------------------------------------------------- */
+
+/* Resources consumed by a test case body.  Times are in microseconds and
+ * the output sizes are -1 when they cannot be determined because the
+ * output does not go to a regular file. */
+struct atf_usage {
+    int64_t m_wall_usec;
+    int64_t m_user_usec;
+    int64_t m_system_usec;
+    long m_maxrss_kb;
+    long m_nvcsw;
+    long m_nivcsw;
+    int64_t m_stdout_bytes;
+    int64_t m_stderr_bytes;
+};
+typedef struct atf_usage atf_usage_t;
+
+/* Starting point from which the usage of a test case is accounted. */
+struct atf_usage_mark {
+    struct timespec m_start;
+    struct rusage m_self;
+    struct rusage m_children;
+    int m_outfd;
+    int m_errfd;
+    int64_t m_stdout_size;
+    int64_t m_stderr_size;
+};
+typedef struct atf_usage_mark atf_usage_mark_t;
+
+void atf_usage_mark_init(atf_usage_mark_t *, const int, const int);
+void atf_usage_since_self(const atf_usage_mark_t *, atf_usage_t *);
+void atf_usage_since_child(const atf_usage_mark_t *, const struct rusage *,
+                           atf_usage_t *);
+
+atf_error_t atf_usage_open(const char *, int *);
+atf_error_t atf_usage_write(const atf_usage_t *, const int);
+
+#endif /* !defined(ATF_C_DETAIL_USAGE_H) */
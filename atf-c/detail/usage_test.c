@@ -0,0 +1,208 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+#include "atf-c/detail/usage.h"
+
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atf-c.h>
+
+#include "atf-c/detail/test_helpers.h"
+#include "atf-c/utils.h"
+
+/* ---------------------------------------------------------------------
+ * Auxiliary functions.
+ * --------------------------------------------------------------------- */
+
+/* Burns at least the given number of milliseconds of CPU time.  Spinning
+ * on the CPU clock rather than on the wall clock guarantees the amount of
+ * CPU time used even if other processes take the CPU away from us. */
+static
+void
+spin(const long msec)
+{
+    struct timespec start, now;
+    volatile unsigned long counter = 0;
+
+    ATF_REQUIRE(clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &start) != -1);
+    do {
+        counter++;
+        ATF_REQUIRE(clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now) != -1);
+    } while ((now.tv_sec - start.tv_sec) * 1000000000L +
+             (now.tv_nsec - start.tv_nsec) < msec * 1000000L);
+}
+
+static
+int
+open_output(const char *path)
+{
+    const int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    ATF_REQUIRE(fd != -1);
+    return fd;
+}
+
+/* ---------------------------------------------------------------------
+ * Tests for the "atf_usage" type.
+ * --------------------------------------------------------------------- */
+
+ATF_TC(since_self);
+ATF_TC_HEAD(since_self, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks that atf_usage_since_self "
+                      "accounts the time and output of the current process");
+}
+ATF_TC_BODY(since_self, tc)
+{
+    atf_usage_mark_t mark;
+    atf_usage_t usage;
+    int outfd;
+
+    outfd = open_output("out");
+    ATF_REQUIRE(write(outfd, "before\n", 7) == 7);
+
+    atf_usage_mark_init(&mark, outfd, -1);
+    spin(200);
+    ATF_REQUIRE(write(outfd, "12345", 5) == 5);
+    atf_usage_since_self(&mark, &usage);
+
+    ATF_CHECK(usage.m_wall_usec >= 200000);
+    ATF_CHECK(usage.m_user_usec + usage.m_system_usec >= 100000);
+    ATF_CHECK(usage.m_maxrss_kb > 0);
+    ATF_CHECK_EQ(5, usage.m_stdout_bytes);
+    ATF_CHECK_EQ(-1, usage.m_stderr_bytes);
+
+    close(outfd);
+}
+
+ATF_TC(since_child);
+ATF_TC_HEAD(since_child, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks that atf_usage_since_child "
+                      "accounts the usage returned by wait4");
+}
+ATF_TC_BODY(since_child, tc)
+{
+    atf_usage_mark_t mark;
+    atf_usage_t usage;
+    struct rusage ru;
+    int errfd, status;
+    pid_t pid;
+
+    errfd = open_output("err");
+
+    atf_usage_mark_init(&mark, -1, errfd);
+    pid = fork();
+    ATF_REQUIRE(pid != -1);
+    if (pid == 0) {
+        spin(200);
+        if (write(errfd, "abc", 3) != 3)
+            _exit(EXIT_FAILURE);
+        _exit(EXIT_SUCCESS);
+    }
+    ATF_REQUIRE_EQ(pid, wait4(pid, &status, 0, &ru));
+    ATF_REQUIRE(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS);
+    atf_usage_since_child(&mark, &ru, &usage);
+
+    ATF_CHECK(usage.m_wall_usec >= 200000);
+    ATF_CHECK(usage.m_user_usec + usage.m_system_usec >= 100000);
+    ATF_CHECK_EQ(-1, usage.m_stdout_bytes);
+    ATF_CHECK_EQ(3, usage.m_stderr_bytes);
+
+    close(errfd);
+}
+
+ATF_TC(write);
+ATF_TC_HEAD(write, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks the format of the usage file");
+}
+ATF_TC_BODY(write, tc)
+{
+    atf_usage_t usage;
+    int fd;
+
+    usage.m_wall_usec = 1500000;
+    usage.m_user_usec = 1000;
+    usage.m_system_usec = 2000;
+    usage.m_maxrss_kb = 4096;
+    usage.m_nvcsw = 3;
+    usage.m_nivcsw = 4;
+    usage.m_stdout_bytes = 10;
+    usage.m_stderr_bytes = -1;
+
+    atf_utils_create_file("result.usage", "%s", "garbage that is longer than "
+                          "the usage to make sure it gets truncated\n");
+    RE(atf_usage_open("result", &fd));
+    RE(atf_usage_write(&usage, fd));
+    close(fd);
+
+    ATF_REQUIRE(atf_utils_compare_file("result.usage",
+        "wall.usec: 1500000\n"
+        "user.usec: 1000\n"
+        "system.usec: 2000\n"
+        "maxrss.kb: 4096\n"
+        "nvcsw: 3\n"
+        "nivcsw: 4\n"
+        "stdout.bytes: 10\n"));
+}
+
+ATF_TC(open_error);
+ATF_TC_HEAD(open_error, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Checks that atf_usage_open reports "
+                      "errors");
+}
+ATF_TC_BODY(open_error, tc)
+{
+    atf_error_t err;
+    int fd;
+
+    err = atf_usage_open("missing/result", &fd);
+    ATF_REQUIRE(atf_is_error(err));
+    ATF_REQUIRE(atf_error_is(err, "libc"));
+    atf_error_free(err);
+}
+
+/* ---------------------------------------------------------------------
+ * Main.
+ * --------------------------------------------------------------------- */
+
+ATF_TP_ADD_TCS(tp)
+{
+    ATF_TP_ADD_TC(tp, since_self);
+    ATF_TP_ADD_TC(tp, since_child);
+    ATF_TP_ADD_TC(tp, write);
+    ATF_TP_ADD_TC(tp, open_error);
+
+    return atf_no_error();
+}
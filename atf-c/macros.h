@@ -73,6 +73,50 @@
         .m_cleanup = atfu_ ## tc ## _cleanup, \
     }
 
+#if ATF_DEFS_HAVE_TC_SECTION
+#define ATF_TC_DESC_REGISTER(tc) \
+    static atf_tc_desc_t *const atfu_ ## tc ## _tc_desc_ptr \
+        __attribute__((__used__, __section__("atf_tcs"))) = \
+        &atfu_ ## tc ## _tc_desc
+#define ATF_TC_DESCS_DECLARE \
+    extern atf_tc_desc_t *const __start_atf_tcs[] __attribute__((__weak__)); \
+    extern atf_tc_desc_t *const __stop_atf_tcs[] __attribute__((__weak__))
+#define ATF_TC_DESCS_BEGIN __start_atf_tcs
+#define ATF_TC_DESCS_END __stop_atf_tcs
+#else
+#define ATF_TC_DESC_REGISTER(tc) \
+    typedef char atfu_ ## tc ## _static_tcs_not_supported[-1]
+#define ATF_TC_DESCS_DECLARE \
+    extern int atfu_no_tc_descs
+#define ATF_TC_DESCS_BEGIN NULL
+#define ATF_TC_DESCS_END NULL
+#endif
+
+#define ATF_TC_STATIC_DESC(tc, cleanup, ...) \
+    static atf_tc_t atfu_ ## tc ## _tc; \
+    static const char *const atfu_ ## tc ## _tc_md[] = { \
+        "ident", #tc, ##__VA_ARGS__, NULL, NULL }; \
+    typedef char atfu_ ## tc ## _tc_md_unpaired[ \
+        (sizeof(atfu_ ## tc ## _tc_md) / sizeof(const char *)) % 2 == 0 ? \
+        1 : -1]; \
+    static atf_tc_desc_t atfu_ ## tc ## _tc_desc = { \
+        .m_ident = #tc, \
+        .m_md = atfu_ ## tc ## _tc_md, \
+        .m_body = atfu_ ## tc ## _body, \
+        .m_cleanup = cleanup, \
+        .m_tc = &atfu_ ## tc ## _tc, \
+    }; \
+    ATF_TC_DESC_REGISTER(tc)
+
+#define ATF_TC_STATIC(tc, ...) \
+    static void atfu_ ## tc ## _body(const atf_tc_t *); \
+    ATF_TC_STATIC_DESC(tc, NULL, ##__VA_ARGS__)
+
+#define ATF_TC_STATIC_WITH_CLEANUP(tc, ...) \
+    static void atfu_ ## tc ## _body(const atf_tc_t *); \
+    static void atfu_ ## tc ## _cleanup(const atf_tc_t *); \
+    ATF_TC_STATIC_DESC(tc, atfu_ ## tc ## _cleanup, ##__VA_ARGS__)
+
 #define ATF_TC_HEAD(tc, tcptr) \
     static \
     void \
@@ -97,14 +141,52 @@
 #define ATF_TC_CLEANUP_NAME(tc) \
     (atfu_ ## tc ## _cleanup)
 
+#define ATF_BENCH_DEFINE(tc, head) \
+    static void atfu_ ## tc ## _bench(const atf_tc_t *, const size_t); \
+    static void atfu_ ## tc ## _bench_head(atf_tc_t *tcptr) \
+    { \
+        head; \
+        atf_tc_mark_as_bench(tcptr); \
+    } \
+    static void atfu_ ## tc ## _body(const atf_tc_t *tcptr) \
+    { \
+        atf_tc_run_bench(tcptr, atfu_ ## tc ## _bench); \
+    } \
+    static atf_tc_t atfu_ ## tc ## _tc; \
+    static atf_tc_pack_t atfu_ ## tc ## _tc_pack = { \
+        .m_ident = #tc, \
+        .m_head = atfu_ ## tc ## _bench_head, \
+        .m_body = atfu_ ## tc ## _body, \
+        .m_cleanup = NULL, \
+    }
+
+#define ATF_BENCH_WITHOUT_HEAD(tc) \
+    ATF_BENCH_DEFINE(tc, (void)0)
+
+#define ATF_BENCH(tc) \
+    static void atfu_ ## tc ## _head(atf_tc_t *); \
+    ATF_BENCH_DEFINE(tc, atfu_ ## tc ## _head(tcptr))
+
+#define ATF_BENCH_HEAD(tc, tcptr) \
+    ATF_TC_HEAD(tc, tcptr)
+
+#define ATF_BENCH_BODY(tc, tcptr, iterations) \
+    static \
+    void \
+    atfu_ ## tc ## _bench(const atf_tc_t *tcptr ATF_DEFS_ATTRIBUTE_UNUSED, \
+                          const size_t iterations)
+
 #define ATF_TP_ADD_TCS(tps) \
     static atf_error_t atfu_tp_add_tcs(atf_tp_t *); \
-    int atf_tp_main(int, char **, atf_error_t (*)(atf_tp_t *)); \
+    int atf_tp_main_descs(int, char **, atf_error_t (*)(atf_tp_t *), \
+                          atf_tc_desc_t *const *, atf_tc_desc_t *const *); \
+    ATF_TC_DESCS_DECLARE; \
     \
     int \
     main(int argc, char **argv) \
     { \
-        return atf_tp_main(argc, argv, atfu_tp_add_tcs); \
+        return atf_tp_main_descs(argc, argv, atfu_tp_add_tcs, \
+                                 ATF_TC_DESCS_BEGIN, ATF_TC_DESCS_END); \
     } \
     static \
     atf_error_t \
@@ -113,16 +195,8 @@
 #define ATF_TP_ADD_TC(tp, tc) \
     do { \
         atf_error_t atfu_err; \
-        char **atfu_config = atf_tp_get_config(tp); \
-        if (atfu_config == NULL) \
-            return atf_no_memory_error(); \
-        atfu_err = atf_tc_init_pack(&atfu_ ## tc ## _tc, \
-                                    &atfu_ ## tc ## _tc_pack, \
-                                    (const char *const *)atfu_config); \
-        atf_utils_free_charpp(atfu_config); \
-        if (atf_is_error(atfu_err)) \
-            return atfu_err; \
-        atfu_err = atf_tp_add_tc(tp, &atfu_ ## tc ## _tc); \
+        atfu_err = atf_tp_add_tc_pack(tp, &atfu_ ## tc ## _tc, \
+                                      &atfu_ ## tc ## _tc_pack); \
         if (atf_is_error(atfu_err)) \
             return atfu_err; \
     } while (0)
@@ -228,4 +302,23 @@
 #define ATF_REQUIRE_ERRNO(exp_errno, bool_expr) \
     atf_tc_require_errno(__FILE__, __LINE__, exp_errno, #bool_expr, bool_expr)
 
+/* The block following these macros runs 'repeat' times and must not be
+ * left with break, goto or return. */
+#define ATF_TIMED_BLOCK(fatal, msec, repeat) \
+    for (atf_tc_timing_t atfu_timing = atf_tc_timing_start(__FILE__, \
+             __LINE__, fatal, msec, repeat); \
+         atf_tc_timing_next(&atfu_timing); )
+
+#define ATF_CHECK_WITHIN(msec) \
+    ATF_TIMED_BLOCK(false, msec, 1)
+
+#define ATF_REQUIRE_WITHIN(msec) \
+    ATF_TIMED_BLOCK(true, msec, 1)
+
+#define ATF_CHECK_FASTER_THAN(msec, repeat) \
+    ATF_TIMED_BLOCK(false, msec, repeat)
+
+#define ATF_REQUIRE_FASTER_THAN(msec, repeat) \
+    ATF_TIMED_BLOCK(true, msec, repeat)
+
 #endif /* !defined(ATF_C_MACROS_H) */
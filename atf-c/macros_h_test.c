@@ -29,6 +29,7 @@ void atf_require_inside_if(void);
 void atf_require_equal_inside_if(void);
 void atf_check_errno_semicolons(void);
 void atf_require_errno_semicolons(void);
+void atf_timing_inside_if(void);
 
 void
 atf_require_inside_if(void)
@@ -74,6 +75,27 @@ atf_require_errno_semicolons(void)
     ATF_REQUIRE_ERRNO(2, 2 == 2);
 }
 
+void
+atf_timing_inside_if(void)
+{
+    /* Make sure that the timing macros can be used inside an if statement
+     * that does not have braces and that they accept a single statement
+     * as well as a block. */
+    if (true)
+        ATF_CHECK_WITHIN(10) {
+        }
+    else
+        ATF_REQUIRE_WITHIN(10)
+            ATF_CHECK(true);
+
+    if (true)
+        ATF_CHECK_FASTER_THAN(10, 3)
+            ATF_CHECK(true);
+    else
+        ATF_REQUIRE_FASTER_THAN(10, 3) {
+        }
+}
+
 /* Test case names should not be expanded during instatiation so that they
  * can have the exact same name as macros. */
 #define TEST_MACRO_1 invalid + name
@@ -35,6 +35,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 #include <atf-c.h>
@@ -764,6 +765,156 @@ ATF_TC_BODY(require_match, tc)
     do_require_eq_tests(tests);
 }
 
+/* ---------------------------------------------------------------------
+ * Test cases for the timing macros.
+ * --------------------------------------------------------------------- */
+
+static
+void
+sleep_msec(const long msec)
+{
+    struct timespec ts;
+
+    ts.tv_sec = msec / 1000;
+    ts.tv_nsec = (msec % 1000) * 1000000;
+    while (nanosleep(&ts, &ts) == -1)
+        ATF_REQUIRE(errno == EINTR);
+}
+
+static
+void
+count_run(void)
+{
+    FILE *f;
+
+    f = fopen("runs", "a");
+    ATF_REQUIRE(f != NULL);
+    fprintf(f, "run\n");
+    fclose(f);
+}
+
+#define H_TIMING_HEAD_NAME(id) ATF_TC_HEAD_NAME(h_timing_ ## id)
+#define H_TIMING_BODY_NAME(id) ATF_TC_BODY_NAME(h_timing_ ## id)
+#define H_TIMING(id, macro) \
+    H_DEF(timing_ ## id, macro)
+
+H_TIMING(check_within_pass, ATF_CHECK_WITHIN(10000) { count_run(); });
+H_TIMING(check_within_fail, ATF_CHECK_WITHIN(10) { sleep_msec(50); });
+H_TIMING(require_within_pass, ATF_REQUIRE_WITHIN(10000) { count_run(); });
+H_TIMING(require_within_fail, ATF_REQUIRE_WITHIN(10) { sleep_msec(50); });
+H_TIMING(check_faster_than_pass,
+         ATF_CHECK_FASTER_THAN(10000, 5) { count_run(); });
+H_TIMING(check_faster_than_fail,
+         ATF_CHECK_FASTER_THAN(10, 3) { count_run(); sleep_msec(50); });
+H_TIMING(require_faster_than_fail,
+         ATF_REQUIRE_FASTER_THAN(10, 3) { count_run(); sleep_msec(50); });
+
+ATF_TC(timing);
+ATF_TC_HEAD(timing, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests the ATF_CHECK_WITHIN, "
+                      "ATF_REQUIRE_WITHIN, ATF_CHECK_FASTER_THAN and "
+                      "ATF_REQUIRE_FASTER_THAN macros");
+}
+ATF_TC_BODY(timing, tc)
+{
+    struct test {
+        void (*head)(atf_tc_t *);
+        void (*body)(const atf_tc_t *);
+        bool fatal;
+        bool ok;
+        const char *exp_runs;
+        const char *exp_regex;
+    } *t, tests[] = {
+        { H_TIMING_HEAD_NAME(check_within_pass),
+          H_TIMING_BODY_NAME(check_within_pass), false, true, "run\n", NULL },
+        { H_TIMING_HEAD_NAME(check_within_fail),
+          H_TIMING_BODY_NAME(check_within_fail), false, false, NULL,
+          "Timed block took [0-9]+\\.[0-9]{3}ms, exceeding its budget of "
+          "10ms" },
+        { H_TIMING_HEAD_NAME(require_within_pass),
+          H_TIMING_BODY_NAME(require_within_pass), true, true, "run\n", NULL },
+        { H_TIMING_HEAD_NAME(require_within_fail),
+          H_TIMING_BODY_NAME(require_within_fail), true, false, NULL,
+          "Timed block took [0-9]+\\.[0-9]{3}ms, exceeding its budget of "
+          "10ms" },
+        { H_TIMING_HEAD_NAME(check_faster_than_pass),
+          H_TIMING_BODY_NAME(check_faster_than_pass), false, true,
+          "run\nrun\nrun\nrun\nrun\n", NULL },
+        { H_TIMING_HEAD_NAME(check_faster_than_fail),
+          H_TIMING_BODY_NAME(check_faster_than_fail), false, false,
+          "run\nrun\nrun\n",
+          "Timed block took [0-9.]+ms \\(median of 3 runs; min [0-9.]+ms, "
+          "max [0-9.]+ms\\), exceeding its budget of 10ms" },
+        { H_TIMING_HEAD_NAME(require_faster_than_fail),
+          H_TIMING_BODY_NAME(require_faster_than_fail), true, false,
+          "run\nrun\nrun\n",
+          "Timed block took [0-9.]+ms \\(median of 3 runs; min [0-9.]+ms, "
+          "max [0-9.]+ms\\), exceeding its budget of 10ms" },
+        { NULL, NULL, false, false, NULL, NULL }
+    };
+
+    for (t = &tests[0]; t->head != NULL; t++) {
+        init_and_run_h_tc("h_timing", t->head, t->body);
+
+        ATF_REQUIRE(exists("before"));
+        if (t->exp_runs != NULL)
+            ATF_REQUIRE(atf_utils_compare_file("runs", t->exp_runs));
+
+        if (t->ok) {
+            ATF_REQUIRE(atf_utils_grep_file("^passed", "result"));
+            ATF_REQUIRE(exists("after"));
+        } else if (t->fatal) {
+            ATF_REQUIRE(atf_utils_grep_file(
+                "^failed: .*macros_test.c:[0-9]+: %s$", "result",
+                t->exp_regex));
+            ATF_REQUIRE(!exists("after"));
+        } else {
+            ATF_REQUIRE(atf_utils_grep_file("^failed", "result"));
+            ATF_REQUIRE(atf_utils_grep_file(
+                "macros_test.c:[0-9]+: %s$", "error", t->exp_regex));
+            ATF_REQUIRE(exists("after"));
+        }
+
+        ATF_REQUIRE(unlink("before") != -1);
+        if (exists("after"))
+            ATF_REQUIRE(unlink("after") != -1);
+        if (exists("runs"))
+            ATF_REQUIRE(unlink("runs") != -1);
+    }
+}
+
+ATF_TC(timing_scale);
+ATF_TC_HEAD(timing_scale, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that the timing macros scale "
+                      "their budget by the timing.scale configuration "
+                      "variable");
+}
+ATF_TC_BODY(timing_scale, tc)
+{
+    const char *const scaled[] = { "timing.scale", "100", NULL };
+    const char *const invalid[] = { "timing.scale", "0", NULL };
+    atf_tc_t htc;
+
+    RE(atf_tc_init(&htc, "h_timing_scale",
+                   H_TIMING_HEAD_NAME(require_within_fail),
+                   H_TIMING_BODY_NAME(require_within_fail), NULL, scaled));
+    run_h_tc(&htc, "output", "error", "result");
+    atf_tc_fini(&htc);
+    ATF_REQUIRE(atf_utils_grep_file("^passed", "result"));
+
+    RE(atf_tc_init(&htc, "h_timing_scale",
+                   H_TIMING_HEAD_NAME(check_faster_than_fail),
+                   H_TIMING_BODY_NAME(check_faster_than_fail), NULL, invalid));
+    run_h_tc(&htc, "output", "error", "result");
+    atf_tc_fini(&htc);
+    ATF_REQUIRE(atf_utils_grep_file("^failed: Configuration variable "
+                                    "timing.scale must be a positive "
+                                    "number; found 0$", "result"));
+    ATF_REQUIRE(!exists("runs"));
+}
+
 /* ---------------------------------------------------------------------
  * Miscellaneous test cases covering several macros.
  * --------------------------------------------------------------------- */
@@ -883,6 +1034,9 @@ ATF_TP_ADD_TCS(tp)
     ATF_TP_ADD_TC(tp, require_errno);
     ATF_TP_ADD_TC(tp, require_match);
 
+    ATF_TP_ADD_TC(tp, timing);
+    ATF_TP_ADD_TC(tp, timing_scale);
+
     ATF_TP_ADD_TC(tp, msg_embedded_fmt);
 
     /* Add the test cases for the header file. */
@@ -37,14 +37,18 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "atf-c/defs.h"
+#include "atf-c/detail/bench.h"
 #include "atf-c/detail/env.h"
 #include "atf-c/detail/fs.h"
 #include "atf-c/detail/map.h"
 #include "atf-c/detail/sanity.h"
+#include "atf-c/detail/shared_config.h"
 #include "atf-c/detail/text.h"
+#include "atf-c/detail/usage.h"
 #include "atf-c/error.h"
 
 /* ---------------------------------------------------------------------
@@ -64,7 +68,9 @@ struct context {
     const atf_tc_t *tc;
     const char *resfile;
     int resfilefd;
+    int usagefd;
     size_t fail_count;
+    atf_usage_mark_t usage;
 
     enum expect_type expect;
     atf_dynstr_t expect_reason;
@@ -115,6 +121,7 @@ context_init(struct context *ctx, const atf_tc_t *tc, const char *resfile)
 
     ctx->tc = tc;
     ctx->resfilefd = -1;
+    ctx->usagefd = -1;
     context_set_resfile(ctx, resfile);
     ctx->fail_count = 0;
     ctx->expect = EXPECT_PASS;
@@ -123,12 +130,14 @@ context_init(struct context *ctx, const atf_tc_t *tc, const char *resfile)
     ctx->expect_fail_count = 0;
     ctx->expect_exitcode = 0;
     ctx->expect_signo = 0;
+    atf_usage_mark_init(&ctx->usage, STDOUT_FILENO, STDERR_FILENO);
 }
 
 static void
 context_set_resfile(struct context *ctx, const char *resfile)
 {
     atf_error_t err;
+    struct stat sb;
 
     context_close_resfile(ctx);
     ctx->resfile = resfile;
@@ -145,6 +154,14 @@ context_set_resfile(struct context *ctx, const char *resfile)
             check_fatal_error(err);
     }
 
+    /*
+     * The usage of the test case is only recorded next to regular results
+     * files; there is no place to put it for /dev/stdout and the like.
+     */
+    if (ctx->resfilefd != STDOUT_FILENO && ctx->resfilefd != STDERR_FILENO &&
+        fstat(ctx->resfilefd, &sb) != -1 && S_ISREG(sb.st_mode))
+        check_fatal_error(atf_usage_open(resfile, &ctx->usagefd));
+
     ctx->resfile = resfile;
 }
 
@@ -157,6 +174,9 @@ context_close_resfile(struct context *ctx)
     if (ctx->resfilefd != STDOUT_FILENO && ctx->resfilefd != STDERR_FILENO)
         close(ctx->resfilefd);
     ctx->resfilefd = -1;
+    if (ctx->usagefd != -1)
+        close(ctx->usagefd);
+    ctx->usagefd = -1;
     ctx->resfile = NULL;
 }
 
@@ -264,6 +284,16 @@ create_resfile(struct context *ctx, const char *result, const int arg,
         lseek(ctx->resfilefd, 0, SEEK_SET);
     err = write_resfile(ctx->resfilefd, result, arg, reason);
 
+    if (!atf_is_error(err) && ctx->usagefd != -1) {
+        atf_usage_t usage;
+
+        /* Account for the output that the body left in the buffers. */
+        fflush(stdout);
+        fflush(stderr);
+        atf_usage_since_self(&ctx->usage, &usage);
+        err = atf_usage_write(&usage, ctx->usagefd);
+    }
+
     if (reason != NULL)
         atf_dynstr_fini(reason);
 
@@ -569,13 +599,39 @@ struct atf_tc_impl {
     const char *m_ident;
 
     atf_map_t m_vars;
-    atf_map_t m_config;
+    atf_shared_config_t *m_config;
 
     atf_tc_head_t m_head;
     atf_tc_body_t m_body;
     atf_tc_cleanup_t m_cleanup;
+
+    /* The head is only run the first time the metadata is needed so that
+     * registering a test case is cheap when it is not going to be used. */
+    bool m_head_pending;
 };
 
+static
+void
+run_head(const atf_tc_t *tc)
+{
+    struct atf_tc_impl *impl = tc->pimpl;
+
+    if (!impl->m_head_pending)
+        return;
+    impl->m_head_pending = false;
+
+    /* XXX Should the head be able to return error codes? */
+#define UNCONST(a) ((void *)(uintptr_t)(const void *)(a))
+    impl->m_head(UNCONST(tc));
+#undef UNCONST
+
+    if (strcmp(atf_tc_get_md_var(tc, "ident"), impl->m_ident) != 0) {
+        report_fatal_error("Test case head modified the read-only 'ident' "
+            "property");
+        UNREACHABLE;
+    }
+}
+
 /*
  * Constructors/destructors.
  */
@@ -584,6 +640,23 @@ atf_error_t
 atf_tc_init(atf_tc_t *tc, const char *ident, atf_tc_head_t head,
             atf_tc_body_t body, atf_tc_cleanup_t cleanup,
             const char *const *config)
+{
+    atf_shared_config_t *shared;
+    atf_error_t err;
+
+    err = atf_shared_config_new(&shared, config);
+    if (atf_is_error(err))
+        return err;
+
+    err = atf_tc_init_config(tc, ident, head, body, cleanup, shared);
+    atf_shared_config_unref(shared);
+    return err;
+}
+
+atf_error_t
+atf_tc_init_config(atf_tc_t *tc, const char *ident, atf_tc_head_t head,
+                   atf_tc_body_t body, atf_tc_cleanup_t cleanup,
+                   struct atf_shared_config *config)
 {
     atf_error_t err;
 
@@ -597,14 +670,12 @@ atf_tc_init(atf_tc_t *tc, const char *ident, atf_tc_head_t head,
     tc->pimpl->m_head = head;
     tc->pimpl->m_body = body;
     tc->pimpl->m_cleanup = cleanup;
-
-    err = atf_map_init_charpp(&tc->pimpl->m_config, config);
-    if (atf_is_error(err))
-        goto err;
+    tc->pimpl->m_head_pending = false;
 
     err = atf_map_init(&tc->pimpl->m_vars);
     if (atf_is_error(err))
-        goto err_vars;
+        goto err_impl;
+    tc->pimpl->m_config = atf_shared_config_ref(config);
 
     err = atf_tc_set_md_var(tc, "ident", ident);
     if (atf_is_error(err))
@@ -616,23 +687,16 @@ atf_tc_init(atf_tc_t *tc, const char *ident, atf_tc_head_t head,
             goto err_map;
     }
 
-    /* XXX Should the head be able to return error codes? */
-    if (tc->pimpl->m_head != NULL)
-        tc->pimpl->m_head(tc);
-
-    if (strcmp(atf_tc_get_md_var(tc, "ident"), ident) != 0) {
-        report_fatal_error("Test case head modified the read-only 'ident' "
-            "property");
-        UNREACHABLE;
-    }
+    tc->pimpl->m_head_pending = head != NULL;
 
     INV(!atf_is_error(err));
     return err;
 
 err_map:
+    atf_shared_config_unref(tc->pimpl->m_config);
     atf_map_fini(&tc->pimpl->m_vars);
-err_vars:
-    atf_map_fini(&tc->pimpl->m_config);
+err_impl:
+    free(tc->pimpl);
 err:
     return err;
 }
@@ -648,6 +712,7 @@ atf_tc_init_pack(atf_tc_t *tc, const atf_tc_pack_t *pack,
 void
 atf_tc_fini(atf_tc_t *tc)
 {
+    atf_shared_config_unref(tc->pimpl->m_config);
     atf_map_fini(&tc->pimpl->m_vars);
     free(tc->pimpl);
 }
@@ -666,12 +731,9 @@ const char *
 atf_tc_get_config_var(const atf_tc_t *tc, const char *name)
 {
     const char *val;
-    atf_map_citer_t iter;
 
-    PRE(atf_tc_has_config_var(tc, name));
-    iter = atf_map_find_c(&tc->pimpl->m_config, name);
-    val = atf_map_citer_data(iter);
-    INV(val != NULL);
+    val = atf_shared_config_get(tc->pimpl->m_config, name);
+    PRE(val != NULL);
 
     return val;
 }
@@ -760,6 +822,7 @@ atf_tc_get_md_var(const atf_tc_t *tc, const char *name)
     const char *val;
     atf_map_citer_t iter;
 
+    run_head(tc);
     PRE(atf_tc_has_md_var(tc, name));
     iter = atf_map_find_c(&tc->pimpl->m_vars, name);
     val = atf_map_citer_data(iter);
@@ -771,17 +834,14 @@ atf_tc_get_md_var(const atf_tc_t *tc, const char *name)
 char **
 atf_tc_get_md_vars(const atf_tc_t *tc)
 {
+    run_head(tc);
     return atf_map_to_charpp(&tc->pimpl->m_vars);
 }
 
 bool
 atf_tc_has_config_var(const atf_tc_t *tc, const char *name)
 {
-    atf_map_citer_t end, iter;
-
-    iter = atf_map_find_c(&tc->pimpl->m_config, name);
-    end = atf_map_end_c(&tc->pimpl->m_config);
-    return !atf_equal_map_citer_map_citer(iter, end);
+    return atf_shared_config_get(tc->pimpl->m_config, name) != NULL;
 }
 
 bool
@@ -789,6 +849,7 @@ atf_tc_has_md_var(const atf_tc_t *tc, const char *name)
 {
     atf_map_citer_t end, iter;
 
+    run_head(tc);
     iter = atf_map_find_c(&tc->pimpl->m_vars, name);
     end = atf_map_end_c(&tc->pimpl->m_vars);
     return !atf_equal_map_citer_map_citer(iter, end);
@@ -805,6 +866,8 @@ atf_tc_set_md_var(atf_tc_t *tc, const char *name, const char *fmt, ...)
     char *value;
     va_list ap;
 
+    run_head(tc);
+
     va_start(ap, fmt);
     err = atf_text_format_ap(&value, fmt, ap);
     va_end(ap);
@@ -817,6 +880,24 @@ atf_tc_set_md_var(atf_tc_t *tc, const char *name, const char *fmt, ...)
     return err;
 }
 
+atf_error_t
+atf_tc_set_config_var(atf_tc_t *tc, const char *name, const char *value)
+{
+    atf_error_t err;
+
+    if (atf_shared_config_is_shared(tc->pimpl->m_config)) {
+        atf_shared_config_t *copy;
+
+        err = atf_shared_config_copy(&copy, tc->pimpl->m_config);
+        if (atf_is_error(err))
+            return err;
+        atf_shared_config_unref(tc->pimpl->m_config);
+        tc->pimpl->m_config = copy;
+    }
+
+    return atf_shared_config_set(tc->pimpl->m_config, name, value);
+}
+
 /* ---------------------------------------------------------------------
  * Free functions, as they should be publicly but they can't.
  * --------------------------------------------------------------------- */
@@ -844,6 +925,11 @@ static void _atf_tc_expect_signal(struct context *, const int, const char *,
     va_list);
 static void _atf_tc_expect_death(struct context *, const char *,
     va_list);
+static void _atf_tc_run_bench(struct context *, atf_tc_bench_t);
+static atf_tc_timing_t _atf_tc_timing_start(struct context *, const char *,
+                                            const size_t, const bool,
+                                            const long, const size_t);
+static bool _atf_tc_timing_next(struct context *, atf_tc_timing_t *);
 
 static void
 _atf_tc_fail(struct context *ctx, const char *fmt, va_list ap)
@@ -1040,6 +1126,148 @@ _atf_tc_set_resultsfile(struct context *ctx, const char *file)
     context_set_resfile(ctx, file);
 }
 
+static void
+_atf_tc_run_bench(struct context *ctx, atf_tc_bench_t body)
+{
+    atf_bench_params_t params;
+    atf_bench_result_t result;
+    long samples, sample_ms;
+    int fd;
+
+    samples = atf_tc_get_config_var_as_long_wd(ctx->tc, "bench.samples", 10);
+    sample_ms = atf_tc_get_config_var_as_long_wd(ctx->tc, "bench.sample_ms",
+                                                 100);
+    if (samples <= 0)
+        atf_tc_fail("Configuration variable bench.samples must be positive; "
+                    "found %ld", samples);
+    if (sample_ms <= 0)
+        atf_tc_fail("Configuration variable bench.sample_ms must be "
+                    "positive; found %ld", sample_ms);
+    params.m_samples = (size_t)samples;
+    params.m_sample_nsec = (int64_t)sample_ms * 1000000;
+
+    /*
+     * Open the output before running the benchmark, which may change the
+     * working directory.  Benchmarks that report their results to
+     * stdout/stderr also print their statistics there.
+     */
+    if (ctx->usagefd != -1)
+        check_fatal_error(atf_bench_open(ctx->resfile, &fd));
+    else
+        fd = STDOUT_FILENO;
+
+    check_fatal_error(atf_bench_run(ctx->tc, body, &params, &result));
+
+    fflush(stdout);
+    check_fatal_error(atf_bench_write(&result, fd));
+    atf_bench_result_fini(&result);
+    if (fd != STDOUT_FILENO)
+        close(fd);
+}
+
+static
+int64_t
+monotonic_nsec(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == -1)
+        UNREACHABLE;
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static
+int
+compare_nsec(const void *a, const void *b)
+{
+    const int64_t na = *(const int64_t *)a;
+    const int64_t nb = *(const int64_t *)b;
+
+    return na < nb ? -1 : na > nb ? 1 : 0;
+}
+
+static atf_tc_timing_t
+_atf_tc_timing_start(struct context *ctx, const char *file, const size_t line,
+                     const bool fatal, const long budget_msec,
+                     const size_t repeat)
+{
+    atf_tc_timing_t t;
+    const char *scale;
+    char *end;
+
+    PRE(repeat > 0);
+
+    /* Slow builds, e.g. those with sanitizers, can scale all budgets at
+     * once instead of editing every test. */
+    scale = atf_tc_get_config_var_wd(ctx->tc, "timing.scale", "1");
+    errno = 0;
+    t.m_scale = strtod(scale, &end);
+    if (errno != 0 || *scale == '\0' || *end != '\0' || !(t.m_scale > 0.0))
+        atf_tc_fail("Configuration variable timing.scale must be a "
+                    "positive number; found %s", scale);
+
+    t.m_file = file;
+    t.m_line = line;
+    t.m_fatal = fatal;
+    t.m_budget_msec = budget_msec;
+    t.m_repeat = repeat;
+    t.m_done = 0;
+    t.m_start = -1;
+    t.m_samples = malloc(repeat * sizeof(int64_t));
+    if (t.m_samples == NULL)
+        check_fatal_error(atf_no_memory_error());
+    return t;
+}
+
+static bool
+_atf_tc_timing_next(struct context *ctx, atf_tc_timing_t *t)
+{
+    const int64_t now = monotonic_nsec();
+    const size_t n = t->m_repeat;
+    double median, min, max, budget;
+    atf_dynstr_t reason;
+
+    if (t->m_start != -1)
+        t->m_samples[t->m_done++] = now - t->m_start;
+    if (t->m_done < n) {
+        t->m_start = monotonic_nsec();
+        return true;
+    }
+
+    qsort(t->m_samples, n, sizeof(int64_t), compare_nsec);
+    min = t->m_samples[0] / 1000000.0;
+    max = t->m_samples[n - 1] / 1000000.0;
+    if (n % 2 == 1)
+        median = t->m_samples[n / 2] / 1000000.0;
+    else
+        median = (t->m_samples[n / 2 - 1] + t->m_samples[n / 2]) /
+            2000000.0;
+    free(t->m_samples);
+    t->m_samples = NULL;
+
+    budget = t->m_budget_msec * t->m_scale;
+    if (median <= budget)
+        return false;
+
+    if (n == 1)
+        format_reason_fmt(&reason, t->m_file, t->m_line, "Timed block took "
+            "%.3fms, exceeding its budget of %ldms", median,
+            t->m_budget_msec);
+    else
+        format_reason_fmt(&reason, t->m_file, t->m_line, "Timed block took "
+            "%.3fms (median of %zu runs; min %.3fms, max %.3fms), exceeding "
+            "its budget of %ldms", median, n, min, max, t->m_budget_msec);
+    if (t->m_scale != 1.0)
+        check_fatal_error(atf_dynstr_append_fmt(&reason, " (%.3fms with "
+            "timing.scale %g)", budget, t->m_scale));
+
+    if (t->m_fatal)
+        fail_requirement(ctx, &reason);
+    else
+        fail_check(ctx, &reason);
+    return false;
+}
+
 /* ---------------------------------------------------------------------
  * Free functions.
  * --------------------------------------------------------------------- */
@@ -1049,6 +1277,8 @@ static struct context Current;
 atf_error_t
 atf_tc_run(const atf_tc_t *tc, const char *resfile)
 {
+    run_head(tc);
+
     context_init(&Current, tc, resfile);
 
     tc->pimpl->m_body(tc);
@@ -1074,9 +1304,16 @@ atf_tc_run(const atf_tc_t *tc, const char *resfile)
     return atf_no_error();
 }
 
+void
+atf_tc_mark_as_bench(atf_tc_t *tc)
+{
+    check_fatal_error(atf_tc_set_md_var(tc, "X-kind", "benchmark"));
+}
+
 atf_error_t
 atf_tc_cleanup(const atf_tc_t *tc)
 {
+    run_head(tc);
     if (tc->pimpl->m_cleanup != NULL)
         tc->pimpl->m_cleanup(tc);
     return atf_no_error(); /* XXX */
@@ -1262,6 +1499,32 @@ atf_tc_expect_timeout(const char *reason, ...)
     va_end(ap);
 }
 
+void
+atf_tc_run_bench(const atf_tc_t *tc, atf_tc_bench_t body)
+{
+    PRE(Current.tc == tc);
+
+    _atf_tc_run_bench(&Current, body);
+}
+
+atf_tc_timing_t
+atf_tc_timing_start(const char *file, const size_t line, const bool fatal,
+                    const long budget_msec, const size_t repeat)
+{
+    PRE(Current.tc != NULL);
+
+    return _atf_tc_timing_start(&Current, file, line, fatal, budget_msec,
+                                repeat);
+}
+
+bool
+atf_tc_timing_next(atf_tc_timing_t *t)
+{
+    PRE(Current.tc != NULL);
+
+    return _atf_tc_timing_next(&Current, t);
+}
+
 /* Internal! */
 void
 atf_tc_set_resultsfile(const char *file)
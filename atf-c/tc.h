@@ -28,15 +28,18 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #include <atf-c/defs.h>
 #include <atf-c/error_fwd.h>
 
+struct atf_shared_config;
 struct atf_tc;
 
 typedef void (*atf_tc_head_t)(struct atf_tc *);
 typedef void (*atf_tc_body_t)(const struct atf_tc *);
 typedef void (*atf_tc_cleanup_t)(const struct atf_tc *);
+typedef void (*atf_tc_bench_t)(const struct atf_tc *, const size_t);
 
 /* ---------------------------------------------------------------------
  * The "atf_tc_pack" type.
@@ -54,6 +57,25 @@ struct atf_tc_pack {
 };
 typedef const struct atf_tc_pack atf_tc_pack_t;
 
+/* ---------------------------------------------------------------------
+ * The "atf_tc_desc" type.
+ * --------------------------------------------------------------------- */
+
+/* For static initialization only; see the ATF_TC_STATIC macros.  The
+ * metadata is a list of name/value pairs starting with "ident" and ending
+ * with two NULL pointers.  The test case is only initialized, in the given
+ * storage, if the test program needs to run it. */
+struct atf_tc_desc {
+    const char *m_ident;
+    const char *const *m_md;
+
+    atf_tc_body_t m_body;
+    atf_tc_cleanup_t m_cleanup;
+
+    struct atf_tc *m_tc;
+};
+typedef const struct atf_tc_desc atf_tc_desc_t;
+
 /* ---------------------------------------------------------------------
  * The "atf_tc" type.
  * --------------------------------------------------------------------- */
@@ -70,6 +92,11 @@ atf_error_t atf_tc_init(atf_tc_t *, const char *, atf_tc_head_t,
                         const char *const *);
 atf_error_t atf_tc_init_pack(atf_tc_t *, atf_tc_pack_t *,
                              const char *const *);
+/* Internal to the test program code; shares the given configuration with
+ * the test case instead of copying it. */
+atf_error_t atf_tc_init_config(atf_tc_t *, const char *, atf_tc_head_t,
+                               atf_tc_body_t, atf_tc_cleanup_t,
+                               struct atf_shared_config *);
 void atf_tc_fini(atf_tc_t *);
 
 /* Getters. */
@@ -91,6 +118,32 @@ bool atf_tc_has_md_var(const atf_tc_t *, const char *);
 /* Modifiers. */
 atf_error_t atf_tc_set_md_var(atf_tc_t *, const char *, const char *, ...);
 
+/* Internal to the test program main code; overrides the configuration
+ * given to atf_tc_init when running a test case in server mode. */
+atf_error_t atf_tc_set_config_var(atf_tc_t *, const char *, const char *);
+
+/* ---------------------------------------------------------------------
+ * The "atf_tc_timing" type.
+ * --------------------------------------------------------------------- */
+
+/* State of a block measured by the timing macros; internal to macros.h.
+ * The block runs m_repeat times and the median of the durations, in
+ * nanoseconds, is compared to the budget multiplied by m_scale. */
+struct atf_tc_timing {
+    const char *m_file;
+    size_t m_line;
+    bool m_fatal;
+
+    long m_budget_msec;
+    double m_scale;
+    size_t m_repeat;
+
+    size_t m_done;
+    int64_t m_start;
+    int64_t *m_samples;
+};
+typedef struct atf_tc_timing atf_tc_timing_t;
+
 /* ---------------------------------------------------------------------
  * Free functions.
  * --------------------------------------------------------------------- */
@@ -122,6 +175,11 @@ void atf_tc_expect_death(const char *, ...)
 void atf_tc_expect_timeout(const char *, ...)
     ATF_DEFS_ATTRIBUTE_FORMAT_PRINTF(1, 2);
 
+/* Internal to the benchmark macros; the former is to be run from test case
+ * heads and the latter from test case bodies. */
+void atf_tc_mark_as_bench(atf_tc_t *);
+void atf_tc_run_bench(const atf_tc_t *, atf_tc_bench_t);
+
 /* To be run from test case bodies only; internal to macros.h. */
 void atf_tc_fail_check(const char *, const size_t, const char *, ...)
     ATF_DEFS_ATTRIBUTE_FORMAT_PRINTF(3, 4);
@@ -132,5 +190,8 @@ void atf_tc_check_errno(const char *, const size_t, const int,
                         const char *, const bool);
 void atf_tc_require_errno(const char *, const size_t, const int,
                           const char *, const bool);
+atf_tc_timing_t atf_tc_timing_start(const char *, const size_t, const bool,
+                                    const long, const size_t);
+bool atf_tc_timing_next(atf_tc_timing_t *);
 
 #endif /* !defined(ATF_C_TC_H) */
@@ -49,6 +49,14 @@ ATF_TC_HEAD(test_var, tc)
     atf_tc_set_md_var(tc, "test-var", "Test text");
 }
 
+static int counted_heads = 0;
+
+ATF_TC_HEAD(counted, tc)
+{
+    counted_heads++;
+    atf_tc_set_md_var(tc, "test-var", "Counted text");
+}
+
 /* ---------------------------------------------------------------------
  * Test cases for the "atf_tc_t" type.
  * --------------------------------------------------------------------- */
@@ -126,6 +134,39 @@ ATF_TC_BODY(vars, tcin)
     atf_tc_fini(&tc);
 }
 
+ATF_TC(lazy_head);
+ATF_TC_HEAD(lazy_head, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Tests that the head of a test case "
+                      "only runs once its metadata is first needed");
+}
+ATF_TC_BODY(lazy_head, tcin)
+{
+    atf_tc_t tc;
+
+    counted_heads = 0;
+    RE(atf_tc_init(&tc, "test1", ATF_TC_HEAD_NAME(counted),
+                   ATF_TC_BODY_NAME(empty), NULL, NULL));
+    ATF_REQUIRE_EQ(counted_heads, 0);
+    ATF_REQUIRE(strcmp(atf_tc_get_ident(&tc), "test1") == 0);
+    ATF_REQUIRE_EQ(counted_heads, 0);
+    ATF_REQUIRE(atf_tc_has_md_var(&tc, "test-var"));
+    ATF_REQUIRE_EQ(counted_heads, 1);
+    ATF_REQUIRE(strcmp(atf_tc_get_md_var(&tc, "test-var"),
+                       "Counted text") == 0);
+    ATF_REQUIRE_EQ(counted_heads, 1);
+    atf_tc_fini(&tc);
+
+    counted_heads = 0;
+    RE(atf_tc_init(&tc, "test2", ATF_TC_HEAD_NAME(counted),
+                   ATF_TC_BODY_NAME(empty), NULL, NULL));
+    RE(atf_tc_set_md_var(&tc, "test-var", "Overridden text"));
+    ATF_REQUIRE_EQ(counted_heads, 1);
+    ATF_REQUIRE(strcmp(atf_tc_get_md_var(&tc, "test-var"),
+                       "Overridden text") == 0);
+    atf_tc_fini(&tc);
+}
+
 ATF_TC(config);
 ATF_TC_HEAD(config, tc)
 {
@@ -174,6 +215,7 @@ ATF_TP_ADD_TCS(tp)
     ATF_TP_ADD_TC(tp, init);
     ATF_TP_ADD_TC(tp, init_pack);
     ATF_TP_ADD_TC(tp, vars);
+    ATF_TP_ADD_TC(tp, lazy_head);
     ATF_TP_ADD_TC(tp, config);
 
     /* Add the test cases for the free functions. */
@@ -31,14 +31,17 @@
 #include <unistd.h>
 
 #include "atf-c/detail/fs.h"
-#include "atf-c/detail/map.h"
+#include "atf-c/detail/list.h"
 #include "atf-c/detail/sanity.h"
+#include "atf-c/detail/shared_config.h"
+#include "atf-c/detail/tc_index.h"
 #include "atf-c/error.h"
 #include "atf-c/tc.h"
 
 struct atf_tp_impl {
     atf_list_t m_tcs;
-    atf_map_t m_config;
+    atf_tc_index_t m_index;
+    atf_shared_config_t *m_config;
 };
 
 /* ---------------------------------------------------------------------
@@ -49,19 +52,7 @@ static
 const atf_tc_t *
 find_tc(const atf_tp_t *tp, const char *ident)
 {
-    const atf_tc_t *tc;
-    atf_list_citer_t iter;
-
-    tc = NULL;
-    atf_list_for_each_c(iter, &tp->pimpl->m_tcs) {
-        const atf_tc_t *tc2;
-        tc2 = atf_list_citer_data(iter);
-        if (strcmp(atf_tc_get_ident(tc2), ident) == 0) {
-            tc = tc2;
-            break;
-        }
-    }
-    return tc;
+    return atf_tc_index_find(&tp->pimpl->m_index, ident);
 }
 
 /* ---------------------------------------------------------------------
@@ -87,8 +78,15 @@ atf_tp_init(atf_tp_t *tp, const char *const *config)
     if (atf_is_error(err))
         goto out;
 
-    err = atf_map_init_charpp(&tp->pimpl->m_config, config);
+    err = atf_tc_index_init(&tp->pimpl->m_index);
+    if (atf_is_error(err)) {
+        atf_list_fini(&tp->pimpl->m_tcs);
+        goto out;
+    }
+
+    err = atf_shared_config_new(&tp->pimpl->m_config, config);
     if (atf_is_error(err)) {
+        atf_tc_index_fini(&tp->pimpl->m_index);
         atf_list_fini(&tp->pimpl->m_tcs);
         goto out;
     }
@@ -103,13 +101,13 @@ atf_tp_fini(atf_tp_t *tp)
 {
     atf_list_iter_t iter;
 
-    atf_map_fini(&tp->pimpl->m_config);
-
     atf_list_for_each(iter, &tp->pimpl->m_tcs) {
         atf_tc_t *tc = atf_list_iter_data(iter);
         atf_tc_fini(tc);
     }
+    atf_tc_index_fini(&tp->pimpl->m_index);
     atf_list_fini(&tp->pimpl->m_tcs);
+    atf_shared_config_unref(tp->pimpl->m_config);
 
     free(tp->pimpl);
 }
@@ -121,7 +119,7 @@ atf_tp_fini(atf_tp_t *tp)
 char **
 atf_tp_get_config(const atf_tp_t *tp)
 {
-    return atf_map_to_charpp(&tp->pimpl->m_config);
+    return atf_shared_config_to_charpp(tp->pimpl->m_config);
 }
 
 bool
@@ -179,13 +177,72 @@ atf_tp_add_tc(atf_tp_t *tp, atf_tc_t *tc)
 
     PRE(find_tc(tp, atf_tc_get_ident(tc)) == NULL);
 
+    /* Make room in the index first so that, once the test case is in the
+     * list, adding it to the index as well cannot fail. */
+    err = atf_tc_index_reserve(&tp->pimpl->m_index,
+                               atf_tc_index_size(&tp->pimpl->m_index) + 1);
+    if (atf_is_error(err))
+        return err;
+
     err = atf_list_append(&tp->pimpl->m_tcs, tc, false);
+    if (atf_is_error(err))
+        return err;
+
+    err = atf_tc_index_add(&tp->pimpl->m_index, tc);
+    INV(!atf_is_error(err));
 
     POST(find_tc(tp, atf_tc_get_ident(tc)) != NULL);
 
     return err;
 }
 
+atf_error_t
+atf_tp_add_tc_pack(atf_tp_t *tp, atf_tc_t *tc, const atf_tc_pack_t *pack)
+{
+    atf_error_t err;
+
+    err = atf_tc_init_config(tc, pack->m_ident, pack->m_head, pack->m_body,
+                             pack->m_cleanup, tp->pimpl->m_config);
+    if (atf_is_error(err))
+        return err;
+
+    err = atf_tp_add_tc(tp, tc);
+    if (atf_is_error(err))
+        atf_tc_fini(tc);
+
+    return err;
+}
+
+atf_error_t
+atf_tp_add_tc_desc(atf_tp_t *tp, const atf_tc_desc_t *desc)
+{
+    const char *const *ptr;
+    atf_error_t err;
+
+    PRE(strcmp(desc->m_md[0], "ident") == 0);
+
+    err = atf_tc_init_config(desc->m_tc, desc->m_ident, NULL, desc->m_body,
+                             desc->m_cleanup, tp->pimpl->m_config);
+    if (atf_is_error(err))
+        return err;
+
+    for (ptr = desc->m_md + 2; *ptr != NULL; ptr += 2) {
+        err = atf_tc_set_md_var(desc->m_tc, *ptr, "%s", *(ptr + 1));
+        if (atf_is_error(err))
+            goto err_tc;
+    }
+
+    err = atf_tp_add_tc(tp, desc->m_tc);
+    if (atf_is_error(err))
+        goto err_tc;
+
+    return err;
+
+err_tc:
+    atf_tc_fini(desc->m_tc);
+    return err;
+}
+
 /* ---------------------------------------------------------------------
  * Free functions.
  * --------------------------------------------------------------------- */
@@ -31,6 +31,8 @@
 #include <atf-c/error_fwd.h>
 
 struct atf_tc;
+struct atf_tc_desc;
+struct atf_tc_pack;
 
 /* ---------------------------------------------------------------------
  * The "atf_tp" type.
@@ -55,6 +57,15 @@ const struct atf_tc **atf_tp_get_tcs(const atf_tp_t *);
 /* Modifiers. */
 atf_error_t atf_tp_add_tc(atf_tp_t *, struct atf_tc *);
 
+/* Internal to macros.h; registers a test case that shares the test
+ * program's configuration. */
+atf_error_t atf_tp_add_tc_pack(atf_tp_t *, struct atf_tc *,
+                               const struct atf_tc_pack *);
+
+/* Internal to the test program main code; initializes and registers a
+ * test case described by a static descriptor. */
+atf_error_t atf_tp_add_tc_desc(atf_tp_t *, const struct atf_tc_desc *);
+
 /* ---------------------------------------------------------------------
  * Free functions.
  * --------------------------------------------------------------------- */
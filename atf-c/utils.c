@@ -39,7 +39,9 @@
 
 #include <atf-c.h>
 
+#include "atf-c/detail/compare.h"
 #include "atf-c/detail/dynstr.h"
+#include "atf-c/detail/grep.h"
 
 /* No prototype in header for this one, it's a little sketchy (internal). */
 void atf_tc_set_resultsfile(const char *);
@@ -72,6 +74,21 @@ init_out_filename(atf_dynstr_t *name, const pid_t pid, const char *suffix,
     }
 }
 
+/** Matches a string against a compiled regexp.
+ *
+ * \param preg The regexp to look for.
+ * \param str The string in which to look for the expression.
+ *
+ * \return True if there is a match; false otherwise. */
+static
+bool
+match_regex(const regex_t *preg, const char *str)
+{
+    const int res = regexec(preg, str, 0, NULL, 0);
+    ATF_REQUIRE(res == 0 || res == REG_NOMATCH);
+    return res == 0;
+}
+
 /** Searches for a regexp in a string.
  *
  * \param regex The regexp to look for.
@@ -82,18 +99,17 @@ static
 bool
 grep_string(const char *regex, const char *str)
 {
-    int res;
+    bool found;
     regex_t preg;
 
     printf("Looking for '%s' in '%s'\n", regex, str);
-    ATF_REQUIRE(regcomp(&preg, regex, REG_EXTENDED) == 0);
+    ATF_REQUIRE(regcomp(&preg, regex, REG_EXTENDED | REG_NOSUB) == 0);
 
-    res = regexec(&preg, str, 0, NULL, 0);
-    ATF_REQUIRE(res == 0 || res == REG_NOMATCH);
+    found = match_regex(&preg, str);
 
     regfree(&preg);
 
-    return res == 0;
+    return found;
 }
 
 /** Prints the contents of a file to stdout.
@@ -145,25 +161,21 @@ atf_utils_cat_file(const char *name, const char *prefix)
 bool
 atf_utils_compare_file(const char *name, const char *contents)
 {
-    const int fd = open(name, O_RDONLY | O_CLOEXEC);
-    ATF_REQUIRE_MSG(fd != -1, "Cannot open %s", name);
-
-    const char *pos = contents;
-    ssize_t remaining = strlen(contents);
+    atf_compare_result_t result;
+    atf_error_t error;
 
-    char buffer[1024];
-    ssize_t count;
-    while ((count = read(fd, buffer, sizeof(buffer))) > 0 &&
-           count <= remaining) {
-        if (memcmp(pos, buffer, count) != 0) {
-            close(fd);
-            return false;
-        }
-        remaining -= count;
-        pos += count;
+    error = atf_compare_file_mem(name, contents, strlen(contents), &result);
+    if (atf_is_error(error)) {
+        char buffer[1024];
+        atf_error_format(error, buffer, sizeof(buffer));
+        atf_error_free(error);
+        atf_tc_fail("Cannot compare %s: %s", name, buffer);
     }
-    close(fd);
-    return count == 0 && remaining == 0;
+
+    if (!result.m_equal)
+        printf("%s differs from the expected contents at byte %zu, "
+               "line %zu\n", name, result.m_offset, result.m_line);
+    return result.m_equal;
 }
 
 /** Copies a file.
@@ -309,6 +321,8 @@ atf_utils_grep_file(const char *regex, const char *file, ...)
     va_list ap;
     atf_dynstr_t formatted;
     atf_error_t error;
+    atf_grep_t grep;
+    const char *regexes[1];
 
     va_start(ap, file);
     error = atf_dynstr_init_ap(&formatted, regex, ap);
@@ -316,14 +330,19 @@ atf_utils_grep_file(const char *regex, const char *file, ...)
     ATF_REQUIRE(!atf_is_error(error));
 
     ATF_REQUIRE((fd = open(file, O_RDONLY | O_CLOEXEC)) != -1);
-    bool found = false;
-    char *line = NULL;
-    while (!found && (line = atf_utils_readline(fd)) != NULL) {
-        found = grep_string(atf_dynstr_cstring(&formatted), line);
-        free(line);
-    }
+
+    printf("Looking for '%s' in file '%s'\n", atf_dynstr_cstring(&formatted),
+           file);
+    regexes[0] = atf_dynstr_cstring(&formatted);
+    ATF_REQUIRE(!atf_is_error(atf_grep_init(&grep, regexes, 1)));
+    ATF_REQUIRE(!atf_is_error(atf_grep_scan_fd(&grep, fd)));
     close(fd);
 
+    const bool found = atf_grep_matched(&grep, 0);
+    if (found)
+        printf("Found at line %zu\n", atf_grep_line(&grep, 0));
+    atf_grep_fini(&grep);
+
     atf_dynstr_fini(&formatted);
 
     return found;
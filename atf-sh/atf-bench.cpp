@@ -0,0 +1,611 @@
+// Copyright (c) 2026 The NetBSD Foundation, Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+// CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+// INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+// IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+// IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+// OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "atf-c++/detail/application.hpp"
+#include "atf-c++/detail/fs.hpp"
+#include "atf-c++/detail/sanity.hpp"
+#include "atf-c++/detail/text.hpp"
+
+// ------------------------------------------------------------------------
+// Auxiliary functions.
+// ------------------------------------------------------------------------
+
+namespace {
+
+//!
+//! \brief The measurements of a single benchmark.
+//!
+//! The properties are kept in the order in which they were read so that
+//! they can be written back verbatim to a baseline.
+//!
+struct bench_data {
+    std::string ident;
+    std::string source;
+    std::vector< std::pair< std::string, std::string > > props;
+    std::vector< double > samples;
+};
+
+typedef std::map< std::string, bench_data > bench_map;
+
+struct comparison {
+    std::string ident;
+    std::string status;
+    const bench_data* baseline;
+    const bench_data* current;
+    double change;
+    double p_value;
+
+    comparison(const std::string& p_ident, const std::string& p_status,
+               const bench_data* p_baseline, const bench_data* p_current,
+               const double p_change, const double p_p_value) :
+        ident(p_ident),
+        status(p_status),
+        baseline(p_baseline),
+        current(p_current),
+        change(p_change),
+        p_value(p_p_value)
+    {
+    }
+};
+
+std::string
+format_double(const double value, const int precision)
+{
+    std::ostringstream str;
+    str << std::fixed << std::setprecision(precision) << value;
+    return str.str();
+}
+
+std::string
+format_json_string(const std::string& str)
+{
+    std::ostringstream out;
+    out << '"';
+    for (std::string::const_iterator iter = str.begin(); iter != str.end();
+         iter++) {
+        const unsigned char ch = *iter;
+        if (ch == '"' || ch == '\\')
+            out << '\\' << ch;
+        else if (ch < 0x20)
+            out << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+                << static_cast< int >(ch) << std::dec;
+        else
+            out << ch;
+    }
+    out << '"';
+    return out.str();
+}
+
+double
+median(const std::vector< double >& sorted)
+{
+    PRE(!sorted.empty());
+
+    const std::size_t n = sorted.size();
+    if (n % 2 == 1)
+        return sorted[n / 2];
+    else
+        return (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+}
+
+//!
+//! \brief Computes the two-sided p-value of the Mann-Whitney U test.
+//!
+//! Uses the normal approximation with a continuity correction and the
+//! correction for ties, which is accurate enough for the sample sizes
+//! that benchmarks take.  Returns 1 if the samples cannot be told apart
+//! at all, e.g. because all of them are equal.
+//!
+double
+mann_whitney_p(const std::vector< double >& x, const std::vector< double >& y)
+{
+    const double n1 = x.size();
+    const double n2 = y.size();
+    const double n = n1 + n2;
+
+    std::vector< std::pair< double, bool > > all;
+    for (std::vector< double >::const_iterator iter = x.begin();
+         iter != x.end(); iter++)
+        all.push_back(std::make_pair(*iter, true));
+    for (std::vector< double >::const_iterator iter = y.begin();
+         iter != y.end(); iter++)
+        all.push_back(std::make_pair(*iter, false));
+    std::sort(all.begin(), all.end());
+
+    double r1 = 0.0;
+    double ties = 0.0;
+    for (std::size_t i = 0; i < all.size(); ) {
+        std::size_t j = i;
+        while (j < all.size() && all[j].first == all[i].first)
+            j++;
+
+        // Tied values get the average of the ranks i + 1 .. j.
+        const double rank = (i + 1 + j) / 2.0;
+        const double t = j - i;
+        ties += t * t * t - t;
+        for (std::size_t k = i; k < j; k++)
+            if (all[k].second)
+                r1 += rank;
+        i = j;
+    }
+
+    const double u = r1 - n1 * (n1 + 1) / 2;
+    const double mean = n1 * n2 / 2;
+    const double variance = n1 * n2 / 12 * ((n + 1) - ties / (n * (n - 1)));
+    if (variance <= 0.0)
+        return 1.0;
+
+    const double z = std::max(0.0, std::fabs(u - mean) - 0.5) /
+        std::sqrt(variance);
+    return std::erfc(z / std::sqrt(2.0));
+}
+
+void
+parse_samples(bench_data& data, const std::string& value)
+{
+    const std::vector< std::string > words = atf::text::split(value, " ");
+    for (std::vector< std::string >::const_iterator iter = words.begin();
+         iter != words.end(); iter++) {
+        try {
+            data.samples.push_back(atf::text::to_type< double >(*iter));
+        } catch (const std::runtime_error&) {
+            throw std::runtime_error("Invalid sample '" + *iter + "' for "
+                                     "benchmark " + data.ident + " in " +
+                                     data.source);
+        }
+    }
+    std::sort(data.samples.begin(), data.samples.end());
+}
+
+void
+add_bench(bench_map& benches, bench_data& data)
+{
+    if (data.samples.empty())
+        throw std::runtime_error("No samples for benchmark " + data.ident +
+                                 " in " + data.source);
+
+    const bench_map::const_iterator iter = benches.find(data.ident);
+    if (iter != benches.end())
+        throw std::runtime_error("Benchmark " + data.ident + " found in " +
+                                 (*iter).second.source + " and in " +
+                                 data.source);
+
+    benches[data.ident] = data;
+}
+
+//!
+//! \brief Reads a .bench file or a baseline.
+//!
+//! A baseline is a sequence of .bench files, each one preceded by an ident
+//! property and followed by an empty line.  A plain .bench file takes its
+//! name from the file, or from its directory if it is the result.bench
+//! file of a batch results directory.
+//!
+void
+read_file(const atf::fs::path& path, bench_map& benches)
+{
+    std::ifstream is(path.c_str());
+    if (!is)
+        throw std::runtime_error("Cannot open " + path.str());
+
+    std::unique_ptr< bench_data > data;
+    std::string line;
+    while (std::getline(is, line)) {
+        if (line.empty()) {
+            if (data.get() != NULL) {
+                add_bench(benches, *data);
+                data.reset();
+            }
+            continue;
+        }
+
+        const std::string::size_type pos = line.find(": ");
+        if (pos == std::string::npos)
+            throw std::runtime_error("Invalid line '" + line + "' in " +
+                                     path.str());
+        const std::string name = line.substr(0, pos);
+        const std::string value = line.substr(pos + 2);
+
+        if (name == "ident") {
+            if (data.get() != NULL)
+                add_bench(benches, *data);
+            data.reset(new bench_data());
+            data->ident = value;
+            data->source = path.str();
+            continue;
+        }
+
+        if (data.get() == NULL) {
+            std::string ident = path.leaf_name();
+            if (ident == "result.bench")
+                ident = path.branch_path().leaf_name();
+            else if (ident.size() > 6 &&
+                     ident.substr(ident.size() - 6) == ".bench")
+                ident = ident.substr(0, ident.size() - 6);
+
+            data.reset(new bench_data());
+            data->ident = ident;
+            data->source = path.str();
+        }
+
+        data->props.push_back(std::make_pair(name, value));
+        if (name == "ns_per_op.samples")
+            parse_samples(*data, value);
+    }
+
+    if (data.get() != NULL)
+        add_bench(benches, *data);
+}
+
+void
+read_input(const atf::fs::path& path, bench_map& benches)
+{
+    if (!atf::fs::exists(path))
+        throw std::runtime_error("Cannot open " + path.str() + ": no such "
+                                 "file or directory");
+
+    const atf::fs::file_info info(path);
+    if (info.get_type() != atf::fs::file_info::dir_type) {
+        read_file(path, benches);
+        return;
+    }
+
+    const atf::fs::directory dir(path);
+    for (atf::fs::directory::const_iterator iter = dir.begin();
+         iter != dir.end(); iter++) {
+        if ((*iter).first == "." || (*iter).first == ".." ||
+            (*iter).second.get_type() != atf::fs::file_info::dir_type)
+            continue;
+
+        const atf::fs::path file = path / (*iter).first / "result.bench";
+        if (atf::fs::exists(file))
+            read_file(file, benches);
+    }
+}
+
+void
+write_baseline(std::ostream& os, const bench_map& benches)
+{
+    for (bench_map::const_iterator iter = benches.begin();
+         iter != benches.end(); iter++) {
+        const bench_data& data = (*iter).second;
+
+        os << "ident: " << data.ident << "\n";
+        for (std::vector< std::pair< std::string, std::string > >::
+             const_iterator iter2 = data.props.begin();
+             iter2 != data.props.end(); iter2++)
+            os << (*iter2).first << ": " << (*iter2).second << "\n";
+        os << "\n";
+    }
+}
+
+void
+write_text_report(std::ostream& os, const std::vector< comparison >& cmps,
+                  const std::size_t failed, const std::size_t improved)
+{
+    for (std::vector< comparison >::const_iterator iter = cmps.begin();
+         iter != cmps.end(); iter++) {
+        const comparison& c = *iter;
+
+        os << c.ident << ": " << c.status;
+        if (c.baseline != NULL && c.current != NULL) {
+            os << ": median " << format_double(median(c.baseline->samples), 3)
+               << " -> " << format_double(median(c.current->samples), 3)
+               << " ns/op (" << (c.change >= 0.0 ? "+" : "")
+               << format_double(c.change * 100, 2) << "%), p = "
+               << format_double(c.p_value, 4);
+        } else if (c.current != NULL) {
+            os << ": median " << format_double(median(c.current->samples), 3)
+               << " ns/op";
+        }
+        os << "\n";
+    }
+    os << "Summary: " << cmps.size() << " benchmarks, " << failed
+       << " failed, " << improved << " improved\n";
+}
+
+void
+write_json_side(std::ostream& os, const char* name, const bench_data* data)
+{
+    os << format_json_string(name) << ": ";
+    if (data == NULL)
+        os << "null";
+    else
+        os << "{\"samples\": " << data->samples.size() << ", \"median\": "
+           << format_double(median(data->samples), 3) << "}";
+}
+
+void
+write_json_report(std::ostream& os, const std::vector< comparison >& cmps,
+                  const double threshold, const double alpha,
+                  const std::size_t failed, const std::size_t improved)
+{
+    os << "{\"threshold\": " << format_double(threshold, 3)
+       << ", \"alpha\": " << format_double(alpha, 6)
+       << ", \"failed\": " << failed
+       << ", \"improved\": " << improved
+       << ", \"benchmarks\": [";
+    for (std::vector< comparison >::const_iterator iter = cmps.begin();
+         iter != cmps.end(); iter++) {
+        const comparison& c = *iter;
+        const bool both = c.baseline != NULL && c.current != NULL;
+
+        os << (iter == cmps.begin() ? "\n" : ",\n")
+           << "{\"ident\": " << format_json_string(c.ident)
+           << ", \"status\": " << format_json_string(c.status) << ", ";
+        write_json_side(os, "baseline", c.baseline);
+        os << ", ";
+        write_json_side(os, "current", c.current);
+        os << ", \"change\": "
+           << (both ? format_double(c.change, 6) : "null")
+           << ", \"p_value\": "
+           << (both ? format_double(c.p_value, 6) : "null") << "}";
+    }
+    os << "\n]}\n";
+}
+
+} // anonymous namespace
+
+// ------------------------------------------------------------------------
+// The "atf_bench" application.
+// ------------------------------------------------------------------------
+
+namespace {
+
+class atf_bench : public atf::application::app {
+    bool m_sflag;
+    double m_alpha;
+    double m_threshold;
+    std::string m_jsonfile;
+    std::string m_outfile;
+
+    static const char* m_description;
+
+    std::string specific_args(void) const;
+    options_set specific_options(void) const;
+    void process_option(int, const char*);
+
+    std::vector< comparison > compare_benches(const bench_map&,
+                                              const bench_map&) const;
+    int save(std::ostream&);
+    int compare(std::ostream&);
+
+public:
+    atf_bench(void);
+    int main(void);
+};
+
+} // anonymous namespace
+
+const char* atf_bench::m_description =
+    "atf-bench saves the results of benchmarks as a baseline and compares "
+    "later runs against it.";
+
+atf_bench::atf_bench(void) :
+    app(m_description, "atf-bench(1)"),
+    m_sflag(false),
+    m_alpha(0.05),
+    m_threshold(5.0)
+{
+}
+
+std::string
+atf_bench::specific_args(void)
+    const
+{
+    return "<baseline> <input1> [.. <inputN>] | -s <input1> [.. <inputN>]";
+}
+
+atf_bench::options_set
+atf_bench::specific_options(void)
+    const
+{
+    using atf::application::option;
+    options_set opts;
+
+    opts.insert(option('a', "alpha", "Significance level of the comparison "
+                "(default: 0.05)"));
+    opts.insert(option('j', "file", "Write a JSON report to this file"));
+    opts.insert(option('o', "file", "Write the report or the baseline to "
+                "this file instead of stdout"));
+    opts.insert(option('s', "", "Save the inputs as a baseline"));
+    opts.insert(option('t', "percent", "Slowdown of the median above which "
+                "a benchmark fails (default: 5)"));
+
+    return opts;
+}
+
+void
+atf_bench::process_option(int ch, const char* arg)
+{
+    switch (ch) {
+    case 'a':
+        try {
+            m_alpha = atf::text::to_type< double >(arg);
+        } catch (const std::runtime_error&) {
+            throw atf::application::usage_error("Invalid alpha '%s'", arg);
+        }
+        if (m_alpha <= 0.0 || m_alpha >= 1.0)
+            throw atf::application::usage_error("Alpha must be between 0 "
+                                                "and 1");
+        break;
+
+    case 'j':
+        m_jsonfile = arg;
+        break;
+
+    case 'o':
+        m_outfile = arg;
+        break;
+
+    case 's':
+        m_sflag = true;
+        break;
+
+    case 't':
+        try {
+            m_threshold = atf::text::to_type< double >(arg);
+        } catch (const std::runtime_error&) {
+            throw atf::application::usage_error("Invalid threshold '%s'",
+                                                arg);
+        }
+        if (m_threshold < 0.0)
+            throw atf::application::usage_error("Threshold cannot be "
+                                                "negative");
+        break;
+
+    default:
+        UNREACHABLE;
+    }
+}
+
+std::vector< comparison >
+atf_bench::compare_benches(const bench_map& baseline,
+                           const bench_map& current)
+    const
+{
+    std::vector< comparison > cmps;
+
+    for (bench_map::const_iterator iter = current.begin();
+         iter != current.end(); iter++) {
+        const bench_data& cur = (*iter).second;
+
+        const bench_map::const_iterator iter2 = baseline.find(cur.ident);
+        if (iter2 == baseline.end()) {
+            cmps.push_back(comparison(cur.ident, "new", NULL, &cur, 0.0,
+                                      1.0));
+            continue;
+        }
+        const bench_data& base = (*iter2).second;
+
+        const double base_median = median(base.samples);
+        const double change = base_median > 0.0 ?
+            median(cur.samples) / base_median - 1.0 : 0.0;
+        const double p = mann_whitney_p(base.samples, cur.samples);
+
+        std::string status = "unchanged";
+        if (p < m_alpha && change * 100 > m_threshold)
+            status = "failed";
+        else if (p < m_alpha && -change * 100 > m_threshold)
+            status = "improved";
+        cmps.push_back(comparison(cur.ident, status, &base, &cur, change, p));
+    }
+
+    for (bench_map::const_iterator iter = baseline.begin();
+         iter != baseline.end(); iter++) {
+        if (current.find((*iter).first) == current.end())
+            cmps.push_back(comparison((*iter).first, "missing",
+                                      &(*iter).second, NULL, 0.0, 1.0));
+    }
+
+    return cmps;
+}
+
+int
+atf_bench::save(std::ostream& os)
+{
+    if (m_argc < 1)
+        throw atf::application::usage_error("No inputs specified");
+    if (!m_jsonfile.empty())
+        throw atf::application::usage_error("Cannot specify -j with -s");
+
+    bench_map benches;
+    for (int i = 0; i < m_argc; i++)
+        read_input(atf::fs::path(m_argv[i]), benches);
+
+    write_baseline(os, benches);
+    return EXIT_SUCCESS;
+}
+
+int
+atf_bench::compare(std::ostream& os)
+{
+    if (m_argc < 2)
+        throw atf::application::usage_error("No baseline or inputs "
+                                            "specified");
+
+    bench_map baseline;
+    read_input(atf::fs::path(m_argv[0]), baseline);
+
+    bench_map current;
+    for (int i = 1; i < m_argc; i++)
+        read_input(atf::fs::path(m_argv[i]), current);
+
+    const std::vector< comparison > cmps = compare_benches(baseline,
+                                                           current);
+    std::size_t failed = 0, improved = 0;
+    for (std::vector< comparison >::const_iterator iter = cmps.begin();
+         iter != cmps.end(); iter++) {
+        if ((*iter).status == "failed")
+            failed++;
+        else if ((*iter).status == "improved")
+            improved++;
+    }
+
+    write_text_report(os, cmps, failed, improved);
+    if (!m_jsonfile.empty()) {
+        std::ofstream json(m_jsonfile.c_str());
+        if (!json)
+            throw std::runtime_error("Cannot create " + m_jsonfile);
+        write_json_report(json, cmps, m_threshold, m_alpha, failed,
+                          improved);
+    }
+
+    return failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int
+atf_bench::main(void)
+{
+    std::ofstream out;
+    if (!m_outfile.empty()) {
+        out.open(m_outfile.c_str());
+        if (!out)
+            throw std::runtime_error("Cannot create " + m_outfile);
+    }
+    std::ostream& os = m_outfile.empty() ? std::cout : out;
+
+    return m_sflag ? save(os) : compare(os);
+}
+
+int
+main(int argc, char* const* argv)
+{
+    return atf_bench().run(argc, argv);
+}
@@ -0,0 +1,209 @@
+# Copyright (c) 2026 The NetBSD Foundation, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+# 1. Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+# CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+# INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+# IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+# DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+# GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+# IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+# OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+# IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+: ${ATF_BENCH:="__ATF_BENCH__"}
+
+# Creates a .bench file with the given samples.
+create_bench()
+{
+    file="${1}"; shift
+
+    echo "iterations: 1000" >"${file}"
+    echo "samples: ${#}" >>"${file}"
+    echo "ns_per_op.samples: ${*}" >>"${file}"
+}
+
+atf_test_case save
+save_head()
+{
+    atf_set "descr" "Tests that -s merges benchmark files into a baseline"
+}
+save_body()
+{
+    create_bench a.bench 1.0 2.0 3.0
+    create_bench b.bench 4.0 5.0 6.0
+    mkdir -p results/c
+    create_bench results/c/result.bench 7.0 8.0 9.0
+
+    cat >expout <<EOF
+ident: a
+iterations: 1000
+samples: 3
+ns_per_op.samples: 1.0 2.0 3.0
+
+ident: b
+iterations: 1000
+samples: 3
+ns_per_op.samples: 4.0 5.0 6.0
+
+ident: c
+iterations: 1000
+samples: 3
+ns_per_op.samples: 7.0 8.0 9.0
+
+EOF
+    atf_check -s eq:0 -o file:expout -e empty "${ATF_BENCH}" -s \
+        b.bench a.bench results
+    atf_check -s eq:0 -o empty -e empty "${ATF_BENCH}" -s -o baseline \
+        a.bench b.bench results
+    atf_check -s eq:0 -o file:expout -e empty cat baseline
+    atf_check -s eq:0 -o file:expout -e empty "${ATF_BENCH}" -s baseline
+}
+
+atf_test_case save_duplicate
+save_duplicate_head()
+{
+    atf_set "descr" "Tests that a benchmark cannot appear twice in the inputs"
+}
+save_duplicate_body()
+{
+    create_bench a.bench 1.0 2.0 3.0
+    mkdir -p results/a
+    create_bench results/a/result.bench 1.0 2.0 3.0
+    atf_check -s eq:1 -o empty -e match:"Benchmark a found in" \
+        "${ATF_BENCH}" -s a.bench results
+}
+
+atf_test_case no_samples
+no_samples_head()
+{
+    atf_set "descr" "Tests that benchmark files without samples are rejected"
+}
+no_samples_body()
+{
+    echo "iterations: 10" >a.bench
+    atf_check -s eq:1 -o empty -e match:"No samples for benchmark a" \
+        "${ATF_BENCH}" -s a.bench
+}
+
+atf_test_case unchanged
+unchanged_head()
+{
+    atf_set "descr" "Tests that equivalent runs compare as unchanged"
+}
+unchanged_body()
+{
+    create_bench x.bench 10.2 10.0 10.4 9.9 10.1 10.3 9.8 10.0
+    atf_check -s eq:0 -o empty -e empty "${ATF_BENCH}" -s -o baseline \
+        x.bench
+    create_bench x.bench 10.1 10.3 9.9 10.0 10.2 9.8 10.4 10.1
+    atf_check -s eq:0 -o match:"^x: unchanged: median 10.050 -> 10.100" \
+        -o match:"^Summary: 1 benchmarks, 0 failed, 0 improved$" -e empty \
+        "${ATF_BENCH}" baseline x.bench
+}
+
+atf_test_case regression
+regression_head()
+{
+    atf_set "descr" "Tests that a significant slowdown fails the comparison"
+}
+regression_body()
+{
+    mkdir old new
+    create_bench old/x.bench 10.2 10.0 10.4 9.9 10.1 10.3 9.8 10.0
+    create_bench new/x.bench 12.1 12.3 11.9 12.0 12.2 11.8 12.4 12.1
+    atf_check -s eq:1 -o match:"^x: failed: median 10.050 -> 12.100 ns/op" \
+        -o match:"\(\+20.40%\), p = 0.00" \
+        -o match:"^Summary: 1 benchmarks, 1 failed, 0 improved$" -e empty \
+        "${ATF_BENCH}" -j report.json old/x.bench new/x.bench
+    atf_check -s eq:0 -o match:'"failed": 1' \
+        -o match:'"ident": "x", "status": "failed"' \
+        -o match:'"baseline": \{"samples": 8, "median": 10.050\}' \
+        -o match:'"change": 0.20398' -e empty cat report.json
+
+    atf_check -s eq:0 -o match:"^x: unchanged" -e empty \
+        "${ATF_BENCH}" -t 25 old/x.bench new/x.bench
+    atf_check -s eq:0 -o match:"^x: unchanged" -e empty \
+        "${ATF_BENCH}" -a 0.00001 old/x.bench new/x.bench
+}
+
+atf_test_case improvement
+improvement_head()
+{
+    atf_set "descr" "Tests that a significant speedup is reported"
+}
+improvement_body()
+{
+    mkdir old new
+    create_bench old/x.bench 10.2 10.0 10.4 9.9 10.1 10.3 9.8 10.0
+    create_bench new/x.bench 8.1 8.3 7.9 8.0 8.2 7.8 8.4 8.1
+    atf_check -s eq:0 -o match:"^x: improved: .*\(-19.40%\)" \
+        -o match:"^Summary: 1 benchmarks, 0 failed, 1 improved$" -e empty \
+        "${ATF_BENCH}" old/x.bench new/x.bench
+}
+
+atf_test_case new_and_missing
+new_and_missing_head()
+{
+    atf_set "descr" "Tests that benchmarks only present in one side do not" \
+                    "fail the comparison"
+}
+new_and_missing_body()
+{
+    create_bench a.bench 1.0 2.0 3.0
+    create_bench b.bench 1.0 2.0 3.0
+    atf_check -s eq:0 -o empty -e empty "${ATF_BENCH}" -s -o baseline a.bench
+    atf_check -s eq:0 -o match:"^b: new: median 2.000 ns/op$" \
+        -o match:"^a: missing$" -e empty \
+        "${ATF_BENCH}" -j report.json baseline b.bench
+    atf_check -s eq:0 \
+        -o match:'"ident": "b", "status": "new", "baseline": null' \
+        -o match:'"ident": "a", "status": "missing", .*"current": null' \
+        -e empty cat report.json
+}
+
+atf_test_case usage_errors
+usage_errors_head()
+{
+    atf_set "descr" "Tests that invalid invocations are reported"
+}
+usage_errors_body()
+{
+    create_bench a.bench 1.0 2.0 3.0
+    atf_check -s eq:1 -o empty -e match:"No inputs specified" \
+        "${ATF_BENCH}" -s
+    atf_check -s eq:1 -o empty -e match:"No baseline or inputs specified" \
+        "${ATF_BENCH}" a.bench
+    atf_check -s eq:1 -o empty -e match:"Alpha must be between 0 and 1" \
+        "${ATF_BENCH}" -a 2 a.bench a.bench
+    atf_check -s eq:1 -o empty -e match:"Invalid threshold 'foo'" \
+        "${ATF_BENCH}" -t foo a.bench a.bench
+    atf_check -s eq:1 -o empty -e match:"Cannot open missing" \
+        "${ATF_BENCH}" a.bench missing
+}
+
+atf_init_test_cases()
+{
+    atf_add_test_case save
+    atf_add_test_case save_duplicate
+    atf_add_test_case no_samples
+    atf_add_test_case unchanged
+    atf_add_test_case regression
+    atf_add_test_case improvement
+    atf_add_test_case new_and_missing
+    atf_add_test_case usage_errors
+}
+
+# vim: syntax=sh:expandtab:shiftwidth=4:softtabstop=4
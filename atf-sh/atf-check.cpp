@@ -31,6 +31,10 @@ extern "C" {
 #include <signal.h>
 #include <stdint.h>
 #include <unistd.h>
+
+#include "atf-c/detail/compare.h"
+#include "atf-c/detail/diff.h"
+#include "atf-c/error.h"
 }
 
 #include <cerrno>
@@ -57,6 +61,10 @@ static const useconds_t seconds_in_useconds = (1000 * 1000);
 static const useconds_t mseconds_in_useconds = 1000;
 static const useconds_t useconds_in_nseconds = 1000;
 
+// Limits of the diffs printed when an output check fails.
+static const std::size_t diff_max_hunks = 100;
+static const std::size_t diff_max_bytes = 256 * 1024;
+
 // ------------------------------------------------------------------------
 // Auxiliary functions.
 // ------------------------------------------------------------------------
@@ -106,61 +114,203 @@ struct output_check {
     }
 };
 
-class temp_file : public std::ostream {
-    std::unique_ptr< atf::fs::path > m_path;
-    int m_fd;
+//!
+//! \brief An input stream over a block of memory.
+//!
+class memory_istream : public std::istream {
+    class buffer : public std::streambuf {
+    public:
+        buffer(const char* data, const std::size_t size)
+        {
+            char* begin = const_cast< char* >(data);
+            setg(begin, begin, begin + size);
+        }
+    };
+
+    buffer m_buf;
 
 public:
-    temp_file(const char* pattern) :
-        std::ostream(NULL),
-        m_fd(-1)
+    memory_istream(const char* data, const std::size_t size) :
+        std::istream(NULL),
+        m_buf(data, size)
     {
-        const atf::fs::path file = atf::fs::path(
-            atf::env::get("TMPDIR", "/tmp")) / pattern;
+        rdbuf(&m_buf);
+    }
+};
 
-        std::string file_s = file.str();
-        std::vector<char> buf(file_s.begin(), file_s.end() + 1);
+//!
+//! \brief One of the outputs of the checked command.
+//!
+//! The output is usually kept in memory by the check_result; this class
+//! hides whether it is there or in a file, which is only the case when
+//! the output is too large.
+//!
+class captured_output {
+    const atf::check::check_result& m_result;
+    const bool m_stdout;
+    const char* m_data;
+    std::size_t m_size;
+
+    static
+    void
+    print_diff_error(atf_error_t err)
+    {
+        if (atf_is_error(err)) {
+            char buf[1024];
+            atf_error_format(err, buf, sizeof(buf));
+            atf_error_free(err);
+            std::cerr << "Failed to compute the diff: " << buf << "\n";
+        }
+    }
 
-        m_fd = ::mkstemp(buf.data());
-        if (m_fd == -1)
-            throw atf::system_error("atf_check::temp_file::temp_file(" +
-                                    file.str() + ")", "mkstemp(3) failed",
-                                    errno);
+public:
+    captured_output(const atf::check::check_result& result,
+                    const std::string& stdxxx) :
+        m_result(result),
+        m_stdout(stdxxx == "stdout"),
+        m_size(0)
+    {
+        m_data = m_stdout ? result.stdout_data(&m_size) :
+                            result.stderr_data(&m_size);
+    }
 
-        m_path.reset(new atf::fs::path(buf.data()));
+    atf::fs::path
+    path(void) const
+    {
+        return atf::fs::path(m_stdout ? m_result.stdout_path() :
+                                        m_result.stderr_path());
     }
 
-    ~temp_file(void)
+    bool
+    empty(void) const
     {
-        close();
-        try {
-            remove(*m_path);
-        } catch (const atf::system_error&) {
-            // Ignore deletion errors.
+        if (m_data != NULL)
+            return m_size == 0;
+        else
+            return atf::fs::file_info(path()).get_size() == 0;
+    }
+
+    //!
+    //! \brief Compares the output against the contents of a file.
+    //!
+    atf_compare_result_t
+    compare(const std::string& golden) const
+    {
+        atf_compare_result_t result;
+        atf_error_t err;
+
+        if (m_data != NULL)
+            err = atf_compare_file_mem(golden.c_str(), m_data, m_size,
+                                       &result);
+        else
+            err = atf_compare_files(golden.c_str(), path().c_str(),
+                                    &result);
+        if (atf_is_error(err))
+            atf::throw_atf_error(err);
+        return result;
+    }
+
+    //!
+    //! \brief Compares the output against the given contents.
+    //!
+    atf_compare_result_t
+    compare_data(const std::string& expected) const
+    {
+        atf_compare_result_t result;
+
+        if (m_data != NULL) {
+            atf_compare_mem(expected.data(), expected.size(), m_data, m_size,
+                            &result);
+        } else {
+            atf_error_t err = atf_compare_file_mem(path().c_str(),
+                                                   expected.data(),
+                                                   expected.size(), &result);
+            if (atf_is_error(err))
+                atf::throw_atf_error(err);
         }
+        return result;
     }
 
-    const atf::fs::path&
-    get_path(void) const
+    void
+    scan(atf::text::regex_set& regexps) const
     {
-        return *m_path;
+        if (m_data != NULL) {
+            regexps.scan(m_data, m_size);
+        } else {
+            std::unique_ptr< std::istream > stream = open();
+            const std::string data(
+                (std::istreambuf_iterator< char >(*stream)),
+                std::istreambuf_iterator< char >());
+            regexps.scan(data.data(), data.size());
+        }
     }
 
+    //!
+    //! \brief Prints a unified diff from the given contents to the output.
+    //!
+    //! Failing to compute the diff is not fatal, as the check has already
+    //! failed; the error is printed instead.
+    //!
     void
-    write(const std::string& text)
+    print_diff(const void* expected, const std::size_t size,
+               const std::string& label) const
     {
-        if (::write(m_fd, text.c_str(), text.size()) == -1)
-            throw atf::system_error("atf_check", "write(2) failed", errno);
+        atf_diff_options_t options;
+        atf_error_t err;
+
+        atf_diff_options_init(&options, label.c_str(),
+                              m_stdout ? "stdout" : "stderr");
+        options.m_max_hunks = diff_max_hunks;
+        options.m_max_bytes = diff_max_bytes;
+
+        if (m_data != NULL)
+            err = atf_diff_mem(expected, size, m_data, m_size, &options,
+                               STDERR_FILENO);
+        else {
+            atf_file_contents_t contents;
+
+            err = atf_file_contents_init(&contents, path().c_str());
+            if (!atf_is_error(err)) {
+                err = atf_diff_mem(expected, size, contents.m_data,
+                                   contents.m_size, &options, STDERR_FILENO);
+                atf_file_contents_fini(&contents);
+            }
+        }
+        print_diff_error(err);
     }
 
+    //!
+    //! \brief Prints a unified diff from a golden file to the output.
+    //!
     void
-    close(void)
+    print_diff_file(const std::string& golden) const
     {
-        if (m_fd != -1) {
-            flush();
-            ::close(m_fd);
-            m_fd = -1;
+        atf_file_contents_t contents;
+        atf_error_t err;
+
+        err = atf_file_contents_init(&contents, golden.c_str());
+        if (atf_is_error(err)) {
+            print_diff_error(err);
+            return;
         }
+
+        print_diff(contents.m_data, contents.m_size, golden);
+        atf_file_contents_fini(&contents);
+    }
+
+    std::unique_ptr< std::istream >
+    open(void) const
+    {
+        if (m_data != NULL)
+            return std::unique_ptr< std::istream >(
+                new memory_istream(m_data, m_size));
+
+        const atf::fs::path p = path();
+        std::unique_ptr< std::istream > stream(
+            new std::ifstream(p.c_str(), std::fstream::binary));
+        if (!*stream)
+            throw std::runtime_error("Failed to open " + p.str());
+        return stream;
     }
 };
 
@@ -337,6 +487,24 @@ parse_output_check_arg(const std::string& arg)
     return output_check(type, negated, arg.substr(delimiter + 1));
 }
 
+static
+int
+parse_timeout_arg(const std::string& arg)
+{
+    char *end;
+
+    errno = 0;
+    const double seconds = std::strtod(arg.c_str(), &end);
+    if (errno != 0 || arg.empty() || *end != '\0' || !(seconds > 0))
+        throw atf::application::usage_error("Timeout must be a positive "
+                                            "number of seconds");
+    if (seconds >= INT_MAX / 1000)
+        throw atf::application::usage_error("Bogus timeout in seconds");
+
+    const int timeout_ms = static_cast< int >(seconds * 1000);
+    return timeout_ms > 0 ? timeout_ms : 1;
+}
+
 static void
 parse_repeat_check_arg(const std::string& arg, useconds_t *m_timo,
     useconds_t *m_interval)
@@ -414,7 +582,10 @@ flatten_argv(char* const* argv)
 
 static
 std::unique_ptr< atf::check::check_result >
-execute(const char* const* argv)
+execute(const char* const* argv,
+        const atf::check::expected_output* out_expect,
+        const atf::check::expected_output* err_expect,
+        const int timeout_ms)
 {
     // TODO: This should go to stderr... but fixing it now may be hard as test
     // cases out there might be relying on stderr being silent.
@@ -425,12 +596,15 @@ execute(const char* const* argv)
     std::cout.flush();
 
     atf::process::argv_array argva(argv);
-    return atf::check::exec(argva);
+    return atf::check::exec(argva, out_expect, err_expect, timeout_ms);
 }
 
 static
 std::unique_ptr< atf::check::check_result >
-execute_with_shell(char* const* argv)
+execute_with_shell(char* const* argv,
+                   const atf::check::expected_output* out_expect,
+                   const atf::check::expected_output* err_expect,
+                   const int timeout_ms)
 {
     const std::string cmd = flatten_argv(argv);
     const std::string shell = atf::env::get("ATF_SHELL", ATF_SHELL);
@@ -440,110 +614,45 @@ execute_with_shell(char* const* argv)
     sh_argv[1] = "-c";
     sh_argv[2] = cmd.c_str();
     sh_argv[3] = NULL;
-    return execute(sh_argv);
+    return execute(sh_argv, out_expect, err_expect, timeout_ms);
 }
 
 static
 void
-cat_file(const atf::fs::path& path)
+cat_stream(std::istream& stream)
 {
-    std::ifstream stream(path.c_str());
-    if (!stream)
-        throw std::runtime_error("Failed to open " + path.str());
-
     stream >> std::noskipws;
     std::istream_iterator< char > begin(stream), end;
     std::ostream_iterator< char > out(std::cerr);
     std::copy(begin, end, out);
-
-    stream.close();
 }
 
 static
-bool
-grep_file(const atf::fs::path& path, const std::string& regexp)
+void
+print_partial_output(const atf::check::check_result& r,
+                     const std::string& stdxxx)
 {
-    std::ifstream stream(path.c_str());
-    if (!stream)
-        throw std::runtime_error("Failed to open " + path.str());
+    const captured_output output(r, stdxxx);
 
-    bool found = false;
-
-    std::string line;
-    while (!found && !std::getline(stream, line).fail()) {
-        if (atf::text::match(line, regexp))
-            found = true;
+    if (output.empty())
+        std::cerr << "No " << stdxxx << " before the timeout\n";
+    else {
+        std::cerr << "Partial " << stdxxx << ":\n";
+        cat_stream(*output.open());
     }
-
-    stream.close();
-
-    return found;
 }
 
 static
-bool
-file_empty(const atf::fs::path& p)
-{
-    atf::fs::file_info f(p);
-
-    return (f.get_size() == 0);
-}
-
-static bool
-compare_files(const atf::fs::path& p1, const atf::fs::path& p2)
+void
+cat_file(const atf::fs::path& path)
 {
-    bool equal = false;
-
-    std::ifstream f1(p1.c_str());
-    if (!f1)
-        throw std::runtime_error("Failed to open " + p1.str());
-
-    std::ifstream f2(p2.c_str());
-    if (!f2)
-        throw std::runtime_error("Failed to open " + p2.str());
-
-    for (;;) {
-        char buf1[512], buf2[512];
-
-        f1.read(buf1, sizeof(buf1));
-        if (f1.bad())
-            throw std::runtime_error("Failed to read from " + p1.str());
-
-        f2.read(buf2, sizeof(buf2));
-        if (f2.bad())
-            throw std::runtime_error("Failed to read from " + p2.str());
-
-        if ((f1.gcount() == 0) && (f2.gcount() == 0)) {
-            equal = true;
-            break;
-        }
-
-        if ((f1.gcount() != f2.gcount()) ||
-            (std::memcmp(buf1, buf2, f1.gcount()) != 0)) {
-            break;
-        }
-    }
+    std::ifstream stream(path.c_str());
+    if (!stream)
+        throw std::runtime_error("Failed to open " + path.str());
 
-    return equal;
-}
+    cat_stream(stream);
 
-static
-void
-print_diff(const atf::fs::path& p1, const atf::fs::path& p2)
-{
-    const atf::process::status s =
-        atf::process::exec(atf::fs::path("diff"),
-                           atf::process::argv_array("diff", "-u", p1.c_str(),
-                                                    p2.c_str(), NULL),
-                           atf::process::stream_connect(STDOUT_FILENO,
-                                                        STDERR_FILENO),
-                           atf::process::stream_inherit());
-
-    if (!s.exited())
-        std::cerr << "Failed to run diff(3)\n";
-
-    if (s.exitstatus() != 1)
-        std::cerr << "Error while running diff(3)\n";
+    stream.close();
 }
 
 static
@@ -649,11 +758,11 @@ run_status_check(const status_check& sc, const atf::check::check_result& cr)
 
     if (result == false) {
         std::cerr << "stdout:\n";
-        cat_file(atf::fs::path(cr.stdout_path()));
+        cat_stream(*captured_output(cr, "stdout").open());
         std::cerr << "\n";
 
         std::cerr << "stderr:\n";
-        cat_file(atf::fs::path(cr.stderr_path()));
+        cat_stream(*captured_output(cr, "stderr").open());
         std::cerr << "\n";
     }
 
@@ -675,18 +784,24 @@ run_status_checks(const std::vector< status_check >& checks,
     return ok;
 }
 
+//!
+//! \brief Runs an output check.
+//!
+//! For match checks, 'match_line' is the number of the first line that
+//! matched the expression, or 0 if none did.
+//!
 static
 bool
-run_output_check(const output_check oc, const atf::fs::path& path,
-                 const std::string& stdxxx)
+run_output_check(const output_check oc, const captured_output& output,
+                 const std::string& stdxxx, const std::size_t match_line)
 {
     bool result;
 
     if (oc.type == oc_empty) {
-        const bool is_empty = file_empty(path);
+        const bool is_empty = output.empty();
         if (!oc.negated && !is_empty) {
             std::cerr << "Fail: " << stdxxx << " not empty\n";
-            print_diff(atf::fs::path("/dev/null"), path);
+            output.print_diff("", 0, "/dev/null");
             result = false;
         } else if (oc.negated && is_empty) {
             std::cerr << "Fail: " << stdxxx << " is empty\n";
@@ -694,11 +809,13 @@ run_output_check(const output_check oc, const atf::fs::path& path,
         } else
             result = true;
     } else if (oc.type == oc_file) {
-        const bool equals = compare_files(path, atf::fs::path(oc.value));
+        const atf_compare_result_t cmp = output.compare(oc.value);
+        const bool equals = cmp.m_equal;
         if (!oc.negated && !equals) {
             std::cerr << "Fail: " << stdxxx << " does not match golden "
-                "output\n";
-            print_diff(atf::fs::path(oc.value), path);
+                "output (first difference at byte " << cmp.m_offset
+                      << ", line " << cmp.m_line << ")\n";
+            output.print_diff_file(oc.value);
             result = false;
         } else if (oc.negated && equals) {
             std::cerr << "Fail: " << stdxxx << " matches golden output\n";
@@ -709,41 +826,38 @@ run_output_check(const output_check oc, const atf::fs::path& path,
     } else if (oc.type == oc_ignore) {
         result = true;
     } else if (oc.type == oc_inline) {
-        temp_file temp("atf-check.XXXXXX");
-        temp.write(decode(oc.value));
-        temp.close();
-
-        const bool equals = compare_files(path, temp.get_path());
+        const std::string expected = decode(oc.value);
+        const bool equals = output.compare_data(expected).m_equal;
         if (!oc.negated && !equals) {
             std::cerr << "Fail: " << stdxxx << " does not match expected "
                 "value\n";
-            print_diff(temp.get_path(), path);
+            output.print_diff(expected.data(), expected.size(), "expected");
             result = false;
         } else if (oc.negated && equals) {
             std::cerr << "Fail: " << stdxxx << " matches expected value\n";
-            cat_file(temp.get_path());
+            std::cerr << expected;
             result = false;
         } else
             result = true;
     } else if (oc.type == oc_match) {
-        const bool matches = grep_file(path, oc.value);
+        const bool matches = match_line > 0;
         if (!oc.negated && !matches) {
             std::cerr << "Fail: regexp " + oc.value + " not in " << stdxxx
                       << "\n";
-            cat_file(path);
+            cat_stream(*output.open());
             result = false;
         } else if (oc.negated && matches) {
             std::cerr << "Fail: regexp " + oc.value + " is in " << stdxxx
-                      << "\n";
-            cat_file(path);
+                      << " at line " << match_line << "\n";
+            cat_stream(*output.open());
             result = false;
         } else
             result = true;
     } else if (oc.type == oc_save) {
         INV(!oc.negated);
-        std::ifstream ifs(path.c_str(), std::fstream::binary);
-        ifs >> std::noskipws;
-        std::istream_iterator< char > begin(ifs), end;
+        std::unique_ptr< std::istream > is = output.open();
+        *is >> std::noskipws;
+        std::istream_iterator< char > begin(*is), end;
 
         std::ofstream ofs(oc.value.c_str(), std::fstream::binary
                                      | std::fstream::trunc);
@@ -759,16 +873,54 @@ run_output_check(const output_check oc, const atf::fs::path& path,
     return result;
 }
 
+static
+void
+write_usage(const atf::check::check_result& r, const std::string& path)
+{
+    std::ofstream ofs(path.c_str(), std::fstream::trunc);
+    if (!ofs)
+        throw std::runtime_error("Cannot create usage file '" + path + "'");
+
+    ofs << "wall.usec: " << r.wall_usec() << "\n"
+        << "user.usec: " << r.user_usec() << "\n"
+        << "system.usec: " << r.system_usec() << "\n"
+        << "maxrss.kb: " << r.maxrss_kb() << "\n"
+        << "minflt: " << r.minflt() << "\n"
+        << "majflt: " << r.majflt() << "\n"
+        << "nvcsw: " << r.nvcsw() << "\n"
+        << "nivcsw: " << r.nivcsw() << "\n";
+    if (!ofs)
+        throw std::runtime_error("Cannot write usage file '" + path + "'");
+}
+
 static
 bool
 run_output_checks(const std::vector< output_check >& checks,
-                  const atf::fs::path& path, const std::string& stdxxx)
+                  const captured_output& output, const std::string& stdxxx)
 {
     bool ok = true;
 
+    // Evaluate all the match checks in a single scan of the output.
+    std::vector< std::string > regexps;
     for (std::vector< output_check >::const_iterator iter = checks.begin();
          iter != checks.end(); iter++) {
-         ok &= run_output_check(*iter, path, stdxxx);
+        if (iter->type == oc_match)
+            regexps.push_back(iter->value);
+    }
+    atf::text::regex_set matches(regexps);
+    if (!regexps.empty())
+        output.scan(matches);
+
+    std::size_t match = 0;
+    for (std::vector< output_check >::const_iterator iter = checks.begin();
+         iter != checks.end(); iter++) {
+        std::size_t match_line = 0;
+        if (iter->type == oc_match) {
+            if (matches.matched(match))
+                match_line = matches.line(match);
+            match++;
+        }
+        ok &= run_output_check(*iter, output, stdxxx, match_line);
     }
 
     return ok;
@@ -780,13 +932,84 @@ run_output_checks(const std::vector< output_check >& checks,
 
 namespace {
 
+//!
+//! \brief The expected contents of an output, if they can be compared
+//! with it while the command runs.
+//!
+//! This is the case when the output must match a file or an inline value,
+//! as the command can then be stopped as soon as the output diverges.  An
+//! output that is saved must be read in full, so it is not compared early.
+//!
+class streamed_check {
+    std::string m_inline;
+    bool m_has_contents;
+    atf_file_contents_t m_contents;
+    std::unique_ptr< atf::check::expected_output > m_expected;
+
+    // Non-copyable.
+    streamed_check(const streamed_check&);
+    streamed_check& operator=(const streamed_check&);
+
+public:
+    streamed_check(const std::vector< output_check >& checks) :
+        m_has_contents(false)
+    {
+        const output_check* streamed = NULL;
+
+        for (std::vector< output_check >::const_iterator iter =
+             checks.begin(); iter != checks.end(); iter++) {
+            if ((*iter).type == oc_save)
+                return;
+            if (streamed == NULL && !(*iter).negated &&
+                ((*iter).type == oc_file || (*iter).type == oc_inline))
+                streamed = &(*iter);
+        }
+        if (streamed == NULL)
+            return;
+
+        if (streamed->type == oc_inline) {
+            m_inline = decode(streamed->value);
+            m_expected.reset(new atf::check::expected_output(
+                m_inline.data(), m_inline.size()));
+        } else {
+            // Errors are reported by the check itself once the command
+            // has run.
+            atf_error_t err = atf_file_contents_init(
+                &m_contents, streamed->value.c_str());
+            if (atf_is_error(err)) {
+                atf_error_free(err);
+                return;
+            }
+            m_has_contents = true;
+            m_expected.reset(new atf::check::expected_output(
+                m_contents.m_data, m_contents.m_size));
+        }
+    }
+
+    ~streamed_check(void)
+    {
+        if (m_has_contents)
+            atf_file_contents_fini(&m_contents);
+    }
+
+    const atf::check::expected_output*
+    get(void) const
+    {
+        return m_expected.get();
+    }
+};
+
 class atf_check : public atf::application::app {
     bool m_rflag;
     bool m_xflag;
+    std::string m_usage_path;
 
     useconds_t m_timo;
     useconds_t m_interval;
 
+    std::string m_timeout_arg;
+    int m_timeout_ms;
+
     std::vector< status_check > m_status_checks;
     std::vector< output_check > m_stdout_checks;
     std::vector< output_check > m_stderr_checks;
@@ -814,7 +1037,8 @@ const char* atf_check::m_description =
 atf_check::atf_check(void) :
     app(m_description, "atf-check(1)"),
     m_rflag(false),
-    m_xflag(false)
+    m_xflag(false),
+    m_timeout_ms(0)
 {
 }
 
@@ -825,10 +1049,10 @@ atf_check::run_output_checks(const atf::check::check_result& r,
 {
     if (stdxxx == "stdout") {
         return ::run_output_checks(m_stdout_checks,
-            atf::fs::path(r.stdout_path()), "stdout");
+            captured_output(r, "stdout"), "stdout");
     } else if (stdxxx == "stderr") {
         return ::run_output_checks(m_stderr_checks,
-            atf::fs::path(r.stderr_path()), "stderr");
+            captured_output(r, "stderr"), "stderr");
     } else {
         UNREACHABLE;
         return false;
@@ -859,6 +1083,10 @@ atf_check::specific_options(void)
                 "save:<path>"));
     opts.insert(option('r', "timeout[:interval]", "Repeat failed check until "
                 "the timeout expires."));
+    opts.insert(option('t', "seconds", "Kill the command and fail if it "
+                "runs for longer than the given number of seconds"));
+    opts.insert(option('u', "path", "Write the resources consumed by the "
+                "command to the given file"));
     opts.insert(option('x', "", "Execute command as a shell command"));
 
     return opts;
@@ -885,6 +1113,15 @@ atf_check::process_option(int ch, const char* arg)
         parse_repeat_check_arg(arg, &m_timo, &m_interval);
         break;
 
+    case 't':
+        m_timeout_arg = arg;
+        m_timeout_ms = parse_timeout_arg(arg);
+        break;
+
+    case 'u':
+        m_usage_path = arg;
+        break;
+
     case 'x':
         m_xflag = true;
         break;
@@ -914,13 +1151,44 @@ atf_check::main(void)
     if (m_stderr_checks.empty())
         m_stderr_checks.push_back(output_check(oc_empty, false, ""));
 
+    const streamed_check out_expect(m_stdout_checks);
+    const streamed_check err_expect(m_stderr_checks);
+
     do {
         std::unique_ptr< atf::check::check_result > r =
-            m_xflag ? execute_with_shell(m_argv) : execute(m_argv);
-
-        if ((run_status_checks(m_status_checks, *r) == false) ||
-            (run_output_checks(*r, "stderr") == false) ||
-            (run_output_checks(*r, "stdout") == false))
+            m_xflag ? execute_with_shell(m_argv, out_expect.get(),
+                                         err_expect.get(), m_timeout_ms)
+                    : execute(m_argv, out_expect.get(), err_expect.get(),
+                              m_timeout_ms);
+
+        if (!m_usage_path.empty())
+            write_usage(*r, m_usage_path);
+
+        std::size_t offset;
+        const bool out_diverged = r->stdout_diverged(&offset);
+        if (r->timed_out()) {
+            // The status and the outputs of a killed command are
+            // incomplete, so show what there is instead of checking them.
+            std::cerr << "Fail: command timed out after " << m_timeout_arg
+                      << " seconds and was killed\n";
+            print_partial_output(*r, "stdout");
+            print_partial_output(*r, "stderr");
+            status = EXIT_FAILURE;
+        } else if (out_diverged || r->stderr_diverged(&offset)) {
+            // The command was killed, so its exit status is meaningless and
+            // the check of the output that diverged is what failed.
+            std::cerr << "Command killed because its "
+                      << (out_diverged ? "stdout" : "stderr")
+                      << " diverged from the expected output at byte "
+                      << offset << "\n";
+            // Report the checks of both streams, not only up to the first
+            // one that fails.
+            (void)run_output_checks(*r, "stderr");
+            (void)run_output_checks(*r, "stdout");
+            status = EXIT_FAILURE;
+        } else if ((run_status_checks(m_status_checks, *r) == false) ||
+                   (run_output_checks(*r, "stderr") == false) ||
+                   (run_output_checks(*r, "stdout") == false))
             status = EXIT_FAILURE;
         else
             status = EXIT_SUCCESS;
@@ -156,6 +156,57 @@ xflag_body()
         atf_fail "Using -x does not respect all provided arguments"
 }
 
+atf_test_case tflag
+tflag_head()
+{
+    atf_set "descr" "Tests for the -t option"
+    atf_set "timeout" "60"
+}
+tflag_body()
+{
+    atf_check -s eq:1 -o ignore \
+        -e match:'^Fail: command timed out after 0.5 seconds and was killed$' \
+        -e match:'^Partial stdout:$' -e match:'^partial$' \
+        -e match:'^No stderr before the timeout$' \
+        "${Atf_Check}" -t 0.5 -o empty -x 'echo partial; sleep 60'
+
+    atf_check -s eq:1 -o ignore -e match:'timed out after 1 seconds' \
+        "${Atf_Check}" -t 1 -x 'trap "" TERM; sleep 60 & wait'
+
+    atf_check -s eq:0 -o ignore -e empty "${Atf_Check}" -t 30 \
+        -o inline:'done\n' echo done
+
+    atf_check -s eq:1 -o empty -e match:'Timeout must be a positive number' \
+        "${Atf_Check}" -t 0 true
+    atf_check -s eq:1 -o empty -e match:'Timeout must be a positive number' \
+        "${Atf_Check}" -t foo true
+}
+
+atf_test_case uflag
+uflag_head()
+{
+    atf_set "descr" "Tests for the -u option"
+}
+uflag_body()
+{
+    atf_check -s eq:0 -o ignore -e empty "${Atf_Check}" -u usage sleep 1
+    cat usage
+    for name in wall.usec user.usec system.usec maxrss.kb minflt majflt \
+        nvcsw nivcsw
+    do
+        atf_check -s eq:0 -o ignore -e empty \
+            grep "^${name}: [0-9][0-9]*\$" usage
+    done
+    wall=$(sed -n 's,^wall.usec: ,,p' usage)
+    [ "${wall}" -ge 1000000 ] || atf_fail "Wall time ${wall} is too short"
+
+    atf_check -s eq:1 -o ignore -e ignore "${Atf_Check}" -u failed false
+    atf_check -s eq:0 -o ignore -e empty grep '^maxrss.kb: ' failed
+
+    atf_check -s eq:1 -o ignore -e match:"Cannot create usage file" \
+        "${Atf_Check}" -u non-existent/usage true
+}
+
 atf_test_case oflag_empty
 oflag_empty_head()
 {
@@ -192,6 +243,11 @@ oflag_file_body()
     h_pass "echo foo" -o file:text
     h_fail "echo bar" -o file:text
 
+    printf 'foo\nbar\nbaz\n' >lines
+    atf_check -s eq:1 -o ignore \
+        -e match:"does not match golden output \(first difference at byte 9, line 3\)" \
+        "${Atf_Check}" -o file:lines -x "printf 'foo\\nbar\\nbiz\\n'"
+
     dd if=/dev/urandom of=bin bs=1k count=10
     h_pass "cat bin" -o file:bin
 }
@@ -251,6 +307,24 @@ oflag_multiple_body()
     h_pass "echo foo; echo bar" -o match:foo -o match:bar
     h_fail "echo foo baz" -o match:bar -o match:foo
     h_fail "echo foo; echo baz" -o match:bar -o match:foo
+    h_pass "echo foo; echo bar" -o match:foo -o not-match:baz -o match:bar
+    h_fail "echo foo; echo bar" -o match:bar -o not-match:foo
+
+    # All the patterns are checked in a single pass; make sure each one
+    # still reports its own result.
+    ${Atf_Check} -o match:foo -o match:baz -o match:bar -x \
+        'echo foo; echo bar' 2>stderr && \
+        atf_fail "atf-check returned 0 but it should have failed"
+    atf_check -s eq:0 -o ignore -e empty grep "regexp baz not in stdout" stderr
+    atf_check -s eq:1 -o empty -e empty grep "regexp foo" stderr
+    atf_check -s eq:1 -o empty -e empty grep "regexp bar" stderr
+
+    # Negated matches report where the expression was found.
+    ${Atf_Check} -o match:foo -o not-match:ba -x \
+        'echo foo; echo bar; echo baz' 2>stderr && \
+        atf_fail "atf-check returned 0 but it should have failed"
+    atf_check -s eq:0 -o ignore -e empty \
+        grep "regexp ba is in stdout at line 2" stderr
 }
 
 atf_test_case oflag_negated
@@ -378,6 +452,69 @@ eflag_negated_body()
     h_fail "echo foo bar 1>&2" -e not-match:foo
 }
 
+atf_test_case diff
+diff_head()
+{
+    atf_set "descr" "Tests the diffs printed when an output does not" \
+                    "match its expected value"
+}
+diff_body()
+{
+    printf 'foo\nbar\nbaz\n' >lines
+    atf_check -s eq:1 -o ignore -e match:'^--- lines$' \
+        -e match:'^\+\+\+ stdout$' -e match:'^@@ -1,3 \+1,3 @@$' \
+        -e match:'^-baz$' -e match:'^\+biz$' \
+        "${Atf_Check}" -o file:lines -x "printf 'foo\\nbar\\nbiz\\n'"
+
+    atf_check -s eq:1 -o ignore -e match:'^--- expected$' \
+        -e match:'^\+\+\+ stderr$' -e match:'^-foo$' -e match:'^\+bar$' \
+        "${Atf_Check}" -e inline:'foo\n' -x 'echo bar 1>&2'
+
+    atf_check -s eq:1 -o ignore -e match:'^--- /dev/null$' \
+        -e match:'^@@ -0,0 \+1 @@$' -e match:'^\+bar$' \
+        "${Atf_Check}" -o empty echo bar
+
+    awk 'BEGIN { for (i = 0; i < 2000; i++) print i }' >golden
+    cat >changed.sh <<EOF
+awk 'BEGIN { for (i = 0; i < 2000; i++) print (i % 10 == 5 ? "x" : i) }'
+EOF
+    atf_check -s eq:1 -o ignore -e match:'^-995$' \
+        -e not-match:'^-1005$' -e match:'^\[100 more hunks not shown\]$' \
+        "${Atf_Check}" -o file:golden -o save:actual sh changed.sh
+}
+
+atf_test_case diverged
+diverged_head()
+{
+    atf_set "descr" "Tests that commands are stopped as soon as their output" \
+                    "diverges from the expected contents"
+    atf_set "timeout" "60"
+}
+diverged_body()
+{
+    atf_check -s eq:1 -o ignore -e match:'^--- expected$' \
+        -e match:'Command killed because its stdout diverged from the expected output at byte 4$' \
+        "${Atf_Check}" -o inline:'y\ny\n' yes
+
+    printf 'y\ny\nn\n' >golden
+    atf_check -s eq:1 -o ignore \
+        -e match:'Command killed because its stderr diverged from the expected output at byte 4$' \
+        "${Atf_Check}" -e file:golden -x 'yes 1>&2'
+    atf_check -s eq:1 -o ignore \
+        -e match:'Command killed because its stderr diverged' \
+        -e match:'stderr does not match golden output' \
+        -e match:'stdout does not match expected value' \
+        "${Atf_Check}" -e file:golden -o inline:'x\n' -x 'yes 1>&2'
+
+    atf_check -s eq:0 -o ignore -e empty "${Atf_Check}" -o inline:'y\n' \
+        -x 'yes | head -n 1'
+
+    atf_check -s eq:1 -o ignore -e not-match:'Command killed' \
+        -e match:'stdout does not match expected value' \
+        "${Atf_Check}" -o inline:'y\n' -o save:saved -x 'yes | head -n 3'
+    atf_check -s eq:0 -o inline:'y\ny\ny\n' -e empty cat saved
+}
+
 atf_test_case stdin
 stdin_head()
 {
@@ -393,12 +530,12 @@ atf_test_case invalid_umask
 invalid_umask_head()
 {
     atf_set "descr" "Tests for a correct error condition if the umask is" \
-            "too restrictive"
+            "too restrictive to store a large output"
 }
 invalid_umask_body()
 {
     umask 0222
-    ${Atf_Check} false 2>stderr && \
+    ${Atf_Check} -o ignore -x 'yes | head -n 200000' 2>stderr && \
         atf_fail "atf-check returned 0 but it should have failed"
     cat stderr
     grep 'temporary.*current umask.*0222' stderr >/dev/null || \
@@ -414,6 +551,8 @@ atf_init_test_cases()
     atf_add_test_case sflag_signal
 
     atf_add_test_case xflag
+    atf_add_test_case tflag
+    atf_add_test_case uflag
 
     atf_add_test_case oflag_empty
     atf_add_test_case oflag_ignore
@@ -433,6 +572,9 @@ atf_init_test_cases()
     atf_add_test_case eflag_multiple
     atf_add_test_case eflag_negated
 
+    atf_add_test_case diff
+    atf_add_test_case diverged
+
     atf_add_test_case stdin
 
     atf_add_test_case invalid_umask
@@ -24,7 +24,16 @@
 // IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 extern "C" {
+#include <sys/types.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include <signal.h>
 #include <unistd.h>
+
+#include "atf-c/detail/usage.h"
+#include "atf-c/error.h"
 }
 
 #include <cerrno>
@@ -34,6 +43,7 @@ extern "C" {
 
 #include "atf-c++/detail/application.hpp"
 #include "atf-c++/detail/env.hpp"
+#include "atf-c++/detail/exceptions.hpp"
 #include "atf-c++/detail/fs.hpp"
 #include "atf-c++/detail/sanity.hpp"
 
@@ -99,6 +109,112 @@ construct_argv(const std::string& shell, const int interpreter_argc,
     return argv;
 }
 
+//
+// Returns the results file that the test program is going to write, or an
+// empty string if it is not going to run a test case into a file.  This
+// must recognize the same options as main() in libatf-sh.subr.
+//
+static
+std::string
+find_resfile(const int interpreter_argc, const char* const* interpreter_argv)
+{
+    std::string resfile;
+
+    for (int i = 1; i < interpreter_argc; i++) {
+        const char* arg = interpreter_argv[i];
+        if (arg[0] != '-' || arg[1] == '\0' || std::strcmp(arg, "--") == 0)
+            break;
+
+        for (const char* ptr = arg + 1; *ptr != '\0'; ptr++) {
+            if (*ptr == 'l')
+                return "";
+            else if (*ptr == 'r' || *ptr == 's' || *ptr == 'v') {
+                const char* value;
+                if (*(ptr + 1) != '\0')
+                    value = ptr + 1;
+                else if (i + 1 < interpreter_argc)
+                    value = interpreter_argv[++i];
+                else
+                    return "";
+
+                if (*ptr == 'r')
+                    resfile = value;
+                break;
+            }
+        }
+    }
+
+    if (resfile == "/dev/stdout" || resfile == "/dev/stderr")
+        return "";
+    return resfile;
+}
+
+static
+void
+write_usage(const atf_usage_mark_t* mark, const struct rusage* ru,
+            const std::string& resfile)
+{
+    struct stat sb;
+    if (::stat(resfile.c_str(), &sb) == -1 || !S_ISREG(sb.st_mode))
+        return;
+
+    atf_usage_t usage;
+    atf_usage_since_child(mark, ru, &usage);
+
+    int fd;
+    atf_error_t err = atf_usage_open(resfile.c_str(), &fd);
+    if (!atf_is_error(err)) {
+        err = atf_usage_write(&usage, fd);
+        ::close(fd);
+    }
+    if (atf_is_error(err))
+        atf::throw_atf_error(err);
+}
+
+//
+// Runs the shell in a subprocess so that the resources it consumes can be
+// recorded next to the results file, and then terminates in the same way
+// as the shell did.
+//
+static
+int
+run_with_usage(const std::string& shell, const char** argv,
+               const std::string& resfile)
+{
+    atf_usage_mark_t mark;
+    atf_usage_mark_init(&mark, STDOUT_FILENO, STDERR_FILENO);
+
+    const pid_t pid = ::fork();
+    if (pid == -1)
+        throw atf::system_error("atf_sh::main", "fork failed", errno);
+    else if (pid == 0) {
+        ::execv(shell.c_str(), const_cast< char** >(argv));
+        std::cerr << "Failed to execute " << shell << ": "
+                  << std::strerror(errno) << "\n";
+        std::cerr.flush();
+        ::_exit(EXIT_FAILURE);
+    }
+
+    int status;
+    struct rusage ru;
+    while (::wait4(pid, &status, 0, &ru) == -1) {
+        if (errno != EINTR)
+            throw atf::system_error("atf_sh::main", "wait4 failed", errno);
+    }
+
+    write_usage(&mark, &ru, resfile);
+
+    if (WIFSIGNALED(status)) {
+        // The shell already dumped core if it had to.
+        const struct rlimit rl = { 0, 0 };
+        (void)::setrlimit(RLIMIT_CORE, &rl);
+        ::signal(WTERMSIG(status), SIG_DFL);
+        ::kill(::getpid(), WTERMSIG(status));
+        return EXIT_FAILURE;
+    }
+    return WEXITSTATUS(status);
+}
+
 } // anonymous namespace
 
 // ------------------------------------------------------------------------
@@ -171,6 +287,10 @@ atf_sh::main(void)
     // Don't bother keeping track of the memory allocated by construct_argv:
     // we are going to exec or die immediately.
 
+    const std::string resfile = find_resfile(m_argc, m_argv);
+    if (!resfile.empty())
+        return run_with_usage(m_shell.str(), argv, resfile);
+
     const int ret = execv(m_shell.c_str(), const_cast< char** >(argv));
     INV(ret == -1);
     std::cerr << "Failed to execute " << m_shell.str() << ": "
@@ -101,8 +101,65 @@ function(int a __attribute__((__unused__)))
     AC_SUBST([ATTRIBUTE_UNUSED], [${value}])
 ])
 
+dnl Checks whether the toolchain can collect static test case descriptors
+dnl in a named section and expose its bounds through the __start_<name> and
+dnl __stop_<name> symbols, as ELF linkers do.
+dnl
+dnl The bounds are declared weak, as in the headers, so that programs without
+dnl static test cases still link; the program must therefore be run to tell
+dnl whether they were actually defined.  When cross-compiling, fall back to
+dnl linking against strong references to the bounds, which fails unless the
+dnl linker defines them.
+AC_DEFUN([ATF_TC_SECTION], [
+    AC_CACHE_CHECK(
+        [whether test cases can be registered in a linker section],
+        [atf_cv_tc_section], [
+        AC_RUN_IFELSE(
+            [AC_LANG_PROGRAM([
+struct desc { int value; };
+static const struct desc d = { 3 };
+static const struct desc *const dp
+    __attribute__((__used__, __section__("atf_conftest"))) = &d;
+extern const struct desc *const __start_atf_conftest[[]]
+    __attribute__((__weak__));
+extern const struct desc *const __stop_atf_conftest[[]]
+    __attribute__((__weak__));
+extern const struct desc *const __start_atf_conftest_none[[]]
+    __attribute__((__weak__));
+], [
+    if (__stop_atf_conftest - __start_atf_conftest != 1 ||
+        __start_atf_conftest[[0]]->value != 3 ||
+        __start_atf_conftest_none != 0)
+        return 1;
+    return 0;
+])],
+        [atf_cv_tc_section=yes],
+        [atf_cv_tc_section=no],
+        [AC_LINK_IFELSE(
+            [AC_LANG_PROGRAM([
+struct desc { int value; };
+static const struct desc d = { 3 };
+static const struct desc *const dp
+    __attribute__((__used__, __section__("atf_conftest"))) = &d;
+extern const struct desc *const __start_atf_conftest[[]];
+extern const struct desc *const __stop_atf_conftest[[]];
+], [
+    return (int)(__stop_atf_conftest - __start_atf_conftest);
+])],
+            [atf_cv_tc_section=yes],
+            [atf_cv_tc_section=no])])
+    ])
+    if test x"${atf_cv_tc_section}" = xyes; then
+        value=1
+    else
+        value=0
+    fi
+    AC_SUBST([HAVE_TC_SECTION], [${value}])
+])
+
 AC_DEFUN([ATF_MODULE_DEFS], [
     ATF_ATTRIBUTE_FORMAT_PRINTF
     ATF_ATTRIBUTE_NORETURN
     ATF_ATTRIBUTE_UNUSED
+    ATF_TC_SECTION
 ])
@@ -0,0 +1,234 @@
+# Copyright (c) 2026 The NetBSD Foundation, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+# 1. Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+# CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+# INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+# IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+# DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+# GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+# IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+# OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+# IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+atf_test_case selected
+selected_head()
+{
+    atf_set "descr" "Tests that -R runs the selected test cases and stores" \
+                    "their results in the results directory"
+}
+selected_body()
+{
+    for h in $(get_helpers c_helpers cpp_helpers); do
+        rm -rf results
+        atf_check -s eq:1 -o empty -e ignore ${h} -s $(atf_get_srcdir) \
+            -R results result_pass result_fail result_skip
+
+        atf_check -o inline:"passed\n" cat results/result_pass/result
+        atf_check -o inline:"msg\n" cat results/result_pass/stdout
+        atf_check -o match:"^wall.usec: [0-9]+$" \
+            -o match:"^stdout.bytes: 4$" cat results/result_pass/result.usage
+        atf_check -o inline:"failed: Failure reason\n" \
+            cat results/result_fail/result
+        atf_check -o inline:"skipped: Skipped reason\n" \
+            cat results/result_skip/result
+        test -d results/result_skip/work || atf_fail "Missing work directory"
+        test ! -d results/result_newlines_fail || \
+            atf_fail "Unselected test case was run"
+    done
+}
+
+atf_test_case all
+all_head()
+{
+    atf_set "descr" "Tests that -R with 'all' runs every test case"
+}
+all_body()
+{
+    for h in $(get_helpers c_helpers cpp_helpers); do
+        rm -rf results
+        atf_check -s eq:1 -o empty -e ignore ${h} -s $(atf_get_srcdir) \
+            -R results -v cleanup=true -v tmpfile=$(pwd)/tmpfile all
+        for tc in $(${h} -l | sed -n 's,^ident: ,,p'); do
+            test -f results/${tc}/result || atf_fail "${tc} not run"
+        done
+    done
+}
+
+atf_test_case cleanup
+cleanup_head()
+{
+    atf_set "descr" "Tests that -R runs the cleanup routine of a test case" \
+                    "in the same work directory as its body"
+}
+cleanup_body()
+{
+    for h in $(get_helpers c_helpers); do
+        rm -rf results
+        atf_check -s eq:0 -o empty -e ignore ${h} -s $(atf_get_srcdir) \
+            -R results cleanup_curdir
+        atf_check -o inline:"passed\n" cat results/cleanup_curdir/result
+        atf_check -o inline:"Old value: 1234" \
+            cat results/cleanup_curdir/stdout
+    done
+}
+
+atf_test_case parallel
+parallel_head()
+{
+    atf_set "descr" "Tests that -j runs several test cases concurrently"
+}
+parallel_body()
+{
+    for h in $(get_helpers c_helpers cpp_helpers); do
+        rm -rf results rendezvous
+        mkdir rendezvous
+        atf_check -s eq:0 -o empty -e ignore ${h} -s $(atf_get_srcdir) \
+            -R results -j 2 -v rendezvous=$(pwd)/rendezvous \
+            batch_rendezvous_a batch_rendezvous_b
+        atf_check -o inline:"passed\n" cat results/batch_rendezvous_a/result
+        atf_check -o inline:"passed\n" cat results/batch_rendezvous_b/result
+    done
+}
+
+atf_test_case timeout
+timeout_head()
+{
+    atf_set "descr" "Tests that -R enforces the timeout property of the" \
+                    "test cases"
+}
+timeout_body()
+{
+    for h in $(get_helpers c_helpers cpp_helpers); do
+        rm -rf results
+        atf_check -s eq:1 -o empty -e ignore ${h} -s $(atf_get_srcdir) \
+            -R results batch_hang expect_timeout_and_hang
+        atf_check \
+            -o inline:"failed: Test case body timed out after 1 seconds\n" \
+            cat results/batch_hang/result
+        atf_check -o match:"^wall.usec: [0-9]{7}" \
+            cat results/batch_hang/result.usage
+        atf_check -o inline:"expected_timeout: Will overrun\n" \
+            cat results/expect_timeout_and_hang/result
+    done
+}
+
+atf_test_case expectations
+expectations_head()
+{
+    atf_set "descr" "Tests that -R judges the test cases by their results," \
+                    "so that met expectations do not count as failures"
+}
+expectations_body()
+{
+    for h in $(get_helpers c_helpers cpp_helpers); do
+        rm -rf results
+        atf_check -s eq:0 -o empty -e ignore ${h} -s $(atf_get_srcdir) \
+            -R results -j 4 expect_fail_and_fail_requirement \
+            expect_exit_code_and_exit expect_signal_no_and_signal \
+            expect_death_and_signal expect_timeout_and_hang
+        atf_check -o match:"^expected_signal\\(1\\): " \
+            cat results/expect_signal_no_and_signal/result
+
+        for tc in expect_exit_but_pass expect_signal_but_pass; do
+            rm -rf results
+            atf_check -s eq:1 -o empty -e ignore ${h} \
+                -s $(atf_get_srcdir) -R results ${tc}
+        done
+    done
+}
+
+atf_test_case job_errors
+job_errors_head()
+{
+    atf_set "descr" "Tests that -R reports a test case whose results cannot" \
+                    "be recorded as broken and keeps running the others"
+}
+job_errors_body()
+{
+    for h in $(get_helpers c_helpers cpp_helpers); do
+        rm -rf results
+        mkdir -p results/result_pass/result.usage
+        atf_check -s eq:1 -o empty -e ignore ${h} -s $(atf_get_srcdir) \
+            -R results -j 1 result_pass result_skip
+        atf_check -o match:"^broken: Cannot create usage file" \
+            cat results/result_pass/result
+        atf_check -o inline:"skipped: Skipped reason\n" \
+            cat results/result_skip/result
+    done
+}
+
+atf_test_case exclusive
+exclusive_head()
+{
+    atf_set "descr" "Tests that -j never runs exclusive test cases" \
+                    "concurrently with any other"
+}
+exclusive_body()
+{
+    for h in $(get_helpers c_helpers cpp_helpers); do
+        rm -rf results lockdir
+        mkdir lockdir
+        atf_check -s eq:0 -o empty -e ignore ${h} -s $(atf_get_srcdir) \
+            -R results -j 4 -v lockdir=$(pwd)/lockdir \
+            batch_exclusive_a batch_exclusive_b result_pass
+        atf_check -o inline:"passed\n" cat results/batch_exclusive_a/result
+        atf_check -o inline:"passed\n" cat results/batch_exclusive_b/result
+    done
+}
+
+atf_test_case usage_errors
+usage_errors_head()
+{
+    atf_set "descr" "Tests the usage errors of -R"
+}
+usage_errors_body()
+{
+    for h in $(get_helpers c_helpers cpp_helpers); do
+        atf_check -s eq:1 -o empty -e match:"Must provide at least one" \
+            ${h} -s $(atf_get_srcdir) -R results
+        atf_check -s eq:1 -o empty -e match:"Unknown test case .foo'" \
+            ${h} -s $(atf_get_srcdir) -R results result_pass foo
+        atf_check -s eq:1 -o empty -e match:"Cannot select a test case part" \
+            ${h} -s $(atf_get_srcdir) -R results result_pass:cleanup
+        atf_check -s eq:1 -o empty -e match:"Cannot provide -r with -R" \
+            ${h} -s $(atf_get_srcdir) -r resfile -R results result_pass
+        atf_check -s eq:1 -o empty -e match:"Cannot provide -R with -l" \
+            ${h} -s $(atf_get_srcdir) -R results -l
+        atf_check -s eq:1 -o empty -e match:"Cannot provide -j without -R" \
+            ${h} -s $(atf_get_srcdir) -j 2 result_pass
+        atf_check -s eq:1 -o empty -e match:"-j requires a positive integer" \
+            ${h} -s $(atf_get_srcdir) -R results -j 0 result_pass
+        atf_check -s eq:1 -o empty -e match:"-j requires a positive integer" \
+            ${h} -s $(atf_get_srcdir) -R results -j foo result_pass
+        test ! -f results/result_pass/result || \
+            atf_fail "Test case run despite usage error"
+    done
+}
+
+atf_init_test_cases()
+{
+    atf_add_test_case selected
+    atf_add_test_case all
+    atf_add_test_case cleanup
+    atf_add_test_case parallel
+    atf_add_test_case timeout
+    atf_add_test_case expectations
+    atf_add_test_case job_errors
+    atf_add_test_case exclusive
+    atf_add_test_case usage_errors
+}
+
+# vim: syntax=sh:expandtab:shiftwidth=4:softtabstop=4
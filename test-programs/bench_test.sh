@@ -0,0 +1,110 @@
+# Copyright (c) 2026 The NetBSD Foundation, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+# 1. Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+# CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+# INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+# IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+# DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+# GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+# IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+# OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+# IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+atf_test_case metadata
+metadata_head()
+{
+    atf_set "descr" "Tests that benchmarks are tagged as such in the list" \
+                    "of test cases"
+}
+metadata_body()
+{
+    srcdir="$(atf_get_srcdir)"
+    for h in $(get_helpers c_helpers cpp_helpers); do
+        atf_check -s eq:0 -o save:stdout -e empty "${h}" -s "${srcdir}" -l
+        atf_check -s eq:0 -o inline:"X-kind: benchmark\n" \
+            sed -n '/^ident: bench_sum$/,/^$/{/^X-kind/p;}' stdout
+        atf_check -s eq:0 -o empty \
+            sed -n '/^ident: result_pass$/,/^$/{/^X-kind/p;}' stdout
+    done
+}
+
+atf_test_case results
+results_head()
+{
+    atf_set "descr" "Tests that the statistics of a benchmark are recorded" \
+                    "next to the results file"
+}
+results_body()
+{
+    srcdir="$(atf_get_srcdir)"
+    for h in $(get_helpers c_helpers cpp_helpers); do
+        rm -f resfile resfile.bench
+        atf_check -s eq:0 -o empty -e ignore "${h}" -s "${srcdir}" -r resfile \
+            -v bench.samples=3 -v bench.sample_ms=1 bench_sum
+        atf_check -o inline:"passed\n" cat resfile
+        atf_check -o match:"^iterations: [1-9][0-9]*$" cat resfile.bench
+        atf_check -o match:"^samples: 3$" cat resfile.bench
+        atf_check -o match:"^ns_per_op\.samples:( [0-9]+\.[0-9]{3}){3}$" \
+            cat resfile.bench
+        for name in min median p99 mean stddev; do
+            atf_check -o match:"^ns_per_op\.${name}: [0-9]+\.[0-9]{3}$" \
+                cat resfile.bench
+        done
+    done
+}
+
+atf_test_case stdout
+stdout_head()
+{
+    atf_set "descr" "Tests that the statistics of a benchmark are printed" \
+                    "when there is no results file"
+}
+stdout_body()
+{
+    srcdir="$(atf_get_srcdir)"
+    for h in $(get_helpers c_helpers cpp_helpers); do
+        atf_check -s eq:0 -o match:"^samples: 2$" \
+            -o match:"^ns_per_op\.median: " -o match:"passed" -e ignore \
+            "${h}" -s "${srcdir}" -v bench.samples=2 -v bench.sample_ms=1 \
+            bench_sum
+    done
+}
+
+atf_test_case bad_config
+bad_config_head()
+{
+    atf_set "descr" "Tests that invalid benchmark parameters are reported"
+}
+bad_config_body()
+{
+    srcdir="$(atf_get_srcdir)"
+    for h in $(get_helpers c_helpers cpp_helpers); do
+        atf_check -s eq:1 -o match:"failed: .*bench.samples" -e ignore \
+            "${h}" -s "${srcdir}" -v bench.samples=0 bench_sum
+        atf_check -s eq:1 -o match:"failed: .*bench.sample_ms" -e ignore \
+            "${h}" -s "${srcdir}" -v bench.sample_ms=-1 bench_sum
+    done
+}
+
+atf_init_test_cases()
+{
+    atf_add_test_case metadata
+    atf_add_test_case results
+    atf_add_test_case stdout
+    atf_add_test_case bad_config
+}
+
+# vim: syntax=sh:expandtab:shiftwidth=4:softtabstop=4
@@ -24,6 +24,7 @@
  * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
 
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <sys/wait.h>
 #include <fcntl.h>
 #include <unistd.h>
@@ -64,6 +65,128 @@ touch(const char *path)
     close(fd);
 }
 
+/* ---------------------------------------------------------------------
+ * Helper tests for "t_batch".
+ * --------------------------------------------------------------------- */
+
+static
+void
+rendezvous(const atf_tc_t *tc, const char *self, const char *other)
+{
+    char *selfpath, *otherpath;
+    int i;
+
+    if (!atf_tc_has_config_var(tc, "rendezvous"))
+        atf_tc_skip("rendezvous not set");
+
+    RE(atf_text_format(&selfpath, "%s/%s",
+                       atf_tc_get_config_var(tc, "rendezvous"), self));
+    RE(atf_text_format(&otherpath, "%s/%s",
+                       atf_tc_get_config_var(tc, "rendezvous"), other));
+    touch(selfpath);
+    for (i = 0; i < 100 && access(otherpath, F_OK) == -1; i++)
+        usleep(100000);
+    ATF_REQUIRE_MSG(access(otherpath, F_OK) != -1, "%s did not run "
+                    "concurrently", other);
+    free(otherpath);
+    free(selfpath);
+}
+
+static
+void
+exclusive_section(const atf_tc_t *tc)
+{
+    char *lockpath;
+
+    if (!atf_tc_has_config_var(tc, "lockdir"))
+        atf_tc_skip("lockdir not set");
+
+    RE(atf_text_format(&lockpath, "%s/lock",
+                       atf_tc_get_config_var(tc, "lockdir")));
+    ATF_REQUIRE_MSG(mkdir(lockpath, 0755) != -1, "Exclusive test case ran "
+                    "concurrently with another one");
+    usleep(500000);
+    ATF_REQUIRE(rmdir(lockpath) != -1);
+    free(lockpath);
+}
+
+ATF_TC(batch_hang);
+ATF_TC_HEAD(batch_hang, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Helper test case for the t_batch test "
+                      "program");
+    atf_tc_set_md_var(tc, "timeout", "1");
+}
+ATF_TC_BODY(batch_hang, tc)
+{
+    sleep(10);
+}
+
+ATF_TC(batch_rendezvous_a);
+ATF_TC_HEAD(batch_rendezvous_a, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Helper test case for the t_batch test "
+                      "program");
+}
+ATF_TC_BODY(batch_rendezvous_a, tc)
+{
+    rendezvous(tc, "a", "b");
+}
+
+ATF_TC(batch_rendezvous_b);
+ATF_TC_HEAD(batch_rendezvous_b, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Helper test case for the t_batch test "
+                      "program");
+}
+ATF_TC_BODY(batch_rendezvous_b, tc)
+{
+    rendezvous(tc, "b", "a");
+}
+
+ATF_TC(batch_exclusive_a);
+ATF_TC_HEAD(batch_exclusive_a, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Helper test case for the t_batch test "
+                      "program");
+    atf_tc_set_md_var(tc, "is.exclusive", "true");
+}
+ATF_TC_BODY(batch_exclusive_a, tc)
+{
+    exclusive_section(tc);
+}
+
+ATF_TC(batch_exclusive_b);
+ATF_TC_HEAD(batch_exclusive_b, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Helper test case for the t_batch test "
+                      "program");
+    atf_tc_set_md_var(tc, "is.exclusive", "true");
+}
+ATF_TC_BODY(batch_exclusive_b, tc)
+{
+    exclusive_section(tc);
+}
+
+/* ---------------------------------------------------------------------
+ * Helper tests for "t_bench".
+ * --------------------------------------------------------------------- */
+
+ATF_BENCH(bench_sum);
+ATF_BENCH_HEAD(bench_sum, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Helper benchmark for the t_bench test "
+                      "program");
+}
+ATF_BENCH_BODY(bench_sum, tc, iterations)
+{
+    volatile size_t sum = 0;
+    size_t i;
+
+    for (i = 0; i < iterations; i++)
+        sum += i;
+}
+
 /* ---------------------------------------------------------------------
  * Helper tests for "t_cleanup".
  * --------------------------------------------------------------------- */
@@ -211,6 +334,22 @@ ATF_TC_BODY(config_value, tc)
     ATF_REQUIRE(strcmp(atf_tc_get_config_var(tc, "test"), "foo") == 0);
 }
 
+ATF_TC(config_head_value);
+ATF_TC_HEAD(config_head_value, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Helper test case for the server_test "
+                      "test program");
+    atf_tc_set_md_var(tc, "X-head-value", "%s",
+                      atf_tc_has_config_var(tc, "test") ?
+                      atf_tc_get_config_var(tc, "test") : "unset");
+}
+ATF_TC_BODY(config_head_value, tc)
+{
+    printf("head: %s\n", atf_tc_get_md_var(tc, "X-head-value"));
+    printf("body: %s\n", atf_tc_has_config_var(tc, "test") ?
+           atf_tc_get_config_var(tc, "test") : "unset");
+}
+
 ATF_TC(config_multi_value);
 ATF_TC_HEAD(config_multi_value, tc)
 {
@@ -378,6 +517,75 @@ ATF_TC_BODY(metadata_no_head, tc)
 {
 }
 
+ATF_TC(metadata_lazy_head);
+ATF_TC_HEAD(metadata_lazy_head, tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Helper test case for the t_meta_data "
+                      "test program");
+    if (atf_tc_has_config_var(tc, "headfile"))
+        atf_utils_create_file(atf_tc_get_config_var(tc, "headfile"), "%s",
+                              "");
+}
+ATF_TC_BODY(metadata_lazy_head, tc)
+{
+}
+
+#if ATF_DEFS_HAVE_TC_SECTION
+ATF_TC_STATIC(metadata_static,
+              "descr", "Helper test case for the t_meta_data test program",
+              "X-custom", "custom value");
+ATF_TC_BODY(metadata_static, tc)
+{
+    ATF_REQUIRE_STREQ("custom value", atf_tc_get_md_var(tc, "X-custom"));
+}
+
+ATF_TC_STATIC_WITH_CLEANUP(metadata_static_cleanup,
+                           "descr", "Helper test case for the t_meta_data "
+                           "test program");
+ATF_TC_BODY(metadata_static_cleanup, tc)
+{
+}
+ATF_TC_CLEANUP(metadata_static_cleanup, tc)
+{
+    if (atf_tc_has_config_var(tc, "cleanupfile"))
+        atf_utils_create_file(atf_tc_get_config_var(tc, "cleanupfile"),
+                              "%s", "");
+}
+
+/* A static test case shadowed by another one with the same name that is
+ * registered at run time, which must take precedence. */
+ATF_TC_STATIC(metadata_shadowed,
+              "descr", "Helper test case for the t_meta_data test program",
+              "X-registered", "compile time");
+ATF_TC_BODY(metadata_shadowed, tc)
+{
+    atf_tc_fail("Static test case run instead of the run time one");
+}
+
+static
+void
+metadata_shadowing_head(atf_tc_t *tc)
+{
+    atf_tc_set_md_var(tc, "descr", "Helper test case for the t_meta_data "
+                      "test program");
+    atf_tc_set_md_var(tc, "X-registered", "run time");
+}
+
+static
+void
+metadata_shadowing_body(const atf_tc_t *tc ATF_DEFS_ATTRIBUTE_UNUSED)
+{
+}
+
+static atf_tc_t metadata_shadowing_tc;
+static atf_tc_pack_t metadata_shadowing_tc_pack = {
+    .m_ident = "metadata_shadowed",
+    .m_head = metadata_shadowing_head,
+    .m_body = metadata_shadowing_body,
+    .m_cleanup = NULL,
+};
+#endif
+
 /* ---------------------------------------------------------------------
  * Helper tests for "t_srcdir".
  * --------------------------------------------------------------------- */
@@ -453,6 +661,16 @@ ATF_TC_BODY(result_newlines_skip, tc)
 
 ATF_TP_ADD_TCS(tp)
 {
+    /* Add helper tests for t_batch. */
+    ATF_TP_ADD_TC(tp, batch_hang);
+    ATF_TP_ADD_TC(tp, batch_rendezvous_a);
+    ATF_TP_ADD_TC(tp, batch_rendezvous_b);
+    ATF_TP_ADD_TC(tp, batch_exclusive_a);
+    ATF_TP_ADD_TC(tp, batch_exclusive_b);
+
+    /* Add helper tests for t_bench. */
+    ATF_TP_ADD_TC(tp, bench_sum);
+
     /* Add helper tests for t_cleanup. */
     ATF_TP_ADD_TC(tp, cleanup_pass);
     ATF_TP_ADD_TC(tp, cleanup_fail);
@@ -465,6 +683,7 @@ ATF_TP_ADD_TCS(tp)
     ATF_TP_ADD_TC(tp, config_empty);
     ATF_TP_ADD_TC(tp, config_value);
     ATF_TP_ADD_TC(tp, config_multi_value);
+    ATF_TP_ADD_TC(tp, config_head_value);
 
     /* Add helper tests for t_expect. */
     ATF_TP_ADD_TC(tp, expect_pass_and_pass);
@@ -488,6 +707,15 @@ ATF_TP_ADD_TCS(tp)
     /* Add helper tests for t_meta_data. */
     ATF_TP_ADD_TC(tp, metadata_no_descr);
     ATF_TP_ADD_TC(tp, metadata_no_head);
+    ATF_TP_ADD_TC(tp, metadata_lazy_head);
+#if ATF_DEFS_HAVE_TC_SECTION
+    {
+        atf_error_t err = atf_tp_add_tc_pack(tp, &metadata_shadowing_tc,
+                                             &metadata_shadowing_tc_pack);
+        if (atf_is_error(err))
+            return err;
+    }
+#endif
 
     /* Add helper tests for t_srcdir. */
     ATF_TP_ADD_TC(tp, srcdir_exists);
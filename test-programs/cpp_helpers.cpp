@@ -24,6 +24,8 @@
 // IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 extern "C" {
+#include <sys/stat.h>
+
 #include <signal.h>
 #include <unistd.h>
 }
@@ -36,6 +38,109 @@ extern "C" {
 
 #include "atf-c++/detail/fs.hpp"
 
+// ------------------------------------------------------------------------
+// Helper tests for "t_batch".
+// ------------------------------------------------------------------------
+
+static void
+rendezvous(const atf::tests::tc& tc, const std::string& self,
+           const std::string& other)
+{
+    if (!tc.has_config_var("rendezvous"))
+        ATF_SKIP("rendezvous not set");
+
+    const atf::fs::path dir(tc.get_config_var("rendezvous"));
+    std::ofstream((dir / self).c_str());
+    for (int i = 0; i < 100 && !atf::fs::exists(dir / other); i++)
+        ::usleep(100000);
+    if (!atf::fs::exists(dir / other))
+        ATF_FAIL(other + " did not run concurrently");
+}
+
+static void
+exclusive_section(const atf::tests::tc& tc)
+{
+    if (!tc.has_config_var("lockdir"))
+        ATF_SKIP("lockdir not set");
+
+    const atf::fs::path lock = atf::fs::path(tc.get_config_var("lockdir")) /
+        "lock";
+    if (::mkdir(lock.c_str(), 0755) == -1)
+        ATF_FAIL("Exclusive test case ran concurrently with another one");
+    ::usleep(500000);
+    ATF_REQUIRE(::rmdir(lock.c_str()) != -1);
+}
+
+ATF_TEST_CASE(batch_hang);
+ATF_TEST_CASE_HEAD(batch_hang)
+{
+    set_md_var("descr", "Helper test case for the t_batch test program");
+    set_md_var("timeout", "1");
+}
+ATF_TEST_CASE_BODY(batch_hang)
+{
+    ::sleep(10);
+}
+
+ATF_TEST_CASE(batch_rendezvous_a);
+ATF_TEST_CASE_HEAD(batch_rendezvous_a)
+{
+    set_md_var("descr", "Helper test case for the t_batch test program");
+}
+ATF_TEST_CASE_BODY(batch_rendezvous_a)
+{
+    rendezvous(*this, "a", "b");
+}
+
+ATF_TEST_CASE(batch_rendezvous_b);
+ATF_TEST_CASE_HEAD(batch_rendezvous_b)
+{
+    set_md_var("descr", "Helper test case for the t_batch test program");
+}
+ATF_TEST_CASE_BODY(batch_rendezvous_b)
+{
+    rendezvous(*this, "b", "a");
+}
+
+ATF_TEST_CASE(batch_exclusive_a);
+ATF_TEST_CASE_HEAD(batch_exclusive_a)
+{
+    set_md_var("descr", "Helper test case for the t_batch test program");
+    set_md_var("is.exclusive", "true");
+}
+ATF_TEST_CASE_BODY(batch_exclusive_a)
+{
+    exclusive_section(*this);
+}
+
+ATF_TEST_CASE(batch_exclusive_b);
+ATF_TEST_CASE_HEAD(batch_exclusive_b)
+{
+    set_md_var("descr", "Helper test case for the t_batch test program");
+    set_md_var("is.exclusive", "true");
+}
+ATF_TEST_CASE_BODY(batch_exclusive_b)
+{
+    exclusive_section(*this);
+}
+
+// ------------------------------------------------------------------------
+// Helper tests for "t_bench".
+// ------------------------------------------------------------------------
+
+ATF_BENCHMARK_CASE(bench_sum);
+ATF_BENCHMARK_CASE_HEAD(bench_sum)
+{
+    set_md_var("descr", "Helper benchmark for the t_bench test program");
+}
+ATF_BENCHMARK_CASE_BODY(bench_sum, iterations)
+{
+    volatile std::size_t sum = 0;
+
+    for (std::size_t i = 0; i < iterations; i++)
+        sum += i;
+}
+
 // ------------------------------------------------------------------------
 // Helper tests for "t_config".
 // ------------------------------------------------------------------------
@@ -70,6 +175,20 @@ ATF_TEST_CASE_BODY(config_value)
     ATF_REQUIRE_EQ(get_config_var("test"), "foo");
 }
 
+ATF_TEST_CASE(config_head_value);
+ATF_TEST_CASE_HEAD(config_head_value)
+{
+    set_md_var("descr", "Helper test case for the server_test test program");
+    set_md_var("X-head-value", has_config_var("test") ?
+               get_config_var("test") : "unset");
+}
+ATF_TEST_CASE_BODY(config_head_value)
+{
+    std::cout << "head: " << get_md_var("X-head-value") << "\n";
+    std::cout << "body: " << (has_config_var("test") ?
+                              get_config_var("test") : "unset") << "\n";
+}
+
 ATF_TEST_CASE(config_multi_value);
 ATF_TEST_CASE_HEAD(config_multi_value)
 {
@@ -237,6 +356,73 @@ ATF_TEST_CASE_BODY(metadata_no_head)
 {
 }
 
+ATF_TEST_CASE(metadata_lazy_head);
+ATF_TEST_CASE_HEAD(metadata_lazy_head)
+{
+    set_md_var("descr", "Helper test case for the t_meta_data test program");
+    if (has_config_var("headfile"))
+        atf::utils::create_file(get_config_var("headfile"), "");
+}
+ATF_TEST_CASE_BODY(metadata_lazy_head)
+{
+}
+
+#if ATF_DEFS_HAVE_TC_SECTION
+ATF_TEST_CASE_STATIC(metadata_static,
+                     "descr", "Helper test case for the t_meta_data test "
+                     "program",
+                     "X-custom", "custom value");
+ATF_TEST_CASE_BODY(metadata_static)
+{
+    ATF_REQUIRE_EQ("custom value", get_md_var("X-custom"));
+}
+
+ATF_TEST_CASE_STATIC_WITH_CLEANUP(metadata_static_cleanup,
+                                  "descr", "Helper test case for the "
+                                  "t_meta_data test program");
+ATF_TEST_CASE_BODY(metadata_static_cleanup)
+{
+}
+ATF_TEST_CASE_CLEANUP(metadata_static_cleanup)
+{
+    if (has_config_var("cleanupfile"))
+        atf::utils::create_file(get_config_var("cleanupfile"), "");
+}
+
+// A static test case shadowed by another one with the same name that is
+// registered at run time, which must take precedence.
+ATF_TEST_CASE_STATIC(metadata_shadowed,
+                     "descr", "Helper test case for the t_meta_data test "
+                     "program",
+                     "X-registered", "compile time");
+ATF_TEST_CASE_BODY(metadata_shadowed)
+{
+    ATF_FAIL("Static test case run instead of the run time one");
+}
+
+namespace {
+class metadata_shadowing : public atf::tests::tc {
+    void head(void);
+    void body(void) const;
+public:
+    metadata_shadowing(void) : atf::tests::tc("metadata_shadowed", false) {}
+};
+}
+
+void
+metadata_shadowing::head(void)
+{
+    set_md_var("descr", "Helper test case for the t_meta_data test program");
+    set_md_var("X-registered", "run time");
+}
+
+void
+metadata_shadowing::body(void)
+    const
+{
+}
+#endif
+
 // ------------------------------------------------------------------------
 // Helper tests for "t_srcdir".
 // ------------------------------------------------------------------------
@@ -313,11 +499,22 @@ ATF_TEST_CASE_BODY(result_exception)
 
 ATF_INIT_TEST_CASES(tcs)
 {
+    // Add helper tests for t_batch.
+    ATF_ADD_TEST_CASE(tcs, batch_hang);
+    ATF_ADD_TEST_CASE(tcs, batch_rendezvous_a);
+    ATF_ADD_TEST_CASE(tcs, batch_rendezvous_b);
+    ATF_ADD_TEST_CASE(tcs, batch_exclusive_a);
+    ATF_ADD_TEST_CASE(tcs, batch_exclusive_b);
+
+    // Add helper tests for t_bench.
+    ATF_ADD_TEST_CASE(tcs, bench_sum);
+
     // Add helper tests for t_config.
     ATF_ADD_TEST_CASE(tcs, config_unset);
     ATF_ADD_TEST_CASE(tcs, config_empty);
     ATF_ADD_TEST_CASE(tcs, config_value);
     ATF_ADD_TEST_CASE(tcs, config_multi_value);
+    ATF_ADD_TEST_CASE(tcs, config_head_value);
 
     // Add helper tests for t_expect.
     ATF_ADD_TEST_CASE(tcs, expect_pass_and_pass);
@@ -341,6 +538,10 @@ ATF_INIT_TEST_CASES(tcs)
     // Add helper tests for t_meta_data.
     ATF_ADD_TEST_CASE(tcs, metadata_no_descr);
     ATF_ADD_TEST_CASE(tcs, metadata_no_head);
+    ATF_ADD_TEST_CASE(tcs, metadata_lazy_head);
+#if ATF_DEFS_HAVE_TC_SECTION
+    tcs.push_back(new metadata_shadowing());
+#endif
 
     // Add helper tests for t_srcdir.
     ATF_ADD_TEST_CASE(tcs, srcdir_exists);
@@ -0,0 +1,162 @@
+# Copyright (c) 2026 The NetBSD Foundation, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+# 1. Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+# CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+# INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+# IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+# DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+# GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+# IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+# OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+# IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+atf_test_case json
+json_head()
+{
+    atf_set "descr" "Tests that -F json lists the test cases as JSON"
+}
+json_body()
+{
+    for h in $(get_helpers c_helpers cpp_helpers); do
+        atf_check -s eq:0 -o save:list -e empty ${h} -s $(atf_get_srcdir) \
+            -l -F json
+        atf_check -s eq:0 -o match:'^\{"version": 1, "test_cases": \[$' \
+            head -n 1 list
+        atf_check -s eq:0 -o inline:"]}\n" tail -n 1 list
+        atf_check -s eq:0 -o ignore grep \
+            '^{"ident": "metadata_lazy_head", "descr": "Helper test case' list
+        atf_check -s eq:0 -o inline:"$(${h} -l | grep -c '^ident: ')\n" \
+            grep -c '^{"ident": ' list
+    done
+}
+
+atf_test_case binary
+binary_head()
+{
+    atf_set "descr" "Tests that -F binary lists the test cases in the" \
+                    "length-prefixed binary format"
+}
+binary_body()
+{
+    for h in $(get_helpers c_helpers cpp_helpers); do
+        atf_check -s eq:0 -o save:list -e empty ${h} -s $(atf_get_srcdir) \
+            -l -F binary
+        atf_check -s eq:0 -o inline:"ATFL" head -c 4 list
+        atf_check -s eq:0 -o ignore grep -a metadata_lazy_head list
+    done
+}
+
+atf_test_case cache
+cache_head()
+{
+    atf_set "descr" "Tests that -C stores the listing in a cache and that" \
+                    "later listings are served from it"
+}
+cache_body()
+{
+    for h in $(get_helpers c_helpers cpp_helpers); do
+        rm -f cache
+        atf_check -s eq:0 -o save:expected -e empty ${h} \
+            -s $(atf_get_srcdir) -l
+        atf_check -s eq:0 -o file:expected -e empty ${h} \
+            -s $(atf_get_srcdir) -l -C cache
+        atf_check -s eq:0 -o match:"^atf-tp-list-cache 3 atf " \
+            head -n 1 cache
+
+        # Tamper with the cached listing to prove that it is served without
+        # registering the test cases again.
+        sed -e 's,^ident: ,ident: cached_,' cache >cache.new
+        mv cache.new cache
+        atf_check -s eq:0 -o match:"^ident: cached_" -e empty ${h} \
+            -s $(atf_get_srcdir) -l -C cache
+
+        # Neither does one listed with other configuration variables, which
+        # the heads of the test cases can see.
+        atf_check -s eq:0 -o not-match:"cached_" -e empty ${h} \
+            -s $(atf_get_srcdir) -l -v var=value -C cache
+
+        # A cached listing in another format does not match.
+        atf_check -s eq:0 -o not-match:"cached_" -e empty ${h} \
+            -s $(atf_get_srcdir) -l -F json -C cache
+        atf_check -s eq:0 -o match:"^atf-tp-list-cache 3 json " \
+            head -n 1 cache
+    done
+}
+
+atf_test_case cache_path
+cache_path_head()
+{
+    atf_set "descr" "Tests that -C keys the cache on the running binary" \
+                    "even if it was found through the PATH"
+}
+cache_path_body()
+{
+    for h in $(get_helpers c_helpers cpp_helpers); do
+        rm -f cache
+        atf_check -s eq:0 -o save:expected -e empty ${h} \
+            -s $(atf_get_srcdir) -l
+        atf_check -s eq:0 -o file:expected -e empty \
+            env PATH="$(dirname ${h}):${PATH}" $(basename ${h}) \
+            -s $(atf_get_srcdir) -l -C cache
+        atf_check -s eq:0 -o match:"^atf-tp-list-cache 3 atf " \
+            head -n 1 cache
+    done
+}
+
+atf_test_case cache_error
+cache_error_head()
+{
+    atf_set "descr" "Tests that a cache that cannot be written does not" \
+                    "prevent the listing"
+}
+cache_error_body()
+{
+    for h in $(get_helpers c_helpers cpp_helpers); do
+        atf_check -s eq:0 -o save:expected -e empty ${h} \
+            -s $(atf_get_srcdir) -l
+        atf_check -s eq:0 -o file:expected -e match:"WARNING: .*cache" \
+            ${h} -s $(atf_get_srcdir) -l -C missing/cache
+    done
+}
+
+atf_test_case usage_errors
+usage_errors_head()
+{
+    atf_set "descr" "Tests the usage errors of -F and -C"
+}
+usage_errors_body()
+{
+    for h in $(get_helpers c_helpers cpp_helpers); do
+        atf_check -s eq:1 -o empty -e match:"Unknown listing format .xml'" \
+            ${h} -s $(atf_get_srcdir) -l -F xml
+        atf_check -s eq:1 -o empty -e match:"Cannot provide -F without -l" \
+            ${h} -s $(atf_get_srcdir) -F json result_pass
+        atf_check -s eq:1 -o empty -e match:"Cannot provide -C without -l" \
+            ${h} -s $(atf_get_srcdir) -C cache result_pass
+    done
+}
+
+atf_init_test_cases()
+{
+    atf_add_test_case json
+    atf_add_test_case binary
+    atf_add_test_case cache
+    atf_add_test_case cache_path
+    atf_add_test_case cache_error
+    atf_add_test_case usage_errors
+}
+
+# vim: syntax=sh:expandtab:shiftwidth=4:softtabstop=4
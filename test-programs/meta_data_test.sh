@@ -51,10 +51,94 @@ no_head_body()
     done
 }
 
+atf_test_case lazy_head
+lazy_head_head()
+{
+    atf_set "descr" "Tests that the heads of the test cases only run when" \
+                    "their metadata is needed"
+}
+lazy_head_body()
+{
+    for h in $(get_helpers c_helpers cpp_helpers); do
+        rm -f head
+        atf_check -s eq:0 -o match:passed -e ignore ${h} \
+            -s $(atf_get_srcdir) -v headfile=$(pwd)/head metadata_no_head
+        test ! -f head || atf_fail "Running a test case ran unrelated heads"
+
+        atf_check -s eq:0 -o ignore -e ignore ${h} -s $(atf_get_srcdir) \
+            -v headfile=$(pwd)/head -l
+        test -f head || atf_fail "Listing the test cases did not run the heads"
+
+        rm -f head
+        atf_check -s eq:0 -o match:passed -e ignore ${h} \
+            -s $(atf_get_srcdir) -v headfile=$(pwd)/head metadata_lazy_head
+        test -f head || atf_fail "Running a test case did not run its head"
+    done
+}
+
+atf_test_case static_tcs
+static_tcs_head()
+{
+    atf_set "descr" "Tests that test cases registered at compile time are" \
+                    "listed and run like the others"
+}
+static_tcs_body()
+{
+    for h in $(get_helpers c_helpers cpp_helpers); do
+        atf_check -s eq:0 -o save:list -e ignore ${h} -s $(atf_get_srcdir) -l
+        grep '^ident: metadata_static$' list >/dev/null || \
+            atf_skip "Static test cases not supported by the toolchain"
+
+        sed -n '/^ident: metadata_static$/,/^$/p' list >static
+        atf_check -o match:'^descr: Helper test case' \
+            -o match:'^X-custom: custom value$' cat static
+        sed -n '/^ident: metadata_static_cleanup$/,/^$/p' list >static
+        atf_check -o match:'^has.cleanup: true$' cat static
+
+        atf_check -s eq:0 -o match:passed -e ignore ${h} \
+            -s $(atf_get_srcdir) metadata_static
+
+        rm -f cleanup
+        atf_check -s eq:0 -o ignore -e ignore ${h} -s $(atf_get_srcdir) \
+            -v cleanupfile=$(pwd)/cleanup metadata_static_cleanup:cleanup
+        test -f cleanup || atf_fail "Cleanup routine not run"
+
+        rm -rf results
+        atf_check -s eq:0 -o empty -e ignore ${h} -s $(atf_get_srcdir) \
+            -R results metadata_static result_pass
+        atf_check -o inline:"passed\n" cat results/metadata_static/result
+    done
+}
+
+atf_test_case shadowed_static_tc
+shadowed_static_tc_head()
+{
+    atf_set "descr" "Tests that a test case registered at run time takes" \
+                    "precedence over a static one with the same name"
+}
+shadowed_static_tc_body()
+{
+    for h in $(get_helpers c_helpers cpp_helpers); do
+        atf_check -s eq:0 -o save:list -e ignore ${h} -s $(atf_get_srcdir) -l
+        grep '^ident: metadata_static$' list >/dev/null || \
+            atf_skip "Static test cases not supported by the toolchain"
+
+        atf_check -o inline:"1\n" grep -c '^ident: metadata_shadowed$' list
+        sed -n '/^ident: metadata_shadowed$/,/^$/p' list >shadowed
+        atf_check -o match:'^X-registered: run time$' cat shadowed
+
+        atf_check -s eq:0 -o match:passed -e ignore ${h} \
+            -s $(atf_get_srcdir) metadata_shadowed
+    done
+}
+
 atf_init_test_cases()
 {
     atf_add_test_case no_descr
     atf_add_test_case no_head
+    atf_add_test_case lazy_head
+    atf_add_test_case static_tcs
+    atf_add_test_case shadowed_static_tc
 }
 
 # vim: syntax=sh:expandtab:shiftwidth=4:softtabstop=4
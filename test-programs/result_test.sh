@@ -83,6 +83,34 @@ result_to_file_body()
     done
 }
 
+atf_test_case result_usage
+result_usage_head()
+{
+    atf_set "descr" "Tests that the resources consumed by the test case are" \
+                    "recorded next to the results file"
+}
+result_usage_body()
+{
+    srcdir="$(atf_get_srcdir)"
+    for h in $(get_helpers); do
+        rm -f resfile resfile.usage
+        # The output size is only known when stdout is a regular file.
+        atf_check -s eq:0 -e ignore -x "'${h}' -s '${srcdir}'" \
+            "-r resfile result_pass >resfile.stdout"
+        atf_check -o inline:"msg\n" cat resfile.stdout
+        atf_check -o inline:"passed\n" cat resfile
+        for name in wall.usec user.usec system.usec maxrss.kb nvcsw nivcsw; do
+            atf_check -o match:"^${name}: [0-9]+$" cat resfile.usage
+        done
+        atf_check -o match:"^stdout.bytes: 4$" cat resfile.usage
+
+        rm -f resfile.usage
+        atf_check -s eq:1 -o match:"failed: Failure reason" -e ignore \
+            "${h}" -s "${srcdir}" result_fail
+        test ! -f resfile.usage || atf_fail "Usage recorded without -r"
+    done
+}
+
 atf_test_case result_to_file_fail
 result_to_file_fail_head()
 {
@@ -128,6 +156,7 @@ atf_init_test_cases()
     atf_add_test_case runtime_warnings
     atf_add_test_case result_on_stdout
     atf_add_test_case result_to_file
+    atf_add_test_case result_usage
     atf_add_test_case result_to_file_fail
     atf_add_test_case result_exception
 }
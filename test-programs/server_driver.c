@@ -0,0 +1,377 @@
+/* Copyright (c) 2026 The NetBSD Foundation, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+ * CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.  */
+
+/* Simple local driver for the server mode of test programs; see the -S
+ * flag in atf-test-program(1).
+ *
+ * In its first form, it starts a server and asks it to run the given test
+ * cases in the current directory, storing their results in <tc>.result and
+ * their output in <tc>.<part>.stdout and <tc>.<part>.stderr, and prints a
+ * line per test case with its exit status and result.
+ *
+ * In its second form (-b), it measures the latency of running the given
+ * test case the given number of times by executing the test program once
+ * per test case, as runtime engines traditionally do, and by sending the
+ * same requests to a single server instance. */
+
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include <err.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+struct server {
+    pid_t m_pid;
+    FILE *m_requests;
+    FILE *m_responses;
+};
+
+static
+void
+usage(void)
+{
+    fprintf(stderr, "Usage: server_driver [-v var=value] test_program "
+            "test_case[:part] ...\n");
+    fprintf(stderr, "       server_driver -b iterations test_program "
+            "test_case\n");
+    exit(EXIT_FAILURE);
+}
+
+static
+double
+now_s(void)
+{
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == -1)
+        err(EXIT_FAILURE, "clock_gettime failed");
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static
+void
+redirect_to_null(const int fd)
+{
+    const int nullfd = open("/dev/null", O_WRONLY);
+
+    if (nullfd == -1 || dup2(nullfd, fd) == -1)
+        err(EXIT_FAILURE, "Cannot redirect fd %d to /dev/null", fd);
+    close(nullfd);
+}
+
+static
+void
+server_start(struct server *s, const char *program, const bool quiet)
+{
+    int reqpipe[2], resppipe[2];
+
+    if (pipe(reqpipe) == -1 || pipe(resppipe) == -1)
+        err(EXIT_FAILURE, "Failed to create pipes");
+
+    s->m_pid = fork();
+    if (s->m_pid == -1)
+        err(EXIT_FAILURE, "Failed to fork");
+    else if (s->m_pid == 0) {
+        if (dup2(reqpipe[0], STDIN_FILENO) == -1 ||
+            dup2(resppipe[1], STDOUT_FILENO) == -1)
+            err(EXIT_FAILURE, "Failed to set up server pipes");
+        close(reqpipe[0]);
+        close(reqpipe[1]);
+        close(resppipe[0]);
+        close(resppipe[1]);
+        if (quiet)
+            redirect_to_null(STDERR_FILENO);
+
+        execl(program, program, "-S", (const char *)NULL);
+        err(EXIT_FAILURE, "Failed to execute %s", program);
+    }
+
+    close(reqpipe[0]);
+    close(resppipe[1]);
+    s->m_requests = fdopen(reqpipe[1], "w");
+    s->m_responses = fdopen(resppipe[0], "r");
+    if (s->m_requests == NULL || s->m_responses == NULL)
+        err(EXIT_FAILURE, "fdopen failed");
+}
+
+static
+void
+server_stop(struct server *s)
+{
+    int status;
+
+    fclose(s->m_requests);
+    fclose(s->m_responses);
+    if (waitpid(s->m_pid, &status, 0) == -1)
+        err(EXIT_FAILURE, "Failed to wait for the server");
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+        errx(EXIT_FAILURE, "The server did not exit cleanly");
+}
+
+/* Reads a response block and returns the value of its "status" property,
+ * or exits if the server reported an error. */
+static
+char *
+server_read_response(struct server *s)
+{
+    char *line, *status;
+    size_t linecap;
+    ssize_t len;
+
+    line = NULL;
+    linecap = 0;
+    status = NULL;
+    while ((len = getline(&line, &linecap, s->m_responses)) != -1) {
+        if (len > 0 && line[len - 1] == '\n')
+            line[--len] = '\0';
+        if (len == 0) {
+            if (status != NULL)
+                break;
+        } else if (strncmp(line, "status: ", 8) == 0) {
+            status = strdup(line + 8);
+            if (status == NULL)
+                err(EXIT_FAILURE, "strdup failed");
+        } else if (strncmp(line, "error: ", 7) == 0)
+            errx(EXIT_FAILURE, "Server error: %s", line + 7);
+    }
+    free(line);
+
+    if (status == NULL)
+        errx(EXIT_FAILURE, "The server exited prematurely");
+    return status;
+}
+
+static
+void
+server_wait_ready(struct server *s)
+{
+    char *line;
+    size_t linecap;
+
+    line = NULL;
+    linecap = 0;
+    if (getline(&line, &linecap, s->m_responses) == -1 ||
+        strncmp(line, "Content-Type: application/X-atf-server;", 39) != 0 ||
+        getline(&line, &linecap, s->m_responses) == -1 ||
+        strcmp(line, "\n") != 0)
+        errx(EXIT_FAILURE, "Invalid server header");
+    free(line);
+}
+
+static
+char *
+server_run(struct server *s, const char *tcarg, char *const *config,
+           const int nconfig, const bool quiet)
+{
+    const char *part;
+    char *tcname;
+    int i;
+
+    tcname = strdup(tcarg);
+    if (tcname == NULL)
+        err(EXIT_FAILURE, "strdup failed");
+    part = "body";
+    if (strchr(tcname, ':') != NULL) {
+        part = strchr(tcname, ':') + 1;
+        *strchr(tcname, ':') = '\0';
+    }
+
+    fprintf(s->m_requests, "ident: %s\n", tcname);
+    fprintf(s->m_requests, "part: %s\n", part);
+    if (strcmp(part, "body") == 0)
+        fprintf(s->m_requests, "resfile: %s.result\n", tcname);
+    if (quiet)
+        fprintf(s->m_requests, "stderr: /dev/null\n");
+    else {
+        fprintf(s->m_requests, "stdout: %s.%s.stdout\n", tcname, part);
+        fprintf(s->m_requests, "stderr: %s.%s.stderr\n", tcname, part);
+    }
+    for (i = 0; i < nconfig; i++)
+        fprintf(s->m_requests, "config: %s\n", config[i]);
+    fprintf(s->m_requests, "\n");
+    if (fflush(s->m_requests) == EOF)
+        err(EXIT_FAILURE, "Failed to send request");
+
+    free(tcname);
+    return server_read_response(s);
+}
+
+static
+void
+print_result(const char *tcarg, const char *status)
+{
+    char path[1024], *line;
+    size_t linecap;
+    FILE *f;
+
+    if (strchr(tcarg, ':') != NULL &&
+        strcmp(strchr(tcarg, ':'), ":body") != 0) {
+        printf("%s: %s\n", tcarg, status);
+        return;
+    }
+
+    snprintf(path, sizeof(path), "%.*s.result", (int)strcspn(tcarg, ":"),
+             tcarg);
+
+    line = NULL;
+    linecap = 0;
+    f = fopen(path, "r");
+    if (f == NULL || getline(&line, &linecap, f) == -1)
+        printf("%s: %s: no result\n", tcarg, status);
+    else
+        printf("%s: %s: %s", tcarg, status, line);
+    if (f != NULL)
+        fclose(f);
+    free(line);
+}
+
+static
+int
+drive(const char *program, char *const *config, const int nconfig,
+      char *const *tcargs, const int ntcargs)
+{
+    struct server s;
+    int i;
+
+    server_start(&s, program, false);
+    server_wait_ready(&s);
+    for (i = 0; i < ntcargs; i++) {
+        char *status = server_run(&s, tcargs[i], config, nconfig, false);
+        print_result(tcargs[i], status);
+        free(status);
+    }
+    server_stop(&s);
+
+    return EXIT_SUCCESS;
+}
+
+static
+void
+exec_once(const char *program, const char *tcname)
+{
+    char resfile[1024];
+    int status;
+    pid_t pid;
+
+    snprintf(resfile, sizeof(resfile), "%s.result", tcname);
+
+    pid = fork();
+    if (pid == -1)
+        err(EXIT_FAILURE, "Failed to fork");
+    else if (pid == 0) {
+        redirect_to_null(STDOUT_FILENO);
+        redirect_to_null(STDERR_FILENO);
+        execl(program, program, "-r", resfile, tcname, (const char *)NULL);
+        err(EXIT_FAILURE, "Failed to execute %s", program);
+    }
+
+    if (waitpid(pid, &status, 0) == -1)
+        err(EXIT_FAILURE, "Failed to wait for the test program");
+}
+
+static
+int
+bench(const char *program, const char *tcname, const long iterations)
+{
+    struct server s;
+    double start, exec_time, server_time;
+    long i;
+
+    start = now_s();
+    for (i = 0; i < iterations; i++)
+        exec_once(program, tcname);
+    exec_time = now_s() - start;
+
+    start = now_s();
+    server_start(&s, program, true);
+    server_wait_ready(&s);
+    for (i = 0; i < iterations; i++)
+        free(server_run(&s, tcname, NULL, 0, true));
+    server_stop(&s);
+    server_time = now_s() - start;
+
+    printf("exec: %ld runs, %.3f ms per run\n", iterations,
+           exec_time * 1000 / iterations);
+    printf("server: %ld runs, %.3f ms per run\n", iterations,
+           server_time * 1000 / iterations);
+
+    return EXIT_SUCCESS;
+}
+
+int
+main(int argc, char **argv)
+{
+    char **config;
+    long iterations;
+    int ch, nconfig, ret;
+
+    config = calloc(argc, sizeof(char *));
+    if (config == NULL)
+        err(EXIT_FAILURE, "calloc failed");
+
+    iterations = 0;
+    nconfig = 0;
+    while ((ch = getopt(argc, argv, "b:v:")) != -1) {
+        switch (ch) {
+        case 'b':
+            iterations = strtol(optarg, NULL, 10);
+            if (iterations <= 0)
+                usage();
+            break;
+
+        case 'v':
+            config[nconfig++] = optarg;
+            break;
+
+        default:
+            usage();
+        }
+    }
+    argc -= optind;
+    argv += optind;
+
+    /* Silence the warnings about running outside of a runtime engine. */
+    setenv("__RUNNING_INSIDE_ATF_RUN", "internal-yes-value", 1);
+
+    if (iterations > 0) {
+        if (argc != 2 || nconfig > 0)
+            usage();
+        ret = bench(argv[0], argv[1], iterations);
+    } else {
+        if (argc < 2)
+            usage();
+        ret = drive(argv[0], config, nconfig, argv + 1, argc - 1);
+    }
+
+    free(config);
+    return ret;
+}
@@ -0,0 +1,230 @@
+# Copyright (c) 2026 The NetBSD Foundation, Inc.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+# 1. Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE NETBSD FOUNDATION, INC. AND
+# CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES,
+# INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+# IN NO EVENT SHALL THE FOUNDATION OR CONTRIBUTORS BE LIABLE FOR ANY
+# DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+# GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+# INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+# IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+# OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+# IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+atf_test_case requests
+requests_head()
+{
+    atf_set "descr" "Tests that -S runs the requested test cases and" \
+                    "reports their exit status"
+}
+requests_body()
+{
+    for h in $(get_helpers c_helpers cpp_helpers); do
+        cat >requests <<EOF2
+ident: result_pass
+resfile: $(pwd)/pass.result
+stdout: $(pwd)/pass.stdout
+
+ident: result_fail
+resfile: $(pwd)/fail.result
+EOF2
+        cat >expout <<EOF2
+Content-Type: application/X-atf-server; version="1"
+
+ident: result_pass
+status: exited 0
+
+ident: result_fail
+status: exited 1
+
+EOF2
+        atf_check -s eq:0 -o file:expout -e ignore \
+            ${h} -s $(atf_get_srcdir) -S <requests
+        atf_check -o inline:"passed\n" cat pass.result
+        atf_check -o inline:"msg\n" cat pass.stdout
+        atf_check -o inline:"failed: Failure reason\n" cat fail.result
+    done
+}
+
+atf_test_case config
+config_head()
+{
+    atf_set "descr" "Tests that -S applies the configuration variables of" \
+                    "each request to that request only"
+}
+config_body()
+{
+    for h in $(get_helpers c_helpers cpp_helpers); do
+        cat >requests <<EOF2
+ident: config_value
+resfile: $(pwd)/with.result
+config: test=foo
+
+ident: config_unset
+resfile: $(pwd)/without.result
+EOF2
+        atf_check -s eq:0 -o match:"status: exited 0" -e ignore \
+            ${h} -s $(atf_get_srcdir) -S <requests
+        atf_check -o inline:"passed\n" cat with.result
+        atf_check -o inline:"passed\n" cat without.result
+    done
+}
+
+atf_test_case config_head
+config_head_head()
+{
+    atf_set "descr" "Tests that -S runs the test case heads before serving" \
+                    "any request, so that they do not see the configuration" \
+                    "variables of the requests"
+}
+config_head_body()
+{
+    for h in $(get_helpers c_helpers cpp_helpers); do
+        cat >requests <<EOF2
+ident: config_head_value
+resfile: $(pwd)/result
+stdout: $(pwd)/stdout
+config: test=foo
+EOF2
+        atf_check -s eq:0 -o match:"status: exited 0" -e ignore \
+            ${h} -s $(atf_get_srcdir) -v test=bar -S <requests
+        atf_check -o inline:"passed\n" cat result
+        atf_check -o inline:"head: bar\nbody: foo\n" cat stdout
+    done
+}
+
+atf_test_case cleanup
+cleanup_head()
+{
+    atf_set "descr" "Tests that -S runs the cleanup routine of a test case" \
+                    "in the requested work directory"
+}
+cleanup_body()
+{
+    for h in $(get_helpers c_helpers); do
+        rm -rf work
+        mkdir work
+        cat >requests <<EOF2
+ident: cleanup_curdir
+resfile: $(pwd)/result
+workdir: $(pwd)/work
+
+ident: cleanup_curdir
+part: cleanup
+workdir: $(pwd)/work
+stdout: $(pwd)/stdout
+EOF2
+        atf_check -s eq:0 -o ignore -e ignore \
+            ${h} -s $(atf_get_srcdir) -S <requests
+        atf_check -o inline:"passed\n" cat result
+        atf_check -o inline:"Old value: 1234" cat stdout
+    done
+}
+
+atf_test_case request_errors
+request_errors_head()
+{
+    atf_set "descr" "Tests that -S reports invalid requests and carries on" \
+                    "with the following ones"
+}
+request_errors_body()
+{
+    for h in $(get_helpers c_helpers cpp_helpers); do
+        cat >requests <<EOF2
+ident: foo
+resfile: $(pwd)/result
+
+ident: result_pass
+
+ident: result_pass
+resfile: $(pwd)/result
+bar: baz
+
+ident: result_pass
+resfile: $(pwd)/result
+EOF2
+        cat >expout <<EOF2
+Content-Type: application/X-atf-server; version="1"
+
+error: Unknown test case \`foo'
+
+error: Missing property \`resfile'
+
+error: Unknown property \`bar'
+
+ident: result_pass
+status: exited 0
+
+EOF2
+        atf_check -s eq:0 -o file:expout -e ignore \
+            ${h} -s $(atf_get_srcdir) -S <requests
+    done
+}
+
+atf_test_case usage_errors
+usage_errors_head()
+{
+    atf_set "descr" "Tests the usage errors of -S"
+}
+usage_errors_body()
+{
+    for h in $(get_helpers c_helpers cpp_helpers); do
+        atf_check -s eq:1 -o empty -e match:"Cannot provide test case names" \
+            ${h} -s $(atf_get_srcdir) -S result_pass
+        atf_check -s eq:1 -o empty -e match:"Cannot provide -S with -l" \
+            ${h} -s $(atf_get_srcdir) -S -l
+        atf_check -s eq:1 -o empty -e match:"Cannot provide -R with -S" \
+            ${h} -s $(atf_get_srcdir) -S -R results
+        atf_check -s eq:1 -o empty -e match:"Cannot provide -r with -S" \
+            ${h} -s $(atf_get_srcdir) -S -r resfile
+    done
+}
+
+atf_test_case driver
+driver_head()
+{
+    atf_set "descr" "Tests the server_driver helper"
+}
+driver_body()
+{
+    driver=$(atf_get_srcdir)/server_driver
+    for h in $(get_helpers c_helpers cpp_helpers); do
+        cat >expout <<EOF2
+result_pass: exited 0: passed
+result_fail: exited 1: failed: Failure reason
+config_value: exited 0: passed
+EOF2
+        atf_check -s eq:0 -o file:expout -e empty \
+            ${driver} -v test=foo ${h} result_pass result_fail config_value
+        atf_check -o inline:"msg\n" cat result_pass.body.stdout
+
+        atf_check -s eq:0 -o match:"^exec: 3 runs, .* ms per run$" \
+            -o match:"^server: 3 runs, .* ms per run$" -e empty \
+            ${driver} -b 3 ${h} result_pass
+    done
+}
+
+atf_init_test_cases()
+{
+    atf_add_test_case requests
+    atf_add_test_case config
+    atf_add_test_case config_head
+    atf_add_test_case cleanup
+    atf_add_test_case request_errors
+    atf_add_test_case usage_errors
+    atf_add_test_case driver
+}
+
+# vim: syntax=sh:expandtab:shiftwidth=4:softtabstop=4